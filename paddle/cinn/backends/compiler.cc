@@ -38,6 +38,7 @@ PD_DECLARE_string(cinn_dump_group_source_code);
 PD_DECLARE_string(cinn_dump_group_ptx);
 PD_DECLARE_string(cinn_dump_group_instruction);
 PD_DECLARE_string(cinn_debug_custom_code_path);
+PD_DECLARE_int32(cinn_llvm_compile_thread);
 
 namespace cinn {
 namespace backends {
@@ -230,6 +231,12 @@ void SourceCodePrint::write(const std::string& source_code) {
   }
 }
 
+Compiler::Compiler(const Target& target) : target_(target) {
+  ExecutionOptions options;
+  options.num_compile_threads = FLAGS_cinn_llvm_compile_thread;
+  engine_ = ExecutionEngine::Create(options);
+}
+
 void Compiler::Build(const Module& module,
                      const std::string& code,
                      const bool end) {
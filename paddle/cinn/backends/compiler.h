@@ -126,6 +126,16 @@ class Compiler final {
 
   std::vector<void*> GetFnPtr() const { return fn_ptr_; }
 
+  /**
+   * The x86 objects compiled by the JIT, which another Compiler can link with
+   * AddObject rather than building the modules again.
+   */
+  std::vector<std::string> GetObjects() const { return engine_->GetObjects(); }
+
+  bool AddObject(const std::string& object) {
+    return engine_->AddObject(object);
+  }
+
  private:
   void CompileCudaModule(const ir::Module& module,
                          const std::string& code = "",
@@ -133,8 +143,7 @@ class Compiler final {
 
   void CompileX86Module(const ir::Module& module, bool add_module = true);
 
-  explicit Compiler(const Target& target)
-      : target_(target), engine_(ExecutionEngine::Create(ExecutionOptions())) {}
+  explicit Compiler(const Target& target);
 
   CINN_DISALLOW_COPY_AND_ASSIGN(Compiler);
 
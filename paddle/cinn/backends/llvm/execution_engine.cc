@@ -15,8 +15,11 @@
 #include "paddle/cinn/backends/llvm/execution_engine.h"
 
 #include <absl/strings/string_view.h>
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/Triple.h>
 #include <llvm/AsmParser/Parser.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/Config/llvm-config.h>
 #include <llvm/ExecutionEngine/JITSymbol.h>
 #include <llvm/ExecutionEngine/Orc/Core.h>
@@ -47,12 +50,15 @@
 #include <llvm/Transforms/Scalar/NewGVN.h>
 #include <llvm/Transforms/Scalar/Reassociate.h>
 #include <llvm/Transforms/Scalar/SimplifyCFG.h>
+#include <llvm/Transforms/Utils/Cloning.h>
 
+#include <algorithm>
 #include <cmath>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "paddle/cinn/backends/codegen_cuda_host.h"
 #include "paddle/cinn/backends/llvm/cinn_runtime_llvm_ir.h"
@@ -63,7 +69,9 @@
 #include "paddle/cinn/backends/llvm/runtime_symbol_registry.h"
 #include "paddle/cinn/ir/ir_printer.h"
 #include "paddle/cinn/runtime/intrinsic.h"
+#include "paddle/cinn/utils/multi_threading.h"
 #include "paddle/cinn/utils/profiler.h"
+#include "paddle/cinn/utils/timer.h"
 
 namespace cinn::backends {
 namespace {
@@ -89,11 +97,23 @@ void InitializeLLVMPasses() {
 }  // namespace
 void NaiveObjectCache::notifyObjectCompiled(const llvm::Module *m,
                                             llvm::MemoryBufferRef obj_buffer) {
+  if (cached_objects_.count(m->getModuleIdentifier()) == 0) {
+    module_ids_.push_back(m->getModuleIdentifier());
+  }
   cached_objects_[m->getModuleIdentifier()] =
       llvm::MemoryBuffer::getMemBufferCopy(obj_buffer.getBuffer(),
                                            obj_buffer.getBufferIdentifier());
 }
 
+std::vector<std::string> NaiveObjectCache::GetObjects() const {
+  std::vector<std::string> objects;
+  for (const auto &module_id : module_ids_) {
+    objects.emplace_back(
+        cached_objects_.find(module_id)->second->getBuffer().str());
+  }
+  return objects;
+}
+
 std::unique_ptr<llvm::MemoryBuffer> NaiveObjectCache::getObject(
     const llvm::Module *m) {
   auto it = cached_objects_.find(m->getModuleIdentifier());
@@ -171,36 +191,66 @@ std::unique_ptr<llvm::MemoryBuffer> NaiveObjectCache::getObject(
   llvm::SMDiagnostic error;
   engine->m = llvm::parseAssemblyString(
       AsStringRef(backends::kRuntimeLlvmIr), error, *engine->ctx);
+  engine->num_compile_threads_ = config.num_compile_threads;
+  for (const auto &f : *engine->m) {
+    if (!f.isDeclaration()) {
+      engine->runtime_functions_.insert(f.getName());
+    }
+  }
 
   return engine;
 }
 
 template <typename CodeGenT>
 void ExecutionEngine::Link(const ir::Module &module, bool add_module) {
-  utils::RecordEvent("ExecutionEngine Link", utils::EventType::kOrdinary);
+  utils::RecordEvent record_link("ExecutionEngine Link",
+                                 utils::EventType::kOrdinary);
+
+  utils::Timer timer;
+  timer.Start();
+  {
+    utils::RecordEvent record_emit("ExecutionEngine EmitIR",
+                                   utils::EventType::kCodeGen);
+    auto ir_emitter = std::make_unique<CodeGenT>(m.get(), b.get());
+    VLOG(3) << "ir_emitter->Compile(module) Begin";
+    ir_emitter->Compile(module);
+    VLOG(3) << "ir_emitter->Compile(module) Succeed!";
+    CHECK(!llvm::verifyModule(*m, &llvm::errs())) << "Invalid module found";
+  }
+  VLOG(4) << "Emitting the LLVM IR takes " << timer.Stop() << " ms";
 
-  auto ir_emitter = std::make_unique<CodeGenT>(m.get(), b.get());
-  VLOG(3) << "ir_emitter->Compile(module) Begin";
-  ir_emitter->Compile(module);
-  VLOG(3) << "ir_emitter->Compile(module) Succeed!";
-  CHECK(!llvm::verifyModule(*m, &llvm::errs())) << "Invalid module found";
+  if (add_module && num_compile_threads_ > 1 && LinkPartitions()) {
+    return;
+  }
 
   auto machine = std::move(llvm::cantFail(
       llvm::cantFail(llvm::orc::JITTargetMachineBuilder::detectHost())
           .createTargetMachine()));
-  LLVMModuleOptimizer optimize(machine.get(), 3, {}, true);
-  optimize(m.get());
-  CHECK(!llvm::verifyModule(*m, &llvm::errs()))
-      << "Invalid optimized module detected";
+  timer.Start();
+  {
+    utils::RecordEvent record_optimize("ExecutionEngine Optimize",
+                                       utils::EventType::kCompile);
+    LLVMModuleOptimizer optimize(machine.get(), 3, {}, true);
+    optimize(m.get());
+    CHECK(!llvm::verifyModule(*m, &llvm::errs()))
+        << "Invalid optimized module detected";
+  }
+  VLOG(4) << "Optimizing the LLVM module takes " << timer.Stop() << " ms";
   for (auto &f : *m) {
     VLOG(5) << "function: " << DumpToString(f);
   }
 
-  llvm::raw_svector_ostream rawstream(buffer_);
-  llvm::legacy::PassManager pass_manager;
-  machine->addPassesToEmitFile(
-      pass_manager, rawstream, nullptr, llvm::CGFT_ObjectFile);
-  pass_manager.run(*m);
+  timer.Start();
+  {
+    utils::RecordEvent record_codegen("ExecutionEngine Codegen",
+                                      utils::EventType::kCompile);
+    llvm::raw_svector_ostream rawstream(buffer_);
+    llvm::legacy::PassManager pass_manager;
+    machine->addPassesToEmitFile(
+        pass_manager, rawstream, nullptr, llvm::CGFT_ObjectFile);
+    pass_manager.run(*m);
+  }
+  VLOG(4) << "Emitting the object takes " << timer.Stop() << " ms";
 
   if (add_module) {
     AddSelfModule();
@@ -219,7 +269,8 @@ void ExecutionEngine::Link(const ir::Module &module, bool add_module) {
 
 bool ExecutionEngine::AddModule(std::unique_ptr<llvm::Module> module,
                                 std::unique_ptr<llvm::LLVMContext> context) {
-  utils::RecordEvent("ExecutionEngine AddModule", utils::EventType::kOrdinary);
+  utils::RecordEvent record_event("ExecutionEngine AddModule",
+                                  utils::EventType::kOrdinary);
   module->setDataLayout(jit_->getDataLayout());
   if (VLOG_IS_ON(5)) {
     VLOG(5) << "======= dump jit lib ==========";
@@ -239,14 +290,156 @@ bool ExecutionEngine::AddSelfModule() {
   return AddModule(std::move(m), std::move(ctx));
 }
 
+bool ExecutionEngine::LinkPartitions() {
+  // The functions compiled from the CINN module, the runtime functions and
+  // the local ones being copied into every partition.
+  std::vector<llvm::Function *> functions;
+  for (auto &f : *m) {
+    if (!f.isDeclaration() && !f.hasLocalLinkage() &&
+        runtime_functions_.count(f.getName()) == 0) {
+      functions.push_back(&f);
+    }
+  }
+  const int num_partitions =
+      std::min<int>(num_compile_threads_, functions.size());
+  if (num_partitions < 2) {
+    return false;
+  }
+
+  // Puts the largest function into the smallest partition, in turn.
+  std::sort(functions.begin(),
+            functions.end(),
+            [](llvm::Function *lhs, llvm::Function *rhs) {
+              return lhs->getInstructionCount() > rhs->getInstructionCount();
+            });
+  std::vector<unsigned> partition_sizes(num_partitions, 0);
+  llvm::DenseMap<const llvm::GlobalValue *, int> partition_of;
+  for (llvm::Function *f : functions) {
+    auto smallest =
+        std::min_element(partition_sizes.begin(), partition_sizes.end());
+    partition_of[f] = smallest - partition_sizes.begin();
+    *smallest += std::max(f->getInstructionCount(), 1U);
+  }
+
+  // The partitions are compiled in their own LLVMContext, so they are passed
+  // to the threads as bitcode.
+  std::vector<std::string> bitcodes(num_partitions);
+  for (int i = 0; i < num_partitions; ++i) {
+    llvm::ValueToValueMapTy vmap;
+    auto partition =
+        llvm::CloneModule(*m, vmap, [&](const llvm::GlobalValue *gv) {
+          if (gv->hasLocalLinkage()) {
+            return true;
+          }
+          auto it = partition_of.find(gv);
+          if (it != partition_of.end()) {
+            return it->second == i;
+          }
+          // The first partition defines the runtime functions and the
+          // variables, the others copy the functions as internal ones.
+          return i == 0 || llvm::isa<llvm::Function>(gv);
+        });
+    if (i > 0) {
+      for (auto &f : *partition) {
+        if (!f.isDeclaration() && runtime_functions_.count(f.getName())) {
+          f.setLinkage(llvm::GlobalValue::InternalLinkage);
+          f.setComdat(nullptr);
+        }
+      }
+    }
+    llvm::raw_string_ostream os(bitcodes[i]);
+    llvm::WriteBitcodeToFile(*partition, os);
+    os.flush();
+  }
+  m.reset();
+
+  std::vector<std::string> objects(num_partitions);
+  auto compile_partition = [&](int index) {
+    llvm::LLVMContext context;
+    auto partition = llvm::cantFail(llvm::parseBitcodeFile(
+        llvm::MemoryBufferRef(bitcodes[index], "cinn_partition"), context));
+    auto machine = std::move(llvm::cantFail(
+        llvm::cantFail(llvm::orc::JITTargetMachineBuilder::detectHost())
+            .createTargetMachine()));
+    partition->setDataLayout(machine->createDataLayout());
+
+    utils::Timer timer;
+    timer.Start();
+    {
+      utils::RecordEvent record_optimize("ExecutionEngine Optimize",
+                                         utils::EventType::kCompile);
+      LLVMModuleOptimizer optimize(machine.get(), 3, {}, true);
+      optimize(partition.get());
+      CHECK(!llvm::verifyModule(*partition, &llvm::errs()))
+          << "Invalid optimized module detected";
+    }
+    VLOG(4) << "Optimizing the partition " << index << " takes "
+            << timer.Stop() << " ms";
+
+    timer.Start();
+    {
+      utils::RecordEvent record_codegen("ExecutionEngine Codegen",
+                                        utils::EventType::kCompile);
+      llvm::SmallString<0> buffer;
+      llvm::raw_svector_ostream rawstream(buffer);
+      llvm::legacy::PassManager pass_manager;
+      machine->addPassesToEmitFile(
+          pass_manager, rawstream, nullptr, llvm::CGFT_ObjectFile);
+      pass_manager.run(*partition);
+      objects[index] = buffer.str().str();
+    }
+    VLOG(4) << "Emitting the object of the partition " << index << " takes "
+            << timer.Stop() << " ms";
+  };
+  VLOG(4) << "Compile " << functions.size() << " functions in "
+          << num_partitions << " partitions";
+  utils::parallel_run(compile_partition,
+                      utils::SequenceDispatcher(0, num_partitions),
+                      num_partitions);
+
+  std::lock_guard<std::mutex> lock(mu_);
+  for (const auto &object : objects) {
+    llvm::cantFail(jit_->addObjectFile(
+        llvm::MemoryBuffer::getMemBufferCopy(object, "cinn_partition")));
+  }
+  linked_objects_.insert(linked_objects_.end(), objects.begin(), objects.end());
+  return true;
+}
+
+std::vector<std::string> ExecutionEngine::GetObjects() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  std::vector<std::string> objects = cache_->GetObjects();
+  objects.insert(objects.end(), linked_objects_.begin(), linked_objects_.end());
+  return objects;
+}
+
+bool ExecutionEngine::AddObject(const std::string &object) {
+  utils::RecordEvent record_event("ExecutionEngine AddObject",
+                                  utils::EventType::kOrdinary);
+  std::lock_guard<std::mutex> lock(mu_);
+  if (auto error = jit_->addObjectFile(
+          llvm::MemoryBuffer::getMemBufferCopy(object, "cinn_cached_object"))) {
+    LOG(WARNING) << "Failed to add a cached object: "
+                 << llvm::toString(std::move(error));
+    return false;
+  }
+  return true;
+}
+
 void ExecutionEngine::ExportObject(const std::string &path) {
+  if (buffer_.empty() && !linked_objects_.empty()) {
+    LOG(WARNING) << "The module is compiled in " << linked_objects_.size()
+                 << " partitions, which can't be exported as one object. "
+                    "Set num_compile_threads to 1 to export it.";
+  }
   FILE *of = fopen(path.c_str(), "w");
   fwrite(buffer_.data(), 1, buffer_.size(), of);
   fclose(of);
 }
 
 void *ExecutionEngine::Lookup(absl::string_view name) {
-  utils::RecordEvent("ExecutionEngine Lookup", utils::EventType::kOrdinary);
+  utils::RecordEvent record_event("ExecutionEngine Lookup",
+                                  utils::EventType::kOrdinary);
   std::lock_guard<std::mutex> lock(mu_);
   if (auto symbol = jit_->lookup(AsStringRef(name))) {
     return reinterpret_cast<void *>(symbol->getAddress());
@@ -257,8 +450,8 @@ void *ExecutionEngine::Lookup(absl::string_view name) {
 }
 
 void ExecutionEngine::RegisterRuntimeSymbols() {
-  utils::RecordEvent("ExecutionEngine RegisterRuntimeSymbols",
-                     utils::EventType::kOrdinary);
+  utils::RecordEvent record_event("ExecutionEngine RegisterRuntimeSymbols",
+                                  utils::EventType::kOrdinary);
   const auto &registry = GlobalSymbolRegistry::Global();
   auto *session = &jit_->getExecutionSession();
   for (const auto &sym : registry.All()) {
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringSet.h>
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
 #include <llvm/ExecutionEngine/JITSymbol.h>
 #include <llvm/ExecutionEngine/ObjectCache.h>
@@ -56,15 +57,21 @@ class NaiveObjectCache : public llvm::ObjectCache {
                             llvm::MemoryBufferRef) override;
   std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *) override;
 
+  // The objects compiled so far, in the order of compilation.
+  std::vector<std::string> GetObjects() const;
+
  private:
   llvm::StringMap<std::unique_ptr<llvm::MemoryBuffer>> cached_objects_;
+  std::vector<std::string> module_ids_;
 };
 
 struct ExecutionOptions {
   int opt_level{3};
   bool enable_debug_info{false};
+  // The number of threads optimizing and emitting the functions of a linked
+  // module, which is split into as many partitions if greater than 1.
+  int num_compile_threads{1};
   // TODO(fc500110)
-  // int num_compile_threads{1};
   // bool enable_fast_math;
 };
 
@@ -88,6 +95,12 @@ class ExecutionEngine {
 
   bool AddSelfModule();
 
+  // The objects compiled by the JIT, which another ExecutionEngine can link
+  // with AddObject rather than compiling the modules again.
+  std::vector<std::string> GetObjects() const;
+
+  bool AddObject(const std::string &object);
+
  protected:
   explicit ExecutionEngine(bool enable_object_cache,
                            RuntimeSymbols &&module_symbols)
@@ -100,6 +113,11 @@ class ExecutionEngine {
 
   bool SetupTargetTriple(llvm::Module *module);
 
+  // Optimizes and emits the partitions of the module on
+  // num_compile_threads_ threads, and links their objects. Returns false if
+  // the module has too few functions to be split.
+  bool LinkPartitions();
+
   // This may not be a compatible implementation.
   friend std::unique_ptr<ExecutionEngine> std::make_unique<ExecutionEngine>(
       bool &&, cinn::backends::RuntimeSymbols &&);
@@ -110,6 +128,11 @@ class ExecutionEngine {
   std::unique_ptr<llvm::orc::LLJIT> jit_;
   std::unique_ptr<NaiveObjectCache> cache_;
   RuntimeSymbols module_symbols_;
+  int num_compile_threads_{1};
+  // the functions defined by the runtime IR, shared by the partitions
+  llvm::StringSet<> runtime_functions_;
+  // the objects of the partitions linked by LinkPartitions
+  std::vector<std::string> linked_objects_;
 
   std::unique_ptr<llvm::LLVMContext> ctx;
   std::unique_ptr<llvm::Module> m;
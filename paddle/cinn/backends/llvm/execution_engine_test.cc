@@ -352,5 +352,55 @@ TEST(ExecutionEngine, call_extern) {
   }
 }
 
+TEST(ExecutionEngine, link_partitions) {
+  ir::Expr M(kM);
+  ir::Expr N(kN);
+
+  Module::Builder builder("module0", cinn::common::DefaultHostTarget());
+  for (const std::string &name : {"add", "sub", "mul"}) {
+    Placeholder<float> x("x", {M, N});
+    Placeholder<float> y("y", {M, N});
+    auto out = Compute(
+        {M, N},
+        [&](Var i, Var j) -> Expr {
+          return name == "add"   ? x(i, j) + y(i, j)
+                 : name == "sub" ? x(i, j) - y(i, j)
+                                 : x(i, j) * y(i, j);
+        },
+        name + "_out");
+    auto stages = CreateStages({out});
+    builder.AddFunction(Lower(name, stages, {x, y, out}));
+  }
+
+  ExecutionOptions options;
+  options.num_compile_threads = 2;
+  auto engine = backends::ExecutionEngine::Create(options);
+  engine->Link(builder.Build());
+  // every partition is linked as an object
+  ASSERT_EQ(engine->GetObjects().size(), 2UL);
+
+  auto _ab_bb_cb_ = CreateTestBuffer();  // NOLINT
+  auto &ab = std::get<0>(_ab_bb_cb_);
+  auto &bb = std::get<1>(_ab_bb_cb_);
+  auto &cb = std::get<2>(_ab_bb_cb_);
+  auto *ad = reinterpret_cast<float *>(ab->memory);
+  auto *bd = reinterpret_cast<float *>(bb->memory);
+  auto *cd = reinterpret_cast<float *>(cb->memory);
+
+  cinn_pod_value_t a_arg(ab), b_arg(bb), c_arg(cb);
+  cinn_pod_value_t args[3] = {a_arg, b_arg, c_arg};
+  for (const std::string &name : {"add", "sub", "mul"}) {
+    auto fn_addr = engine->Lookup(name);
+    ASSERT_NE(fn_addr, nullptr);
+    reinterpret_cast<void (*)(void *, int32_t)>(fn_addr)(args, 3);
+    for (int i = 0; i < kM * kN; i++) {
+      float expected = name == "add"   ? ad[i] + bd[i]
+                       : name == "sub" ? ad[i] - bd[i]
+                                       : ad[i] * bd[i];
+      ASSERT_NEAR(cd[i], expected, 1e-5);
+    }
+  }
+}
+
 }  // namespace backends
 }  // namespace cinn
@@ -20,6 +20,7 @@
 #include "paddle/cinn/hlir/framework/op_lowering_util.h"
 #include "paddle/cinn/hlir/op/external_api_registry.h"
 #include "paddle/cinn/ir/group_schedule/base_group_scheduler.h"
+#include "paddle/cinn/ir/group_schedule/search/x86_schedule_tuner.h"
 #include "paddle/cinn/ir/schedule/ir_schedule.h"
 #include "paddle/cinn/optim/transform_gpu_forloop.h"
 #include "paddle/cinn/runtime/flags.h"
@@ -308,18 +309,22 @@ std::vector<ir::LoweredFunc> OpLowererImpl::PostProcess(
   auto temp_buffers =
       lang::GetTempBuffers(*group_func_arg_tensors, stages, func_body);
   // 3.Building LoweredFunc
-  auto func = ir::_LoweredFunc_::Make(group->GetFuncName(),
-                                      group_func_args,
-                                      ir_sch->GetModule().GetExprs().at(0),
-                                      temp_buffers);
-  if (!done_op_schedule) {
-    func->PrepareBufferCastExprs();
-  }
-  // 4.Apply low level pass
-  if (apply_pass) {
-    func = optim::Optimize(Expr(func), target_, false).as_lowered_func_ref();
+  auto BuildFunc = [&](const ir::Expr& body) {
+    auto func = ir::_LoweredFunc_::Make(
+        group->GetFuncName(), group_func_args, body, temp_buffers);
+    if (!done_op_schedule) {
+      func->PrepareBufferCastExprs();
+    }
+    // 4.Apply low level pass
+    if (apply_pass) {
+      func = optim::Optimize(Expr(func), target_, false).as_lowered_func_ref();
+    }
+    return func;
+  };
+  if (std::holds_alternative<common::X86Arch>(target_.arch.variant())) {
+    ir::search::ApplyTunedX86Schedule(ir_sch, BuildFunc);
   }
-  return {func};
+  return {BuildFunc(ir_sch->GetModule().GetExprs().at(0))};
 }
 
 std::vector<ir::Expr> OpLowererImpl::LowerOps(
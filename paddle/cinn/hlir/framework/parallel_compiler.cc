@@ -32,8 +32,11 @@
 #include "paddle/cinn/hlir/framework/pass.h"
 #include "paddle/cinn/ir/module.h"
 #include "paddle/cinn/runtime/flags.h"
+#include "paddle/cinn/utils/profiler.h"
+#include "paddle/cinn/utils/timer.h"
 
 PD_DECLARE_int32(cinn_parallel_compile_thread);
+PD_DECLARE_int32(cinn_llvm_compile_thread);
 
 namespace cinn {
 namespace hlir {
@@ -104,18 +107,28 @@ void ParallelCompiler::RunTask() {
     VLOG(4) << "Start run task " << idx
             << " on thread: " << std::this_thread::get_id();
     VLOG(4) << "Start lowering on task " << idx;
+    utils::Timer timer;
+    timer.Start();
     CINN_COMPILE_STEP_BEGIN();
+    utils::RecordEvent record_lowering("ParallelCompiler Lowering",
+                                       utils::EventType::kOrdinary);
     tasks_[idx].Lowering();
     CINN_COMPILE_STEP_END(err_msg_level_, idx);
+    VLOG(4) << "Lowering task " << idx << " takes " << timer.Stop() << " ms";
     if (context_->stage == CompilationStage::LOWERING) {
       VLOG(4) << "Just lowering, finish task " << idx
               << " on thread: " << std::this_thread::get_id();
       continue;
     }
     VLOG(4) << "Start CodegenAndJit";
+    timer.Start();
     CINN_COMPILE_STEP_BEGIN();
+    utils::RecordEvent record_codegen("ParallelCompiler CodegenAndJit",
+                                      utils::EventType::kOrdinary);
     tasks_[idx].CodegenAndJit();
     CINN_COMPILE_STEP_END(err_msg_level_, idx);
+    VLOG(4) << "CodegenAndJit task " << idx << " takes " << timer.Stop()
+            << " ms";
     if (context_->stage == CompilationStage::CODEGEN_AND_JIT) {
       VLOG(4) << "Just codegen and jit, finish task " << idx
               << " on thread: " << std::this_thread::get_id();
@@ -302,8 +315,9 @@ void ParallelCompiler::Task::CodegenAndJit() {
 #endif
       },
       [&](std::variant<common::UnknownArch, common::X86Arch, common::ARMArch>) {
-        engine =
-            backends::ExecutionEngine::Create(backends::ExecutionOptions());
+        backends::ExecutionOptions options;
+        options.num_compile_threads = FLAGS_cinn_llvm_compile_thread;
+        engine = backends::ExecutionEngine::Create(options);
         engine->Link<backends::CodeGenX86>(ir_module);
       });
 }
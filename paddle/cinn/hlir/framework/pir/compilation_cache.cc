@@ -59,19 +59,21 @@ pir::CINNKernelInfo BackendResource::GenerateKernelInfo() const {
 }  // namespace pir
 
 bool CompilationCache::Has(const CacheKey& key) const {
+  std::lock_guard<std::mutex> lock(mutex_);
   const bool has_existed = cache_.find(key) != cache_.end();
   VLOG(6) << "Check IsExisted in CompilationCache: " << has_existed << " - "
           << key;
   return has_existed;
 }
 
-const CompilationCache::CacheValue& CompilationCache::Get(
-    const CacheKey& key) const {
+CompilationCache::CacheValue CompilationCache::Get(const CacheKey& key) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = cache_.find(key);
   PADDLE_ENFORCE_EQ(
-      Has(key),
+      it != cache_.end(),
       true,
       ::common::errors::NotFound("%s is not in CompliatonCache.", key));
-  return cache_.at(key);
+  return it->second;
 }
 
 pir::CINNKernelInfo CompilationCache::GetKernelInfo(const CacheKey& key) const {
@@ -80,15 +82,21 @@ pir::CINNKernelInfo CompilationCache::GetKernelInfo(const CacheKey& key) const {
 
 void CompilationCache::Insert(const CacheKey& key, const CacheValue& value) {
   VLOG(6) << "Insert CompilationCache for: " << key;
-  PADDLE_ENFORCE_EQ(Has(key),
-                    false,
-                    ::common::errors::PreconditionNotMet(
-                        "%s is already in CompliatonCache while calling "
-                        "CompilationCache::Insert().",
-                        key));
-  cache_.insert({key, value});
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!cache_.insert({key, value}).second) {
+    VLOG(6) << key << " is already in CompilationCache, compiled by another "
+            << "thread.";
+  }
 }
 
-void CompilationCache::Clear() { cache_.clear(); }
+void CompilationCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cache_.clear();
+}
+
+size_t CompilationCache::Size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cache_.size();
+}
 
 }  // namespace cinn::hlir::framework
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <memory>
+#include <mutex>  // NOLINT
 #include <unordered_map>
 #include "paddle/cinn/backends/compiler.h"
 #include "paddle/cinn/common/macros.h"
@@ -42,6 +43,8 @@ class BackendResource final {
   void* GetHostFuncPtr() const;
   void* GetInferFuncPtr() const;
   void* GetCX86HostFuncPtr() const;
+  const std::string& GetHostFuncName() const { return host_fn_name_; }
+  const std::string& GetInferFuncName() const { return infer_fn_name_; }
   const std::map<int, CINNKernelInfo::ArgDimIdx>& GetIntArgsMap() const {
     return int_args_map_;
   }
@@ -84,21 +87,23 @@ class CompilationResult final {
 
 }  // namespace pir
 
+// The kernels compiled in the process, shared by its threads.
 class CompilationCache {
  public:
   using CacheKey = pir::FusionInfo;
   using CacheValue = std::shared_ptr<pir::CompilationResult>;
 
   static CompilationCache& Instance() {
-    thread_local static CompilationCache instance;
+    static CompilationCache instance;
     return instance;
   }
 
   bool Has(const CacheKey& key) const;
-  const CacheValue& Get(const CacheKey& key) const;
+  CacheValue Get(const CacheKey& key) const;
+  // Keeps the value inserted first, if threads compile the same key.
   void Insert(const CacheKey& key, const CacheValue& value);
   void Clear();
-  size_t Size() const { return cache_.size(); }
+  size_t Size() const;
 
   pir::CINNKernelInfo GetKernelInfo(const CacheKey& key) const;
 
@@ -106,6 +111,7 @@ class CompilationCache {
   CompilationCache() = default;
   CINN_DISALLOW_COPY_AND_ASSIGN(CompilationCache);
 
+  mutable std::mutex mutex_;
   std::unordered_map<CacheKey, CacheValue> cache_;
 };
 
@@ -25,6 +25,7 @@ class AttributeInfo {
       : name_(name), attr_(attr) {}
 
   std::size_t hash() const;
+  void WriteStableKey(std::ostream &os) const;  // NOLINT
   friend std::ostream &operator<<(std::ostream &os, const AttributeInfo &info);
 
  private:
@@ -37,6 +38,7 @@ class ValueInfo {
   explicit ValueInfo(const ::pir::Value &value) : type_(value.type()) {}
 
   std::size_t hash() const;
+  void WriteStableKey(std::ostream &os) const;  // NOLINT
   friend std::ostream &operator<<(std::ostream &os, const ValueInfo &info);
 
  private:
@@ -49,6 +51,7 @@ class OperationInfo {
   explicit OperationInfo(const ::pir::Operation &op);
 
   std::size_t hash() const;
+  void WriteStableKey(std::ostream &os) const;  // NOLINT
   friend std::ostream &operator<<(std::ostream &os, const OperationInfo &info);
 
  private:
@@ -66,6 +69,7 @@ class OpDepInfo {
     return this->upstream_index_ == other.upstream_index_ &&
            this->upstream_hash_ == other.upstream_hash_;
   }
+  size_t upstream_index() const { return upstream_index_; }
 
   std::size_t hash() const;
   friend std::ostream &operator<<(std::ostream &os, const OpDepInfo &info);
@@ -82,6 +86,7 @@ class FusionOpInfo {
       : op_info_(op), inner_deps_(deps) {}
 
   std::size_t hash() const;
+  void WriteStableKey(std::ostream &os) const;  // NOLINT
   friend std::ostream &operator<<(std::ostream &os, const FusionOpInfo &info);
 
  private:
@@ -100,6 +105,10 @@ class FusionInfo {
   FusionInfo(FusionInfo &&) = default;
 
   std::size_t hash() const;
+  // Unlike hash(), which depends on the addresses of the types and the
+  // attributes, the key is the same in every process, for the persistent
+  // compilation cache.
+  std::string StableKey() const;
 
   bool operator==(const FusionInfo &other) const {
     return this->hash() == other.hash();
@@ -0,0 +1,278 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/cinn/hlir/framework/pir/persistent_compilation_cache.h"
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/Host.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "paddle/cinn/hlir/framework/visualize_helper.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/framework/commit.h"
+
+PD_DECLARE_bool(enable_cinn_compile_cache);
+PD_DECLARE_string(cinn_compile_cache_dir);
+
+namespace cinn::hlir::framework {
+
+namespace {
+
+constexpr char kEntryMagic[] = "CINN_COMPILATION_CACHE_V1";
+
+uint64_t Fnv1aHash(const std::string& str) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : str) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+void WriteString(std::ostream& os, const std::string& str) {
+  uint64_t size = str.size();
+  os.write(reinterpret_cast<const char*>(&size), sizeof(size));
+  os.write(str.data(), size);
+}
+
+bool ReadString(std::istream& is, std::string* str) {
+  uint64_t size = 0;
+  // an object is far smaller, unless the entry is broken
+  if (!is.read(reinterpret_cast<char*>(&size), sizeof(size)) ||
+      size > (1ULL << 32)) {
+    return false;
+  }
+  str->resize(size);
+  return static_cast<bool>(is.read(&(*str)[0], size));
+}
+
+template <typename T>
+void WritePod(std::ostream& os, T value) {
+  os.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool ReadPod(std::istream& is, T* value) {
+  return static_cast<bool>(is.read(reinterpret_cast<char*>(value), sizeof(T)));
+}
+
+}  // namespace
+
+bool WriteCompilationCacheEntry(const std::string& path,
+                                const CompilationCacheEntry& entry) {
+  std::ostringstream tmp_suffix;
+  tmp_suffix << ".tmp." << getpid() << "." << std::this_thread::get_id();
+  const std::string tmp_path = path + tmp_suffix.str();
+  {
+    std::ofstream os(tmp_path, std::ios::binary);
+    WriteString(os, entry.key);
+    WriteString(os, entry.host_fn_name);
+    WriteString(os, entry.infer_fn_name);
+    WritePod<uint64_t>(os, entry.int_args_map.size());
+    for (const auto& [arg, arg_dim_idx] : entry.int_args_map) {
+      WritePod(os, arg);
+      WritePod(os, arg_dim_idx.arg_idx);
+      WritePod(os, arg_dim_idx.dim_idx);
+    }
+    WritePod<uint64_t>(os, entry.objects.size());
+    for (const auto& object : entry.objects) {
+      WriteString(os, object);
+    }
+    if (!os.good()) {
+      LOG(WARNING) << "Failed to write the compilation cache entry "
+                   << tmp_path;
+      os.close();
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG(WARNING) << "Failed to rename " << tmp_path << " to " << path;
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool ReadCompilationCacheEntry(const std::string& path,
+                               const std::string& key,
+                               CompilationCacheEntry* entry) {
+  std::ifstream is(path, std::ios::binary);
+  if (!is.is_open()) {
+    VLOG(4) << "No compilation cache entry " << path;
+    return false;
+  }
+  uint64_t int_args_num = 0;
+  if (!ReadString(is, &entry->key) || entry->key != key ||
+      !ReadString(is, &entry->host_fn_name) ||
+      !ReadString(is, &entry->infer_fn_name) ||
+      !ReadPod(is, &int_args_num)) {
+    VLOG(4) << "The compilation cache entry " << path
+            << " does not match the key";
+    return false;
+  }
+  entry->int_args_map.clear();
+  for (uint64_t i = 0; i < int_args_num; ++i) {
+    int arg = 0;
+    pir::CINNKernelInfo::ArgDimIdx arg_dim_idx;
+    if (!ReadPod(is, &arg) || !ReadPod(is, &arg_dim_idx.arg_idx) ||
+        !ReadPod(is, &arg_dim_idx.dim_idx)) {
+      LOG(WARNING) << "The compilation cache entry " << path
+                   << " is truncated.";
+      return false;
+    }
+    entry->int_args_map[arg] = arg_dim_idx;
+  }
+  uint64_t object_num = 0;
+  if (!ReadPod(is, &object_num) || object_num == 0 || object_num > 1024) {
+    LOG(WARNING) << "The compilation cache entry " << path
+                 << " is truncated.";
+    return false;
+  }
+  entry->objects.resize(object_num);
+  for (auto& object : entry->objects) {
+    if (!ReadString(is, &object)) {
+      LOG(WARNING) << "The compilation cache entry " << path
+                   << " is truncated.";
+      return false;
+    }
+  }
+  return true;
+}
+
+PersistentCompilationCache::PersistentCompilationCache() {
+  std::ostringstream os;
+  os << kEntryMagic;
+  // the commit too, the objects calling into the runtime of this build
+  os << " paddle " << paddle::framework::paddle_version() << " "
+     << paddle::framework::paddle_commit();
+  os << " llvm " << LLVM_VERSION_STRING;
+  os << " cpu " << llvm::sys::getHostCPUName().str();
+  llvm::StringMap<bool> features;
+  if (llvm::sys::getHostCPUFeatures(features)) {
+    // in order, the StringMap being unordered
+    std::map<std::string, bool> sorted_features;
+    for (const auto& feature : features) {
+      sorted_features.emplace(feature.getKey().str(), feature.getValue());
+    }
+    for (const auto& [name, enabled] : sorted_features) {
+      os << (enabled ? " +" : " -") << name;
+    }
+  }
+  version_ = os.str();
+}
+
+bool PersistentCompilationCache::Enabled(const Target& target) const {
+  // The CUDA kernels are not saved, only the x86 ones.
+  return FLAGS_enable_cinn_compile_cache &&
+         !FLAGS_cinn_compile_cache_dir.empty() &&
+         std::holds_alternative<common::X86Arch>(target.arch.variant());
+}
+
+std::string PersistentCompilationCache::Key(const pir::FusionInfo& info) const {
+  return version_ + "\n" + info.StableKey();
+}
+
+std::string PersistentCompilationCache::EntryPath(
+    const std::string& key) const {
+  char name[32];
+  snprintf(name,
+           sizeof(name),
+           "%016llx.bin",
+           static_cast<unsigned long long>(Fnv1aHash(key)));  // NOLINT
+  return FLAGS_cinn_compile_cache_dir + "/" + name;
+}
+
+std::shared_ptr<pir::CompilationResult> PersistentCompilationCache::Load(
+    const pir::FusionInfo& info, const Target& target) const {
+  if (!Enabled(target)) {
+    return nullptr;
+  }
+  const std::string key = Key(info);
+  const std::string path = EntryPath(key);
+  CompilationCacheEntry entry;
+  if (!ReadCompilationCacheEntry(path, key, &entry)) {
+    return nullptr;
+  }
+
+  auto backend_resource =
+      std::make_shared<pir::BackendResource>(target,
+                                             entry.host_fn_name,
+                                             entry.infer_fn_name,
+                                             entry.int_args_map);
+  for (const auto& object : entry.objects) {
+    if (!backend_resource->GetBackendCompiler()->AddObject(object)) {
+      return nullptr;
+    }
+  }
+  auto result = std::make_shared<pir::CompilationResult>(target);
+  result->SetBackendResource(backend_resource);
+  try {
+    // links the objects, and checks that they have the functions
+    result->GetKernelInfo();
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Failed to link the compilation cache entry " << path
+                 << ": " << e.what();
+    return nullptr;
+  }
+  VLOG(4) << "Loaded " << info << " from " << path;
+  return result;
+}
+
+void PersistentCompilationCache::Save(
+    const pir::FusionInfo& info,
+    const Target& target,
+    const pir::CompilationResult& result) const {
+  if (!Enabled(target)) {
+    return;
+  }
+  const auto& backend_resource = result.GetBackendResource();
+  if (backend_resource == nullptr) {
+    return;
+  }
+  std::vector<std::string> objects =
+      backend_resource->GetBackendCompiler()->GetObjects();
+  if (objects.empty()) {
+    VLOG(4) << "No object was compiled for " << info;
+    return;
+  }
+  if (!MakeDirectory(FLAGS_cinn_compile_cache_dir,
+                     S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH)) {
+    return;
+  }
+
+  CompilationCacheEntry entry;
+  entry.key = Key(info);
+  entry.host_fn_name = backend_resource->GetHostFuncName();
+  entry.infer_fn_name = backend_resource->GetInferFuncName();
+  entry.int_args_map = backend_resource->GetIntArgsMap();
+  entry.objects = std::move(objects);
+  const std::string path = EntryPath(entry.key);
+  if (!WriteCompilationCacheEntry(path, entry)) {
+    return;
+  }
+  VLOG(4) << "Saved " << info << " into " << path;
+}
+
+}  // namespace cinn::hlir::framework
@@ -0,0 +1,89 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "paddle/cinn/common/macros.h"
+#include "paddle/cinn/common/target.h"
+#include "paddle/cinn/hlir/framework/pir/compilation_cache.h"
+#include "paddle/cinn/hlir/framework/pir/fusion_info.h"
+
+namespace cinn::hlir::framework {
+
+// The content of an entry of PersistentCompilationCache.
+struct CompilationCacheEntry {
+  std::string key;
+  std::string host_fn_name;
+  std::string infer_fn_name;
+  std::map<int, pir::CINNKernelInfo::ArgDimIdx> int_args_map;
+  std::vector<std::string> objects;
+};
+
+// Writes entry into path through a temporary file, renamed at the end.
+bool WriteCompilationCacheEntry(const std::string& path,
+                                const CompilationCacheEntry& entry);
+
+// Reads the entry in path. Fails if there is none, if it is truncated or if
+// its key is not key, e.g. it was saved by another version.
+bool ReadCompilationCacheEntry(const std::string& path,
+                               const std::string& key,
+                               CompilationCacheEntry* entry);
+
+// The x86 kernels compiled by CINN, saved in FLAGS_cinn_compile_cache_dir
+// so that the later processes link their objects rather than lowering and
+// compiling the fusion groups again.
+//
+// An entry is a file named after the hash of its key, which is the stable
+// key of the FusionInfo, the version and commit of Paddle, the version of
+// LLVM and the host CPU.
+// It holds the key, to tell the collisions apart, the names of the
+// functions, the int_args_map and the objects compiled by the JIT. The
+// entries are written to a temporary file and renamed, so the processes
+// sharing a directory never read a partial one.
+class PersistentCompilationCache {
+ public:
+  static PersistentCompilationCache& Instance() {
+    static PersistentCompilationCache instance;
+    return instance;
+  }
+
+  bool Enabled(const Target& target) const;
+
+  // Returns nullptr if there is no entry for info, or it can't be linked.
+  std::shared_ptr<pir::CompilationResult> Load(const pir::FusionInfo& info,
+                                               const Target& target) const;
+
+  void Save(const pir::FusionInfo& info,
+            const Target& target,
+            const pir::CompilationResult& result) const;
+
+  const std::string& version() const { return version_; }
+
+ private:
+  PersistentCompilationCache();
+  CINN_DISALLOW_COPY_AND_ASSIGN(PersistentCompilationCache);
+
+  std::string Key(const pir::FusionInfo& info) const;
+  std::string EntryPath(const std::string& key) const;
+
+  // the version and commit of Paddle, the version of LLVM and the host CPU
+  std::string version_;
+};
+
+}  // namespace cinn::hlir::framework
@@ -15,6 +15,7 @@
 #include "paddle/cinn/hlir/framework/pir_compiler.h"
 #include "paddle/cinn/ir/group_schedule/config/schedule_config_manager.h"
 
+#include "paddle/cinn/hlir/framework/pir/persistent_compilation_cache.h"
 #include "paddle/cinn/hlir/framework/pir/utils.h"
 #include "paddle/cinn/runtime/arch_device.h"
 #include "paddle/cinn/utils/multi_threading.h"
@@ -39,6 +40,11 @@ class CompilationContextMapper {
     return compilation_results_;
   }
 
+  // The FusionInfo of the index-th unique compilation context.
+  const pir::FusionInfo& UniqueFusionInfo(size_t index) const {
+    return fusion_infos_[mapper_index_[index]];
+  }
+
   std::vector<pir::CINNKernelInfo> RecoverKernelInfos();
   void UpdateGlobalCache();
   void SetFinalize(bool val) { is_finalized_ = val; }
@@ -80,12 +86,19 @@ std::vector<pir::CINNKernelInfo> PirCompiler::Build(
     // https://developer.nvidia.com/blog/cuda-pro-tip-always-set-current-device-avoid-multithreading-bugs/
     // for details.
     const auto device_id = runtime::GetArchDevice(target_);
+    const auto& persistent_cache = PersistentCompilationCache::Instance();
     auto worker_fn = [&](int index) {
       runtime::SetArchDevice(target_, device_id);
+      const auto& fusion_info = ctx_mapper.UniqueFusionInfo(index);
+      compilation_results[index] = persistent_cache.Load(fusion_info, target_);
+      if (compilation_results[index] != nullptr) {
+        return;
+      }
       CompilationTask task(&group_compilation_contexts[index]);
       compilation_results[index] = task();
       // Triggering llvm compilation in thread
       compilation_results[index]->GetKernelInfo();
+      persistent_cache.Save(fusion_info, target_, *compilation_results[index]);
     };
     utils::parallel_run(worker_fn,
                         utils::SequenceDispatcher(0, task_size),
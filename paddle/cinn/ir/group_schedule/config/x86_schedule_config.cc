@@ -0,0 +1,211 @@
+// Copyright (c) 2024 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/cinn/ir/group_schedule/config/x86_schedule_config.h"
+
+#include <set>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "paddle/cinn/ir/ir_analyzer/ir_analyzer.h"
+#include "paddle/cinn/ir/utils/ir_nodes_collector.h"
+
+namespace cinn {
+namespace ir {
+
+namespace {
+
+struct BlockLoopVars {
+  std::unordered_set<std::string> spatial;
+  std::unordered_set<std::string> reduce;
+};
+
+// The names of the loop vars the spatial and the reduce iter vars of the
+// block are bound to.
+BlockLoopVars GetBlockLoopVars(const ir::Expr& block) {
+  const auto* realize = block.As<ir::ScheduleBlockRealize>();
+  const auto* schedule_block = realize->schedule_block.As<ir::ScheduleBlock>();
+  BlockLoopVars loop_vars;
+  for (size_t i = 0; i < schedule_block->iter_vars.size() &&
+                     i < realize->iter_values.size();
+       ++i) {
+    std::unordered_set<std::string>& names =
+        schedule_block->iter_vars[i]->is_reduce_axis ? loop_vars.reduce
+                                                     : loop_vars.spatial;
+    ir::ir_utils::CollectIRNodesWithoutTensor(
+        realize->iter_values[i], [&](const ir::Expr* x) {
+          if (x->as_var()) {
+            names.insert(x->as_var()->name);
+          }
+          return false;
+        });
+  }
+  return loop_vars;
+}
+
+std::string GetLoopVarName(const ir::Expr& loop) {
+  return loop.As<ir::For>()->loop_var->name;
+}
+
+bool IsSerialConstantLoop(const ir::Expr& loop) {
+  const ir::For* for_node = loop.As<ir::For>();
+  return for_node != nullptr && for_node->is_serial() &&
+         for_node->min.is_constant() && for_node->min.get_constant() == 0 &&
+         for_node->extent.is_constant();
+}
+
+int64_t GetConstantExtent(const ir::Expr& loop) {
+  return static_cast<int64_t>(loop.As<ir::For>()->extent.get_constant());
+}
+
+// Whether the block is the only statement in the body of the loop.
+bool IsOnlyBlockOfLoop(const ir::Expr& loop, const std::string& block_name) {
+  ir::Expr body = loop.As<ir::For>()->body;
+  if (body.As<ir::Block>()) {
+    if (body.As<ir::Block>()->stmts.size() != 1) {
+      return false;
+    }
+    body = body.As<ir::Block>()->stmts[0];
+  }
+  return body.As<ir::ScheduleBlockRealize>() &&
+         analyzer::GetBlockName(body) == block_name;
+}
+
+std::string GetStoreTypeStr(const ir::Expr& block) {
+  std::set<ir::Expr> stores = ir::ir_utils::CollectIRNodesWithoutTensor(
+      block.As<ir::ScheduleBlockRealize>()->schedule_block,
+      [](const ir::Expr* x) { return x->As<ir::Store>() != nullptr; },
+      /* uniq_target = */ true);
+  if (stores.empty()) {
+    return "?";
+  }
+  return common::Type2Str(stores.begin()->As<ir::Store>()->tensor.type());
+}
+
+}  // namespace
+
+std::string X86ScheduleConfig::ToString() const {
+  std::ostringstream os;
+  os << "tile_factor=" << tile_factor
+     << ", vectorize_factor=" << vectorize_factor
+     << ", parallel=" << (parallel ? "true" : "false");
+  return os.str();
+}
+
+std::string X86ScheduleSignature(const ir::IRSchedule& ir_sch) {
+  std::ostringstream os;
+  std::unordered_map<std::string, int> root_loop_ids;
+  for (const ir::Expr& block : ir_sch.GetAllBlocks()) {
+    BlockLoopVars loop_vars = GetBlockLoopVars(block);
+    std::vector<ir::Expr> loops = ir_sch.GetLoops(block);
+    os << GetStoreTypeStr(block) << "[";
+    for (size_t i = 0; i < loops.size(); ++i) {
+      const ir::For* for_node = loops[i].As<ir::For>();
+      os << (i > 0 ? "," : "")
+         << (loop_vars.reduce.count(for_node->loop_var->name) ? "R" : "S");
+      if (for_node->extent.is_constant()) {
+        os << GetConstantExtent(loops[i]);
+      } else {
+        os << "?";
+      }
+    }
+    os << "]";
+    if (!loops.empty()) {
+      const std::string root = GetLoopVarName(loops[0]);
+      if (root_loop_ids.count(root) == 0) {
+        const int id = root_loop_ids.size();
+        root_loop_ids[root] = id;
+      }
+      os << "@" << root_loop_ids.at(root);
+    }
+    os << ";";
+  }
+  return os.str();
+}
+
+void ApplyX86ScheduleConfig(const X86ScheduleConfig& config,
+                            ir::IRSchedule* ir_sch) {
+  if (config.IsDefault()) {
+    return;
+  }
+  std::vector<std::string> block_names;
+  for (const ir::Expr& block : ir_sch->GetAllBlocks()) {
+    block_names.push_back(analyzer::GetBlockName(block));
+  }
+
+  // 1. Vectorize or tile the innermost loop of each block. The loop is split
+  // before being vectorized, which leaves the outer loop to run in parallel.
+  for (const std::string& block_name : block_names) {
+    std::vector<ir::Expr> loops = ir_sch->GetLoops(block_name);
+    if (loops.empty() || !IsSerialConstantLoop(loops.back()) ||
+        !IsOnlyBlockOfLoop(loops.back(), block_name)) {
+      continue;
+    }
+    const ir::Expr inner = loops.back();
+    const std::string var_name = GetLoopVarName(inner);
+    const int64_t extent = GetConstantExtent(inner);
+    BlockLoopVars loop_vars = GetBlockLoopVars(ir_sch->GetBlock(block_name));
+    const bool is_spatial = loop_vars.reduce.count(var_name) == 0 &&
+                            loop_vars.spatial.count(var_name) > 0;
+    if (is_spatial && config.vectorize_factor > 1 &&
+        extent % config.vectorize_factor == 0) {
+      std::vector<ir::Expr> splited = ir_sch->Split(
+          inner, {-1, static_cast<int>(config.vectorize_factor)});
+      ir_sch->Vectorize(splited.back(), config.vectorize_factor);
+    } else if (config.tile_factor > 1 && extent > config.tile_factor &&
+               extent % config.tile_factor == 0) {
+      std::vector<ir::Expr> splited =
+          ir_sch->Split(inner, {-1, static_cast<int>(config.tile_factor)});
+      ir_sch->Unroll(splited.back());
+    }
+  }
+  if (!config.parallel) {
+    return;
+  }
+
+  // 2. Run an outermost loop in parallel if every block in it writes
+  // different elements in each iteration, i.e. the loop is spatial for all.
+  std::vector<std::string> root_loops;
+  std::unordered_map<std::string, std::string> first_blocks;
+  std::unordered_map<std::string, bool> parallelizable;
+  for (const std::string& block_name : block_names) {
+    std::vector<ir::Expr> loops = ir_sch->GetLoops(block_name);
+    if (loops.empty()) {
+      continue;
+    }
+    const std::string root = GetLoopVarName(loops[0]);
+    BlockLoopVars loop_vars = GetBlockLoopVars(ir_sch->GetBlock(block_name));
+    const bool legal = IsSerialConstantLoop(loops[0]) &&
+                       GetConstantExtent(loops[0]) > 1 &&
+                       loop_vars.reduce.count(root) == 0 &&
+                       loop_vars.spatial.count(root) > 0;
+    if (parallelizable.count(root) == 0) {
+      root_loops.push_back(root);
+      first_blocks[root] = block_name;
+      parallelizable[root] = legal;
+    } else {
+      parallelizable[root] = parallelizable[root] && legal;
+    }
+  }
+  for (const std::string& root : root_loops) {
+    if (parallelizable.at(root)) {
+      ir_sch->Parallel(ir_sch->GetLoops(first_blocks.at(root)).front());
+    }
+  }
+}
+
+}  // namespace ir
+}  // namespace cinn
@@ -0,0 +1,65 @@
+// Copyright (c) 2024 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "paddle/cinn/ir/schedule/ir_schedule.h"
+
+namespace cinn {
+namespace ir {
+
+/**
+ * The loop schedule of a fusion group on x86, on top of the loop alignment
+ * and fusion done by the group scheduler. The default one changes nothing.
+ */
+struct X86ScheduleConfig {
+  // The innermost loop of a block which is not vectorized is split by it, and
+  // the inner loop is unrolled. 0 not to split.
+  int64_t tile_factor{0};
+  // The innermost spatial loop of a block is vectorized by it. 0 not to
+  // vectorize.
+  int64_t vectorize_factor{0};
+  // Whether the outermost loops which are spatial for all the blocks in them
+  // are run in parallel.
+  bool parallel{false};
+
+  bool IsDefault() const {
+    return tile_factor <= 1 && vectorize_factor <= 1 && !parallel;
+  }
+
+  bool operator==(const X86ScheduleConfig& other) const {
+    return tile_factor == other.tile_factor &&
+           vectorize_factor == other.vectorize_factor &&
+           parallel == other.parallel;
+  }
+
+  std::string ToString() const;
+};
+
+/**
+ * The shape signature of the fusion group scheduled by ir_sch, which are the
+ * type and loop extents of each block, marked spatial(S) or reduce(R), and the
+ * outermost loop it is in. The groups of the same signature share a schedule.
+ */
+std::string X86ScheduleSignature(const ir::IRSchedule& ir_sch);
+
+// Applies the config to the blocks of ir_sch, skipping the loops it is not
+// legal or not applicable on, such as vectorizing a reduce loop.
+void ApplyX86ScheduleConfig(const X86ScheduleConfig& config,
+                            ir::IRSchedule* ir_sch);
+
+}  // namespace ir
+}  // namespace cinn
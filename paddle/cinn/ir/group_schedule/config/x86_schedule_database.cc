@@ -0,0 +1,137 @@
+// Copyright (c) 2024 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/cinn/ir/group_schedule/config/x86_schedule_database.h"
+
+#include <google/protobuf/util/json_util.h>
+#include <llvm/Support/Host.h>
+
+#include <fstream>
+
+#include "paddle/cinn/ir/group_schedule/config/tile_config_desc.pb.h"
+#include "paddle/common/enforce.h"
+#include "paddle/common/flags.h"
+
+PD_DECLARE_string(cinn_x86_schedule_database);
+
+namespace cinn {
+namespace ir {
+
+namespace {
+
+// The schedules are only reused on the CPU they are tuned on.
+const std::string& HostCPUName() {
+  static const std::string cpu_name = llvm::sys::getHostCPUName().str();
+  return cpu_name;
+}
+
+}  // namespace
+
+X86ScheduleDatabase& X86ScheduleDatabase::Instance() {
+  static X86ScheduleDatabase instance;
+  return instance;
+}
+
+void X86ScheduleDatabase::LoadFromFile() {
+  if (loaded_) {
+    return;
+  }
+  loaded_ = true;
+  const std::string& file_path = FLAGS_cinn_x86_schedule_database;
+  if (file_path.empty()) {
+    return;
+  }
+  std::ifstream is(file_path);
+  if (!is.good()) {
+    VLOG(3) << "The x86 schedule database " << file_path
+            << " does not exist yet.";
+    return;
+  }
+  for (std::string line; std::getline(is, line);) {
+    if (line.empty()) {
+      continue;
+    }
+    group_schedule::config::proto::X86ScheduleData data;
+    auto status = google::protobuf::util::JsonStringToMessage(line, &data);
+    if (!status.ok()) {
+      LOG(WARNING) << "Skip the broken line of the x86 schedule database "
+                   << file_path << ": " << line;
+      continue;
+    }
+    if (data.cpu() != HostCPUName()) {
+      continue;
+    }
+    X86ScheduleConfig config;
+    config.tile_factor = data.config().tile_factor();
+    config.vectorize_factor = data.config().vectorize_factor();
+    config.parallel = data.config().parallel();
+    // the later lines are tuned later, which take precedence
+    configs_[data.signature()] = config;
+  }
+  VLOG(3) << "Load " << configs_.size() << " x86 schedules from " << file_path;
+}
+
+bool X86ScheduleDatabase::Empty() {
+  std::lock_guard<std::mutex> lock(mu_);
+  LoadFromFile();
+  return configs_.empty();
+}
+
+std::optional<X86ScheduleConfig> X86ScheduleDatabase::GetConfig(
+    const std::string& signature) {
+  std::lock_guard<std::mutex> lock(mu_);
+  LoadFromFile();
+  auto iter = configs_.find(signature);
+  if (iter == configs_.end()) {
+    return std::nullopt;
+  }
+  return iter->second;
+}
+
+void X86ScheduleDatabase::AddConfig(const std::string& signature,
+                                    const X86ScheduleConfig& config,
+                                    double cost_ms) {
+  std::lock_guard<std::mutex> lock(mu_);
+  LoadFromFile();
+  configs_[signature] = config;
+  const std::string& file_path = FLAGS_cinn_x86_schedule_database;
+  if (file_path.empty()) {
+    return;
+  }
+
+  group_schedule::config::proto::X86ScheduleData data;
+  data.set_signature(signature);
+  data.set_cpu(HostCPUName());
+  data.mutable_config()->set_tile_factor(config.tile_factor);
+  data.mutable_config()->set_vectorize_factor(config.vectorize_factor);
+  data.mutable_config()->set_parallel(config.parallel);
+  data.set_cost_ms(cost_ms);
+  std::string json_string;
+  auto status = google::protobuf::util::MessageToJsonString(data, &json_string);
+  PADDLE_ENFORCE_EQ(
+      status.ok(),
+      true,
+      ::common::errors::InvalidArgument(
+          "Failed to serialize the x86 schedule of %s to JSON.", signature));
+  std::ofstream os(file_path, std::ofstream::app);
+  if (!os.good()) {
+    LOG(WARNING) << "Cannot open the x86 schedule database " << file_path
+                 << " to write.";
+    return;
+  }
+  os << json_string << std::endl;
+}
+
+}  // namespace ir
+}  // namespace cinn
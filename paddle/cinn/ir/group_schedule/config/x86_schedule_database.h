@@ -0,0 +1,61 @@
+// Copyright (c) 2024 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "paddle/cinn/ir/group_schedule/config/x86_schedule_config.h"
+
+namespace cinn {
+namespace ir {
+
+/**
+ * The x86 schedules tuned on the local machine, keyed by the shape signature
+ * of the fusion groups. If FLAGS_cinn_x86_schedule_database is set, the
+ * schedules tuned on the same CPU are loaded from the file on the first use,
+ * and every schedule added is appended to it, so that later compilations
+ * reuse them without measuring again.
+ */
+class X86ScheduleDatabase {
+ public:
+  static X86ScheduleDatabase& Instance();
+
+  bool Empty();
+
+  std::optional<X86ScheduleConfig> GetConfig(const std::string& signature);
+
+  void AddConfig(const std::string& signature,
+                 const X86ScheduleConfig& config,
+                 double cost_ms);
+
+ private:
+  X86ScheduleDatabase() = default;
+  X86ScheduleDatabase(const X86ScheduleDatabase&) = delete;
+  void operator=(const X86ScheduleDatabase&) = delete;
+
+  // Requires mu_ to be held.
+  void LoadFromFile();
+
+ private:
+  std::mutex mu_;
+  bool loaded_{false};
+  std::unordered_map<std::string, X86ScheduleConfig> configs_;
+};
+
+}  // namespace ir
+}  // namespace cinn
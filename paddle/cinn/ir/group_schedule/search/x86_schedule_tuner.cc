@@ -0,0 +1,355 @@
+// Copyright (c) 2024 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/cinn/ir/group_schedule/search/x86_schedule_tuner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_set>
+
+#include "paddle/cinn/backends/llvm/codegen_x86.h"
+#include "paddle/cinn/backends/llvm/execution_engine.h"
+#include "paddle/cinn/common/target.h"
+#include "paddle/cinn/ir/group_schedule/config/x86_schedule_database.h"
+#include "paddle/cinn/ir/module.h"
+#include "paddle/cinn/runtime/cinn_runtime.h"
+#include "paddle/cinn/runtime/intrinsic.h"
+#include "paddle/cinn/utils/string.h"
+#include "paddle/cinn/utils/timer.h"
+#include "paddle/common/flags.h"
+
+PD_DECLARE_bool(cinn_x86_schedule_tuning);
+
+namespace cinn {
+namespace ir {
+namespace search {
+
+namespace {
+
+using X86Kernel = void (*)(void*, int32_t);
+
+// The groups lowered on several threads are measured one by one, otherwise
+// the candidates would compete for the cores.
+std::mutex& MeasureMutex() {
+  static std::mutex mu;
+  return mu;
+}
+
+bool IsSupportedType(const Type& type) {
+  return type.is_float(32) || type.is_float(64) || type.is_int(8) ||
+         type.is_int(16) || type.is_int(32) || type.is_int(64) ||
+         type.is_uint(8) || type.is_bool();
+}
+
+template <typename T>
+void FillBuffer(cinn_buffer_t* buffer, T scale) {
+  T* data = reinterpret_cast<T*>(buffer->memory);
+  for (uint64_t i = 0; i < buffer->num_elements(); ++i) {
+    data[i] = static_cast<T>(1 + i % 7) / scale;
+  }
+}
+
+// Fills the buffer with small positive values, which are valid inputs of most
+// operators, e.g. log and division.
+void FillBuffer(const Type& type, cinn_buffer_t* buffer) {
+  if (type.is_float(32)) {
+    FillBuffer<float>(buffer, 8.f);
+  } else if (type.is_float(64)) {
+    FillBuffer<double>(buffer, 8.);
+  } else if (type.is_int(8)) {
+    FillBuffer<int8_t>(buffer, 1);
+  } else if (type.is_int(16)) {
+    FillBuffer<int16_t>(buffer, 1);
+  } else if (type.is_int(32)) {
+    FillBuffer<int32_t>(buffer, 1);
+  } else if (type.is_int(64)) {
+    FillBuffer<int64_t>(buffer, 1);
+  } else {
+    auto* data = reinterpret_cast<uint8_t*>(buffer->memory);
+    for (uint64_t i = 0; i < buffer->num_elements(); ++i) {
+      data[i] = i % 2;
+    }
+  }
+}
+
+template <typename T>
+bool AllClose(const std::string& actual, const std::string& expected) {
+  const T* actual_data = reinterpret_cast<const T*>(actual.data());
+  const T* expected_data = reinterpret_cast<const T*>(expected.data());
+  for (size_t i = 0; i < expected.size() / sizeof(T); ++i) {
+    const double x = actual_data[i];
+    const double y = expected_data[i];
+    if (std::isnan(x) && std::isnan(y)) {
+      continue;
+    }
+    // the vectorized math functions may differ in the last bits
+    if (!(std::abs(x - y) <= 1e-5 + 1e-4 * std::abs(y))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The host buffers of the arguments of a lowered function, shared by the
+// candidates as they have the same arguments.
+class HostArgs {
+ public:
+  HostArgs() = default;
+  HostArgs(const HostArgs&) = delete;
+  void operator=(const HostArgs&) = delete;
+
+  ~HostArgs() {
+    for (cinn_buffer_t* buffer : buffers_) {
+      cinn_buffer_free(nullptr, buffer);
+      cinn_buffer_t::delete_(buffer);
+    }
+  }
+
+  // Returns false if any argument is not a buffer of a static shape and a
+  // supported type.
+  bool Init(const ir::LoweredFunc& func) {
+    for (const ir::Argument& arg : func->args) {
+      if (!arg.is_buffer()) {
+        return false;
+      }
+      const ir::Buffer& buffer = arg.buffer_arg();
+      const Type type = buffer->dtype.ElementOf();
+      if (!IsSupportedType(type)) {
+        return false;
+      }
+      std::vector<int> shape;
+      for (const ir::Expr& dim : buffer->shape) {
+        if (!dim.is_constant()) {
+          return false;
+        }
+        shape.push_back(static_cast<int>(dim.get_constant()));
+      }
+      if (shape.empty()) {
+        shape.push_back(1);
+      }
+      cinn_buffer_t* host_buffer =
+          cinn_buffer_t::new_(cinn_device_kind_t::cinn_x86_device,
+                              runtime::ToRuntimeType(type),
+                              shape,
+                              32);
+      cinn_buffer_malloc(nullptr, host_buffer);
+      buffers_.push_back(host_buffer);
+      types_.push_back(type);
+      is_output_.push_back(arg.is_output());
+      FillBuffer(type, host_buffer);
+      pod_args_.emplace_back(host_buffer);
+    }
+    return true;
+  }
+
+  void Run(X86Kernel kernel) {
+    kernel(pod_args_.data(), static_cast<int32_t>(pod_args_.size()));
+  }
+
+  // Fills the outputs again, so that the elements a kernel does not write
+  // are caught.
+  void ResetOutputs() {
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+      if (is_output_[i]) {
+        FillBuffer(types_[i], buffers_[i]);
+      }
+    }
+  }
+
+  std::vector<std::string> GetOutputs() const {
+    std::vector<std::string> outputs;
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+      if (is_output_[i]) {
+        outputs.emplace_back(reinterpret_cast<const char*>(buffers_[i]->memory),
+                             buffers_[i]->memory_size);
+      }
+    }
+    return outputs;
+  }
+
+  bool OutputsMatch(const std::vector<std::string>& expected) const {
+    std::vector<std::string> actual = GetOutputs();
+    size_t output_idx = 0;
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+      if (!is_output_[i]) {
+        continue;
+      }
+      const std::string& x = actual[output_idx];
+      const std::string& y = expected[output_idx];
+      ++output_idx;
+      bool match = x.size() == y.size();
+      if (match && types_[i].is_float(32)) {
+        match = AllClose<float>(x, y);
+      } else if (match && types_[i].is_float(64)) {
+        match = AllClose<double>(x, y);
+      } else if (match) {
+        match = x == y;
+      }
+      if (!match) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  std::vector<cinn_buffer_t*> buffers_;
+  std::vector<Type> types_;
+  std::vector<bool> is_output_;
+  std::vector<cinn_pod_value_t> pod_args_;
+};
+
+// The engine owns the kernel, which must outlive its runs.
+X86Kernel Compile(const ir::LoweredFunc& func,
+                  std::unique_ptr<backends::ExecutionEngine>* engine) {
+  ir::Module::Builder builder(common::UniqName("x86_tuning_module"),
+                              common::DefaultHostTarget());
+  builder.AddFunction(func);
+  *engine = backends::ExecutionEngine::Create(backends::ExecutionOptions());
+  (*engine)->Link<backends::CodeGenX86>(builder.Build());
+  return reinterpret_cast<X86Kernel>((*engine)->Lookup(func->name));
+}
+
+// The shortest time of a run in milliseconds, which is the least disturbed.
+double MeasureKernel(X86Kernel kernel, int warmup, int repeat, HostArgs* args) {
+  for (int i = 0; i < warmup; ++i) {
+    args->Run(kernel);
+  }
+  double cost_ms = std::numeric_limits<double>::max();
+  utils::Timer timer;
+  for (int i = 0; i < repeat; ++i) {
+    timer.Start();
+    args->Run(kernel);
+    cost_ms = std::min<double>(cost_ms, timer.Stop());
+  }
+  return cost_ms;
+}
+
+}  // namespace
+
+std::vector<X86ScheduleConfig> X86ScheduleTuner::GenerateCandidates() const {
+  std::vector<X86ScheduleConfig> candidates;
+  for (bool parallel : {false, true}) {
+    for (int64_t vectorize_factor : {0, 4, 8, 16}) {
+      for (int64_t tile_factor : {0, 4, 8}) {
+        X86ScheduleConfig config;
+        config.tile_factor = tile_factor;
+        config.vectorize_factor = vectorize_factor;
+        config.parallel = parallel;
+        candidates.push_back(config);
+      }
+    }
+  }
+  return candidates;
+}
+
+std::optional<X86TuningResult> X86ScheduleTuner::Tune(
+    const ir::IRSchedule& ir_sch, const X86FuncBuilder& func_builder) const {
+  std::lock_guard<std::mutex> lock(MeasureMutex());
+  HostArgs args;
+  std::vector<std::string> expected_outputs;
+  // the candidates not applicable to the group leave the same body
+  std::unordered_set<std::string> scheduled_bodies;
+  std::optional<X86TuningResult> result;
+  for (const X86ScheduleConfig& config : GenerateCandidates()) {
+    ir::IRSchedule candidate_sch(ir_sch);
+    std::unique_ptr<backends::ExecutionEngine> engine;
+    X86Kernel kernel = nullptr;
+    try {
+      ApplyX86ScheduleConfig(config, &candidate_sch);
+      ir::Expr body = candidate_sch.GetModule().GetExprs().at(0);
+      if (!scheduled_bodies.insert(utils::GetStreamCnt(body)).second) {
+        continue;
+      }
+      ir::LoweredFunc func = func_builder(body);
+      if (!result.has_value() && !args.Init(func)) {
+        VLOG(3) << "The arguments of " << func->name << " are not measurable.";
+        return std::nullopt;
+      }
+      kernel = Compile(func, &engine);
+    } catch (const std::exception& e) {
+      VLOG(3) << "Failed to compile the x86 schedule {" << config.ToString()
+              << "}: " << e.what();
+    }
+    if (kernel == nullptr) {
+      if (!result.has_value()) {
+        return std::nullopt;
+      }
+      continue;
+    }
+
+    args.ResetOutputs();
+    args.Run(kernel);
+    if (!result.has_value()) {
+      expected_outputs = args.GetOutputs();
+    } else if (!args.OutputsMatch(expected_outputs)) {
+      VLOG(3) << "The x86 schedule {" << config.ToString()
+              << "} computes different outputs, skip it.";
+      continue;
+    }
+    const double cost_ms = MeasureKernel(kernel, warmup_, repeat_, &args);
+    VLOG(4) << "The x86 schedule {" << config.ToString() << "} takes "
+            << cost_ms << " ms";
+    if (!result.has_value()) {
+      result = X86TuningResult{config, cost_ms, cost_ms, 1};
+      continue;
+    }
+    ++result->num_measured;
+    // a candidate has to be clearly faster to win over the timing noise
+    if (cost_ms < result->best_cost_ms * 0.97) {
+      result->best_config = config;
+      result->best_cost_ms = cost_ms;
+    }
+  }
+  return result;
+}
+
+void ApplyTunedX86Schedule(ir::IRSchedule* ir_sch,
+                           const X86FuncBuilder& func_builder) {
+  X86ScheduleDatabase& database = X86ScheduleDatabase::Instance();
+  if (!FLAGS_cinn_x86_schedule_tuning && database.Empty()) {
+    return;
+  }
+  const std::string signature = X86ScheduleSignature(*ir_sch);
+  std::optional<X86ScheduleConfig> config = database.GetConfig(signature);
+  if (!config.has_value()) {
+    if (!FLAGS_cinn_x86_schedule_tuning) {
+      return;
+    }
+    std::optional<X86TuningResult> result =
+        X86ScheduleTuner().Tune(*ir_sch, func_builder);
+    if (!result.has_value()) {
+      return;
+    }
+    VLOG(3) << "Tuned the x86 schedule of " << signature << " in "
+            << result->num_measured << " candidates: {"
+            << result->best_config.ToString() << "} takes "
+            << result->best_cost_ms << " ms, and the default one takes "
+            << result->default_cost_ms << " ms";
+    database.AddConfig(signature, result->best_config, result->best_cost_ms);
+    config = result->best_config;
+  }
+  VLOG(4) << "Apply the x86 schedule {" << config->ToString() << "} to "
+          << signature;
+  ApplyX86ScheduleConfig(*config, ir_sch);
+}
+
+}  // namespace search
+}  // namespace ir
+}  // namespace cinn
@@ -0,0 +1,74 @@
+// Copyright (c) 2024 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "paddle/cinn/ir/group_schedule/config/x86_schedule_config.h"
+#include "paddle/cinn/ir/lowered_func.h"
+#include "paddle/cinn/ir/schedule/ir_schedule.h"
+
+namespace cinn {
+namespace ir {
+namespace search {
+
+// Builds the lowered function of a fusion group from its scheduled body.
+using X86FuncBuilder = std::function<ir::LoweredFunc(const ir::Expr& body)>;
+
+struct X86TuningResult {
+  X86ScheduleConfig best_config;
+  // The time of a run in milliseconds.
+  double default_cost_ms;
+  double best_cost_ms;
+  int num_measured;
+};
+
+/**
+ * Tunes the x86 schedule of a fusion group on the local machine: each
+ * candidate config is applied to a copy of the group, compiled by the LLVM
+ * JIT and run on the same host buffers, and the fastest one whose outputs
+ * match the ones of the default schedule wins.
+ */
+class X86ScheduleTuner {
+ public:
+  explicit X86ScheduleTuner(int warmup = 2, int repeat = 10)
+      : warmup_(warmup), repeat_(repeat) {}
+
+  // The tile, vectorize and parallel candidates, the default one first.
+  std::vector<X86ScheduleConfig> GenerateCandidates() const;
+
+  // Returns std::nullopt if the group can not be measured, e.g. its
+  // arguments have dynamic shapes.
+  std::optional<X86TuningResult> Tune(
+      const ir::IRSchedule& ir_sch, const X86FuncBuilder& func_builder) const;
+
+ private:
+  int warmup_;
+  int repeat_;
+};
+
+/**
+ * Applies the x86 schedule recorded for the group in X86ScheduleDatabase. If
+ * none is recorded and FLAGS_cinn_x86_schedule_tuning is set, the group is
+ * tuned and the result recorded first.
+ */
+void ApplyTunedX86Schedule(ir::IRSchedule* ir_sch,
+                           const X86FuncBuilder& func_builder);
+
+}  // namespace search
+}  // namespace ir
+}  // namespace cinn
@@ -69,10 +69,27 @@ PD_DEFINE_int32(cinn_parallel_compile_thread,
                              (std::thread::hardware_concurrency() >> 1)),
                 "How much thread the parallel compile used.");
 
+PD_DEFINE_int32(cinn_llvm_compile_thread,
+                Int32FromEnv("FLAGS_cinn_llvm_compile_thread", 1),
+                "How much thread the LLVM optimization and codegen of a "
+                "module used, which is split by functions if greater than 1.");
+
 PD_DEFINE_bool(cinn_enable_config_search,
                BoolFromEnv("FLAGS_cinn_enable_config_search", false),
                "Whether to enable schedule config search mode.");
 
+PD_DEFINE_bool(cinn_x86_schedule_tuning,
+               BoolFromEnv("FLAGS_cinn_x86_schedule_tuning", false),
+               "Whether to measure the x86 schedule candidates of the fusion "
+               "groups missing from the x86 schedule database, and record "
+               "the fastest one.");
+
+PD_DEFINE_string(
+    cinn_x86_schedule_database,
+    StringFromEnv("FLAGS_cinn_x86_schedule_database", ""),
+    "The file the tuned x86 schedules are loaded from and appended to, "
+    "not kept across processes if empty.");
+
 PD_DEFINE_bool(cinn_use_op_fusion,
                BoolFromEnv("FLAGS_cinn_use_op_fusion", true),
                "Whether to use op fusion pass.");
@@ -16,6 +16,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <mutex>  // NOLINT
 #include <sstream>
 #include <string>
 #include <unordered_map>
@@ -103,13 +104,16 @@ class HostEventRecorder {
 
   std::vector<HostEvent>& Events() { return events_; }
 
+  // The events may be recorded by the threads compiling in parallel.
   void RecordEvent(const std::string& annotation,
                    double duration,
                    EventType type) {
+    std::lock_guard<std::mutex> lock(mutex_);
     GetInstance().Events().emplace_back(annotation, duration, type);
   }
 
  private:
+  std::mutex mutex_;
   std::vector<HostEvent> events_;
 };
 
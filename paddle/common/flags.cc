@@ -374,6 +374,24 @@ PHI_DEFINE_EXPORTED_int32(dist_threadpool_size,
                           0,
                           "number of threads used for distributed executed.");
 
+/**
+ * CPU related FLAG
+ * Name: FLAGS_cpu_numa_node
+ * Since Version: 3.0.0
+ * Value Range: int32, default=-1
+ * Example: FLAGS_cpu_numa_node=0 runs the CPU worker threads on node 0.
+ * Note: NUMA placement of the host threads of the new executor and of the
+ *       phi::ThreadPool. A node id pins the threads to that node, -2 spreads
+ *       them over all the nodes, and -1 leaves them unpinned. Memory grown by
+ *       the CPU allocator from a pinned thread is bound to its node. Has no
+ *       effect on single node machines.
+ */
+PHI_DEFINE_EXPORTED_int32(cpu_numa_node,
+                          -1,
+                          "NUMA node of the CPU worker threads, -2 to spread "
+                          "them over all the nodes, -1 to leave them "
+                          "unpinned.");
+
 /**
  * Garbage collector related FLAG
  * Name: FLAGS_eager_delete_tensor_gb
@@ -1048,6 +1066,21 @@ PHI_DEFINE_EXPORTED_int64(
     cinn_compile_thread_num,
     -1,
     "It controls how many thread numbers applying compilation cache.");
+
+/*
+ * CINN related FLAG
+ * Name: FLAGS_cinn_compile_cache_dir
+ * Since Version: 3.0
+ * Value Range: string, default=""
+ * Example: FLAGS_cinn_compile_cache_dir="./cinn_cache/" would save the x86
+ * kernels compiled by CINN into "./cinn_cache/", and the later processes
+ * would load them from there rather than compiling them again. The directory
+ * should be cleared when Paddle is rebuilt.
+ */
+PHI_DEFINE_EXPORTED_string(
+    cinn_compile_cache_dir,
+    "",
+    "The directory of the persistent cache of the CINN x86 kernels.");
 /*
  * CINN related FLAG
  * Name: FLAGS_enable_interpretercore_launch_cinn
@@ -1158,6 +1191,21 @@ PD_DEFINE_bool(enable_slotrecord_reset_shrink,  // NOLINT
 PD_DEFINE_bool(enable_ins_parser_file,  // NOLINT
                false,
                "enable parser ins file, default false");
+PHI_DEFINE_EXPORTED_int32(
+    dataset_global_shuffle_inflight_batches,
+    4,
+    "the number of batches MultiSlotDataset::GlobalShuffle keeps in flight "
+    "to each trainer, default 4");
+PHI_DEFINE_EXPORTED_int64(
+    dataset_prefetch_memory_budget_mb,
+    1024,
+    "the memory in MB of all the buffers read ahead by the data feeds whose "
+    "prefetch_read_ahead is set, default 1024");
+PHI_DEFINE_EXPORTED_bool(
+    enable_dataset_record_arena,
+    true,
+    "allocate the feasigns of the records of an in-memory MultiSlotDataset "
+    "from an arena released with the dataset memory, default true");
 PHI_DEFINE_EXPORTED_bool(
     gpugraph_enable_hbm_table_collision_stat,
     false,
@@ -1631,6 +1679,20 @@ PHI_DEFINE_EXPORTED_int64(
     32,
     "Maximum number of broadcast nodes allowed in a tree");
 
+/**
+ * PIR pass related FLAG
+ * Name: pir_pass_num_threads
+ * Since Version: 3.0.0
+ * Value Range: int32, default=1
+ * Example: FLAGS_pir_pass_num_threads=8
+ * Note: The number of threads PassManager runs a pipeline of region-local
+ * passes with over the independent operations nested in a block.
+ */
+PHI_DEFINE_EXPORTED_int32(pir_pass_num_threads,
+                          1,
+                          "The number of threads to run the region-local "
+                          "passes on independent operations.");
+
 PHI_DEFINE_EXPORTED_string(
     nvidia_package_dir,  // NOLINT
     "",
@@ -99,5 +99,93 @@ class ChunkAllocator {
   }
 };
 
+// Same chunked free-list scheme as ChunkAllocator, but for raw blocks whose
+// size is only known at runtime (e.g. one row of floats of a given accessor
+// dim). Blocks of one allocator share a fixed stride, so rows sit contiguously
+// in large slabs instead of being scattered over the heap.
+class SlabChunkAllocator {
+ public:
+  explicit SlabChunkAllocator(size_t block_size, size_t chunk_size = 1024) {
+    CHECK(block_size > 0);
+    _block_size = std::max(block_size, sizeof(Node));
+    // keep every block aligned to a pointer so it can hold a free-list link
+    _block_size = (_block_size + sizeof(void*) - 1) / sizeof(void*) *
+                  sizeof(void*);
+    _chunk_size = chunk_size;
+    _chunks = NULL;
+    _free_nodes = NULL;
+    _counter = 0;
+    _chunk_num = 0;
+  }
+  SlabChunkAllocator(const SlabChunkAllocator&) = delete;
+  ~SlabChunkAllocator() {
+    while (_chunks != NULL) {
+      Chunk* x = _chunks;
+      _chunks = _chunks->next;
+      free(x);
+    }
+  }
+  void* acquire() {
+    if (_free_nodes == NULL) {
+      create_new_chunk();
+    }
+    Node* x = _free_nodes;
+    _free_nodes = _free_nodes->next;
+    _counter++;
+    return x;
+  }
+  void release(void* x) {
+    Node* node = reinterpret_cast<Node*>(x);
+    node->next = _free_nodes;
+    _free_nodes = node;
+    _counter--;
+  }
+  size_t block_size() const { return _block_size; }
+  size_t size() const { return _counter; }
+  // bytes held by all chunks, including blocks on the free list
+  size_t capacity_bytes() const {
+    return _chunk_num * (sizeof(Chunk) + _block_size * _chunk_size);
+  }
+
+ private:
+  struct Node {
+    Node* next;
+  };
+  struct alignas(64) Chunk {
+    Chunk* next;
+  };
+
+  size_t _block_size;  // bytes of one block
+  size_t _chunk_size;  // how many blocks in one chunk
+  Chunk* _chunks;      // a list
+  Node* _free_nodes;   // a list
+  size_t _counter;     // how many blocks are acquired
+  size_t _chunk_num;   // how many chunks are allocated
+
+  void create_new_chunk() {
+    Chunk* chunk;
+    size_t alloc_size = sizeof(Chunk) + _block_size * _chunk_size;
+    int error = posix_memalign(
+        reinterpret_cast<void**>(&chunk), alignof(Chunk), alloc_size);
+    PADDLE_ENFORCE_EQ(error,
+                      0,
+                      paddle::platform::errors::ResourceExhausted(
+                          "Fail to alloc memory of %ld size, error code is %d.",
+                          alloc_size,
+                          error));
+    chunk->next = _chunks;
+    _chunks = chunk;
+    _chunk_num++;
+
+    char* base = reinterpret_cast<char*>(chunk) + sizeof(Chunk);
+    // push in reverse so that blocks are handed out in address order
+    for (size_t i = _chunk_size; i > 0; i--) {
+      Node* node = reinterpret_cast<Node*>(base + (i - 1) * _block_size);
+      node->next = _free_nodes;
+      _free_nodes = node;
+    }
+  }
+};
+
 }  // namespace distributed
 }  // namespace paddle
@@ -0,0 +1,373 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace paddle {
+namespace distributed {
+
+// On-disk layout of one sparse table shard, written by checkpoints of tables
+// with enable_columnar_save. All columns start on a 64 byte boundary:
+//
+//   header | keys[key_num] | offsets[key_num + 1] | values[value_num] | fence
+//
+// keys are sorted ascending, row i owns values[offsets[i], offsets[i + 1]),
+// and fence holds every kFenceStride-th key, so a lookup against the mapped
+// file touches the fence, one page of keys and the value row.
+struct ColumnarShardHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t header_size;
+  uint64_t key_num;
+  uint64_t value_num;
+  uint64_t fence_num;
+  uint64_t keys_offset;
+  uint64_t offsets_offset;
+  uint64_t values_offset;
+  uint64_t fence_offset;
+  uint64_t file_size;
+  uint64_t reserved[6];
+};
+static_assert(sizeof(ColumnarShardHeader) == 128,
+              "columnar shard header must stay 128 bytes");
+
+static constexpr uint64_t kColumnarShardMagic = 0x4c4f435053445050ULL;
+static constexpr uint32_t kColumnarShardVersion = 1;
+static constexpr uint64_t kColumnarShardAlign = 64;
+static constexpr uint64_t kColumnarShardFenceStride = 512;
+static constexpr const char* kColumnarShardSuffix = ".col";
+
+inline bool IsColumnarShardFile(const std::string& path) {
+  size_t len = strlen(kColumnarShardSuffix);
+  return path.size() >= len &&
+         path.compare(path.size() - len, len, kColumnarShardSuffix) == 0;
+}
+
+// Collects the rows of one shard and streams them out in the columnar
+// layout. Rows are referenced, not copied, so they must stay alive and
+// unchanged until Write returns.
+class ColumnarShardWriter {
+ public:
+  void Add(uint64_t key, const float* data, size_t dim) {
+    _rows.push_back({key, data, static_cast<uint32_t>(dim)});
+  }
+  size_t size() const { return _rows.size(); }
+
+  // write(const char* data, size_t size) returns 0 on success
+  template <class WriteFunc>
+  int Write(WriteFunc write) {
+    std::sort(_rows.begin(), _rows.end(), [](const Row& a, const Row& b) {
+      return a.key < b.key;
+    });
+    ColumnarShardHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = kColumnarShardMagic;
+    header.version = kColumnarShardVersion;
+    header.header_size = sizeof(header);
+    header.key_num = _rows.size();
+    for (auto& row : _rows) {
+      header.value_num += row.dim;
+    }
+    header.fence_num = (header.key_num + kColumnarShardFenceStride - 1) /
+                       kColumnarShardFenceStride;
+    header.keys_offset = Align(sizeof(header));
+    header.offsets_offset =
+        Align(header.keys_offset + header.key_num * sizeof(uint64_t));
+    header.values_offset = Align(header.offsets_offset +
+                                 (header.key_num + 1) * sizeof(uint64_t));
+    header.fence_offset =
+        Align(header.values_offset + header.value_num * sizeof(float));
+    header.file_size =
+        header.fence_offset + header.fence_num * sizeof(uint64_t);
+
+    _written = 0;
+    if (Put(write, reinterpret_cast<const char*>(&header), sizeof(header)) !=
+            0 ||
+        Pad(write, header.keys_offset) != 0) {
+      return -1;
+    }
+    std::vector<uint64_t> buffer;
+    buffer.reserve(kBufferRows);
+    auto flush = [&]() -> int {
+      int ret = Put(write,
+                    reinterpret_cast<const char*>(buffer.data()),
+                    buffer.size() * sizeof(uint64_t));
+      buffer.clear();
+      return ret;
+    };
+    for (auto& row : _rows) {
+      buffer.push_back(row.key);
+      if (buffer.size() == kBufferRows && flush() != 0) {
+        return -1;
+      }
+    }
+    if (flush() != 0 || Pad(write, header.offsets_offset) != 0) {
+      return -1;
+    }
+    uint64_t offset = 0;
+    buffer.push_back(offset);
+    for (auto& row : _rows) {
+      offset += row.dim;
+      buffer.push_back(offset);
+      if (buffer.size() == kBufferRows && flush() != 0) {
+        return -1;
+      }
+    }
+    if (flush() != 0 || Pad(write, header.values_offset) != 0) {
+      return -1;
+    }
+    for (auto& row : _rows) {
+      if (Put(write,
+              reinterpret_cast<const char*>(row.data),
+              row.dim * sizeof(float)) != 0) {
+        return -1;
+      }
+    }
+    if (Pad(write, header.fence_offset) != 0) {
+      return -1;
+    }
+    for (size_t i = 0; i < _rows.size(); i += kColumnarShardFenceStride) {
+      buffer.push_back(_rows[i].key);
+    }
+    return flush();
+  }
+
+ private:
+  struct Row {
+    uint64_t key;
+    const float* data;
+    uint32_t dim;
+  };
+  static constexpr size_t kBufferRows = 8192;
+
+  static uint64_t Align(uint64_t offset) {
+    return (offset + kColumnarShardAlign - 1) / kColumnarShardAlign *
+           kColumnarShardAlign;
+  }
+  template <class WriteFunc>
+  int Put(WriteFunc& write, const char* data, size_t size) {
+    if (size == 0) {
+      return 0;
+    }
+    _written += size;
+    return write(data, size) == 0 ? 0 : -1;
+  }
+  template <class WriteFunc>
+  int Pad(WriteFunc& write, uint64_t offset) {
+    static const char zeros[kColumnarShardAlign] = {0};
+    return Put(write, zeros, offset - _written);
+  }
+
+  std::vector<Row> _rows;
+  uint64_t _written = 0;
+};
+
+// Read-only view of a columnar shard file. A local file is mapped and pages
+// are faulted in on access; a remote file is read into memory once. Rows are
+// located by a binary search over the fence and then one key page, without
+// parsing anything.
+class ColumnarShardReader {
+ public:
+  enum AccessPattern { kSequential, kRandom };
+
+  ColumnarShardReader() {}
+  ColumnarShardReader(const ColumnarShardReader&) = delete;
+  ColumnarShardReader& operator=(const ColumnarShardReader&) = delete;
+  ~ColumnarShardReader() { Close(); }
+
+  int Open(const std::string& path, AccessPattern pattern) {
+    Close();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      LOG(ERROR) << "ColumnarShardReader open failed, path: " << path;
+      return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(ColumnarShardHeader)) {
+      LOG(ERROR) << "ColumnarShardReader bad file size, path: " << path;
+      close(fd);
+      return -1;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+      LOG(ERROR) << "ColumnarShardReader mmap failed, path: " << path;
+      return -1;
+    }
+    _mapped = static_cast<const char*>(addr);
+    _mapped_size = st.st_size;
+    madvise(addr,
+            _mapped_size,
+            pattern == kSequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+    return Parse(_mapped, _mapped_size, path);
+  }
+
+  // takes a file already read into memory, e.g. from a remote file system
+  int Open(std::vector<char>&& buffer, const std::string& path) {
+    Close();
+    _buffer.swap(buffer);
+    // vector storage is at least 16 byte aligned, enough for the columns
+    return Parse(_buffer.data(), _buffer.size(), path);
+  }
+
+  void Close() {
+    if (_mapped != nullptr) {
+      munmap(const_cast<char*>(_mapped), _mapped_size);
+      _mapped = nullptr;
+      _mapped_size = 0;
+    }
+    std::vector<char>().swap(_buffer);
+    _header = nullptr;
+  }
+
+  bool is_open() const { return _header != nullptr; }
+  bool is_mapped() const { return _mapped != nullptr; }
+  size_t size() const { return _header == nullptr ? 0 : _header->key_num; }
+
+  uint64_t key(size_t i) const { return _keys[i]; }
+  const float* value(size_t i) const { return _values + _offsets[i]; }
+  size_t dim(size_t i) const { return _offsets[i + 1] - _offsets[i]; }
+
+  // index of key, or size() if absent
+  size_t Find(uint64_t key) const {
+    size_t key_num = size();
+    if (key_num == 0) {
+      return key_num;
+    }
+    const uint64_t* fence_end = _fence + _header->fence_num;
+    const uint64_t* fence = std::upper_bound(_fence, fence_end, key);
+    if (fence == _fence) {
+      return key_num;
+    }
+    size_t begin = (fence - _fence - 1) * kColumnarShardFenceStride;
+    size_t end = std::min(begin + kColumnarShardFenceStride, key_num);
+    const uint64_t* pos = std::lower_bound(_keys + begin, _keys + end, key);
+    if (pos == _keys + end || *pos != key) {
+      return key_num;
+    }
+    return pos - _keys;
+  }
+
+ private:
+  int Parse(const char* data, size_t size, const std::string& path) {
+    auto header = reinterpret_cast<const ColumnarShardHeader*>(data);
+    if (size < sizeof(ColumnarShardHeader) ||
+        header->magic != kColumnarShardMagic) {
+      LOG(ERROR) << "ColumnarShardReader not a columnar shard, path: " << path;
+      return -1;
+    }
+    if (header->version != kColumnarShardVersion ||
+        header->header_size != sizeof(ColumnarShardHeader)) {
+      LOG(ERROR) << "ColumnarShardReader unsupported version "
+                 << header->version << ", path: " << path;
+      return -1;
+    }
+    // every section must lie inside the file and end before the next one
+    // starts, computed without overflow since the header may be corrupt
+    uint64_t keys_end = 0;
+    uint64_t offsets_end = 0;
+    uint64_t values_end = 0;
+    uint64_t fence_end = 0;
+    if (header->file_size != size || header->key_num == UINT64_MAX ||
+        !SectionEnd(header->keys_offset,
+                    header->key_num,
+                    sizeof(uint64_t),
+                    &keys_end) ||
+        !SectionEnd(header->offsets_offset,
+                    header->key_num + 1,
+                    sizeof(uint64_t),
+                    &offsets_end) ||
+        !SectionEnd(header->values_offset,
+                    header->value_num,
+                    sizeof(float),
+                    &values_end) ||
+        !SectionEnd(header->fence_offset,
+                    header->fence_num,
+                    sizeof(uint64_t),
+                    &fence_end) ||
+        header->keys_offset < sizeof(ColumnarShardHeader) ||
+        keys_end > header->offsets_offset ||
+        offsets_end > header->values_offset ||
+        values_end > header->fence_offset || fence_end > size) {
+      LOG(ERROR) << "ColumnarShardReader truncated file, path: " << path;
+      return -1;
+    }
+    if (header->keys_offset % sizeof(uint64_t) != 0 ||
+        header->offsets_offset % sizeof(uint64_t) != 0 ||
+        header->values_offset % sizeof(float) != 0 ||
+        header->fence_offset % sizeof(uint64_t) != 0 ||
+        header->fence_num !=
+            (header->key_num + kColumnarShardFenceStride - 1) /
+                kColumnarShardFenceStride) {
+      LOG(ERROR) << "ColumnarShardReader bad layout, path: " << path;
+      return -1;
+    }
+    _keys = reinterpret_cast<const uint64_t*>(data + header->keys_offset);
+    _offsets = reinterpret_cast<const uint64_t*>(data + header->offsets_offset);
+    _values = reinterpret_cast<const float*>(data + header->values_offset);
+    _fence = reinterpret_cast<const uint64_t*>(data + header->fence_offset);
+    // rows must own disjoint value ranges inside the value column
+    if (_offsets[0] != 0 || _offsets[header->key_num] != header->value_num) {
+      LOG(ERROR) << "ColumnarShardReader bad value index, path: " << path;
+      return -1;
+    }
+    for (uint64_t i = 0; i < header->key_num; ++i) {
+      if (_offsets[i] > _offsets[i + 1]) {
+        LOG(ERROR) << "ColumnarShardReader bad value index, path: " << path;
+        return -1;
+      }
+    }
+    _header = header;
+    return 0;
+  }
+
+  // end of a section of num items of width bytes, false on overflow
+  static bool SectionEnd(uint64_t offset,
+                         uint64_t num,
+                         uint64_t width,
+                         uint64_t* end) {
+    if (num > (UINT64_MAX - offset) / width) {
+      return false;
+    }
+    *end = offset + num * width;
+    return true;
+  }
+
+  const ColumnarShardHeader* _header = nullptr;
+  const uint64_t* _keys = nullptr;
+  const uint64_t* _offsets = nullptr;
+  const float* _values = nullptr;
+  const uint64_t* _fence = nullptr;
+  const char* _mapped = nullptr;
+  size_t _mapped_size = 0;
+  std::vector<char> _buffer;
+};
+
+}  // namespace distributed
+}  // namespace paddle
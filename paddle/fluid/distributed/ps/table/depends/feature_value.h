@@ -14,12 +14,16 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
 #include <vector>
 
 #include <mct/hash-map.hpp>
 
 #include "paddle/common/flags.h"
 #include "paddle/fluid/distributed/common/chunk_allocator.h"
+#include "paddle/fluid/distributed/ps/table/depends/swiss_hash_map.h"
 
 namespace paddle {
 namespace distributed {
@@ -28,38 +32,190 @@ static const int CTR_SPARSE_SHARD_BUCKET_NUM_BITS = 6;
 static const size_t CTR_SPARSE_SHARD_BUCKET_NUM =
     static_cast<size_t>(1) << CTR_SPARSE_SHARD_BUCKET_NUM_BITS;
 
+// Pool of fixed-stride slabs for feature values of one shard, with one
+// SlabChunkAllocator per value dim. Like the shard itself it is only accessed
+// from the shard's task thread, so it is not thread safe.
+class FeatureValueSlab {
+ public:
+  FeatureValueSlab() {}
+  FeatureValueSlab(const FeatureValueSlab&) = delete;
+  float* acquire(size_t dim) {
+    return reinterpret_cast<float*>(allocator(dim).acquire());
+  }
+  void release(float* data, size_t dim) { allocator(dim).release(data); }
+  size_t capacity_bytes() const {
+    size_t bytes = 0;
+    for (auto& alloc : _allocs) {
+      if (alloc != nullptr) {
+        bytes += alloc->capacity_bytes();
+      }
+    }
+    return bytes;
+  }
+
+ private:
+  // about 64KB per chunk, so that small dims do not reserve huge slabs
+  static constexpr size_t kSlabChunkBytes = 64 * 1024;
+
+  SlabChunkAllocator& allocator(size_t dim) {
+    if (dim >= _allocs.size()) {
+      _allocs.resize(dim + 1);
+    }
+    if (_allocs[dim] == nullptr) {
+      size_t block_size = dim * sizeof(float);
+      _allocs[dim].reset(new SlabChunkAllocator(
+          block_size, std::max<size_t>(16, kSlabChunkBytes / block_size)));
+    }
+    return *_allocs[dim];
+  }
+
+  std::vector<std::unique_ptr<SlabChunkAllocator>> _allocs;
+};
+
+// Row of floats of one feature. By default the row is a private heap buffer;
+// after bind_slab() it lives in a fixed-stride slab of the owning shard and
+// moves between slabs of different dims on resize().
 class FixedFeatureValue {
  public:
   FixedFeatureValue() {}
-  ~FixedFeatureValue() {}
-  float* data() { return _data.data(); }
-  size_t size() { return _data.size(); }
-  void resize(size_t size) { _data.resize(size); }
-  void shrink_to_fit() { _data.shrink_to_fit(); }
+  FixedFeatureValue(const FixedFeatureValue& other) { *this = other; }
+  FixedFeatureValue& operator=(const FixedFeatureValue& other) {
+    if (this != &other) {
+      resize(other._size);
+      if (_size > 0) {
+        memcpy(_data, other._data, _size * sizeof(float));
+      }
+    }
+    return *this;
+  }
+  ~FixedFeatureValue() { release(); }
+  float* data() { return _data; }
+  size_t size() { return _size; }
+  void resize(size_t size) {
+    if (size == _size) {
+      return;
+    }
+    if (_slab != nullptr) {
+      float* data = size > 0 ? _slab->acquire(size) : nullptr;
+      move_to(data, size);
+      _capacity = size;
+    } else if (size > _capacity) {
+      float* data = static_cast<float*>(malloc(size * sizeof(float)));
+      PADDLE_ENFORCE_NOT_NULL(
+          data,
+          paddle::platform::errors::ResourceExhausted(
+              "Fail to alloc feature value of %ld floats.", size));
+      move_to(data, size);
+      _capacity = size;
+    } else if (size > _size) {
+      memset(_data + _size, 0, (size - _size) * sizeof(float));
+    }
+    _size = size;
+  }
+  void shrink_to_fit() {
+    if (_slab == nullptr && _capacity > _size) {
+      float* data = nullptr;
+      if (_size > 0) {
+        data = static_cast<float*>(malloc(_size * sizeof(float)));
+        PADDLE_ENFORCE_NOT_NULL(
+            data,
+            paddle::platform::errors::ResourceExhausted(
+                "Fail to alloc feature value of %ld floats.", _size));
+      }
+      move_to(data, _size);
+      _capacity = _size;
+    }
+  }
+  // Moves the row into slab, all later resizes are served by it.
+  void bind_slab(FeatureValueSlab* slab) {
+    if (_slab == slab) {
+      return;
+    }
+    float* data = _size > 0 ? slab->acquire(_size) : nullptr;
+    move_to(data, _size);
+    _slab = slab;
+    _capacity = _size;
+  }
+  bool in_slab() const { return _slab != nullptr; }
+  // bytes held outside of this object, slab rows are counted by their stride
+  size_t storage_bytes() const { return _capacity * sizeof(float); }
 
  private:
-  std::vector<float> _data;
+  // copies the common prefix into data, zero fills the tail and frees the
+  // old buffer; does not update _size/_capacity
+  void move_to(float* data, size_t size) {
+    size_t keep = std::min<size_t>(size, _size);
+    if (keep > 0) {
+      memcpy(data, _data, keep * sizeof(float));
+    }
+    if (size > keep) {
+      memset(data + keep, 0, (size - keep) * sizeof(float));
+    }
+    release();
+    _data = data;
+  }
+  void release() {
+    if (_data == nullptr) {
+      return;
+    }
+    if (_slab != nullptr) {
+      _slab->release(_data, _capacity);
+    } else {
+      free(_data);
+    }
+    _data = nullptr;
+  }
+
+  float* _data = nullptr;
+  uint32_t _size = 0;
+  uint32_t _capacity = 0;
+  FeatureValueSlab* _slab = nullptr;
 };
 
+template <class VALUE>
+inline void BindValueSlab(VALUE* value, FeatureValueSlab* slab) {}
+inline void BindValueSlab(FixedFeatureValue* value, FeatureValueSlab* slab) {
+  value->bind_slab(slab);
+}
+
 template <class KEY, class VALUE>
 struct alignas(64) SparseTableShard {
  public:
   typedef typename mct::closed_hash_map<KEY, mct::Pointer, std::hash<KEY>>
       map_type;
+  typedef SwissHashMap<KEY, mct::Pointer, std::hash<KEY>> swiss_map_type;
+  // Each bucket is either a closed_hash_map or, after use_swiss_map(), a
+  // SwissHashMap; iterators carry both and follow the shard's choice.
   struct iterator {
     typename map_type::iterator it;
+    typename swiss_map_type::iterator sit;
     size_t bucket;
-    map_type* buckets;
+    SparseTableShard* shard;
     friend bool operator==(const iterator& a, const iterator& b) {
-      return a.it == b.it;
+      return a.shard->swiss_map_enabled() ? a.sit == b.sit : a.it == b.it;
     }
     friend bool operator!=(const iterator& a, const iterator& b) {
-      return a.it != b.it;
+      return !(a == b);
+    }
+    const KEY& key() const {
+      return shard->_use_swiss_map ? sit->first : it->first;
+    }
+    VALUE& value() const { return *value_ptr(); }
+    VALUE* value_ptr() const {
+      return (VALUE*)(void*)(shard->_use_swiss_map ? sit->second  // NOLINT
+                                                   : it->second);
     }
-    const KEY& key() const { return it->first; }
-    VALUE& value() const { return *(VALUE*)(void*)it->second; }     // NOLINT
-    VALUE* value_ptr() const { return (VALUE*)(void*)it->second; }  // NOLINT
     iterator& operator++() {
+      if (shard->_use_swiss_map) {
+        auto* buckets = shard->_swiss_buckets;
+        ++sit;
+        while (sit == buckets[bucket].end() &&
+               bucket + 1 < CTR_SPARSE_SHARD_BUCKET_NUM) {
+          sit = buckets[++bucket].begin();
+        }
+        return *this;
+      }
+      auto* buckets = shard->_buckets;
       ++it;
 
       while (it == buckets[bucket].end() &&
@@ -77,33 +233,68 @@ struct alignas(64) SparseTableShard {
   };
   struct local_iterator {
     typename map_type::iterator it;
+    typename swiss_map_type::iterator sit;
+    bool use_swiss_map;
     friend bool operator==(const local_iterator& a, const local_iterator& b) {
-      return a.it == b.it;
+      return a.use_swiss_map ? a.sit == b.sit : a.it == b.it;
     }
     friend bool operator!=(const local_iterator& a, const local_iterator& b) {
-      return a.it != b.it;
+      return !(a == b);
+    }
+    const KEY& key() const { return use_swiss_map ? sit->first : it->first; }
+    VALUE& value() const {
+      return *(VALUE*)(void*)(use_swiss_map ? sit->second  // NOLINT
+                                            : it->second);
     }
-    const KEY& key() const { return it->first; }
-    VALUE& value() const { return *(VALUE*)(void*)it->second; }  // NOLINT
     local_iterator& operator++() {
-      ++it;
+      if (use_swiss_map) {
+        ++sit;
+      } else {
+        ++it;
+      }
       return *this;
     }
-    local_iterator operator++(int) { return {it++}; }
+    local_iterator operator++(int) {
+      local_iterator ret = *this;
+      ++*this;
+      return ret;
+    }
   };
 
   ~SparseTableShard() { clear(); }
   bool empty() { return _alloc.size() == 0; }
   size_t size() { return _alloc.size(); }
+  // values created from now on keep their rows in fixed-stride slabs
+  void enable_value_slab() { _value_slab_enabled = true; }
+  bool value_slab_enabled() { return _value_slab_enabled; }
+  size_t value_slab_bytes() { return _value_slab.capacity_bytes(); }
+  // switch the buckets to SwissHashMap, only allowed on an empty shard
+  void use_swiss_map() {
+    CHECK(empty());
+    _use_swiss_map = true;
+  }
+  bool swiss_map_enabled() { return _use_swiss_map; }
   void set_max_load_factor(float x) {
     for (size_t bucket = 0; bucket < CTR_SPARSE_SHARD_BUCKET_NUM; bucket++) {
       _buckets[bucket].max_load_factor(x);
+      _swiss_buckets[bucket].max_load_factor(x);
     }
   }
   size_t bucket_count() { return CTR_SPARSE_SHARD_BUCKET_NUM; }
-  size_t bucket_size(size_t bucket) { return _buckets[bucket].size(); }
+  size_t bucket_size(size_t bucket) {
+    return _use_swiss_map ? _swiss_buckets[bucket].size()
+                          : _buckets[bucket].size();
+  }
   void clear() {
     for (size_t bucket = 0; bucket < CTR_SPARSE_SHARD_BUCKET_NUM; bucket++) {
+      if (_use_swiss_map) {
+        swiss_map_type& data = _swiss_buckets[bucket];
+        for (auto it = data.begin(); it != data.end(); ++it) {
+          _alloc.release((VALUE*)(void*)it->second);  // NOLINT
+        }
+        data.clear();
+        continue;
+      }
       map_type& data = _buckets[bucket];
       for (auto it = data.begin(); it != data.end(); ++it) {
         _alloc.release((VALUE*)(void*)it->second);  // NOLINT
@@ -112,29 +303,65 @@ struct alignas(64) SparseTableShard {
     }
   }
   iterator begin() {
-    auto it = _buckets[0].begin();
     size_t bucket = 0;
+    if (_use_swiss_map) {
+      auto sit = _swiss_buckets[0].begin();
+      while (sit == _swiss_buckets[bucket].end() &&
+             bucket + 1 < CTR_SPARSE_SHARD_BUCKET_NUM) {
+        sit = _swiss_buckets[++bucket].begin();
+      }
+      return make_iterator(sit, bucket);
+    }
+    auto it = _buckets[0].begin();
     while (it == _buckets[bucket].end() &&
            bucket + 1 < CTR_SPARSE_SHARD_BUCKET_NUM) {
       it = _buckets[++bucket].begin();
     }
-    return {it, bucket, _buckets};
+    return make_iterator(it, bucket);
   }
   iterator end() {
-    return {_buckets[CTR_SPARSE_SHARD_BUCKET_NUM - 1].end(),
-            CTR_SPARSE_SHARD_BUCKET_NUM - 1,
-            _buckets};
+    if (_use_swiss_map) {
+      return make_iterator(
+          _swiss_buckets[CTR_SPARSE_SHARD_BUCKET_NUM - 1].end(),
+          CTR_SPARSE_SHARD_BUCKET_NUM - 1);
+    }
+    return make_iterator(_buckets[CTR_SPARSE_SHARD_BUCKET_NUM - 1].end(),
+                         CTR_SPARSE_SHARD_BUCKET_NUM - 1);
+  }
+  local_iterator begin(size_t bucket) {
+    if (_use_swiss_map) {
+      return {{}, _swiss_buckets[bucket].begin(), true};
+    }
+    return {_buckets[bucket].begin(), {}, false};
+  }
+  local_iterator end(size_t bucket) {
+    if (_use_swiss_map) {
+      return {{}, _swiss_buckets[bucket].end(), true};
+    }
+    return {_buckets[bucket].end(), {}, false};
   }
-  local_iterator begin(size_t bucket) { return {_buckets[bucket].begin()}; }
-  local_iterator end(size_t bucket) { return {_buckets[bucket].end()}; }
   iterator find(const KEY& key) {
     size_t hash = _hasher(key);
     size_t bucket = compute_bucket(hash);
+    if (_use_swiss_map) {
+      auto sit = _swiss_buckets[bucket].find_with_hash(key, hash);
+      if (sit == _swiss_buckets[bucket].end()) {
+        return end();
+      }
+      return make_iterator(sit, bucket);
+    }
     auto it = _buckets[bucket].find_with_hash(key, hash);
     if (it == _buckets[bucket].end()) {
       return end();
     }
-    return {it, bucket, _buckets};
+    return make_iterator(it, bucket);
+  }
+  // Hint that key is looked up soon, pulls its probe position into cache.
+  void prefetch(const KEY& key) {
+    if (_use_swiss_map) {
+      size_t hash = _hasher(key);
+      _swiss_buckets[compute_bucket(hash)].prefetch(hash);
+    }
   }
   VALUE& operator[](const KEY& key) { return emplace(key).first.value(); }
   std::pair<iterator, bool> insert(const KEY& key, const VALUE& val) {
@@ -147,35 +374,61 @@ struct alignas(64) SparseTableShard {
   std::pair<iterator, bool> emplace(const KEY& key, ARGS&&... args) {
     size_t hash = _hasher(key);
     size_t bucket = compute_bucket(hash);
+    if (_use_swiss_map) {
+      auto res = _swiss_buckets[bucket].insert_with_hash({key, NULL}, hash);
+      if (res.second) {
+        res.first->second = acquire_value(std::forward<ARGS>(args)...);
+      }
+      return {make_iterator(res.first, bucket), res.second};
+    }
     auto res = _buckets[bucket].insert_with_hash({key, NULL}, hash);
 
     if (res.second) {
-      res.first->second = _alloc.acquire(std::forward<ARGS>(args)...);
+      res.first->second = acquire_value(std::forward<ARGS>(args)...);
     }
 
-    return {{res.first, bucket, _buckets}, res.second};
+    return {make_iterator(res.first, bucket), res.second};
   }
   iterator erase(iterator it) {
-    _alloc.release((VALUE*)(void*)it.it->second);  // NOLINT
+    _alloc.release(it.value_ptr());
     size_t bucket = it.bucket;
+    if (_use_swiss_map) {
+      auto sit2 = _swiss_buckets[bucket].erase(it.sit);
+      while (sit2 == _swiss_buckets[bucket].end() &&
+             bucket + 1 < CTR_SPARSE_SHARD_BUCKET_NUM) {
+        sit2 = _swiss_buckets[++bucket].begin();
+      }
+      return make_iterator(sit2, bucket);
+    }
     auto it2 = _buckets[bucket].erase(it.it);
     while (it2 == _buckets[bucket].end() &&
            bucket + 1 < CTR_SPARSE_SHARD_BUCKET_NUM) {
       it2 = _buckets[++bucket].begin();
     }
-    return {it2, bucket, _buckets};
+    return make_iterator(it2, bucket);
   }
   void quick_erase(iterator it) {
-    _alloc.release((VALUE*)(void*)it.it->second);  // NOLINT
-    _buckets[it.bucket].quick_erase(it.it);
+    _alloc.release(it.value_ptr());
+    if (_use_swiss_map) {
+      _swiss_buckets[it.bucket].quick_erase(it.sit);
+    } else {
+      _buckets[it.bucket].quick_erase(it.it);
+    }
   }
   local_iterator erase(size_t bucket, local_iterator it) {
-    _alloc.release((VALUE*)(void*)it.it->second);  // NOLINT
-    return {_buckets[bucket].erase(it.it)};
+    _alloc.release(&it.value());
+    if (_use_swiss_map) {
+      return {{}, _swiss_buckets[bucket].erase(it.sit), true};
+    }
+    return {_buckets[bucket].erase(it.it), {}, false};
   }
   void quick_erase(size_t bucket, local_iterator it) {
-    _alloc.release((VALUE*)(void*)it.it->second);  // NOLINT
-    _buckets[bucket].quick_erase(it.it);
+    _alloc.release(&it.value());
+    if (_use_swiss_map) {
+      _swiss_buckets[bucket].quick_erase(it.sit);
+    } else {
+      _buckets[bucket].quick_erase(it.it);
+    }
   }
   size_t erase(const KEY& key) {
     auto it = find(key);
@@ -185,6 +438,7 @@ struct alignas(64) SparseTableShard {
     quick_erase(it);
     return 1;
   }
+  size_t bucket_of(const KEY& key) { return compute_bucket(_hasher(key)); }
   size_t compute_bucket(size_t hash) {
     if (CTR_SPARSE_SHARD_BUCKET_NUM == 1) {
       return 0;
@@ -194,7 +448,35 @@ struct alignas(64) SparseTableShard {
   }
 
  private:
+  template <class... ARGS>
+  VALUE* acquire_value(ARGS&&... args) {
+    VALUE* value = _alloc.acquire(std::forward<ARGS>(args)...);
+    if (_value_slab_enabled) {
+      BindValueSlab(value, &_value_slab);
+    }
+    return value;
+  }
+  iterator make_iterator(typename map_type::iterator it, size_t bucket) {
+    iterator ret;
+    ret.it = it;
+    ret.bucket = bucket;
+    ret.shard = this;
+    return ret;
+  }
+  iterator make_iterator(typename swiss_map_type::iterator sit,
+                         size_t bucket) {
+    iterator ret;
+    ret.sit = sit;
+    ret.bucket = bucket;
+    ret.shard = this;
+    return ret;
+  }
+
+  FeatureValueSlab _value_slab;
+  bool _value_slab_enabled = false;
+  bool _use_swiss_map = false;
   map_type _buckets[CTR_SPARSE_SHARD_BUCKET_NUM];
+  swiss_map_type _swiss_buckets[CTR_SPARSE_SHARD_BUCKET_NUM];
   ChunkAllocator<VALUE> _alloc;
   std::hash<KEY> _hasher;
 };
@@ -0,0 +1,200 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace paddle {
+namespace distributed {
+
+// Count-min sketch of key access frequencies with saturating 8-bit counters.
+// All counters are halved after a sample window, so old popularity fades
+// (the aging step of TinyLFU).
+class FrequencySketch {
+ public:
+  explicit FrequencySketch(size_t capacity) {
+    size_t width = 64;
+    while (width < capacity) {
+      width <<= 1;
+    }
+    _mask = width - 1;
+    _table.assign(kDepth * width, 0);
+    _sample_size = 10 * width;
+    _additions = 0;
+  }
+  void Increment(uint64_t key) {
+    for (size_t i = 0; i < kDepth; ++i) {
+      uint8_t& counter = _table[Index(key, i)];
+      if (counter < kMaxCount) {
+        ++counter;
+      }
+    }
+    if (++_additions >= _sample_size) {
+      Age();
+    }
+  }
+  uint32_t Estimate(uint64_t key) const {
+    uint32_t freq = kMaxCount;
+    for (size_t i = 0; i < kDepth; ++i) {
+      freq = std::min<uint32_t>(freq, _table[Index(key, i)]);
+    }
+    return freq;
+  }
+  void Age() {
+    for (auto& counter : _table) {
+      counter >>= 1;
+    }
+    _additions /= 2;
+  }
+
+ private:
+  static constexpr size_t kDepth = 4;
+  static constexpr uint8_t kMaxCount = 255;
+
+  size_t Index(uint64_t key, size_t row) const {
+    uint64_t h = (key + row * 0x9e3779b97f4a7c15ULL) * 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 31;
+    return row * (_mask + 1) + (h & _mask);
+  }
+
+  std::vector<uint8_t> _table;
+  size_t _mask;
+  size_t _sample_size;
+  size_t _additions;
+};
+
+// In-memory copy of hot values that live in RocksDB, kept in front of the
+// point lookups of one SSDSparseTable shard. Entries are evicted in LRU
+// order, and a new entry is only admitted when the sketch says it is
+// accessed more often than the entry it would evict (TinyLFU admission), so
+// a scan of one-off keys can not flush the cache.
+class SSDHotCache {
+ public:
+  explicit SSDHotCache(size_t capacity)
+      : _capacity(capacity), _sketch(capacity) {}
+
+  bool Enabled() const { return _capacity > 0; }
+
+  // access log of the current pass, feeds the admission decision
+  void RecordAccess(const uint64_t* keys, size_t num) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    for (size_t i = 0; i < num; ++i) {
+      _sketch.Increment(keys[i]);
+    }
+  }
+  void RecordAccess(const std::vector<std::pair<uint64_t, int>>& keys) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    for (auto& key : keys) {
+      _sketch.Increment(key.first);
+    }
+  }
+
+  // Moves the cached value of key into value. Used when a feature goes back
+  // from the SSD tier to memory, so the entry is dropped.
+  bool Take(uint64_t key, std::vector<float>* value) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    auto it = _index.find(key);
+    if (it == _index.end()) {
+      ++_misses;
+      return false;
+    }
+    ++_hits;
+    value->swap(it->second->second);
+    _lru.erase(it->second);
+    _index.erase(it);
+    return true;
+  }
+
+  // Offers a value that was just written to RocksDB.
+  bool Admit(uint64_t key, const float* data, size_t size) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    if (_capacity == 0) {
+      return false;
+    }
+    auto it = _index.find(key);
+    if (it != _index.end()) {
+      it->second->second.assign(data, data + size);
+      _lru.splice(_lru.begin(), _lru, it->second);
+      return true;
+    }
+    if (_index.size() >= _capacity) {
+      auto& victim = _lru.back();
+      if (_sketch.Estimate(key) <= _sketch.Estimate(victim.first)) {
+        ++_rejected;
+        return false;
+      }
+      _index.erase(victim.first);
+      _lru.pop_back();
+    }
+    _lru.emplace_front(key, std::vector<float>(data, data + size));
+    _index[key] = _lru.begin();
+    ++_admitted;
+    return true;
+  }
+
+  void Erase(uint64_t key) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    auto it = _index.find(key);
+    if (it != _index.end()) {
+      _lru.erase(it->second);
+      _index.erase(it);
+    }
+  }
+
+  void Clear() {
+    std::lock_guard<std::mutex> guard(_mutex);
+    _lru.clear();
+    _index.clear();
+  }
+
+  // called once per pass, after the pass's accesses were used to warm it
+  void Age() {
+    std::lock_guard<std::mutex> guard(_mutex);
+    _sketch.Age();
+  }
+
+  size_t Size() {
+    std::lock_guard<std::mutex> guard(_mutex);
+    return _index.size();
+  }
+  uint64_t Hits() const { return _hits; }
+  uint64_t Misses() const { return _misses; }
+  uint64_t Admitted() const { return _admitted; }
+  uint64_t Rejected() const { return _rejected; }
+
+ private:
+  typedef std::list<std::pair<uint64_t, std::vector<float>>> lru_type;
+
+  size_t _capacity;
+  FrequencySketch _sketch;
+  lru_type _lru;
+  std::unordered_map<uint64_t, lru_type::iterator> _index;
+  std::mutex _mutex;
+  std::atomic<uint64_t> _hits{0};
+  std::atomic<uint64_t> _misses{0};
+  std::atomic<uint64_t> _admitted{0};
+  std::atomic<uint64_t> _rejected{0};
+};
+
+}  // namespace distributed
+}  // namespace paddle
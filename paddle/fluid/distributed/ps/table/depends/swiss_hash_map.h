@@ -0,0 +1,348 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <cstring>
+#include <functional>
+#include <new>
+#include <utility>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace distributed {
+
+// Open addressing hash map in the style of Swiss tables. Every slot has one
+// control byte holding 7 bits of the hash (or an empty/deleted marker), and a
+// probe compares a whole group of control bytes against the hash with one
+// SIMD instruction before touching any key. Keys and values are stored inline
+// in one slot array, so a hit costs one control-byte line and one slot line.
+//
+// The interface follows the subset of mct::closed_hash_map used by
+// SparseTableShard: find_with_hash/insert_with_hash, erase/quick_erase and
+// forward iteration. Like closed_hash_map, a rehash invalidates iterators.
+template <class KEY, class T, class HASH = std::hash<KEY>>
+class SwissHashMap {
+ public:
+  typedef std::pair<KEY, T> value_type;
+
+#if defined(__AVX2__)
+  static constexpr size_t kGroupWidth = 32;
+#else
+  static constexpr size_t kGroupWidth = 16;
+#endif
+  static constexpr int8_t kEmpty = -128;
+  static constexpr int8_t kDeleted = -2;
+
+  struct iterator {
+    SwissHashMap* map = nullptr;
+    size_t index = 0;
+    friend bool operator==(const iterator& a, const iterator& b) {
+      return a.map == b.map && a.index == b.index;
+    }
+    friend bool operator!=(const iterator& a, const iterator& b) {
+      return !(a == b);
+    }
+    value_type& operator*() const { return map->_slots[index]; }
+    value_type* operator->() const { return &map->_slots[index]; }
+    iterator& operator++() {
+      index = map->next_full(index + 1);
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator ret = *this;
+      ++*this;
+      return ret;
+    }
+  };
+
+  SwissHashMap() {}
+  SwissHashMap(const SwissHashMap&) = delete;
+  SwissHashMap& operator=(const SwissHashMap&) = delete;
+  ~SwissHashMap() {
+    destroy_slots();
+    free(_ctrl);
+    free(_slots);
+  }
+
+  size_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+  size_t capacity() const { return _capacity; }
+  void max_load_factor(float x) {
+    _max_load_factor = x;
+    reset_growth_left();
+  }
+
+  iterator begin() { return {this, next_full(0)}; }
+  iterator end() { return {this, _capacity}; }
+
+  iterator find_with_hash(const KEY& key, size_t hash) {
+    if (_size == 0) {
+      return end();
+    }
+    size_t index = find_index(key, mix(hash));
+    return {this, index};
+  }
+  iterator find(const KEY& key) { return find_with_hash(key, _hasher(key)); }
+
+  std::pair<iterator, bool> insert_with_hash(const value_type& value,
+                                             size_t hash) {
+    size_t h = mix(hash);
+    if (_size > 0) {
+      size_t index = find_index(value.first, h);
+      if (index != _capacity) {
+        return {{this, index}, false};
+      }
+    }
+    if (_growth_left == 0) {
+      // drop tombstones in place when they take up most of the load
+      rehash(_size * 2 < growth_limit() ? _capacity : _capacity * 2);
+    }
+    size_t index = find_insert_slot(h);
+    if (_ctrl[index] == kEmpty) {
+      --_growth_left;
+    }
+    set_ctrl(index, static_cast<int8_t>(h & 0x7F));
+    new (&_slots[index]) value_type(value);
+    ++_size;
+    return {{this, index}, true};
+  }
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return insert_with_hash(value, _hasher(value.first));
+  }
+
+  void quick_erase(iterator it) {
+    _slots[it.index].~value_type();
+    set_ctrl(it.index, kDeleted);
+    --_size;
+  }
+  iterator erase(iterator it) {
+    quick_erase(it);
+    return ++it;
+  }
+  size_t erase(const KEY& key) {
+    auto it = find(key);
+    if (it == end()) {
+      return 0;
+    }
+    quick_erase(it);
+    return 1;
+  }
+
+  void clear() {
+    destroy_slots();
+    if (_capacity > 0) {
+      memset(_ctrl, kEmpty, _capacity + kGroupWidth);
+    }
+    _size = 0;
+    reset_growth_left();
+  }
+
+  // Pulls the control group and the first slot of the probe sequence of a
+  // key into cache, to be issued some keys ahead of the actual lookup.
+  void prefetch(size_t hash) const {
+#if defined(__GNUC__)
+    if (_capacity > 0) {
+      size_t pos = (mix(hash) >> 7) & (_capacity - 1);
+      __builtin_prefetch(_ctrl + pos);
+      __builtin_prefetch(_slots + pos);
+    }
+#endif
+  }
+
+ private:
+  // a group of kGroupWidth control bytes, matched in one instruction
+  struct Group {
+    explicit Group(const int8_t* pos) {
+#if defined(__AVX2__)
+      ctrl = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+#elif defined(__SSE2__)
+      ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+#else
+      ctrl = pos;
+#endif
+    }
+    // bit i is set if byte i equals h2
+    uint32_t Match(int8_t h2) const {
+#if defined(__AVX2__)
+      return static_cast<uint32_t>(
+          _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_set1_epi8(h2), ctrl)));
+#elif defined(__SSE2__)
+      return static_cast<uint32_t>(
+          _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl)));
+#else
+      uint32_t mask = 0;
+      for (size_t i = 0; i < kGroupWidth; ++i) {
+        mask |= static_cast<uint32_t>(ctrl[i] == h2) << i;
+      }
+      return mask;
+#endif
+    }
+    uint32_t MatchEmpty() const { return Match(kEmpty); }
+    // empty and deleted bytes are the only ones with the sign bit set
+    uint32_t MatchEmptyOrDeleted() const {
+#if defined(__AVX2__)
+      return static_cast<uint32_t>(_mm256_movemask_epi8(ctrl));
+#elif defined(__SSE2__)
+      return static_cast<uint32_t>(_mm_movemask_epi8(ctrl));
+#else
+      uint32_t mask = 0;
+      for (size_t i = 0; i < kGroupWidth; ++i) {
+        mask |= static_cast<uint32_t>(ctrl[i] < 0) << i;
+      }
+      return mask;
+#endif
+    }
+
+#if defined(__AVX2__)
+    __m256i ctrl;
+#elif defined(__SSE2__)
+    __m128i ctrl;
+#else
+    const int8_t* ctrl;
+#endif
+  };
+
+  static size_t mix(size_t hash) {
+    // std::hash of integers is the identity, spread it over all bits so
+    // that both the probe start and the 7 control bits are well distributed
+    uint64_t h = static_cast<uint64_t>(hash);
+    h = (h ^ (h >> 31)) * 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 29;
+    return static_cast<size_t>(h);
+  }
+  static int lowest_bit(uint32_t mask) { return __builtin_ctz(mask); }
+
+  size_t growth_limit() const {
+    if (_capacity == 0) {
+      return 0;
+    }
+    size_t limit = static_cast<size_t>(_capacity * _max_load_factor);
+    // always keep one empty slot so that a probe terminates
+    return limit < _capacity ? limit : _capacity - 1;
+  }
+  void reset_growth_left() {
+    size_t limit = growth_limit();
+    _growth_left = limit > _size ? limit - _size : 0;
+  }
+
+  size_t find_index(const KEY& key, size_t h) const {
+    const size_t mask = _capacity - 1;
+    const int8_t h2 = static_cast<int8_t>(h & 0x7F);
+    size_t pos = (h >> 7) & mask;
+    for (size_t step = kGroupWidth;; step += kGroupWidth) {
+      Group group(_ctrl + pos);
+      for (uint32_t match = group.Match(h2); match != 0;
+           match &= match - 1) {
+        size_t index = (pos + lowest_bit(match)) & mask;
+        if (_slots[index].first == key) {
+          return index;
+        }
+      }
+      if (group.MatchEmpty() != 0) {
+        return _capacity;
+      }
+      pos = (pos + step) & mask;
+    }
+  }
+
+  size_t find_insert_slot(size_t h) const {
+    const size_t mask = _capacity - 1;
+    size_t pos = (h >> 7) & mask;
+    for (size_t step = kGroupWidth;; step += kGroupWidth) {
+      uint32_t match = Group(_ctrl + pos).MatchEmptyOrDeleted();
+      if (match != 0) {
+        return (pos + lowest_bit(match)) & mask;
+      }
+      pos = (pos + step) & mask;
+    }
+  }
+
+  size_t next_full(size_t index) const {
+    while (index < _capacity && _ctrl[index] < 0) {
+      ++index;
+    }
+    return index;
+  }
+
+  // the first kGroupWidth bytes are mirrored behind the table, so a group
+  // load starting at any slot never wraps around
+  void set_ctrl(size_t index, int8_t h2) {
+    _ctrl[index] = h2;
+    if (index < kGroupWidth) {
+      _ctrl[_capacity + index] = h2;
+    }
+  }
+
+  void destroy_slots() {
+    for (size_t i = 0; i < _capacity; ++i) {
+      if (_ctrl[i] >= 0) {
+        _slots[i].~value_type();
+      }
+    }
+  }
+
+  void rehash(size_t new_capacity) {
+    if (new_capacity < kGroupWidth) {
+      new_capacity = kGroupWidth;
+    }
+    int8_t* old_ctrl = _ctrl;
+    value_type* old_slots = _slots;
+    size_t old_capacity = _capacity;
+
+    _ctrl = static_cast<int8_t*>(malloc(new_capacity + kGroupWidth));
+    int error = posix_memalign(reinterpret_cast<void**>(&_slots),
+                               64,
+                               sizeof(value_type) * new_capacity);
+    PADDLE_ENFORCE_EQ(
+        error == 0 && _ctrl != nullptr,
+        true,
+        paddle::platform::errors::ResourceExhausted(
+            "Fail to alloc SwissHashMap of %ld slots.", new_capacity));
+    memset(_ctrl, kEmpty, new_capacity + kGroupWidth);
+    _capacity = new_capacity;
+
+    for (size_t i = 0; i < old_capacity; ++i) {
+      if (old_ctrl[i] >= 0) {
+        size_t h = mix(_hasher(old_slots[i].first));
+        size_t index = find_insert_slot(h);
+        set_ctrl(index, static_cast<int8_t>(h & 0x7F));
+        new (&_slots[index]) value_type(std::move(old_slots[i]));
+        old_slots[i].~value_type();
+      }
+    }
+    free(old_ctrl);
+    free(old_slots);
+    reset_growth_left();
+  }
+
+  int8_t* _ctrl = nullptr;
+  value_type* _slots = nullptr;
+  size_t _capacity = 0;
+  size_t _size = 0;
+  size_t _growth_left = 0;
+  float _max_load_factor = 0.875;
+  HASH _hasher;
+};
+
+}  // namespace distributed
+}  // namespace paddle
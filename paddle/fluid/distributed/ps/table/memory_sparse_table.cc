@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <omp.h>
+#include <algorithm>
 #include <sstream>
 
 #include "glog/logging.h"
@@ -38,10 +39,18 @@ PD_DEFINE_bool(pserver_enable_create_feasign_randomly,
 PD_DEFINE_int32(pserver_table_save_max_retry,
                 3,
                 "pserver_table_save_max_retry");
+PD_DEFINE_int32(pserver_sparse_pipeline_batch_size,
+                32,
+                "keys gathered per accessor Select/Update call in a shard");
+PD_DEFINE_int32(pserver_sparse_prefetch_distance,
+                8,
+                "how many keys ahead of the lookup a shard prefetches, 0 "
+                "disables prefetching");
 
 namespace paddle {
 namespace distributed {
 
+
 int32_t MemorySparseTable::Initialize() {
   auto &profiler = CostProfiler::instance();
   profiler.register_profiler("pserver_sparse_update_all");
@@ -76,6 +85,7 @@ int32_t MemorySparseTable::InitializeValue() {
           << " _task_pool_size:" << _task_pool_size;
 
   _local_shards.reset(new shard_type[_real_local_shard_num]);
+  InitializeShardStorage(_local_shards.get(), _real_local_shard_num);
 
   if (_config.enable_revert()) {
     // calculate merged shard number based on config param;
@@ -100,10 +110,26 @@ int32_t MemorySparseTable::InitializeValue() {
               << _m_avg_local_shard_num << "|" << _m_real_local_shard_num
               << "]";
     _local_shards_new.reset(new shard_type[_real_local_shard_num]);  // NOLINT
+    InitializeShardStorage(_local_shards_new.get(), _real_local_shard_num);
   }
   return 0;
 }
 
+void MemorySparseTable::InitializeShardStorage(shard_type *shards,
+                                               int shard_num) {
+  for (int i = 0; i < shard_num; ++i) {
+    if (_config.enable_swiss_map()) {
+      shards[i].use_swiss_map();
+    }
+    if (_config.enable_value_slab()) {
+      shards[i].enable_value_slab();
+    }
+  }
+  VLOG(1) << "memory sparse table shard storage, swiss_map: "
+          << _config.enable_swiss_map()
+          << " value_slab: " << _config.enable_value_slab();
+}
+
 int32_t MemorySparseTable::Load(const std::string &path,
                                 const std::string &param) {
   std::string table_path = TableDir(path);
@@ -127,14 +153,22 @@ int32_t MemorySparseTable::Load(const std::string &path,
   }
 
   if (load_param == 5) {
+    // a patch applies on top of the table, mapped rows included
+    ReleaseMappedShards();
     return LoadPatch(file_list, load_param);
   }
+  // a full load replaces the table, so a mapping left by an earlier
+  // columnar load must not serve rows any more
+  _mapped_shards.clear();
 
   size_t file_start_idx = _shard_idx * _avg_local_shard_num;
 
   if (file_start_idx >= file_list.size()) {
     return 0;
   }
+  if (IsColumnarShardFile(file_list[file_start_idx])) {
+    return LoadColumnar(file_list, file_start_idx);
+  }
 
   size_t feature_value_size =
       _value_accessor->GetAccessorInfo().size / sizeof(float);
@@ -202,6 +236,146 @@ int32_t MemorySparseTable::Load(const std::string &path,
   return 0;
 }
 
+int32_t MemorySparseTable::OpenColumnarShard(
+    const std::string &path,
+    ColumnarShardReader::AccessPattern pattern,
+    ColumnarShardReader *reader) {
+  if (paddle::framework::fs_select_internal(path) == 0) {
+    return reader->Open(path, pattern);
+  }
+  // remote files can not be mapped, read them through the fs client at once
+  FsChannelConfig channel_config = {};
+  channel_config.path = path;
+  int err_no = 0;
+  auto read_channel = _afs_client.open_r(channel_config, 0, &err_no);
+  std::vector<char> buffer;
+  const size_t read_size = 64 * 1024 * 1024;
+  size_t file_size = 0;
+  while (true) {
+    buffer.resize(file_size + read_size);
+    int ret = read_channel->read(buffer.data() + file_size, read_size);
+    if (ret <= 0) {
+      break;
+    }
+    file_size += ret;
+  }
+  read_channel->close();
+  if (err_no == -1) {
+    return -1;
+  }
+  buffer.resize(file_size);
+  return reader->Open(std::move(buffer), path);
+}
+
+int32_t MemorySparseTable::LoadColumnar(
+    const std::vector<std::string> &file_list, size_t file_start_idx) {
+  size_t feature_value_size =
+      _value_accessor->GetAccessorInfo().size / sizeof(float);
+  bool lazy_load = _config.enable_columnar_lazy_load();
+  _mapped_shards.clear();
+  if (lazy_load) {
+    _mapped_shards.resize(_real_local_shard_num);
+  }
+
+#ifdef PADDLE_WITH_HETERPS
+  int thread_num = _real_local_shard_num;
+#else
+  int thread_num = _real_local_shard_num < 15 ? _real_local_shard_num : 15;
+#endif
+  std::atomic<uint64_t> feasign_size_all{0};
+  omp_set_num_threads(thread_num);
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    const std::string &path = file_list[file_start_idx + i];
+    std::unique_ptr<ColumnarShardReader> reader(new ColumnarShardReader());
+    int retry_num = 0;
+    while (OpenColumnarShard(path,
+                             lazy_load ? ColumnarShardReader::kRandom
+                                       : ColumnarShardReader::kSequential,
+                             reader.get()) != 0) {
+      ++retry_num;
+      LOG(ERROR) << "MemorySparseTable columnar load failed, retry it! path:"
+                 << path << " , retry_num=" << retry_num;
+      if (retry_num > FLAGS_pserver_table_save_max_retry) {
+        LOG(ERROR) << "MemorySparseTable load failed reach max limit!";
+        exit(-1);
+      }
+    }
+    feasign_size_all += reader->size();
+    if (lazy_load) {
+      // rows in memory are looked up before the mapping, so the ones left
+      // from before the load would shadow the checkpoint
+      _local_shards[i].clear();
+      _mapped_shards[i] = std::move(reader);
+      continue;
+    }
+    // rows are already decoded floats, a load is one copy per row
+    auto &shard = _local_shards[i];
+    for (size_t row = 0; row < reader->size(); ++row) {
+      size_t dim = reader->dim(row);
+      PADDLE_ENFORCE_LE(dim,
+                        feature_value_size,
+                        paddle::platform::errors::InvalidArgument(
+                            "Columnar row of dim %d exceeds the accessor "
+                            "value size %d, path: %s.",
+                            dim,
+                            feature_value_size,
+                            path));
+      auto &value = shard[reader->key(row)];
+      value.resize(dim);
+      memcpy(value.data(), reader->value(row), dim * sizeof(float));
+    }
+  }
+  LOG(INFO) << "MemorySparseTable columnar load success, lazy: " << lazy_load
+            << " feasign_size: " << feasign_size_all << ", path from "
+            << file_list[file_start_idx] << " to "
+            << file_list[file_start_idx + _real_local_shard_num - 1];
+  return 0;
+}
+
+FixedFeatureValue *MemorySparseTable::FaultInMapped(int shard_id,
+                                                    uint64_t key) {
+  if (_mapped_shards.empty() || _mapped_shards[shard_id] == nullptr) {
+    return nullptr;
+  }
+  auto &mapped = *_mapped_shards[shard_id];
+  size_t row = mapped.Find(key);
+  if (row == mapped.size()) {
+    return nullptr;
+  }
+  size_t feature_value_size =
+      _value_accessor->GetAccessorInfo().size / sizeof(float);
+  size_t dim = std::min(mapped.dim(row), feature_value_size);
+  auto &feature_value = _local_shards[shard_id][key];
+  feature_value.resize(dim);
+  memcpy(feature_value.data(), mapped.value(row), dim * sizeof(float));
+  return &feature_value;
+}
+
+void MemorySparseTable::ReleaseMappedShards() {
+  if (_mapped_shards.empty()) {
+    return;
+  }
+  // the table is about to change as a whole, so every row not copied yet
+  // moves into the shards before the mapping goes away
+  omp_set_num_threads(_real_local_shard_num);
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    if (_mapped_shards[i] == nullptr) {
+      continue;
+    }
+    auto &mapped = *_mapped_shards[i];
+    auto &shard = _local_shards[i];
+    for (size_t row = 0; row < mapped.size(); ++row) {
+      if (shard.find(mapped.key(row)) == shard.end()) {
+        FaultInMapped(i, mapped.key(row));
+      }
+    }
+  }
+  _mapped_shards.clear();
+  VLOG(0) << "MemorySparseTable columnar mapping released";
+}
+
 int32_t MemorySparseTable::LoadPatch(const std::vector<std::string> &file_list,
                                      int load_param) {
   if (!_config.enable_revert()) {
@@ -327,10 +501,12 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
   if (save_param == 5) {
     _local_shards_patch_model.reset(_local_shards_new.release());
     _local_shards_new.reset(new shard_type[_real_local_shard_num]);  // NOLINT
+    InitializeShardStorage(_local_shards_new.get(), _real_local_shard_num);
     _save_patch_model_thread = std::thread(std::bind(
         &MemorySparseTable::SavePatch, this, std::string(dirname), save_param));
     return 0;
   }
+  ReleaseMappedShards();
 
   // cache model
   int64_t tk_size = LocalSize() * _config.sparse_table_cache_rate();
@@ -339,6 +515,17 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
   std::string table_path = TableDir(dirname);
   _afs_client.remove(::paddle::string::format_string(
       "%s/part-%03d-*", table_path.c_str(), _shard_idx));
+  if (_config.enable_columnar_save() && (save_param == 0 || save_param == 3)) {
+    // columnar files are mapped as they are on disk, so they can not go
+    // through a converter
+    if (_value_accessor->Converter(save_param).converter.empty()) {
+      _local_show_threshold = tk.top();
+      return SaveColumnar(table_path, save_param);
+    }
+    LOG(WARNING) << "MemorySparseTable columnar save is ignored because a "
+                    "converter is configured for save_param "
+                 << save_param << ", save as text";
+  }
   std::atomic<uint32_t> feasign_size_all{0};
 
   size_t file_start_idx = _avg_local_shard_num * _shard_idx;
@@ -445,6 +632,77 @@ int32_t MemorySparseTable::Save(const std::string &dirname,
   return 0;
 }
 
+int32_t MemorySparseTable::SaveColumnar(const std::string &table_path,
+                                        int save_param) {
+  size_t file_start_idx = _avg_local_shard_num * _shard_idx;
+#ifdef PADDLE_WITH_HETERPS
+  int thread_num = _real_local_shard_num;
+#else
+  int thread_num = _real_local_shard_num < 20 ? _real_local_shard_num : 20;
+#endif
+  omp_set_num_threads(thread_num);
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    FsChannelConfig channel_config = {};
+    channel_config.path =
+        ::paddle::string::format_string("%s/part-%03d-%05d%s",
+                                        table_path.c_str(),
+                                        _shard_idx,
+                                        file_start_idx + i,
+                                        kColumnarShardSuffix);
+    auto &shard = _local_shards[i];
+#ifdef PADDLE_WITH_GPU_GRAPH
+    if (save_param == 3) {
+      for (auto it = shard.begin(); it != shard.end(); ++it) {
+        _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
+      }
+    }
+#endif
+    ColumnarShardWriter writer;
+    for (auto it = shard.begin(); it != shard.end(); ++it) {
+      if (_value_accessor->Save(it.value().data(), save_param)) {
+        writer.Add(it.key(), it.value().data(), it.value().size());
+      }
+    }
+    bool is_write_failed = false;
+    int retry_num = 0;
+    do {
+      int err_no = 0;
+      auto write_channel =
+          _afs_client.open_w(channel_config, 1024 * 1024 * 40, &err_no);
+      int ret = writer.Write([&write_channel](const char *data, size_t size) {
+        return write_channel->write(data, size) == 0 ? 0 : -1;
+      });
+      write_channel->close();
+      is_write_failed = ret != 0 || err_no == -1;
+      if (is_write_failed) {
+        ++retry_num;
+        LOG(ERROR) << "MemorySparseTable columnar save failed, retry it! path:"
+                   << channel_config.path << " , retry_num=" << retry_num;
+        _afs_client.remove(channel_config.path);
+      }
+      if (retry_num > FLAGS_pserver_table_save_max_retry) {
+        LOG(ERROR) << "MemorySparseTable save prefix failed reach max limit!";
+        exit(-1);
+      }
+    } while (is_write_failed);
+#ifndef PADDLE_WITH_GPU_GRAPH
+    for (auto it = shard.begin(); it != shard.end(); ++it) {
+      _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
+    }
+#else
+    if (save_param != 3) {
+      for (auto it = shard.begin(); it != shard.end(); ++it) {
+        _value_accessor->UpdateStatAfterSave(it.value().data(), save_param);
+      }
+    }
+#endif
+    LOG(INFO) << "MemorySparseTable columnar save success, path: "
+              << channel_config.path << " feasign_size: " << writer.size();
+  }
+  return 0;
+}
+
 #ifdef PADDLE_WITH_GPU_GRAPH
 int32_t MemorySparseTable::Save_v2(const std::string &dirname,
                                    const std::string &param) {
@@ -466,10 +724,12 @@ int32_t MemorySparseTable::Save_v2(const std::string &dirname,
   if (save_param == 5) {
     _local_shards_patch_model.reset(_local_shards_new.release());
     _local_shards_new.reset(new shard_type[_real_local_shard_num]);
+    InitializeShardStorage(_local_shards_new.get(), _real_local_shard_num);
     _save_patch_model_thread = std::thread(std::bind(
         &MemorySparseTable::SavePatch, this, std::string(dirname), save_param));
     return 0;
   }
+  ReleaseMappedShards();
 
   // cache model
   int64_t tk_size = LocalSize() * _config.sparse_table_cache_rate();
@@ -940,9 +1200,68 @@ int64_t MemorySparseTable::LocalMFSize() {
   return ret_size;
 }
 
+void MemorySparseTable::LocalValueBytes(size_t *heap_bytes,
+                                        size_t *used_bytes) {
+  // a row kept in its own heap buffer pays for the malloc header and the
+  // rounding to 16 bytes on top of the floats themselves
+  auto heap_row_bytes = [](size_t bytes) -> size_t {
+    return bytes == 0 ? 0 : (bytes + sizeof(size_t) + 15) / 16 * 16;
+  };
+  std::vector<size_t> heap_arr(_real_local_shard_num, 0);
+  std::vector<size_t> used_arr(_real_local_shard_num, 0);
+  std::vector<std::future<int>> tasks(_real_local_shard_num);
+  for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
+    tasks[shard_id] =
+        _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
+            [this, shard_id, &heap_arr, &used_arr, &heap_row_bytes]() -> int {
+              auto &local_shard = _local_shards[shard_id];
+              size_t header_bytes =
+                  local_shard.size() * sizeof(FixedFeatureValue);
+              size_t heap = header_bytes;
+              size_t used = header_bytes;
+              for (auto it = local_shard.begin(); it != local_shard.end();
+                   ++it) {
+                size_t row_bytes = heap_row_bytes(it.value().storage_bytes());
+                heap += row_bytes;
+                if (!it.value().in_slab()) {
+                  used += row_bytes;
+                }
+              }
+              heap_arr[shard_id] = heap;
+              used_arr[shard_id] = used + local_shard.value_slab_bytes();
+              return 0;
+            });
+  }
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    tasks[i].wait();
+  }
+  *heap_bytes = 0;
+  *used_bytes = 0;
+  for (int i = 0; i < _real_local_shard_num; ++i) {
+    *heap_bytes += heap_arr[i];
+    *used_bytes += used_arr[i];
+  }
+}
+
 std::pair<int64_t, int64_t> MemorySparseTable::PrintTableStat() {
   int64_t feasign_size = LocalSize();
   int64_t mf_size = LocalMFSize();
+  if (_config.enable_value_slab() && feasign_size > 0) {
+    size_t heap_bytes = 0;
+    size_t used_bytes = 0;
+    LocalValueBytes(&heap_bytes, &used_bytes);
+    LOG(INFO) << "MemorySparseTable value bytes per key: heap["
+              << static_cast<double>(heap_bytes) / feasign_size << "] slab["
+              << static_cast<double>(used_bytes) / feasign_size << "]";
+  }
+  if (!_mapped_shards.empty()) {
+    size_t mapped_size = 0;
+    for (auto &mapped : _mapped_shards) {
+      mapped_size += mapped == nullptr ? 0 : mapped->size();
+    }
+    LOG(INFO) << "MemorySparseTable columnar mapped feasign: " << mapped_size
+              << ", copied into shards: " << feasign_size;
+  }
   return {feasign_size, mf_size};
 }
 
@@ -972,18 +1291,112 @@ int32_t MemorySparseTable::Push(TableContext &context) {
   }
 }
 
-int32_t MemorySparseTable::PullSparse(float *pull_values,
-                                      const PullSparseValue &pull_value) {
-  CostTimer timer("pserver_sparse_select_all");
-  std::vector<std::future<int>> tasks(_real_local_shard_num);
+void MemorySparseTable::SortKeysByBucket(
+    shard_type *shard, std::vector<std::pair<uint64_t, int>> *keys) {
+  if (keys->size() < 2) {
+    return;
+  }
+  size_t bucket_num = shard->bucket_count();
+  std::vector<size_t> offsets(bucket_num + 1, 0);
+  std::vector<uint8_t> buckets(keys->size());
+  for (size_t i = 0; i < keys->size(); ++i) {
+    buckets[i] = static_cast<uint8_t>(shard->bucket_of((*keys)[i].first));
+    ++offsets[buckets[i] + 1];
+  }
+  for (size_t b = 0; b < bucket_num; ++b) {
+    offsets[b + 1] += offsets[b];
+  }
+  std::vector<std::pair<uint64_t, int>> sorted(keys->size());
+  for (size_t i = 0; i < keys->size(); ++i) {
+    sorted[offsets[buckets[i]]++] = (*keys)[i];
+  }
+  keys->swap(sorted);
+}
 
+int32_t MemorySparseTable::PullSparseShard(
+    int shard_id,
+    std::vector<std::pair<uint64_t, int>> *shard_keys,
+    float *pull_values) {
   const size_t value_size =
       _value_accessor->GetAccessorInfo().size / sizeof(float);
-  size_t mf_value_size =
+  const size_t mf_value_size =
       _value_accessor->GetAccessorInfo().mf_size / sizeof(float);
-  size_t select_value_size =
+  const size_t select_value_size =
       _value_accessor->GetAccessorInfo().select_size / sizeof(float);
-  // std::atomic<uint32_t> missed_keys{0};
+  const size_t batch_size =
+      std::max(FLAGS_pserver_sparse_pipeline_batch_size, 1);
+  const size_t prefetch_distance =
+      std::max(FLAGS_pserver_sparse_prefetch_distance, 0);
+
+  auto &local_shard = _local_shards[shard_id];
+  const ColumnarShardReader *mapped =
+      _mapped_shards.empty() ? nullptr : _mapped_shards[shard_id].get();
+  SortKeysByBucket(&local_shard, shard_keys);
+  auto &keys = *shard_keys;
+
+  std::vector<float> data_buffer(batch_size * value_size);
+  std::vector<FixedFeatureValue *> batch_values(batch_size);
+  std::vector<const float *> data_ptrs(batch_size);
+  std::vector<float *> select_ptrs(batch_size);
+  for (size_t begin = 0; begin < keys.size(); begin += batch_size) {
+    size_t num = std::min(batch_size, keys.size() - begin);
+    // probe the whole batch first, prefetching keys further ahead
+    for (size_t i = 0; i < num; ++i) {
+      size_t cur = begin + i;
+      if (prefetch_distance > 0 && cur + prefetch_distance < keys.size()) {
+        local_shard.prefetch(keys[cur + prefetch_distance].first);
+      }
+      auto itr = local_shard.find(keys[cur].first);
+      batch_values[i] = itr == local_shard.end() ? nullptr : itr.value_ptr();
+    }
+    // then gather rows into one contiguous buffer for a single Select
+    for (size_t i = 0; i < num; ++i) {
+      float *data = data_buffer.data() + i * value_size;
+      size_t data_size = value_size - mf_value_size;
+      if (batch_values[i] == nullptr && !FLAGS_pserver_create_value_when_push) {
+        // a new key repeated in the batch is created at its first position
+        auto itr = local_shard.find(keys[begin + i].first);
+        if (itr != local_shard.end()) {
+          batch_values[i] = itr.value_ptr();
+        }
+      }
+      size_t mapped_row = mapped == nullptr
+                              ? 0
+                              : (batch_values[i] == nullptr
+                                     ? mapped->Find(keys[begin + i].first)
+                                     : mapped->size());
+      if (mapped != nullptr && mapped_row != mapped->size()) {
+        // read-only rows are served from the mapping, not copied in
+        data_size = std::min(mapped->dim(mapped_row), value_size);
+        memcpy(data, mapped->value(mapped_row), data_size * sizeof(float));
+      } else if (batch_values[i] == nullptr) {
+        if (FLAGS_pserver_create_value_when_push) {
+          memset(data, 0, sizeof(float) * data_size);
+        } else {
+          auto &feature_value = local_shard[keys[begin + i].first];
+          feature_value.resize(data_size);
+          _value_accessor->Create(&data, 1);
+          memcpy(feature_value.data(), data, data_size * sizeof(float));
+        }
+      } else {
+        data_size = batch_values[i]->size();
+        memcpy(data, batch_values[i]->data(), data_size * sizeof(float));
+      }
+      if (data_size < value_size) {
+        memset(data + data_size, 0, (value_size - data_size) * sizeof(float));
+      }
+      data_ptrs[i] = data;
+      select_ptrs[i] = pull_values + select_value_size * keys[begin + i].second;
+    }
+    _value_accessor->Select(select_ptrs.data(), data_ptrs.data(), num);
+  }
+  return 0;
+}
+
+int32_t MemorySparseTable::PullSparse(float *pull_values,
+                                      const PullSparseValue &pull_value) {
+  CostTimer timer("pserver_sparse_select_all");
+  std::vector<std::future<int>> tasks(_real_local_shard_num);
 
   std::vector<std::vector<std::pair<uint64_t, int>>> task_keys(
       _real_local_shard_num);
@@ -996,50 +1409,9 @@ int32_t MemorySparseTable::PullSparse(float *pull_values,
   for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
     tasks[shard_id] =
         _shards_task_pool[shard_id % _shards_task_pool.size()]->enqueue(
-            [this,
-             shard_id,
-             &task_keys,
-             value_size,
-             pull_values,
-             mf_value_size,
-             select_value_size]() -> int {
-              auto &local_shard = _local_shards[shard_id];
-              float data_buffer[value_size];  // NOLINT
-              float *data_buffer_ptr = data_buffer;
-
-              auto &keys = task_keys[shard_id];
-              for (auto &item : keys) {
-                uint64_t key = item.first;
-                auto itr = local_shard.find(key);
-                size_t data_size = value_size - mf_value_size;
-                if (itr == local_shard.end()) {
-                  // ++missed_keys;
-                  if (FLAGS_pserver_create_value_when_push) {
-                    memset(data_buffer, 0, sizeof(float) * data_size);
-                  } else {
-                    auto &feature_value = local_shard[key];
-                    feature_value.resize(data_size);
-                    float *data_ptr = feature_value.data();
-                    _value_accessor->Create(&data_buffer_ptr, 1);
-                    memcpy(
-                        data_ptr, data_buffer_ptr, data_size * sizeof(float));
-                  }
-                } else {
-                  data_size = itr.value().size();
-                  memcpy(data_buffer_ptr,
-                         itr.value().data(),
-                         data_size * sizeof(float));
-                }
-                for (size_t mf_idx = data_size; mf_idx < value_size; ++mf_idx) {
-                  data_buffer[mf_idx] = 0.0;
-                }
-                auto offset = item.second;
-                float *select_data = pull_values + select_value_size * offset;
-                _value_accessor->Select(
-                    &select_data, (const float **)&data_buffer_ptr, 1);
-              }
-
-              return 0;
+            [this, shard_id, &task_keys, pull_values]() -> int {
+              return PullSparseShard(
+                  shard_id, &task_keys[shard_id], pull_values);
             });
   }
 
@@ -1085,7 +1457,12 @@ int32_t MemorySparseTable::PullSparsePtr(int shard_id,  // fake num
                 auto itr = local_shard.find(key);
                 size_t data_size = value_size - mf_value_size;
                 FixedFeatureValue *ret = NULL;
-                if (itr == local_shard.end()) {
+                if (itr != local_shard.end()) {
+                  ret = itr.value_ptr();
+                } else {
+                  ret = FaultInMapped(shard_id, key);
+                }
+                if (ret == NULL) {
                   // ++missed_keys;
                   auto &feature_value = local_shard[key];
                   feature_value.resize(data_size);
@@ -1093,8 +1470,6 @@ int32_t MemorySparseTable::PullSparsePtr(int shard_id,  // fake num
                   _value_accessor->Create(&data_buffer_ptr, 1);
                   memcpy(data_ptr, data_buffer_ptr, data_size * sizeof(float));
                   ret = &feature_value;
-                } else {
-                  ret = itr.value_ptr();
                 }
                 int pull_data_idx = item.second;
                 pull_values[pull_data_idx] = reinterpret_cast<char *>(ret);
@@ -1108,6 +1483,112 @@ int32_t MemorySparseTable::PullSparsePtr(int shard_id,  // fake num
   return 0;
 }
 
+template <class UpdateDataFunc>
+int32_t MemorySparseTable::PushSparseShard(
+    int shard_id,
+    std::vector<std::pair<uint64_t, int>> *shard_keys,
+    UpdateDataFunc get_update_data,
+    bool sync_revert_shard) {
+  const size_t value_col =
+      _value_accessor->GetAccessorInfo().size / sizeof(float);
+  const size_t mf_value_col =
+      _value_accessor->GetAccessorInfo().mf_size / sizeof(float);
+  const size_t batch_size =
+      std::max(FLAGS_pserver_sparse_pipeline_batch_size, 1);
+  const size_t prefetch_distance =
+      std::max(FLAGS_pserver_sparse_prefetch_distance, 0);
+
+  auto &local_shard = _local_shards[shard_id];
+  SortKeysByBucket(&local_shard, shard_keys);
+  auto &keys = *shard_keys;
+
+  std::vector<float> data_buffer(batch_size * value_col);
+  std::vector<FixedFeatureValue *> batch_values(batch_size);
+  std::vector<uint64_t> batch_keys(batch_size);
+  std::vector<float *> data_ptrs(batch_size);
+  std::vector<const float *> update_ptrs(batch_size);
+  size_t num = 0;
+
+  // update the gathered rows at once, then write them back
+  auto flush = [&]() {
+    _value_accessor->Update(data_ptrs.data(), update_ptrs.data(), num);
+    for (size_t i = 0; i < num; ++i) {
+      auto &feature_value = *batch_values[i];
+      float *value_data = feature_value.data();
+      size_t value_size = feature_value.size();
+      // 未拓展到最大size时, 不需要的mf则回填时抛弃了
+      if (value_size < value_col &&
+          _value_accessor->NeedExtendMF(data_ptrs[i])) {
+        feature_value.resize(value_col);
+        value_data = feature_value.data();
+        _value_accessor->Create(&value_data, 1);
+      }
+      memcpy(value_data, data_ptrs[i], value_size * sizeof(float));
+      if (sync_revert_shard) {
+        auto &local_shard_new = _local_shards_new[shard_id];
+        FixedFeatureValue *feature_value_new =
+            &(local_shard_new[batch_keys[i]]);
+        auto new_size = feature_value.size();
+        feature_value_new->resize(new_size);
+        memcpy(feature_value_new->data(),
+               feature_value.data(),
+               new_size * sizeof(float));
+      }
+    }
+    num = 0;
+  };
+
+  for (size_t cur = 0; cur < keys.size(); ++cur) {
+    if (prefetch_distance > 0 && cur + prefetch_distance < keys.size()) {
+      local_shard.prefetch(keys[cur + prefetch_distance].first);
+    }
+    uint64_t key = keys[cur].first;
+    const float *update_data = get_update_data(keys[cur].second);
+    auto itr = local_shard.find(key);
+    if (itr == local_shard.end() && FaultInMapped(shard_id, key) != nullptr) {
+      itr = local_shard.find(key);
+    }
+    if (itr == local_shard.end()) {
+      if (FLAGS_pserver_enable_create_feasign_randomly &&
+          !_value_accessor->CreateValue(1, update_data)) {
+        continue;
+      }
+      auto value_size = value_col - mf_value_col;
+      auto &feature_value = local_shard[key];
+      feature_value.resize(value_size);
+      float *data = data_buffer.data() + num * value_col;
+      _value_accessor->Create(&data, 1);
+      memcpy(feature_value.data(), data, value_size * sizeof(float));
+      itr = local_shard.find(key);
+    }
+
+    FixedFeatureValue *feature_value = itr.value_ptr();
+    // a key pushed twice must see its first update, so close the batch
+    if (std::find(batch_values.begin(),
+                  batch_values.begin() + num,
+                  feature_value) != batch_values.begin() + num) {
+      flush();
+    }
+    float *data = data_buffer.data() + num * value_col;
+    size_t value_size = feature_value->size();
+    memcpy(data, feature_value->data(), value_size * sizeof(float));
+    if (value_size < value_col) {
+      memset(data + value_size, 0, (value_col - value_size) * sizeof(float));
+    }
+    batch_values[num] = feature_value;
+    batch_keys[num] = key;
+    data_ptrs[num] = data;
+    update_ptrs[num] = update_data;
+    if (++num == batch_size) {
+      flush();
+    }
+  }
+  if (num > 0) {
+    flush();
+  }
+  return 0;
+}
+
 int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
                                       const float *values,
                                       size_t num) {
@@ -1120,76 +1601,19 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
     task_keys[shard_id].push_back({keys[i], i});
   }
 
-  const size_t value_col =
-      _value_accessor->GetAccessorInfo().size / sizeof(float);
-  size_t mf_value_col =
-      _value_accessor->GetAccessorInfo().mf_size / sizeof(float);
   size_t update_value_col =
       _value_accessor->GetAccessorInfo().update_size / sizeof(float);
 
   for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
     tasks[shard_id] = _shards_task_pool[shard_id % _task_pool_size]->enqueue(
-        [this,
-         shard_id,
-         value_col,
-         mf_value_col,
-         update_value_col,
-         values,
-         &task_keys]() -> int {
-          auto &keys = task_keys[shard_id];
-          auto &local_shard = _local_shards[shard_id];
-          auto &local_shard_new = _local_shards_new[shard_id];
-          float data_buffer[value_col];  // NOLINT
-          float *data_buffer_ptr = data_buffer;
-          for (auto &item : keys) {
-            uint64_t key = item.first;
-            uint64_t push_data_idx = item.second;
-            const float *update_data =
-                values + push_data_idx * update_value_col;
-            auto itr = local_shard.find(key);
-            if (itr == local_shard.end()) {
-              if (FLAGS_pserver_enable_create_feasign_randomly &&
-                  !_value_accessor->CreateValue(1, update_data)) {
-                continue;
-              }
-              auto value_size = value_col - mf_value_col;
-              auto &feature_value = local_shard[key];
-              feature_value.resize(value_size);
-              _value_accessor->Create(&data_buffer_ptr, 1);
-              memcpy(feature_value.data(),
-                     data_buffer_ptr,
-                     value_size * sizeof(float));
-              itr = local_shard.find(key);
-            }
-
-            auto &feature_value = itr.value();
-            float *value_data = feature_value.data();
-            size_t value_size = feature_value.size();
-
-            if (value_size == value_col) {  // 已拓展到最大size, 则就地update
-              _value_accessor->Update(&value_data, &update_data, 1);
-            } else {
-              // 拷入buffer区进行update，然后再回填，不需要的mf则回填时抛弃了
-              memcpy(data_buffer_ptr, value_data, value_size * sizeof(float));
-              _value_accessor->Update(&data_buffer_ptr, &update_data, 1);
-
-              if (_value_accessor->NeedExtendMF(data_buffer)) {
-                feature_value.resize(value_col);
-                value_data = feature_value.data();
-                _value_accessor->Create(&value_data, 1);
-              }
-              memcpy(value_data, data_buffer_ptr, value_size * sizeof(float));
-            }
-            if (_config.enable_revert()) {
-              FixedFeatureValue *feature_value_new = &(local_shard_new[key]);
-              auto new_size = feature_value.size();
-              feature_value_new->resize(new_size);
-              memcpy(feature_value_new->data(),
-                     value_data,
-                     new_size * sizeof(float));
-            }
-          }
-          return 0;
+        [this, shard_id, update_value_col, values, &task_keys]() -> int {
+          return PushSparseShard(
+              shard_id,
+              &task_keys[shard_id],
+              [values, update_value_col](int push_data_idx) {
+                return values + push_data_idx * update_value_col;
+              },
+              _config.enable_revert());
         });
   }
 
@@ -1210,54 +1634,14 @@ int32_t MemorySparseTable::PushSparse(const uint64_t *keys,
     task_keys[shard_id].push_back({keys[i], i});
   }
 
-  size_t value_col = _value_accessor->GetAccessorInfo().size / sizeof(float);
-  size_t mf_value_col =
-      _value_accessor->GetAccessorInfo().mf_size / sizeof(float);
-
   for (int shard_id = 0; shard_id < _real_local_shard_num; ++shard_id) {
     tasks[shard_id] = _shards_task_pool[shard_id % _task_pool_size]->enqueue(
-        [this, shard_id, value_col, mf_value_col, values, &task_keys]() -> int {
-          auto &keys = task_keys[shard_id];
-          auto &local_shard = _local_shards[shard_id];
-          float data_buffer[value_col];  // NOLINT
-          float *data_buffer_ptr = data_buffer;
-          for (auto &item : keys) {
-            uint64_t key = item.first;
-            uint64_t push_data_idx = item.second;
-            const float *update_data = values[push_data_idx];
-            auto itr = local_shard.find(key);
-            if (itr == local_shard.end()) {
-              if (FLAGS_pserver_enable_create_feasign_randomly &&
-                  !_value_accessor->CreateValue(1, update_data)) {
-                continue;
-              }
-              auto value_size = value_col - mf_value_col;
-              auto &feature_value = local_shard[key];
-              feature_value.resize(value_size);
-              _value_accessor->Create(&data_buffer_ptr, 1);
-              memcpy(feature_value.data(),
-                     data_buffer_ptr,
-                     value_size * sizeof(float));
-              itr = local_shard.find(key);
-            }
-            auto &feature_value = itr.value();
-            float *value_data = feature_value.data();
-            size_t value_size = feature_value.size();
-            if (value_size == value_col) {  // 已拓展到最大size, 则就地update
-              _value_accessor->Update(&value_data, &update_data, 1);
-            } else {
-              // 拷入buffer区进行update，然后再回填，不需要的mf则回填时抛弃了
-              memcpy(data_buffer_ptr, value_data, value_size * sizeof(float));
-              _value_accessor->Update(&data_buffer_ptr, &update_data, 1);
-              if (_value_accessor->NeedExtendMF(data_buffer)) {
-                feature_value.resize(value_col);
-                value_data = feature_value.data();
-                _value_accessor->Create(&value_data, 1);
-              }
-              memcpy(value_data, data_buffer_ptr, value_size * sizeof(float));
-            }
-          }
-          return 0;
+        [this, shard_id, values, &task_keys]() -> int {
+          return PushSparseShard(
+              shard_id,
+              &task_keys[shard_id],
+              [values](int push_data_idx) { return values[push_data_idx]; },
+              false);
         });
   }
 
@@ -1271,6 +1655,8 @@ int32_t MemorySparseTable::Flush() { return 0; }
 
 int32_t MemorySparseTable::Shrink(const std::string &param) {
   VLOG(0) << "MemorySparseTable::Shrink";
+  // a shrunk key must not come back from the mapping
+  ReleaseMappedShards();
   std::atomic<uint32_t> shrink_size_all{0};
   int thread_num = _real_local_shard_num;
   omp_set_num_threads(thread_num);
@@ -28,6 +28,7 @@
 #include "Eigen/Dense"
 #include "paddle/fluid/distributed/ps/table/accessor.h"
 #include "paddle/fluid/distributed/ps/table/common_table.h"
+#include "paddle/fluid/distributed/ps/table/depends/columnar_shard_file.h"
 #include "paddle/fluid/distributed/ps/table/depends/feature_value.h"
 #include "paddle/utils/string/string_helper.h"
 
@@ -64,6 +65,8 @@ class MemorySparseTable : public Table {
   int32_t Initialize() override;
   int32_t InitializeShard() override { return 0; }
   int32_t InitializeValue();
+  // applies the per-table hash map and value storage options to shards
+  void InitializeShardStorage(shard_type* shards, int shard_num);
 
   int32_t Load(const std::string& path, const std::string& param) override;
 
@@ -89,6 +92,8 @@ class MemorySparseTable : public Table {
       const std::vector<Table*>& table_ptrs) override;
   int64_t LocalSize();
   int64_t LocalMFSize();
+  // value bytes if every row owned a heap buffer, and bytes actually held
+  void LocalValueBytes(size_t* heap_bytes, size_t* used_bytes);
 
   std::pair<int64_t, int64_t> PrintTableStat() override;
   int32_t PullSparse(float* values, const PullSparseValue& pull_value);
@@ -115,16 +120,45 @@ class MemorySparseTable : public Table {
   virtual void CheckSavePrePatchDone();
 
  protected:
+  // Orders keys of one shard by hash bucket so that probes of a batch
+  // stay within one bucket map.
+  static void SortKeysByBucket(shard_type* shard,
+                               std::vector<std::pair<uint64_t, int>>* keys);
+  // Pipelined pull/push of one shard: keys are probed a batch at a time with
+  // prefetching, and the accessor runs once over the gathered rows.
+  int32_t PullSparseShard(int shard_id,
+                          std::vector<std::pair<uint64_t, int>>* shard_keys,
+                          float* pull_values);
+  template <class UpdateDataFunc>
+  int32_t PushSparseShard(int shard_id,
+                          std::vector<std::pair<uint64_t, int>>* shard_keys,
+                          UpdateDataFunc get_update_data,
+                          bool sync_revert_shard);
+
   virtual int32_t SavePatch(const std::string& path, int save_param);
   virtual int32_t LoadPatch(const std::vector<std::string>& file_list,
                             int save_param);
 
+  // checkpoint in the columnar binary format, see columnar_shard_file.h
+  int32_t SaveColumnar(const std::string& table_path, int save_param);
+  int32_t LoadColumnar(const std::vector<std::string>& file_list,
+                       size_t file_start_idx);
+  int32_t OpenColumnarShard(const std::string& path,
+                            ColumnarShardReader::AccessPattern pattern,
+                            ColumnarShardReader* reader);
+  // With enable_columnar_lazy_load the loaded files stay mapped and serve
+  // keys missing from the shard. A key is copied into the shard only when
+  // it is pushed or handed out by pointer.
+  FixedFeatureValue* FaultInMapped(int shard_id, uint64_t key);
+  void ReleaseMappedShards();
+
   int _task_pool_size = 24;
   int _avg_local_shard_num;
   int _real_local_shard_num;
   int _sparse_table_shard_num;
   std::vector<std::shared_ptr<::ThreadPool>> _shards_task_pool;
   std::unique_ptr<shard_type[]> _local_shards;
+  std::vector<std::unique_ptr<ColumnarShardReader>> _mapped_shards;
 
   // for patch model
   int _m_avg_local_shard_num;
@@ -14,6 +14,8 @@
 
 #include "paddle/fluid/distributed/ps/table/ssd_sparse_table.h"
 
+#include <algorithm>
+
 #include "paddle/fluid/distributed/common/cost_timer.h"
 #include "paddle/fluid/distributed/common/local_random.h"
 #include "paddle/fluid/distributed/common/topk_calculator.h"
@@ -25,6 +27,13 @@ PD_DECLARE_bool(pserver_create_value_when_push);
 PD_DECLARE_bool(pserver_enable_create_feasign_randomly);
 PD_DEFINE_bool(pserver_open_strict_check, false, "pserver_open_strict_check");
 PD_DEFINE_int32(pserver_load_batch_size, 5000, "load batch size for ssd");
+PD_DEFINE_int32(pserver_ssd_multi_get_batch_size,
+                1024,
+                "keys read from rocksdb by one MultiGet in pull sparse");
+PD_DEFINE_int32(pserver_ssd_hot_cache_capacity,
+                0,
+                "values of hot ssd features kept in memory per shard, 0 "
+                "disables the cache");
 PADDLE_DEFINE_EXPORTED_string(rocksdb_path,
                               "database",
                               "path of sparse table rocksdb file");
@@ -36,6 +45,10 @@ int32_t SSDSparseTable::Initialize() {
   MemorySparseTable::Initialize();
   _db = ::paddle::distributed::RocksDBHandler::GetInstance();
   _db->initialize(FLAGS_rocksdb_path, _real_local_shard_num);
+  _hot_caches.resize(_real_local_shard_num);
+  for (auto& hot_cache : _hot_caches) {
+    hot_cache.reset(new SSDHotCache(FLAGS_pserver_ssd_hot_cache_capacity));
+  }
   VLOG(0) << "initialize SSDSparseTable succ";
   VLOG(0) << "SSD FLAGS_pserver_print_missed_key_num_every_push:"
           << FLAGS_pserver_print_missed_key_num_every_push;
@@ -79,8 +92,6 @@ int32_t SSDSparseTable::PullSparse(float* pull_values,
                                    size_t num) {
   CostTimer timer("pserver_downpour_sparse_select_all");
   size_t value_size = _value_accessor->GetAccessorInfo().size / sizeof(float);
-  size_t mf_value_size =
-      _value_accessor->GetAccessorInfo().mf_size / sizeof(float);
   size_t select_value_size =
       _value_accessor->GetAccessorInfo().select_size / sizeof(float);
 
@@ -101,59 +112,30 @@ int32_t SSDSparseTable::PullSparse(float* pull_values,
                shard_id,
                &task_keys,
                value_size,
-               mf_value_size,
                select_value_size,
                pull_values,
                &missed_keys]() -> int {
                 auto& keys = task_keys[shard_id];
                 auto& local_shard = _local_shards[shard_id];
+                auto& hot_cache = *_hot_caches[shard_id];
+                if (hot_cache.Enabled()) {
+                  hot_cache.RecordAccess(keys);
+                }
                 float data_buffer[value_size];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
+                // keys missing in memory, served from the SSD tier in batch
+                std::vector<size_t> ssd_index;
                 for (size_t i = 0; i < keys.size(); ++i) {
                   uint64_t key = keys[i].first;
                   auto itr = local_shard.find(key);
-                  size_t data_size = value_size - mf_value_size;
                   if (itr == local_shard.end()) {
-                    // pull rocksdb
-                    std::string tmp_string("");
-                    if (_db->get(shard_id,
-                                 reinterpret_cast<char*>(&key),
-                                 sizeof(uint64_t),
-                                 tmp_string) > 0) {
-                      ++missed_keys;
-                      if (FLAGS_pserver_create_value_when_push) {
-                        memset(data_buffer, 0, sizeof(float) * data_size);
-                      } else {
-                        auto& feature_value = local_shard[key];
-                        feature_value.resize(data_size);
-                        float* data_ptr =
-                            const_cast<float*>(feature_value.data());
-                        _value_accessor->Create(&data_buffer_ptr, 1);
-                        memcpy(data_ptr,
-                               data_buffer_ptr,
-                               data_size * sizeof(float));
-                      }
-                    } else {
-                      data_size = tmp_string.size() / sizeof(float);
-                      memcpy(data_buffer_ptr,
-                             ::paddle::string::str_to_float(tmp_string),
-                             data_size * sizeof(float));
-                      // from rocksdb to mem
-                      auto& feature_value = local_shard[key];
-                      feature_value.resize(data_size);
-                      memcpy(const_cast<float*>(feature_value.data()),
-                             data_buffer_ptr,
-                             data_size * sizeof(float));
-                      _db->del_data(shard_id,
-                                    reinterpret_cast<char*>(&key),
-                                    sizeof(uint64_t));
-                    }
-                  } else {
-                    data_size = itr.value().size();
-                    memcpy(data_buffer_ptr,
-                           itr.value().data(),
-                           data_size * sizeof(float));
+                    ssd_index.push_back(i);
+                    continue;
                   }
+                  size_t data_size = itr.value().size();
+                  memcpy(data_buffer_ptr,
+                         itr.value().data(),
+                         data_size * sizeof(float));
                   for (size_t mf_idx = data_size; mf_idx < value_size;
                        ++mf_idx) {
                     data_buffer[mf_idx] = 0.0;
@@ -164,6 +146,10 @@ int32_t SSDSparseTable::PullSparse(float* pull_values,
                   _value_accessor->Select(
                       &select_data, (const float**)&data_buffer_ptr, 1);
                 }
+                if (!ssd_index.empty()) {
+                  PullSparseFromSSD(
+                      shard_id, keys, &ssd_index, pull_values, &missed_keys);
+                }
                 return 0;
               });
     }
@@ -178,6 +164,117 @@ int32_t SSDSparseTable::PullSparse(float* pull_values,
   return 0;
 }
 
+void SSDSparseTable::PullSparseFromSSD(
+    int shard_id,
+    const std::vector<std::pair<uint64_t, int>>& keys,
+    std::vector<size_t>* index,
+    float* pull_values,
+    std::atomic<uint32_t>* missed_keys) {
+  size_t value_size = _value_accessor->GetAccessorInfo().size / sizeof(float);
+  size_t mf_value_size =
+      _value_accessor->GetAccessorInfo().mf_size / sizeof(float);
+  size_t select_value_size =
+      _value_accessor->GetAccessorInfo().select_size / sizeof(float);
+  auto& local_shard = _local_shards[shard_id];
+  auto& hot_cache = *_hot_caches[shard_id];
+  float data_buffer[value_size];  // NOLINT
+  float* data_buffer_ptr = data_buffer;
+
+  // MultiGet wants keys in comparator order, equal keys end up adjacent
+  std::sort(index->begin(), index->end(), [&keys](size_t a, size_t b) {
+    return keys[a].first < keys[b].first;
+  });
+
+  auto select = [&](size_t i, size_t data_size) {
+    for (size_t mf_idx = data_size; mf_idx < value_size; ++mf_idx) {
+      data_buffer[mf_idx] = 0.0;
+    }
+    float* select_data = pull_values + keys[i].second * select_value_size;
+    _value_accessor->Select(&select_data, (const float**)&data_buffer_ptr, 1);
+  };
+  // from ssd to mem
+  auto move_to_mem = [&](uint64_t key, const float* data, size_t data_size) {
+    memcpy(data_buffer_ptr, data, data_size * sizeof(float));
+    auto& feature_value = local_shard[key];
+    feature_value.resize(data_size);
+    memcpy(feature_value.data(), data, data_size * sizeof(float));
+    _db->del_data(
+        shard_id, reinterpret_cast<const char*>(&key), sizeof(uint64_t));
+  };
+
+  RocksDBItem item;
+  std::vector<float> cached_value;
+  const size_t batch_size = FLAGS_pserver_ssd_multi_get_batch_size;
+  for (size_t begin = 0; begin < index->size(); begin += batch_size) {
+    size_t end = std::min(begin + batch_size, index->size());
+    item.reset();
+    for (size_t j = begin; j < end; ++j) {
+      size_t i = (*index)[j];
+      // a repeated key was already brought into memory
+      if (local_shard.find(keys[i].first) != local_shard.end()) {
+        continue;
+      }
+      if (hot_cache.Enabled() && hot_cache.Take(keys[i].first, &cached_value)) {
+        move_to_mem(keys[i].first, cached_value.data(), cached_value.size());
+        continue;
+      }
+      item.batch_index.push_back(i);
+      item.batch_keys.emplace_back(
+          reinterpret_cast<const char*>(&keys[i].first), sizeof(uint64_t));
+    }
+    if (!item.batch_keys.empty()) {
+      item.batch_values.resize(item.batch_keys.size());
+      item.status.resize(item.batch_keys.size());
+      _db->multi_get(shard_id,
+                     item.batch_keys.size(),
+                     item.batch_keys.data(),
+                     item.batch_values.data(),
+                     item.status.data());
+    }
+    for (size_t idx = 0; idx < item.batch_keys.size(); ++idx) {
+      uint64_t key = keys[item.batch_index[idx]].first;
+      if (local_shard.find(key) != local_shard.end()) {
+        continue;
+      }
+      if (item.status[idx].ok()) {
+        move_to_mem(key,
+                    ::paddle::string::str_to_float(
+                        item.batch_values[idx].data()),
+                    item.batch_values[idx].size() / sizeof(float));
+        continue;
+      }
+      if (!item.status[idx].IsNotFound()) {
+        LOG(WARNING) << "SSDSparseTable multi_get failed, shard: " << shard_id
+                     << " status: " << item.status[idx].ToString();
+      }
+      ++(*missed_keys);
+      if (!FLAGS_pserver_create_value_when_push) {
+        size_t data_size = value_size - mf_value_size;
+        auto& feature_value = local_shard[key];
+        feature_value.resize(data_size);
+        _value_accessor->Create(&data_buffer_ptr, 1);
+        memcpy(
+            feature_value.data(), data_buffer_ptr, data_size * sizeof(float));
+      }
+    }
+    // every key of the batch is either in memory now or still missing
+    for (size_t j = begin; j < end; ++j) {
+      size_t i = (*index)[j];
+      auto itr = local_shard.find(keys[i].first);
+      size_t data_size = value_size - mf_value_size;
+      if (itr == local_shard.end()) {
+        memset(data_buffer, 0, sizeof(float) * data_size);
+      } else {
+        data_size = itr.value().size();
+        memcpy(data_buffer_ptr,
+               itr.value().data(),
+               data_size * sizeof(float));
+      }
+      select(i, data_size);
+    }
+  }
+}
+
 int32_t SSDSparseTable::PullSparsePtr(int shard_id,
                                       char** pull_values,
                                       const uint64_t* pull_keys,
@@ -195,17 +292,35 @@ int32_t SSDSparseTable::PullSparsePtr(int shard_id,
     cur_ctx->reset();
     FixedFeatureValue* ret = nullptr;
     auto& local_shard = _local_shards[shard_id];
+    auto& hot_cache = *_hot_caches[shard_id];
+    if (hot_cache.Enabled()) {
+      hot_cache.RecordAccess(pull_keys, num);
+    }
+    std::vector<float> cached_value;
     float data_buffer[value_size];  // NOLINT
     float* data_buffer_ptr = data_buffer;
 
     for (size_t i = 0; i < num; ++i) {
       uint64_t key = pull_keys[i];
       auto itr = local_shard.find(key);
+      if (itr == local_shard.end() && hot_cache.Enabled() &&
+          hot_cache.Take(key, &cached_value)) {
+        // from hot cache to mem
+        auto& feature_value = local_shard[key];
+        feature_value.resize(cached_value.size());
+        memcpy(feature_value.data(),
+               cached_value.data(),
+               cached_value.size() * sizeof(float));
+        _db->del_data(
+            shard_id, reinterpret_cast<char*>(&key), sizeof(uint64_t));
+        itr = local_shard.find(key);
+      }
       if (itr == local_shard.end()) {
         cur_ctx->batch_index.push_back(i);
         cur_ctx->batch_keys.emplace_back(
             reinterpret_cast<const char*>(&(pull_keys[i])), sizeof(uint64_t));
-        if (cur_ctx->batch_keys.size() == 1024) {
+        if (cur_ctx->batch_keys.size() ==
+            static_cast<size_t>(FLAGS_pserver_ssd_multi_get_batch_size)) {
           cur_ctx->batch_values.resize(cur_ctx->batch_keys.size());
           cur_ctx->status.resize(cur_ctx->batch_keys.size());
           auto fut =
@@ -359,6 +474,7 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                &task_keys]() -> int {
                 auto& keys = task_keys[shard_id];
                 auto& local_shard = _local_shards[shard_id];
+                auto& hot_cache = *_hot_caches[shard_id];
                 float data_buffer[value_col];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
                 for (size_t i = 0; i < keys.size(); ++i) {
@@ -380,6 +496,11 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                            data_buffer_ptr,
                            value_size * sizeof(float));
                     itr = local_shard.find(key);
+                    // the value in memory supersedes the one cached from
+                    // rocksdb, which must not be pulled back later
+                    if (hot_cache.Enabled()) {
+                      hot_cache.Erase(key);
+                    }
                   }
                   auto& feature_value = itr.value();
                   float* value_data = const_cast<float*>(feature_value.data());
@@ -460,6 +581,7 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                   -> int {
                 auto& keys = task_keys[shard_id];
                 auto& local_shard = _local_shards[shard_id];
+                auto& hot_cache = *_hot_caches[shard_id];
                 float data_buffer[value_col];  // NOLINT
                 float* data_buffer_ptr = data_buffer;
                 for (size_t i = 0; i < keys.size(); ++i) {
@@ -480,6 +602,11 @@ int32_t SSDSparseTable::PushSparse(const uint64_t* keys,
                            data_buffer_ptr,
                            value_size * sizeof(float));
                     itr = local_shard.find(key);
+                    // the value in memory supersedes the one cached from
+                    // rocksdb, which must not be pulled back later
+                    if (hot_cache.Enabled()) {
+                      hot_cache.Erase(key);
+                    }
                   }
                   auto& feature_value = itr.value();
                   float* value_data = const_cast<float*>(feature_value.data());
@@ -547,6 +674,7 @@ int32_t SSDSparseTable::Shrink(const std::string& param) {
       }
     }
     delete it;
+    _hot_caches[i]->Clear();
     LOG(INFO) << "SSDSparseTable shrink success. shard:" << i << " delete MEM["
               << mem_count << "] SSD[" << ssd_count << "]";
     // _db->flush(i);
@@ -566,6 +694,7 @@ int32_t SSDSparseTable::UpdateTable() {
                  sizeof(uint64_t),
                  reinterpret_cast<const char*>(it.value().data()),
                  it.value().size() * sizeof(float));
+        _hot_caches[i]->Erase(it.key());
         count++;
         it = shard.erase(it);
       } else {
@@ -2527,6 +2656,10 @@ int32_t SSDSparseTable::Load(const std::string& path,
   }
   _value_accessor->SetDayId(_day_id);
   VLOG(1) << " Load Set Dayid:" << _day_id;
+  // rocksdb is rebuilt from the files, drop values cached from it
+  for (auto& hot_cache : _hot_caches) {
+    hot_cache->Clear();
+  }
   if (load_param > 3) {
     size_t expect_shard_num = _sparse_table_shard_num;
     if (file_list.size() != expect_shard_num) {
@@ -2937,6 +3070,19 @@ int32_t SSDSparseTable::LoadWithBinary(const std::string& path, int param) {
 
 std::pair<int64_t, int64_t> SSDSparseTable::PrintTableStat() {
   int64_t feasign_size = LocalSize();
+  if (FLAGS_pserver_ssd_hot_cache_capacity > 0) {
+    uint64_t size = 0, hits = 0, misses = 0, admitted = 0, rejected = 0;
+    for (auto& hot_cache : _hot_caches) {
+      size += hot_cache->Size();
+      hits += hot_cache->Hits();
+      misses += hot_cache->Misses();
+      admitted += hot_cache->Admitted();
+      rejected += hot_cache->Rejected();
+    }
+    LOG(INFO) << "SSDSparseTable hot cache size: " << size
+              << " hit: " << hits << " miss: " << misses
+              << " admitted: " << admitted << " rejected: " << rejected;
+  }
   return {feasign_size, -1};
 }
 
@@ -2999,13 +3145,13 @@ int32_t SSDSparseTable::CacheTable(uint16_t pass_id) {
 
           auto& shard = _local_shards[shard_id];
           if (1) {
-            using DataType = shard_type::map_type::iterator;
+            using DataType = std::pair<uint64_t, FixedFeatureValue*>;
             std::vector<DataType> datas;
             datas.reserve(shard.size() * 0.8);
             for (auto it = shard.begin(); it != shard.end(); ++it) {
               if (!_value_accessor->SaveMemCache(
                       it.value().data(), 0, show_threshold, pass_id)) {
-                datas.emplace_back(it.it);
+                datas.emplace_back(it.key(), it.value_ptr());
               }
             }
             count.fetch_add(datas.size(), std::memory_order_relaxed);
@@ -3016,7 +3162,7 @@ int32_t SSDSparseTable::CacheTable(uint16_t pass_id) {
               std::sort(datas.begin(),
                         datas.end(),
                         [](const DataType& a, const DataType& b) {
-                          return a->first < b->first;
+                          return a.first < b.first;
                         });
               VLOG(0) << "sort shard " << shard_id << ": "
                       << butil::gettimeofday_ms() - show_begin
@@ -3041,9 +3187,12 @@ int32_t SSDSparseTable::CacheTable(uint16_t pass_id) {
 
               uint64_t show_begin = butil::gettimeofday_ms();
               for (auto& data : datas) {
-                uint64_t tmp_key = data->first;
-                FixedFeatureValue& tmp_value =
-                    *((FixedFeatureValue*)(void*)(data->second));  // NOLINT
+                uint64_t tmp_key = data.first;
+                FixedFeatureValue& tmp_value = *data.second;
+                if (_hot_caches[shard_id]->Enabled()) {
+                  _hot_caches[shard_id]->Admit(
+                      tmp_key, tmp_value.data(), tmp_value.size());
+                }
                 status = sst_writer.Put(
                     rocksdb::Slice(reinterpret_cast<char*>(&(tmp_key)),
                                    sizeof(uint64_t)),
@@ -3089,6 +3238,11 @@ int32_t SSDSparseTable::CacheTable(uint16_t pass_id) {
   }
   tasks.clear();
 
+  // the access log of this pass warmed the hot cache, let it fade
+  for (auto& hot_cache : _hot_caches) {
+    hot_cache->Age();
+  }
+
   VLOG(0) << "Table>> cache ssd count: " << count.load();
   VLOG(0) << "Table>> after update, mem feasign size:" << LocalSize();
   return 0;
@@ -16,6 +16,7 @@
 
 #include "paddle/common/flags.h"
 #include "paddle/fluid/distributed/ps/table/depends/rocksdb_warpper.h"
+#include "paddle/fluid/distributed/ps/table/depends/ssd_hot_cache.h"
 #include "paddle/fluid/distributed/ps/table/memory_sparse_table.h"
 
 namespace paddle {
@@ -131,7 +132,18 @@ class SSDSparseTable : public MemorySparseTable {
   void SetDayId(int day_id) override;
 
  private:
+  // Serves keys missing in memory: hot cache first, then RocksDB MultiGet.
+  // The values found are moved into the memory shard, and every key of
+  // index is left with a value in its pull buffer slot.
+  void PullSparseFromSSD(int shard_id,
+                         const std::vector<std::pair<uint64_t, int>>& keys,
+                         std::vector<size_t>* index,
+                         float* pull_values,
+                         std::atomic<uint32_t>* missed_keys);
+
   RocksDBHandler* _db;
+  // per shard cache of hot values that were spilled to RocksDB
+  std::vector<std::unique_ptr<SSDHotCache>> _hot_caches;
   int64_t _cache_tk_size;
   double _local_show_threshold{0.0};
   std::vector<paddle::framework::Channel<std::string>> _fs_channel;
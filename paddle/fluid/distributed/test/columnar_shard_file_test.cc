@@ -0,0 +1,115 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/table/depends/columnar_shard_file.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace distributed {
+
+TEST(ColumnarShardFile, WriteMapAndFind) {
+  // keys added out of order, with rows of two different dims
+  std::map<uint64_t, std::vector<float>> rows;
+  for (uint64_t i = 0; i < 3000; ++i) {
+    uint64_t key = (i * 7919) % 3001 + 10;
+    size_t dim = key % 3 == 0 ? 11 : 5;
+    std::vector<float> value(dim);
+    for (size_t j = 0; j < dim; ++j) {
+      value[j] = key + j * 0.5;
+    }
+    rows[key] = value;
+  }
+  ColumnarShardWriter writer;
+  for (uint64_t i = 0; i < 3000; ++i) {
+    uint64_t key = (i * 7919) % 3001 + 10;
+    writer.Add(key, rows[key].data(), rows[key].size());
+  }
+
+  std::string path = "columnar_shard_file_test.col";
+  ASSERT_TRUE(IsColumnarShardFile(path));
+  FILE* fp = fopen(path.c_str(), "wb");
+  ASSERT_NE(fp, nullptr);
+  ASSERT_EQ(writer.Write([fp](const char* data, size_t size) {
+              return fwrite(data, 1, size, fp) == size ? 0 : -1;
+            }),
+            0);
+  fclose(fp);
+
+  ColumnarShardReader reader;
+  ASSERT_EQ(reader.Open(path, ColumnarShardReader::kRandom), 0);
+  ASSERT_TRUE(reader.is_mapped());
+  ASSERT_EQ(reader.size(), rows.size());
+  size_t row = 0;
+  for (auto& item : rows) {
+    ASSERT_EQ(reader.key(row), item.first);
+    ASSERT_EQ(reader.dim(row), item.second.size());
+    ASSERT_EQ(reader.Find(item.first), row);
+    for (size_t j = 0; j < item.second.size(); ++j) {
+      ASSERT_FLOAT_EQ(reader.value(row)[j], item.second[j]);
+    }
+    ++row;
+  }
+  ASSERT_EQ(reader.Find(0), reader.size());
+  ASSERT_EQ(reader.Find(5000), reader.size());
+
+  // the same bytes handed over in memory, as for remote files
+  fp = fopen(path.c_str(), "rb");
+  std::vector<char> bytes(1 << 20);
+  bytes.resize(fread(bytes.data(), 1, bytes.size(), fp));
+  fclose(fp);
+  ColumnarShardReader buffered;
+  ASSERT_EQ(buffered.Open(std::vector<char>(bytes), path), 0);
+  ASSERT_FALSE(buffered.is_mapped());
+  ASSERT_EQ(buffered.Find(rows.rbegin()->first), rows.size() - 1);
+
+  // a truncated file is rejected
+  ColumnarShardReader bad;
+  ASSERT_NE(bad.Open(std::vector<char>(bytes.begin(), bytes.begin() + 256),
+                     path),
+            0);
+
+  // so is a header that does not match the columns
+  auto corrupt = [&](size_t field_offset, uint64_t value) {
+    std::vector<char> copy(bytes);
+    memcpy(copy.data() + field_offset, &value, sizeof(value));
+    ColumnarShardReader reader;
+    return reader.Open(std::move(copy), path) != 0;
+  };
+  ASSERT_TRUE(corrupt(offsetof(ColumnarShardHeader, fence_num), 1));
+  ASSERT_TRUE(corrupt(offsetof(ColumnarShardHeader, key_num), 1UL << 61));
+  ASSERT_TRUE(corrupt(offsetof(ColumnarShardHeader, key_num), UINT64_MAX));
+  ASSERT_TRUE(corrupt(offsetof(ColumnarShardHeader, value_num), 1UL << 62));
+  ASSERT_TRUE(corrupt(offsetof(ColumnarShardHeader, keys_offset), 0));
+  ASSERT_TRUE(corrupt(offsetof(ColumnarShardHeader, fence_offset), 3));
+  ColumnarShardHeader header;
+  memcpy(&header, bytes.data(), sizeof(header));
+  // a row whose value range runs backwards
+  ASSERT_TRUE(corrupt(header.offsets_offset + 2 * sizeof(uint64_t), 0));
+  // or past the value column
+  ASSERT_TRUE(corrupt(header.offsets_offset + sizeof(uint64_t),
+                      header.value_num + 1));
+  remove(path.c_str());
+}
+
+}  // namespace distributed
+}  // namespace paddle
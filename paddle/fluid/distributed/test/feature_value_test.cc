@@ -45,4 +45,74 @@ TEST(BENCHMARK, LargeScaleKV) {
   ASSERT_FLOAT_EQ(value_data[3], 0.3);
 }
 
+TEST(BENCHMARK, LargeScaleKVSlab) {
+  typedef SparseTableShard<uint64_t, FixedFeatureValue> shard_type;
+  shard_type shard;
+  shard.enable_value_slab();
+
+  for (uint64_t key = 0; key < 1000; ++key) {
+    auto& feature_value = shard[key];
+    feature_value.resize(4);
+    feature_value.data()[0] = static_cast<float>(key);
+    if (key % 2 == 0) {
+      feature_value.resize(12);
+      feature_value.data()[11] = 1.0;
+    }
+  }
+  ASSERT_EQ(shard.size(), 1000UL);
+  ASSERT_GT(shard.value_slab_bytes(), 0UL);
+
+  for (uint64_t key = 0; key < 1000; ++key) {
+    auto itr = shard.find(key);
+    ASSERT_TRUE(itr != shard.end());
+    auto& feature_value = itr.value();
+    ASSERT_TRUE(feature_value.in_slab());
+    ASSERT_FLOAT_EQ(feature_value.data()[0], static_cast<float>(key));
+    if (key % 2 == 0) {
+      ASSERT_EQ(feature_value.size(), 12UL);
+      ASSERT_FLOAT_EQ(feature_value.data()[4], 0.0);
+      ASSERT_FLOAT_EQ(feature_value.data()[11], 1.0);
+    } else {
+      ASSERT_EQ(feature_value.size(), 4UL);
+    }
+  }
+
+  FixedFeatureValue copy = shard.find(2).value();
+  ASSERT_FALSE(copy.in_slab());
+  ASSERT_EQ(copy.size(), 12UL);
+  ASSERT_FLOAT_EQ(copy.data()[0], 2.0);
+
+  ASSERT_EQ(shard.erase(2), 1UL);
+  ASSERT_TRUE(shard.find(2) == shard.end());
+}
+
+TEST(BENCHMARK, LargeScaleKVSwissMap) {
+  typedef SparseTableShard<uint64_t, FixedFeatureValue> shard_type;
+  shard_type shard;
+  shard.use_swiss_map();
+
+  for (uint64_t key = 0; key < 10000; ++key) {
+    auto& feature_value = shard[key * 7919];
+    feature_value.resize(2);
+    feature_value.data()[0] = static_cast<float>(key);
+  }
+  ASSERT_EQ(shard.size(), 10000UL);
+
+  size_t count = 0;
+  for (auto it = shard.begin(); it != shard.end(); ++it) {
+    ASSERT_FLOAT_EQ(it.value().data()[0], static_cast<float>(it.key() / 7919));
+    ++count;
+  }
+  ASSERT_EQ(count, 10000UL);
+
+  for (uint64_t key = 0; key < 10000; key += 2) {
+    ASSERT_EQ(shard.erase(key * 7919), 1UL);
+  }
+  for (uint64_t key = 0; key < 10000; ++key) {
+    auto itr = shard.find(key * 7919);
+    ASSERT_EQ(itr == shard.end(), key % 2 == 0);
+  }
+  ASSERT_EQ(shard.size(), 5000UL);
+}
+
 }  // namespace paddle::distributed
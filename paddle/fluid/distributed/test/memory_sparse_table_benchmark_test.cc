@@ -0,0 +1,116 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/distributed/test/memory_sparse_table_test_helper.h"
+
+PD_DECLARE_int32(pserver_sparse_pipeline_batch_size);
+PD_DECLARE_int32(pserver_sparse_prefetch_distance);
+
+PD_DEFINE_int64(sparse_table_bench_key_num,
+                1000000,
+                "distinct keys held by the benchmarked table");
+PD_DEFINE_int32(sparse_table_bench_round_num,
+                10,
+                "pull/push requests of key_num keys per configuration");
+
+namespace paddle {
+namespace distributed {
+
+static const int kBenchEmbDim = 8;
+static const int kBenchTaskPoolSize = 24;
+
+static Table *CreateBenchmarkTable() {
+  return CreateMemorySparseTable(CtrSGDTableParameter(1000, kBenchEmbDim));
+}
+
+static void RunTableBenchmark(Table *table,
+                              const std::vector<uint64_t> &keys,
+                              int batch_size,
+                              int prefetch_distance) {
+  FLAGS_pserver_sparse_pipeline_batch_size = batch_size;
+  FLAGS_pserver_sparse_prefetch_distance = prefetch_distance;
+
+  std::vector<uint32_t> fres(keys.size(), 1);
+  auto pull_value = PullSparseValue(
+      const_cast<std::vector<uint64_t> &>(keys), fres, kBenchEmbDim);
+  std::vector<float> pull_values(keys.size() * (kBenchEmbDim + 3));
+  std::vector<float> push_values(keys.size() * (kBenchEmbDim + 4), 0.1);
+
+  double pull_seconds = 0;
+  double push_seconds = 0;
+  for (int round = 0; round < FLAGS_sparse_table_bench_round_num; ++round) {
+    TableContext pull_context;
+    pull_context.value_type = Sparse;
+    pull_context.pull_context.pull_value = pull_value;
+    pull_context.pull_context.values = pull_values.data();
+    auto start = std::chrono::steady_clock::now();
+    table->Pull(pull_context);
+    pull_seconds += std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+    TableContext push_context;
+    push_context.value_type = Sparse;
+    push_context.push_context.keys = keys.data();
+    push_context.push_context.values = push_values.data();
+    push_context.num = keys.size();
+    start = std::chrono::steady_clock::now();
+    table->Push(push_context);
+    push_seconds += std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  }
+
+  // shards run on at most kBenchTaskPoolSize threads
+  int cores = std::max(
+      1,
+      std::min<int>(kBenchTaskPoolSize, std::thread::hardware_concurrency()));
+  double total =
+      static_cast<double>(keys.size()) * FLAGS_sparse_table_bench_round_num;
+  LOG(INFO) << "batch_size: " << batch_size
+            << " prefetch_distance: " << prefetch_distance
+            << " pull keys/s/core: " << total / pull_seconds / cores
+            << " push keys/s/core: " << total / push_seconds / cores;
+}
+
+TEST(BENCHMARK, MemorySparseTablePipeline) {
+  Table *table = CreateBenchmarkTable();
+  std::mt19937_64 rng(0);
+  std::vector<uint64_t> keys(FLAGS_sparse_table_bench_key_num);
+  for (auto &key : keys) {
+    key = rng();
+  }
+
+  int default_batch_size = FLAGS_pserver_sparse_pipeline_batch_size;
+  int default_prefetch_distance = FLAGS_pserver_sparse_prefetch_distance;
+  // the first run also creates every key
+  RunTableBenchmark(table, keys, 1, 0);
+  RunTableBenchmark(table, keys, 1, 0);
+  RunTableBenchmark(
+      table, keys, default_batch_size, default_prefetch_distance);
+  FLAGS_pserver_sparse_pipeline_batch_size = default_batch_size;
+  FLAGS_pserver_sparse_prefetch_distance = default_prefetch_distance;
+  delete table;
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -22,53 +22,24 @@ limitations under the License. */
 
 #include "google/protobuf/text_format.h"
 #include "gtest/gtest.h"
-#include "paddle/fluid/distributed/ps/table/table.h"
-#include "paddle/fluid/distributed/the_one_ps.pb.h"
+#include "paddle/fluid/distributed/test/memory_sparse_table_test_helper.h"
 
 namespace paddle {
 namespace distributed {
 
+// Creates a table of CtrCommonAccessor with naive SGD rules.
+static Table *CreateSGDTable(bool columnar = false) {
+  TableParameter table_config = CtrSGDTableParameter(10, 8);
+  table_config.set_enable_columnar_save(columnar);
+  table_config.set_enable_columnar_lazy_load(columnar);
+  return CreateMemorySparseTable(table_config);
+}
+
 TEST(MemorySparseTable, SGD) {
   int emb_dim = 8;
   int trainers = 2;
 
-  TableParameter table_config;
-  table_config.set_table_class("MemorySparseTable");
-  table_config.set_shard_num(10);
-  FsClientParameter fs_config;
-  Table *table = new MemorySparseTable();
-  table->SetShard(0, 1);
-
-  TableAccessorParameter *accessor_config = table_config.mutable_accessor();
-  accessor_config->set_accessor_class("CtrCommonAccessor");
-  accessor_config->set_fea_dim(11);
-  accessor_config->set_embedx_dim(8);
-  accessor_config->set_embedx_threshold(5);
-  accessor_config->mutable_ctr_accessor_param()->set_nonclk_coeff(0.2);
-  accessor_config->mutable_ctr_accessor_param()->set_click_coeff(1);
-  accessor_config->mutable_ctr_accessor_param()->set_base_threshold(0.5);
-  accessor_config->mutable_ctr_accessor_param()->set_delta_threshold(0.2);
-  accessor_config->mutable_ctr_accessor_param()->set_delta_keep_days(16);
-  accessor_config->mutable_ctr_accessor_param()->set_show_click_decay_rate(
-      0.99);
-
-  accessor_config->mutable_embed_sgd_param()->set_name("SparseNaiveSGDRule");
-  auto *naive_param =
-      accessor_config->mutable_embed_sgd_param()->mutable_naive();
-  naive_param->set_learning_rate(0.1);
-  naive_param->set_initial_range(0.3);
-  naive_param->add_weight_bounds(-10.0);
-  naive_param->add_weight_bounds(10.0);
-
-  accessor_config->mutable_embedx_sgd_param()->set_name("SparseNaiveSGDRule");
-  naive_param = accessor_config->mutable_embedx_sgd_param()->mutable_naive();
-  naive_param->set_learning_rate(0.1);
-  naive_param->set_initial_range(0.3);
-  naive_param->add_weight_bounds(-10.0);
-  naive_param->add_weight_bounds(10.0);
-
-  auto ret = table->Initialize(table_config, fs_config);
-  ASSERT_EQ(ret, 0);
+  Table *table = CreateSGDTable();
 
   // pull parameters for create and check
   std::vector<uint64_t> init_keys = {0, 1, 2, 3, 4};
@@ -152,5 +123,86 @@ TEST(MemorySparseTable, SGD) {
   }
 }
 
+TEST(MemorySparseTable, RepeatedNewKeyInPull) {
+  int emb_dim = 8;
+  size_t select_dim = emb_dim + 3;
+  Table *table = CreateSGDTable();
+
+  // a new key repeated in one pull batch is created only once
+  std::vector<uint64_t> keys = {7, 8, 7, 9, 7};
+  std::vector<uint32_t> fres(keys.size(), 1);
+  auto value = PullSparseValue(keys, fres, emb_dim);
+  std::vector<float> values(keys.size() * select_dim);
+  TableContext table_context;
+  table_context.value_type = Sparse;
+  table_context.pull_context.pull_value = value;
+  table_context.pull_context.values = values.data();
+  table->Pull(table_context);
+
+  std::vector<float> pulled_again(values.size());
+  table_context.pull_context.values = pulled_again.data();
+  table->Pull(table_context);
+
+  for (size_t i : {2, 4}) {
+    for (size_t j = 0; j < select_dim; ++j) {
+      ASSERT_EQ(values[i * select_dim + j], values[j]);
+    }
+  }
+  for (size_t i = 0; i < values.size(); ++i) {
+    ASSERT_EQ(pulled_again[i], values[i]);
+  }
+  delete table;
+}
+
+static std::vector<float> PullKeys(Table *table,
+                                   const std::vector<uint64_t> &keys) {
+  size_t select_dim = 8 + 3;
+  std::vector<uint32_t> fres(keys.size(), 1);
+  auto value = PullSparseValue(keys, fres, 8);
+  std::vector<float> values(keys.size() * select_dim);
+  TableContext table_context;
+  table_context.value_type = Sparse;
+  table_context.pull_context.pull_value = value;
+  table_context.pull_context.values = values.data();
+  table->Pull(table_context);
+  return values;
+}
+
+TEST(MemorySparseTable, TextLoadDropsColumnarMapping) {
+  std::vector<uint64_t> keys = {1, 2, 3};
+  Table *columnar = CreateSGDTable(/*columnar*/ true);
+  std::vector<float> saved = PullKeys(columnar, keys);
+  ASSERT_EQ(columnar->Save("./memory_sparse_table_col", "0"), 0);
+  delete columnar;
+
+  Table *text = CreateSGDTable();
+  PullKeys(text, {4});
+  ASSERT_EQ(text->Save("./memory_sparse_table_text", "0"), 0);
+  delete text;
+
+  // the columnar files are written raw, so they are served mapped
+  Table *table = CreateSGDTable(/*columnar*/ true);
+  ASSERT_EQ(table->Load("./memory_sparse_table_col", "0"), 0);
+  ASSERT_EQ(PullKeys(table, keys), saved);
+  delete table;
+
+  // rows created before a lazy load do not shadow the mapped checkpoint
+  table = CreateSGDTable(/*columnar*/ true);
+  ASSERT_NE(PullKeys(table, keys), saved);
+  ASSERT_EQ(table->Load("./memory_sparse_table_col", "0"), 0);
+  ASSERT_EQ(PullKeys(table, keys), saved);
+  delete table;
+
+  // a text load replaces the table, the old mapping is gone
+  table = CreateSGDTable(/*columnar*/ true);
+  ASSERT_EQ(table->Load("./memory_sparse_table_col", "0"), 0);
+  ASSERT_EQ(table->Load("./memory_sparse_table_text", "0"), 0);
+  ASSERT_NE(PullKeys(table, keys), saved);
+  delete table;
+  ASSERT_EQ(system("rm -rf ./memory_sparse_table_col "
+                   "./memory_sparse_table_text"),
+            0);
+}
+
 }  // namespace distributed
 }  // namespace paddle
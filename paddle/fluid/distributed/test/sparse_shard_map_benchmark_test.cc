@@ -0,0 +1,134 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/distributed/test/memory_sparse_table_test_helper.h"
+#include "paddle/utils/string/string_helper.h"
+
+// 1e8 and 1e9 keys need tens of GB, so only 1e6 runs by default, e.g.
+// --sparse_shard_bench_key_nums=1000000,100000000,1000000000
+PD_DEFINE_string(sparse_shard_bench_key_nums,
+                 "1000000",
+                 "comma separated key numbers of the sparse shard benchmark");
+PD_DEFINE_int32(sparse_shard_bench_batch_num,
+                100,
+                "pull/push batches run per key number");
+
+namespace paddle {
+namespace distributed {
+
+static const int kBenchEmbDim = 8;
+static const size_t kBenchBatchSize = 100000;
+
+static double ElapsedSeconds(
+    const std::chrono::steady_clock::time_point& start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+static Table* CreateBenchmarkTable(bool use_swiss_map) {
+  TableParameter table_config = CtrSGDTableParameter(1000, kBenchEmbDim);
+  table_config.set_enable_swiss_map(use_swiss_map);
+  return CreateMemorySparseTable(table_config);
+}
+
+// Pulls keys, creating the missing ones, and returns the seconds taken.
+static double PullKeys(Table* table,
+                       std::vector<uint64_t>* keys,
+                       std::vector<float>* values) {
+  std::vector<uint32_t> fres(keys->size(), 1);
+  TableContext context;
+  context.value_type = Sparse;
+  context.pull_context.pull_value =
+      PullSparseValue(*keys, fres, kBenchEmbDim);
+  context.pull_context.values = values->data();
+  auto start = std::chrono::steady_clock::now();
+  table->Pull(context);
+  return ElapsedSeconds(start);
+}
+
+static double PushKeys(Table* table,
+                       const std::vector<uint64_t>& keys,
+                       const std::vector<float>& values) {
+  TableContext context;
+  context.value_type = Sparse;
+  context.push_context.keys = keys.data();
+  context.push_context.values = values.data();
+  context.num = keys.size();
+  auto start = std::chrono::steady_clock::now();
+  table->Push(context);
+  return ElapsedSeconds(start);
+}
+
+static void RunTableBenchmark(bool use_swiss_map, size_t key_num) {
+  Table* table = CreateBenchmarkTable(use_swiss_map);
+  std::mt19937_64 rng(key_num);
+  // distinct keys spread over the whole range
+  std::vector<uint64_t> all_keys(key_num);
+  for (size_t i = 0; i < key_num; ++i) {
+    all_keys[i] = (i + 1) * 0x9E3779B97F4A7C15ULL;
+  }
+
+  std::vector<uint64_t> batch;
+  std::vector<float> pull_values(kBenchBatchSize * (kBenchEmbDim + 3));
+  std::vector<float> push_values(kBenchBatchSize * (kBenchEmbDim + 4), 0.1);
+  double build_seconds = 0;
+  for (size_t begin = 0; begin < key_num; begin += kBenchBatchSize) {
+    size_t end = std::min(key_num, begin + kBenchBatchSize);
+    batch.assign(all_keys.begin() + begin, all_keys.begin() + end);
+    build_seconds += PullKeys(table, &batch, &pull_values);
+  }
+
+  batch.resize(kBenchBatchSize);
+  double pull_seconds = 0;
+  double push_seconds = 0;
+  for (int b = 0; b < FLAGS_sparse_shard_bench_batch_num; ++b) {
+    for (auto& key : batch) {
+      key = all_keys[rng() % key_num];
+    }
+    pull_seconds += PullKeys(table, &batch, &pull_values);
+    push_seconds += PushKeys(table, batch, push_values);
+  }
+  EXPECT_EQ(dynamic_cast<MemorySparseTable*>(table)->LocalSize(),
+            static_cast<int64_t>(key_num));
+
+  double total = static_cast<double>(FLAGS_sparse_shard_bench_batch_num) *
+                 kBenchBatchSize;
+  LOG(INFO) << (use_swiss_map ? "swiss_map" : "closed_hash_map")
+            << " keys: " << key_num << " build: " << build_seconds << "s"
+            << " pull qps: " << total / pull_seconds
+            << " push qps: " << total / push_seconds;
+  delete table;
+}
+
+TEST(BENCHMARK, SparseShardMap) {
+  auto key_nums = paddle::string::split_string<std::string>(
+      FLAGS_sparse_shard_bench_key_nums, ",");
+  for (auto& key_num : key_nums) {
+    size_t num = std::stoull(key_num);
+    RunTableBenchmark(false, num);
+    RunTableBenchmark(true, num);
+  }
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -0,0 +1,88 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/distributed/ps/table/depends/ssd_hot_cache.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace distributed {
+
+TEST(SSDHotCache, TakeAndCounters) {
+  SSDHotCache cache(4);
+  std::vector<float> value = {1.0, 2.0, 3.0};
+  ASSERT_TRUE(cache.Admit(1, value.data(), value.size()));
+  ASSERT_EQ(cache.Size(), 1UL);
+
+  std::vector<float> out;
+  ASSERT_TRUE(cache.Take(1, &out));
+  ASSERT_EQ(out, value);
+  // a taken value went back to memory
+  ASSERT_FALSE(cache.Take(1, &out));
+  ASSERT_EQ(cache.Hits(), 1UL);
+  ASSERT_EQ(cache.Misses(), 1UL);
+  ASSERT_EQ(cache.Size(), 0UL);
+}
+
+TEST(SSDHotCache, FrequencyAdmission) {
+  SSDHotCache cache(2);
+  std::vector<float> value = {1.0};
+  std::vector<uint64_t> hot_keys = {10, 11};
+  for (int i = 0; i < 5; ++i) {
+    cache.RecordAccess(hot_keys.data(), hot_keys.size());
+  }
+  ASSERT_TRUE(cache.Admit(10, value.data(), value.size()));
+  ASSERT_TRUE(cache.Admit(11, value.data(), value.size()));
+
+  // a key seen once can not evict a hotter one
+  uint64_t cold_key = 12;
+  cache.RecordAccess(&cold_key, 1);
+  ASSERT_FALSE(cache.Admit(cold_key, value.data(), value.size()));
+  ASSERT_EQ(cache.Rejected(), 1UL);
+
+  // once it is accessed more often, it replaces the LRU entry
+  for (int i = 0; i < 10; ++i) {
+    cache.RecordAccess(&cold_key, 1);
+  }
+  ASSERT_TRUE(cache.Admit(cold_key, value.data(), value.size()));
+  ASSERT_EQ(cache.Size(), 2UL);
+
+  std::vector<float> out;
+  ASSERT_FALSE(cache.Take(10, &out));
+  ASSERT_TRUE(cache.Take(12, &out));
+}
+
+TEST(SSDHotCache, EraseAndRefresh) {
+  SSDHotCache cache(2);
+  std::vector<float> value = {1.0, 2.0};
+  ASSERT_TRUE(cache.Admit(1, value.data(), value.size()));
+
+  // a value written to rocksdb again replaces the cached one
+  std::vector<float> new_value = {3.0, 4.0};
+  ASSERT_TRUE(cache.Admit(1, new_value.data(), new_value.size()));
+  std::vector<float> out;
+  ASSERT_TRUE(cache.Take(1, &out));
+  ASSERT_EQ(out, new_value);
+
+  // a value superseded in memory is dropped
+  ASSERT_TRUE(cache.Admit(1, value.data(), value.size()));
+  cache.Erase(1);
+  ASSERT_EQ(cache.Size(), 0UL);
+  ASSERT_FALSE(cache.Take(1, &out));
+}
+
+}  // namespace distributed
+}  // namespace paddle
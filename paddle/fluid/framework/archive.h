@@ -352,8 +352,8 @@ Archive<AR>& operator>>(Archive<AR>& ar, T (&p)[N]) {
   return ar;
 }
 
-template <class AR, class T>
-Archive<AR>& operator<<(Archive<AR>& ar, const std::vector<T>& p) {
+template <class AR, class T, class Alloc>
+Archive<AR>& operator<<(Archive<AR>& ar, const std::vector<T, Alloc>& p) {
 #ifdef _LINUX
   ar << static_cast<size_t>(p.size());
 #else
@@ -365,8 +365,8 @@ Archive<AR>& operator<<(Archive<AR>& ar, const std::vector<T>& p) {
   return ar;
 }
 
-template <class AR, class T>
-Archive<AR>& operator>>(Archive<AR>& ar, std::vector<T>& p) {
+template <class AR, class T, class Alloc>
+Archive<AR>& operator>>(Archive<AR>& ar, std::vector<T, Alloc>& p) {
 #ifdef _LINUX
   p.resize(ar.template Get<size_t>());
 #else
@@ -30,6 +30,7 @@
 #include <utility>
 #include <vector>
 
+#include "paddle/fluid/framework/lock_free_channel.h"
 #include "paddle/phi/core/expect.h"
 
 namespace paddle {
@@ -41,17 +42,40 @@ class ChannelObject {
   ChannelObject() {}
 
   // capacity can be zero
-  explicit ChannelObject(size_t capacity) {
+  explicit ChannelObject(size_t capacity, bool lock_free = false) {
     capacity_ = (std::min)(MaxCapacity(), capacity);
+    if (lock_free) {
+      SetLockFreeUnlocked(true);
+    }
   }
 
-  const std::deque<T>& GetData() const { return data_; }
+  const std::deque<T>& GetData() const {
+    CHECK(queue_ == nullptr) << "GetData() is not supported by lock-free "
+                                "channels";
+    return data_;
+  }
   void Clear() {
     std::unique_lock<std::mutex> lock(mutex_);
+    if (queue_ != nullptr) {
+      queue_->Clear();
+      return;
+    }
     data_.clear();
     data_.shrink_to_fit();
   }
 
+  bool LockFree() { return queue_ != nullptr; }
+
+  // A lock-free channel stores its data in a LockFreeChannelQueue, so that
+  // the readers and writers of blocks of data do not serialize on the mutex.
+  // It keeps the semantics of the channel, except that a zero capacity is
+  // taken as 1 and that Close() does not wait for the writes in progress.
+  // Can only be set while the channel is empty and not used.
+  void SetLockFree(bool lock_free) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SetLockFreeUnlocked(lock_free);
+  }
+
   size_t Capacity() {
     return capacity_;  // atomic
   }
@@ -59,6 +83,9 @@ class ChannelObject {
   void SetCapacity(size_t x) {  // capacity can be zero
     std::lock_guard<std::mutex> lock(mutex_);
     capacity_ = std::min(MaxCapacity(), x);
+    if (queue_ != nullptr) {
+      queue_->SetCapacity(capacity_);
+    }
     Notify();
   }
 
@@ -77,6 +104,7 @@ class ChannelObject {
     std::lock_guard<std::mutex> lock(mutex_);
     capacity_ = other->Capacity();
     block_size_ = other->BlockSize();
+    SetLockFreeUnlocked(other->LockFree());
   }
 
   bool Closed() {
@@ -87,6 +115,9 @@ class ChannelObject {
   void Open() {
     std::lock_guard<std::mutex> lock(mutex_);
     closed_ = false;
+    if (queue_ != nullptr) {
+      queue_->SetClosed(false);
+    }
     Notify();
   }
 
@@ -94,15 +125,24 @@ class ChannelObject {
   void Close() {
     std::lock_guard<std::mutex> lock(mutex_);
     closed_ = true;
+    if (queue_ != nullptr) {
+      queue_->SetClosed(true);
+    }
     Notify();
   }
 
   size_t Size() {
+    if (queue_ != nullptr) {
+      return queue_->Size();
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return data_.size();
   }
 
   bool Empty() {
+    if (queue_ != nullptr) {
+      return queue_->Size() == 0;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return EmptyUnlocked();
   }
@@ -116,6 +156,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (queue_ != nullptr) {
+      return queue_->Read(n, p, false);
+    }
 
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Read(n, p, lock);
@@ -135,6 +178,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (queue_ != nullptr) {
+      return queue_->Write(n, p);
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Write(n, p, lock);
     Notify();
@@ -146,6 +192,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (queue_ != nullptr) {
+      return queue_->WriteMove(n, p);
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = WriteMove(n, p, lock);
     Notify();
@@ -164,6 +213,12 @@ class ChannelObject {
     if (size == 0) {
       return 0;
     }
+    if (queue_ != nullptr) {
+      p.resize(size);
+      size_t finished = queue_->Read(size, &p[0], true);
+      p.resize(finished);
+      return finished;
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     p.resize(size);
     size_t finished = Read(size, &p[0], lock, true);
@@ -205,11 +260,28 @@ class ChannelObject {
   int full_waiters_ = 0;
   std::condition_variable empty_cond_;
   std::condition_variable full_cond_;
+  // set if lock-free, in which case the members above except the capacity,
+  // the block size and closed are not used
+  std::unique_ptr<LockFreeChannelQueue<T>> queue_;
 
   static constexpr size_t MaxCapacity() {
     return (std::numeric_limits<size_t>::max)() / 2;
   }
 
+  void SetLockFreeUnlocked(bool lock_free) {
+    if (lock_free == (queue_ != nullptr)) {
+      return;
+    }
+    CHECK(data_.empty() && (queue_ == nullptr || queue_->Size() == 0))
+        << "can not switch a channel holding data to or from lock-free";
+    if (lock_free) {
+      queue_ = std::make_unique<LockFreeChannelQueue<T>>(capacity_);
+      queue_->SetClosed(closed_);
+    } else {
+      queue_.reset();
+    }
+  }
+
   void Notify() {
     if (empty_waiters_ != 0 && (!EmptyUnlocked() || closed_)) {
       empty_cond_.notify_one();
@@ -310,8 +382,9 @@ template <class T>
 using Channel = std::shared_ptr<ChannelObject<T>>;
 
 template <class T>
-Channel<T> MakeChannel(size_t capacity = (std::numeric_limits<size_t>::max)()) {
-  return std::make_shared<ChannelObject<T>>(capacity);
+Channel<T> MakeChannel(size_t capacity = (std::numeric_limits<size_t>::max)(),
+                       bool lock_free = false) {
+  return std::make_shared<ChannelObject<T>>(capacity, lock_free);
 }
 
 template <class T, class U>
@@ -0,0 +1,524 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#if defined _WIN32 || defined __APPLE__
+#else
+#define _LINUX
+#endif
+
+#include "paddle/fluid/framework/columnar_record.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+#ifdef _LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "paddle/fluid/platform/enforce.h"
+#include "zlib.h"
+
+namespace paddle::framework {
+
+namespace {
+
+struct FileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t slots_fingerprint;
+};
+
+struct BlockHeader {
+  uint32_t record_num;
+  uint32_t codec;
+  uint64_t raw_size;
+  uint64_t stored_size;
+};
+
+template <typename T>
+void AppendColumn(const std::vector<T>& column, std::string* raw) {
+  raw->append(reinterpret_cast<const char*>(column.data()),
+              column.size() * sizeof(T));
+}
+
+// Hands out the columns of a decoded block one after another.
+class ColumnCursor {
+ public:
+  ColumnCursor(const char* data, size_t size, const std::string& filename)
+      : data_(data), size_(size), filename_(filename) {}
+
+  template <typename T>
+  const char* Take(size_t num) {
+    size_t bytes = num * sizeof(T);
+    PADDLE_ENFORCE_LE(
+        bytes,
+        size_ - offset_,
+        platform::errors::InvalidArgument(
+            "Columnar record file %s is corrupted, a column of %d bytes "
+            "exceeds its block.",
+            filename_,
+            bytes));
+    const char* column = data_ + offset_;
+    offset_ += bytes;
+    return column;
+  }
+
+  bool Exhausted() const { return offset_ == size_; }
+
+ private:
+  const char* data_;
+  size_t size_;
+  size_t offset_{0};
+  const std::string& filename_;
+};
+
+template <typename T>
+T Load(const char* column, size_t i) {
+  T value;
+  memcpy(&value, column + i * sizeof(T), sizeof(T));
+  return value;
+}
+
+// Takes the offsets of a column of n records, total is set to the number of
+// elements of the column.
+const char* TakeOffsets(ColumnCursor* cursor,
+                        size_t n,
+                        const std::string& filename,
+                        size_t* total) {
+  const char* offsets = cursor->Take<uint32_t>(n + 1);
+  for (size_t i = 0; i < n; ++i) {
+    PADDLE_ENFORCE_LE(
+        Load<uint32_t>(offsets, i),
+        Load<uint32_t>(offsets, i + 1),
+        platform::errors::InvalidArgument(
+            "Columnar record file %s is corrupted, the offsets of a column "
+            "are not sorted.",
+            filename));
+  }
+  PADDLE_ENFORCE_EQ(
+      Load<uint32_t>(offsets, 0),
+      0U,
+      platform::errors::InvalidArgument(
+          "Columnar record file %s is corrupted, the offsets of a column do "
+          "not start at 0.",
+          filename));
+  *total = Load<uint32_t>(offsets, n);
+  return offsets;
+}
+
+void DecodeStrings(ColumnCursor* cursor,
+                   size_t n,
+                   const std::string& filename,
+                   std::string Record::*member,
+                   Record* records) {
+  size_t total = 0;
+  const char* offsets = TakeOffsets(cursor, n, filename, &total);
+  const char* chars = cursor->Take<char>(total);
+  for (size_t i = 0; i < n; ++i) {
+    uint32_t begin = Load<uint32_t>(offsets, i);
+    uint32_t end = Load<uint32_t>(offsets, i + 1);
+    (records[i].*member).assign(chars + begin, end - begin);
+  }
+}
+
+template <typename T>
+void DecodeFeasigns(ColumnCursor* cursor,
+                    size_t n,
+                    const std::string& filename,
+                    FeatureItemVector Record::*member,
+                    Record* records) {
+  size_t total = 0;
+  const char* offsets = TakeOffsets(cursor, n, filename, &total);
+  const char* values = cursor->Take<T>(total);
+  const char* slots = cursor->Take<uint16_t>(total);
+  for (size_t i = 0; i < n; ++i) {
+    uint32_t begin = Load<uint32_t>(offsets, i);
+    uint32_t end = Load<uint32_t>(offsets, i + 1);
+    auto& feasigns = records[i].*member;
+    feasigns.reserve(end - begin);
+    for (uint32_t j = begin; j < end; ++j) {
+      FeatureFeasign sign;
+      sign.uint64_feasign_ = 0;
+      memcpy(&sign, values + j * sizeof(T), sizeof(T));
+      feasigns.emplace_back(sign, Load<uint16_t>(slots, j));
+    }
+  }
+}
+
+}  // namespace
+
+uint64_t ColumnarSlotsFingerprint(const DataFeedDesc& data_feed_desc) {
+  // FNV-1a
+  uint64_t hash = 14695981039346656037ULL;
+  auto update = [&hash](const std::string& str) {
+    for (char c : str) {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 1099511628211ULL;
+    }
+    // separates the strings
+    hash ^= 0xff;
+    hash *= 1099511628211ULL;
+  };
+  const auto& multi_slot_desc = data_feed_desc.multi_slot_desc();
+  for (int i = 0; i < multi_slot_desc.slots_size(); ++i) {
+    const auto& slot = multi_slot_desc.slots(i);
+    if (slot.is_used()) {
+      update(slot.name());
+      update(slot.type());
+    }
+  }
+  return hash;
+}
+
+ColumnarRecordWriter::ColumnarRecordWriter(const std::string& filename,
+                                           uint64_t slots_fingerprint,
+                                           int compress_level,
+                                           size_t block_record_num)
+    : filename_(filename),
+      compress_level_(compress_level),
+      block_record_num_(block_record_num) {
+  PADDLE_ENFORCE_EQ(
+      compress_level >= 0 && compress_level <= 9,
+      true,
+      platform::errors::InvalidArgument(
+          "The compress level of columnar record file should be in [0, 9], "
+          "but got %d.",
+          compress_level));
+  PADDLE_ENFORCE_GT(block_record_num,
+                    0UL,
+                    platform::errors::InvalidArgument(
+                        "The record number of a block should be positive."));
+  fp_ = fopen(filename.c_str(), "wb");
+  PADDLE_ENFORCE_NOT_NULL(
+      fp_,
+      platform::errors::Unavailable(
+          "Fail to open file: %s for writing columnar records, error: %s.",
+          filename,
+          strerror(errno)));
+  FileHeader header{
+      kColumnarRecordMagic, kColumnarRecordVersion, slots_fingerprint};
+  PADDLE_ENFORCE_EQ(fwrite(&header, sizeof(header), 1, fp_),
+                    1UL,
+                    platform::errors::Unavailable(
+                        "Fail to write columnar record file: %s.", filename));
+}
+
+ColumnarRecordWriter::~ColumnarRecordWriter() {
+  if (fp_ != nullptr) {
+    fclose(fp_);
+  }
+}
+
+void ColumnarRecordWriter::Write(const Record& record) {
+  search_ids_.push_back(record.search_id);
+  ranks_.push_back(record.rank);
+  cmatches_.push_back(record.cmatch);
+  for (auto pair : {std::make_pair(&record.ins_id_, &ins_ids_),
+                    std::make_pair(&record.uid_, &uids_),
+                    std::make_pair(&record.content_, &contents_)}) {
+    StringColumn* column = pair.second;
+    column->chars.append(*pair.first);
+    column->offsets.push_back(static_cast<uint32_t>(column->chars.size()));
+  }
+  for (auto& item : record.uint64_feasigns_) {
+    uint64_feasigns_.values.push_back(item.sign().uint64_feasign_);
+    uint64_feasigns_.slots.push_back(item.slot());
+  }
+  uint64_feasigns_.offsets.push_back(
+      static_cast<uint32_t>(uint64_feasigns_.values.size()));
+  for (auto& item : record.float_feasigns_) {
+    float_feasigns_.values.push_back(item.sign().float_feasign_);
+    float_feasigns_.slots.push_back(item.slot());
+  }
+  float_feasigns_.offsets.push_back(
+      static_cast<uint32_t>(float_feasigns_.values.size()));
+  ++record_num_;
+  // the offsets are 32 bits, which a block of strings or feasigns must not
+  // outgrow
+  size_t max_column_size =
+      std::max({ins_ids_.chars.size(),
+                uids_.chars.size(),
+                contents_.chars.size(),
+                uint64_feasigns_.values.size(),
+                float_feasigns_.values.size()});
+  if (++block_size_ == block_record_num_ ||
+      max_column_size >= (std::numeric_limits<uint32_t>::max() >> 1)) {
+    FlushBlock();
+  }
+}
+
+void ColumnarRecordWriter::FlushBlock() {
+  if (block_size_ == 0) {
+    return;
+  }
+  raw_.clear();
+  AppendColumn(search_ids_, &raw_);
+  AppendColumn(ranks_, &raw_);
+  AppendColumn(cmatches_, &raw_);
+  for (StringColumn* column : {&ins_ids_, &uids_, &contents_}) {
+    AppendColumn(column->offsets, &raw_);
+    raw_.append(column->chars);
+  }
+  AppendColumn(uint64_feasigns_.offsets, &raw_);
+  AppendColumn(uint64_feasigns_.values, &raw_);
+  AppendColumn(uint64_feasigns_.slots, &raw_);
+  AppendColumn(float_feasigns_.offsets, &raw_);
+  AppendColumn(float_feasigns_.values, &raw_);
+  AppendColumn(float_feasigns_.slots, &raw_);
+
+  BlockHeader header{static_cast<uint32_t>(block_size_),
+                     static_cast<uint32_t>(ColumnarRecordCodec::kNone),
+                     raw_.size(),
+                     raw_.size()};
+  const std::string* payload = &raw_;
+  if (compress_level_ > 0) {
+    uLongf stored_size = compressBound(raw_.size());
+    stored_.resize(stored_size);
+    int ret = compress2(reinterpret_cast<Bytef*>(&stored_[0]),
+                        &stored_size,
+                        reinterpret_cast<const Bytef*>(raw_.data()),
+                        raw_.size(),
+                        compress_level_);
+    PADDLE_ENFORCE_EQ(ret,
+                      Z_OK,
+                      platform::errors::External(
+                          "Fail to compress a block of columnar record file "
+                          "%s, zlib error %d.",
+                          filename_,
+                          ret));
+    // incompressible blocks are stored as they are
+    if (stored_size < raw_.size()) {
+      stored_.resize(stored_size);
+      header.codec = static_cast<uint32_t>(ColumnarRecordCodec::kZlib);
+      header.stored_size = stored_size;
+      payload = &stored_;
+    }
+  }
+  PADDLE_ENFORCE_EQ(
+      fwrite(&header, sizeof(header), 1, fp_) == 1 &&
+          fwrite(payload->data(), 1, payload->size(), fp_) == payload->size(),
+      true,
+      platform::errors::Unavailable("Fail to write columnar record file: %s.",
+                                    filename_));
+
+  block_size_ = 0;
+  search_ids_.clear();
+  ranks_.clear();
+  cmatches_.clear();
+  for (StringColumn* column : {&ins_ids_, &uids_, &contents_}) {
+    column->offsets.resize(1);
+    column->chars.clear();
+  }
+  uint64_feasigns_.offsets.resize(1);
+  uint64_feasigns_.values.clear();
+  uint64_feasigns_.slots.clear();
+  float_feasigns_.offsets.resize(1);
+  float_feasigns_.values.clear();
+  float_feasigns_.slots.clear();
+}
+
+void ColumnarRecordWriter::Close() {
+  if (fp_ == nullptr) {
+    return;
+  }
+  FlushBlock();
+  int ret = fclose(fp_);
+  fp_ = nullptr;
+  PADDLE_ENFORCE_EQ(ret,
+                    0,
+                    platform::errors::Unavailable(
+                        "Fail to close columnar record file: %s.", filename_));
+  VLOG(3) << "Write " << record_num_ << " records to columnar record file "
+          << filename_;
+}
+
+ColumnarRecordReader::ColumnarRecordReader(const std::string& filename,
+                                           uint64_t slots_fingerprint)
+    : filename_(filename) {
+#ifdef _LINUX
+  fd_ = open(filename.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_NE(
+      fd_,
+      -1,
+      platform::errors::Unavailable(
+          "Fail to open columnar record file: %s, error: %s. Columnar record "
+          "files are read through mmap and have to be local.",
+          filename,
+          strerror(errno)));
+
+  struct stat sb = {};
+  fstat(fd_, &sb);
+  end_ = static_cast<size_t>(sb.st_size);
+  PADDLE_ENFORCE_GE(end_,
+                    sizeof(FileHeader),
+                    platform::errors::InvalidArgument(
+                        "File %s is not a columnar record file.", filename));
+
+  buffer_ = reinterpret_cast<char*>(
+      mmap(nullptr, end_, PROT_READ, MAP_PRIVATE, fd_, 0));
+  PADDLE_ENFORCE_NE(
+      buffer_,
+      MAP_FAILED,
+      platform::errors::Unavailable(
+          "Memory map failed when reading columnar record file %s, error "
+          "number is %s.",
+          filename,
+          strerror(errno)));
+  madvise(buffer_, end_, MADV_SEQUENTIAL);
+
+  FileHeader header;
+  memcpy(&header, buffer_, sizeof(header));
+  offset_ = sizeof(header);
+  PADDLE_ENFORCE_EQ(header.magic,
+                    kColumnarRecordMagic,
+                    platform::errors::InvalidArgument(
+                        "File %s is not a columnar record file.", filename));
+  PADDLE_ENFORCE_EQ(
+      header.version,
+      kColumnarRecordVersion,
+      platform::errors::Unimplemented(
+          "Version %d of columnar record file %s is not supported.",
+          header.version,
+          filename));
+  if (slots_fingerprint != 0) {
+    PADDLE_ENFORCE_EQ(
+        header.slots_fingerprint,
+        slots_fingerprint,
+        platform::errors::InvalidArgument(
+            "Columnar record file %s was written with other used slots, "
+            "please read it with the slot config it was written with.",
+            filename));
+  }
+#else
+  PADDLE_THROW(platform::errors::Unimplemented(
+      "Columnar record files are only supported on Linux."));
+#endif
+}
+
+ColumnarRecordReader::~ColumnarRecordReader() {
+#ifdef _LINUX
+  if (buffer_ != nullptr) {
+    munmap(buffer_, end_);
+  }
+  if (fd_ != -1) {
+    close(fd_);
+  }
+#endif
+}
+
+bool ColumnarRecordReader::ReadBlock(std::vector<Record>* records) {
+  if (offset_ == end_) {
+    return false;
+  }
+  BlockHeader header;
+  PADDLE_ENFORCE_GE(
+      end_ - offset_,
+      sizeof(header),
+      platform::errors::InvalidArgument(
+          "Columnar record file %s is truncated.", filename_));
+  memcpy(&header, buffer_ + offset_, sizeof(header));
+  offset_ += sizeof(header);
+  PADDLE_ENFORCE_GE(
+      end_ - offset_,
+      header.stored_size,
+      platform::errors::InvalidArgument(
+          "Columnar record file %s is truncated.", filename_));
+  const char* payload = buffer_ + offset_;
+  offset_ += header.stored_size;
+
+  const char* data = payload;
+  if (header.codec == static_cast<uint32_t>(ColumnarRecordCodec::kZlib)) {
+    // deflate does not compress better than 1032:1, a larger raw size is
+    // corrupted and must not size the buffer
+    PADDLE_ENFORCE_LE(
+        header.raw_size / 1032,
+        header.stored_size,
+        platform::errors::InvalidArgument(
+            "Columnar record file %s is corrupted, a block of %d bytes can "
+            "not be decompressed to %d bytes.",
+            filename_,
+            header.stored_size,
+            header.raw_size));
+    raw_.resize(header.raw_size);
+    uLongf raw_size = header.raw_size;
+    int ret = uncompress(reinterpret_cast<Bytef*>(&raw_[0]),
+                         &raw_size,
+                         reinterpret_cast<const Bytef*>(payload),
+                         header.stored_size);
+    PADDLE_ENFORCE_EQ(
+        ret == Z_OK && raw_size == header.raw_size,
+        true,
+        platform::errors::InvalidArgument(
+            "Fail to decompress a block of columnar record file %s, zlib "
+            "error %d.",
+            filename_,
+            ret));
+    data = raw_.data();
+  } else {
+    PADDLE_ENFORCE_EQ(
+        header.codec == static_cast<uint32_t>(ColumnarRecordCodec::kNone) &&
+            header.raw_size == header.stored_size,
+        true,
+        platform::errors::InvalidArgument(
+            "Columnar record file %s is corrupted, unknown codec %d.",
+            filename_,
+            header.codec));
+  }
+
+  // A record takes at least its search_id, rank and cmatch and an offset in
+  // each of the five offset columns, which have one more offset each. The
+  // record number is checked against the block before it sizes records.
+  size_t n = header.record_num;
+  PADDLE_ENFORCE_LE(
+      n * (sizeof(uint64_t) + 7 * sizeof(uint32_t)) + 5 * sizeof(uint32_t),
+      header.raw_size,
+      platform::errors::InvalidArgument(
+          "Columnar record file %s is corrupted, a block of %d bytes can not "
+          "hold %d records.",
+          filename_,
+          header.raw_size,
+          n));
+  size_t begin = records->size();
+  records->resize(begin + n);
+  Record* block = records->data() + begin;
+  ColumnCursor cursor(data, header.raw_size, filename_);
+  const char* search_ids = cursor.Take<uint64_t>(n);
+  const char* ranks = cursor.Take<uint32_t>(n);
+  const char* cmatches = cursor.Take<uint32_t>(n);
+  for (size_t i = 0; i < n; ++i) {
+    block[i].search_id = Load<uint64_t>(search_ids, i);
+    block[i].rank = Load<uint32_t>(ranks, i);
+    block[i].cmatch = Load<uint32_t>(cmatches, i);
+  }
+  DecodeStrings(&cursor, n, filename_, &Record::ins_id_, block);
+  DecodeStrings(&cursor, n, filename_, &Record::uid_, block);
+  DecodeStrings(&cursor, n, filename_, &Record::content_, block);
+  DecodeFeasigns<uint64_t>(
+      &cursor, n, filename_, &Record::uint64_feasigns_, block);
+  DecodeFeasigns<float>(&cursor, n, filename_, &Record::float_feasigns_, block);
+  PADDLE_ENFORCE_EQ(cursor.Exhausted(),
+                    true,
+                    platform::errors::InvalidArgument(
+                        "Columnar record file %s is corrupted, a block has "
+                        "unused bytes.",
+                        filename_));
+  return true;
+}
+
+}  // namespace paddle::framework
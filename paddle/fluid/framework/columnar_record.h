@@ -0,0 +1,131 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/data_feed.h"
+#include "paddle/fluid/framework/data_feed.pb.h"
+
+namespace paddle {
+namespace framework {
+
+// A columnar record file holds the Records parsed by
+// MultiSlotInMemoryDataFeed, so that they can be loaded again without
+// parsing any text. The file is a header followed by blocks of records:
+//
+//   FileHeader  magic, version, fingerprint of the used slots
+//   BlockHeader record number, codec, raw and stored payload size
+//   payload     the columns of the block, compressed by the codec
+//
+// The columns of a block of n records are, in order:
+//
+//   uint64 search_id[n], uint32 rank[n], uint32 cmatch[n]
+//   ins_id, uid and content, each as uint32 offsets[n + 1] and the chars
+//   uint64 feasigns as uint32 offsets[n + 1], uint64 values, uint16 slots
+//   float feasigns as uint32 offsets[n + 1], float values, uint16 slots
+//
+// The slots of the feasigns are indexes of the used slots, so a file can
+// only be read with the slot config it was written with, which is checked
+// by the fingerprint.
+
+constexpr uint32_t kColumnarRecordMagic = 0x52435044;  // "DPCR"
+constexpr uint32_t kColumnarRecordVersion = 1;
+
+enum class ColumnarRecordCodec : uint32_t {
+  kNone = 0,
+  kZlib = 1,
+};
+
+// Hash of the names and types of the used slots of data_feed_desc.
+uint64_t ColumnarSlotsFingerprint(const DataFeedDesc& data_feed_desc);
+
+class ColumnarRecordWriter {
+ public:
+  // compress_level is the zlib level of the blocks, from 1 to 9, and 0
+  // stores them uncompressed.
+  ColumnarRecordWriter(const std::string& filename,
+                       uint64_t slots_fingerprint,
+                       int compress_level,
+                       size_t block_record_num = 4096);
+  ~ColumnarRecordWriter();
+
+  void Write(const Record& record);
+
+  void Close();
+
+  size_t RecordNum() const { return record_num_; }
+
+ private:
+  void FlushBlock();
+
+  struct StringColumn {
+    std::vector<uint32_t> offsets{0};
+    std::string chars;
+  };
+
+  template <typename T>
+  struct FeasignColumn {
+    std::vector<uint32_t> offsets{0};
+    std::vector<T> values;
+    std::vector<uint16_t> slots;
+  };
+
+  std::string filename_;
+  FILE* fp_{nullptr};
+  int compress_level_;
+  size_t block_record_num_;
+  size_t record_num_{0};
+
+  // the columns of the current block
+  size_t block_size_{0};
+  std::vector<uint64_t> search_ids_;
+  std::vector<uint32_t> ranks_;
+  std::vector<uint32_t> cmatches_;
+  StringColumn ins_ids_;
+  StringColumn uids_;
+  StringColumn contents_;
+  FeasignColumn<uint64_t> uint64_feasigns_;
+  FeasignColumn<float> float_feasigns_;
+
+  std::string raw_;
+  std::string stored_;
+};
+
+// Reads a local columnar record file through mmap.
+class ColumnarRecordReader {
+ public:
+  // slots_fingerprint is checked against the one of the file unless it is 0.
+  ColumnarRecordReader(const std::string& filename, uint64_t slots_fingerprint);
+  ~ColumnarRecordReader();
+
+  // Decodes the next block into records, which are appended. Returns false
+  // at the end of the file.
+  bool ReadBlock(std::vector<Record>* records);
+
+ private:
+  std::string filename_;
+  int fd_{-1};
+  char* buffer_{nullptr};
+  size_t end_{0};
+  size_t offset_{0};
+  std::string raw_;
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -26,11 +26,13 @@ limitations under the License. */
 #include <sys/stat.h>
 #endif
 #include "io/fs.h"
+#include "paddle/fluid/framework/columnar_record.h"
 #include "paddle/fluid/platform/monitor.h"
 #include "paddle/fluid/platform/timer.h"
 
 USE_INT_STAT(STAT_total_feasign_num_in_mem);
 COMMON_DECLARE_bool(enable_ins_parser_file);
+COMMON_DECLARE_int64(dataset_prefetch_memory_budget_mb);
 namespace paddle::framework {
 
 DLManager& global_dlmanager_pool() {
@@ -38,6 +40,18 @@ DLManager& global_dlmanager_pool() {
   return manager;
 }
 
+// The lines of string::BlockLineReader are padded, which allows the faster
+// conversions of the feasigns.
+inline float ParseFloatFeasign(bool padded, char** endptr) {
+  return padded ? string::str_to_float_padded(*endptr, endptr)
+                : strtof(*endptr, endptr);
+}
+
+inline uint64_t ParseUint64Feasign(bool padded, char** endptr) {
+  return padded ? string::str_to_uint64_padded(*endptr, endptr)
+                : static_cast<uint64_t>(strtoull(*endptr, endptr, 10));
+}
+
 class BufferedLineFileReader {
   typedef std::function<bool()> SampleFunc;
   static const int MAX_FILE_BUFF_SIZE = 4 * 1024 * 1024;
@@ -234,6 +248,30 @@ bool DataFeed::PickOneFile(std::string* filename) {
   return true;
 }
 
+bool DataFeed::PickOnePrefetchFile(std::string* filename) {
+  PrefetchFileReader::Options options;
+  options.read_ahead = prefetch_read_ahead_;
+  options.parallel_reads = prefetch_read_ahead_;
+  fs_prefetch_set_memory_budget(
+      static_cast<size_t>(FLAGS_dataset_prefetch_memory_budget_mb) << 20);
+  prefetch_reader_.reset();
+  if (next_prefetch_reader_ == nullptr) {
+    if (!PickOneFile(&next_prefetch_file_)) {
+      return false;
+    }
+    next_prefetch_reader_ = std::make_unique<PrefetchFileReader>(
+        next_prefetch_file_, pipe_command_, options);
+  }
+  *filename = next_prefetch_file_;
+  prefetch_reader_ = std::move(next_prefetch_reader_);
+  // the next file is read while this one is parsed
+  if (PickOneFile(&next_prefetch_file_)) {
+    next_prefetch_reader_ = std::make_unique<PrefetchFileReader>(
+        next_prefetch_file_, pipe_command_, options);
+  }
+  return true;
+}
+
 void DataFeed::CheckInit() {
   PADDLE_ENFORCE_EQ(
       finish_init_,
@@ -538,28 +576,32 @@ void InMemoryDataFeed<T>::SetParseUid(bool parse_uid) {
 template <typename T>
 void InMemoryDataFeed<T>::LoadIntoMemory() {
 #ifdef _LINUX
+  RecordArenaScope arena_scope(this->record_arena_.get());
   if (!so_parser_name_.empty()) {
     LoadIntoMemoryFromSo();
     return;
   }
   VLOG(3) << "LoadIntoMemory() begin, thread_id=" << thread_id_;
   std::string filename;
-  while (this->PickOneFile(&filename)) {
+  while (this->prefetch_read_ahead_ > 0 ? this->PickOnePrefetchFile(&filename)
+                                        : this->PickOneFile(&filename)) {
     VLOG(3) << "PickOneFile, filename=" << filename
             << ", thread_id=" << thread_id_;
+    if (this->prefetch_reader_ == nullptr) {
 #ifdef PADDLE_WITH_BOX_PS
-    if (BoxWrapper::GetInstance()->UseAfsApi()) {
-      this->fp_ = BoxWrapper::GetInstance()->afs_manager->GetFile(
-          filename, this->pipe_command_);
-    } else {
+      if (BoxWrapper::GetInstance()->UseAfsApi()) {
+        this->fp_ = BoxWrapper::GetInstance()->afs_manager->GetFile(
+            filename, this->pipe_command_);
+      } else {
 #endif
-      int err_no = 0;
-      this->fp_ = fs_open_read(filename, &err_no, this->pipe_command_, true);
+        int err_no = 0;
+        this->fp_ = fs_open_read(filename, &err_no, this->pipe_command_, true);
 #ifdef PADDLE_WITH_BOX_PS
-    }
+      }
 #endif
-    CHECK(this->fp_ != nullptr);
-    __fsetlocking(&*(this->fp_), FSETLOCKING_BYCALLER);
+      CHECK(this->fp_ != nullptr);
+      __fsetlocking(&*(this->fp_), FSETLOCKING_BYCALLER);
+    }
     paddle::framework::ChannelWriter<T> writer(input_channel_);
     T instance;
     platform::Timer timeline;
@@ -692,6 +734,9 @@ void MultiSlotDataFeed::Init(
   }
   feed_vec_.resize(use_slots_.size());
   pipe_command_ = data_feed_desc.pipe_command();
+  prefetch_read_ahead_ = data_feed_desc.prefetch_read_ahead();
+  use_block_parser_ =
+      data_feed_desc.use_block_parser() || prefetch_read_ahead_ > 0;
   finish_init_ = true;
 }
 
@@ -699,11 +744,14 @@ void MultiSlotDataFeed::ReadThread() {
 #ifdef _LINUX
   VLOG(4) << "entering MultiSlotDataFeed::ReadThread()";
   std::string filename;
-  while (PickOneFile(&filename)) {
-    int err_no = 0;
-    fp_ = fs_open_read(filename, &err_no, pipe_command_, true);
-    CHECK(fp_ != nullptr);
-    __fsetlocking(&*fp_, FSETLOCKING_BYCALLER);
+  while (prefetch_read_ahead_ > 0 ? PickOnePrefetchFile(&filename)
+                                  : PickOneFile(&filename)) {
+    if (prefetch_reader_ == nullptr) {
+      int err_no = 0;
+      fp_ = fs_open_read(filename, &err_no, pipe_command_, true);
+      CHECK(fp_ != nullptr);
+      __fsetlocking(&*fp_, FSETLOCKING_BYCALLER);
+    }
     std::vector<MultiSlotType> instance;
     int ins_num = 0;
     while (ParseOneInstanceFromPipe(&instance)) {
@@ -859,15 +907,21 @@ bool MultiSlotDataFeed::ParseOneInstanceFromPipe(
     std::vector<MultiSlotType>* instance) {
 #ifdef _LINUX
   thread_local string::LineFileReader reader;
+  thread_local string::BlockLineReader block_reader;
 
-  if (!reader.getline(&*(fp_.get()))) {
+  const char* str = nullptr;
+  if (prefetch_reader_ != nullptr) {
+    str = block_reader.getline(prefetch_reader_.get());
+  } else if (use_block_parser_) {
+    str = block_reader.getline(&*(fp_.get()));
+  } else if (reader.getline(&*(fp_.get()))) {
+    str = reader.get();
+  }
+  if (str == nullptr) {
     return false;
   } else {
     int use_slots_num = use_slots_.size();
     instance->resize(use_slots_num);
-    const char* str = reader.get();
-    std::string line = std::string(str);
-
     char* endptr = const_cast<char*>(str);
     int pos = 0;
     for (size_t i = 0; i < use_slots_index_.size(); ++i) {
@@ -881,7 +935,7 @@ bool MultiSlotDataFeed::ParseOneInstanceFromPipe(
         ss << "The Origin Input Data:\n";
         ss << "----------------------\n";
 
-        ss << line << "\n";
+        ss << str << "\n";
 
         ss << "\n----------------------\n";
         ss << "Some Possible Errors:\n";
@@ -899,12 +953,12 @@ bool MultiSlotDataFeed::ParseOneInstanceFromPipe(
         (*instance)[idx].Init(all_slots_type_[i]);
         if ((*instance)[idx].GetType()[0] == 'f') {  // float
           for (int j = 0; j < num; ++j) {
-            float feasign = strtof(endptr, &endptr);
+            float feasign = ParseFloatFeasign(use_block_parser_, &endptr);
             (*instance)[idx].AddValue(feasign);
           }
         } else if ((*instance)[idx].GetType()[0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
-            uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
+            uint64_t feasign = ParseUint64Feasign(use_block_parser_, &endptr);
             (*instance)[idx].AddValue(feasign);
           }
         }
@@ -912,7 +966,7 @@ bool MultiSlotDataFeed::ParseOneInstanceFromPipe(
       } else {
         for (int j = 0; j <= num; ++j) {
           // pos = line.find_first_of(' ', pos + 1);
-          while (line[pos + 1] != ' ') {
+          while (str[pos + 1] != ' ') {
             pos++;
           }
         }
@@ -1118,6 +1172,9 @@ void MultiSlotInMemoryDataFeed::Init(
   visit_.resize(all_slot_num, false);
   pipe_command_ = data_feed_desc.pipe_command();
   so_parser_name_ = data_feed_desc.so_parser_name();
+  prefetch_read_ahead_ = data_feed_desc.prefetch_read_ahead();
+  use_block_parser_ =
+      data_feed_desc.use_block_parser() || prefetch_read_ahead_ > 0;
   finish_init_ = true;
   input_type_ = data_feed_desc.input_type();
 }
@@ -1148,13 +1205,25 @@ int MultiSlotInMemoryDataFeed::ParseInstanceFromSo(
 bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
 #ifdef _LINUX
   thread_local string::LineFileReader reader;
-
-  if (!reader.getline(&*(fp_.get()))) {
+  thread_local string::BlockLineReader block_reader;
+  // the feasigns are collected here and copied into the instance at once,
+  // which allocates the exact size, from the record arena if any
+  thread_local std::vector<FeatureItem> float_feasigns;
+  thread_local std::vector<FeatureItem> uint64_feasigns;
+
+  const char* str = nullptr;
+  if (prefetch_reader_ != nullptr) {
+    str = block_reader.getline(prefetch_reader_.get());
+  } else if (use_block_parser_) {
+    str = block_reader.getline(&*(fp_.get()));
+  } else if (reader.getline(&*(fp_.get()))) {
+    str = reader.get();
+  }
+  if (str == nullptr) {
     return false;
   } else {
-    const char* str = reader.get();
-    std::string line = std::string(str);
-    // VLOG(3) << line;
+    float_feasigns.clear();
+    uint64_feasigns.clear();
     char* endptr = const_cast<char*>(str);
     int pos = 0;
     if (parse_ins_id_) {
@@ -1237,7 +1306,7 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
       if (idx != -1) {
         if (all_slots_type_[i][0] == 'f') {  // float
           for (int j = 0; j < num; ++j) {
-            float feasign = strtof(endptr, &endptr);
+            float feasign = ParseFloatFeasign(use_block_parser_, &endptr);
             // if float feasign is equal to zero, ignore it
             // except when slot is dense
             if (fabs(feasign) < 1e-6 && !use_slots_is_dense_[i]) {
@@ -1245,11 +1314,11 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
             }
             FeatureFeasign f;
             f.float_feasign_ = feasign;
-            instance->float_feasigns_.emplace_back(f, idx);
+            float_feasigns.emplace_back(f, idx);
           }
         } else if (all_slots_type_[i][0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
-            uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
+            uint64_t feasign = ParseUint64Feasign(use_block_parser_, &endptr);
             // if uint64 feasign is equal to zero, ignore it
             // except when slot is dense
             if (feasign == 0 && !use_slots_is_dense_[i]) {
@@ -1257,21 +1326,23 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
             }
             FeatureFeasign f;
             f.uint64_feasign_ = feasign;
-            instance->uint64_feasigns_.emplace_back(f, idx);
+            uint64_feasigns.emplace_back(f, idx);
           }
         }
         pos = endptr - str;
       } else {
         for (int j = 0; j <= num; ++j) {
           // pos = line.find_first_of(' ', pos + 1);
-          while (line[pos + 1] != ' ') {
+          while (str[pos + 1] != ' ') {
             pos++;
           }
         }
       }
     }
-    instance->float_feasigns_.shrink_to_fit();
-    instance->uint64_feasigns_.shrink_to_fit();
+    instance->float_feasigns_.assign(float_feasigns.begin(),
+                                     float_feasigns.end());
+    instance->uint64_feasigns_.assign(uint64_feasigns.begin(),
+                                      uint64_feasigns.end());
     fea_num_ += instance->uint64_feasigns_.size();
     return true;
   }
@@ -1348,6 +1419,44 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
   return false;
 }
 
+void MultiSlotColumnarInMemoryDataFeed::Init(
+    const DataFeedDesc& data_feed_desc) {
+  MultiSlotInMemoryDataFeed::Init(data_feed_desc);
+  slots_fingerprint_ = ColumnarSlotsFingerprint(data_feed_desc);
+}
+
+void MultiSlotColumnarInMemoryDataFeed::LoadIntoMemory() {
+  VLOG(3) << "LoadIntoMemory() begin, thread_id=" << thread_id_;
+  RecordArenaScope arena_scope(record_arena_.get());
+  std::string filename;
+  std::vector<Record> records;
+  while (this->PickOneFile(&filename)) {
+    VLOG(3) << "PickOneFile, filename=" << filename
+            << ", thread_id=" << thread_id_;
+    platform::Timer timeline;
+    timeline.Start();
+    ColumnarRecordReader reader(filename, slots_fingerprint_);
+    while (reader.ReadBlock(&records)) {
+      for (auto& record : records) {
+        fea_num_ += record.uint64_feasigns_.size();
+      }
+      input_channel_->Write(std::move(records));
+      records.clear();
+    }
+    STAT_ADD(STAT_total_feasign_num_in_mem, fea_num_);
+    {
+      std::lock_guard<std::mutex> flock(*mutex_for_fea_num_);
+      *total_fea_num_ += fea_num_;
+      fea_num_ = 0;
+    }
+    timeline.Pause();
+    VLOG(3) << "LoadIntoMemory() read all records, file=" << filename
+            << ", cost time=" << timeline.ElapsedSec()
+            << " seconds, thread_id=" << thread_id_;
+  }
+  VLOG(3) << "LoadIntoMemory() end, thread_id=" << thread_id_;
+}
+
 void MultiSlotInMemoryDataFeed::PutToFeedVec(const Record* ins_vec, int num) {
 #ifdef _LINUX
   for (size_t i = 0; i < batch_float_feasigns_.size(); ++i) {
@@ -37,8 +37,10 @@ limitations under the License. */
 #include "paddle/fluid/framework/channel.h"
 #include "paddle/fluid/framework/data_feed.pb.h"
 #include "paddle/fluid/framework/fleet/fleet_wrapper.h"
+#include "paddle/fluid/framework/io/prefetch_reader.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/reader.h"
+#include "paddle/fluid/framework/record_arena.h"
 #include "paddle/fluid/framework/variable.h"
 #include "paddle/fluid/platform/timer.h"
 #include "paddle/utils/string/string_helper.h"
@@ -194,10 +196,14 @@ struct SlotRecordObject {
   }
 };
 using SlotRecord = SlotRecordObject*;
+// the feasigns of a Record, allocated from the record arena of the thread
+// which makes them, if any
+using FeatureItemVector =
+    std::vector<FeatureItem, RecordAllocator<FeatureItem>>;
 // sizeof Record is much less than std::vector<MultiSlotType>
 struct Record {
-  std::vector<FeatureItem> uint64_feasigns_;
-  std::vector<FeatureItem> float_feasigns_;
+  FeatureItemVector uint64_feasigns_;
+  FeatureItemVector float_feasigns_;
   std::string ins_id_;
   std::string content_;
   uint64_t search_id;
@@ -1199,6 +1205,11 @@ class DataFeed {
   virtual void SetParseLogKey(bool parse_logkey UNUSED) {}
   virtual void SetEnablePvMerge(bool enable_pv_merge UNUSED) {}
   virtual void SetCurrentPhase(int current_phase UNUSED) {}
+  // The Records loaded into memory are allocated from the arena, which is
+  // kept alive by the DataFeed as long as it may hold some of them.
+  void SetRecordArena(std::shared_ptr<RecordArena> arena) {
+    record_arena_ = arena;
+  }
 #if defined(PADDLE_WITH_GPU_GRAPH) && defined(PADDLE_WITH_HETERPS)
   virtual void InitGraphResource() {}
   virtual void InitGraphTrainResource() {}
@@ -1359,6 +1370,9 @@ class DataFeed {
   // This function is used to pick one file from the global filelist(thread
   // safe).
   virtual bool PickOneFile(std::string* filename);
+  // Picks one file as PickOneFile and opens it into prefetch_reader_. The
+  // file after it is picked and opened ahead.
+  virtual bool PickOnePrefetchFile(std::string* filename);
   virtual void CopyToFeedTensor(void* dst, const void* src, size_t size);
 
   std::vector<std::string> filelist_;
@@ -1399,6 +1413,16 @@ class DataFeed {
   bool finish_start_;
   std::string pipe_command_;
   std::string so_parser_name_;
+  // read the pipe in large blocks and parse the lines in place, see
+  // string::BlockLineReader
+  bool use_block_parser_ = false;
+  // read the files by PrefetchFileReader if > 0, in which case the lines
+  // come from prefetch_reader_ instead of fp_
+  int prefetch_read_ahead_ = 0;
+  std::unique_ptr<PrefetchFileReader> prefetch_reader_;
+  std::unique_ptr<PrefetchFileReader> next_prefetch_reader_;
+  std::string next_prefetch_file_;
+  std::shared_ptr<RecordArena> record_arena_;
   std::vector<SlotConf> slot_conf_;
   std::vector<std::string> ins_id_vec_;
   std::vector<std::string> ins_content_vec_;
@@ -1892,6 +1916,20 @@ class MultiSlotInMemoryDataFeed : public InMemoryDataFeed<Record> {
   virtual void PutToFeedVec(const Record* ins_vec, int num);
 };
 
+// Loads the local columnar record files dumped by
+// MultiSlotDataset::DumpColumnarRecords, which hold the records already
+// parsed, so no text is parsed and the pipe command is not used.
+class MultiSlotColumnarInMemoryDataFeed : public MultiSlotInMemoryDataFeed {
+ public:
+  MultiSlotColumnarInMemoryDataFeed() {}
+  virtual ~MultiSlotColumnarInMemoryDataFeed() {}
+  void Init(const DataFeedDesc& data_feed_desc) override;
+  void LoadIntoMemory() override;
+
+ protected:
+  uint64_t slots_fingerprint_{0};
+};
+
 class SlotRecordInMemoryDataFeed : public InMemoryDataFeed<SlotRecord> {
  public:
   SlotRecordInMemoryDataFeed() = default;
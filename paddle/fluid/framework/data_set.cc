@@ -14,11 +14,17 @@
 
 #include "paddle/fluid/framework/data_set.h"
 
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <type_traits>
+
 #include "google/protobuf/text_format.h"
 #if (defined PADDLE_WITH_DISTRIBUTE) && (defined PADDLE_WITH_PSCORE)
 #include "paddle/fluid/distributed/index_dataset/index_sampler.h"
 #endif
 #include "paddle/common/flags.h"
+#include "paddle/fluid/framework/columnar_record.h"
 #include "paddle/fluid/framework/data_feed_factory.h"
 #include "paddle/fluid/framework/fleet/fleet_wrapper.h"
 #include "paddle/fluid/framework/io/fs.h"
@@ -42,10 +48,30 @@ COMMON_DECLARE_bool(graph_get_neighbor_id);
 COMMON_DECLARE_int32(gpugraph_storage_mode);
 COMMON_DECLARE_string(graph_edges_split_mode);
 COMMON_DECLARE_bool(query_dest_rank_by_multi_node);
+COMMON_DECLARE_int32(dataset_global_shuffle_inflight_batches);
+COMMON_DECLARE_bool(enable_dataset_record_arena);
 
 namespace paddle {
 namespace framework {
 
+// Writes the records into the channel in the order std::shuffle would put
+// them in with the same engine. Only their indexes are shuffled, so each
+// record is moved once instead of being swapped around.
+template <typename T>
+static void WriteShuffled(std::vector<T>* data,
+                          std::default_random_engine* engine,
+                          ChannelObject<T>* channel) {
+  std::vector<size_t> index(data->size());
+  std::iota(index.begin(), index.end(), 0);
+  std::shuffle(index.begin(), index.end(), *engine);
+  ChannelWriter<T> writer(channel);
+  for (size_t i : index) {
+    writer << std::move((*data)[i]);
+  }
+  writer.Flush();
+  std::vector<T>().swap(*data);
+}
+
 // constructor
 template <typename T>
 DatasetImpl<T>::DatasetImpl()
@@ -249,33 +275,33 @@ std::vector<paddle::framework::DataFeed*> DatasetImpl<T>::GetReaders() {
 template <typename T>
 void DatasetImpl<T>::CreateChannel() {
   if (input_channel_ == nullptr) {
-    input_channel_ = paddle::framework::MakeChannel<T>();
+    input_channel_ = NewChannel<T>();
   }
   if (multi_output_channel_.empty()) {
     multi_output_channel_.reserve(channel_num_);
     for (int i = 0; i < channel_num_; ++i) {
-      multi_output_channel_.push_back(paddle::framework::MakeChannel<T>());
+      multi_output_channel_.push_back(NewChannel<T>());
     }
   }
   if (multi_consume_channel_.empty()) {
     multi_consume_channel_.reserve(channel_num_);
     for (int i = 0; i < channel_num_; ++i) {
-      multi_consume_channel_.push_back(paddle::framework::MakeChannel<T>());
+      multi_consume_channel_.push_back(NewChannel<T>());
     }
   }
   if (input_pv_channel_ == nullptr) {
-    input_pv_channel_ = paddle::framework::MakeChannel<PvInstance>();
+    input_pv_channel_ = NewChannel<PvInstance>();
   }
   if (multi_pv_output_.empty()) {
     multi_pv_output_.reserve(channel_num_);
     for (int i = 0; i < channel_num_; ++i) {
-      multi_pv_output_.push_back(paddle::framework::MakeChannel<PvInstance>());
+      multi_pv_output_.push_back(NewChannel<PvInstance>());
     }
   }
   if (multi_pv_consume_.empty()) {
     multi_pv_consume_.reserve(channel_num_);
     for (int i = 0; i < channel_num_; ++i) {
-      multi_pv_consume_.push_back(paddle::framework::MakeChannel<PvInstance>());
+      multi_pv_consume_.push_back(NewChannel<PvInstance>());
     }
   }
 }
@@ -580,6 +606,7 @@ void DatasetImpl<T>::LoadIntoMemory() {
             << "]";
 #endif
   } else {
+    PrepareRecordArena();
     std::vector<std::thread> load_threads;
     for (int64_t i = 0; i < thread_num_; ++i) {
       load_threads.emplace_back(&paddle::framework::DataFeed::LoadIntoMemory,
@@ -602,6 +629,7 @@ void DatasetImpl<T>::LoadIntoMemory() {
 template <typename T>
 void DatasetImpl<T>::PreLoadIntoMemory() {
   VLOG(3) << "DatasetImpl<T>::PreLoadIntoMemory() begin";
+  PrepareRecordArena();
   if (preload_thread_num_ != 0) {
     CHECK(static_cast<size_t>(preload_thread_num_) == preload_readers_.size());
     preload_threads_.clear();
@@ -621,6 +649,23 @@ void DatasetImpl<T>::PreLoadIntoMemory() {
   VLOG(3) << "DatasetImpl<T>::PreLoadIntoMemory() end";
 }
 
+template <typename T>
+void DatasetImpl<T>::PrepareRecordArena() {
+  // SlotRecords are pooled by SlotObjPool instead
+  if (!std::is_same<T, Record>::value || !FLAGS_enable_dataset_record_arena) {
+    return;
+  }
+  if (!record_arena_) {
+    record_arena_ = std::make_shared<RecordArena>();
+  }
+  for (auto& reader : readers_) {
+    reader->SetRecordArena(record_arena_);
+  }
+  for (auto& reader : preload_readers_) {
+    reader->SetRecordArena(record_arena_);
+  }
+}
+
 template <typename T>
 void DatasetImpl<T>::WaitPreLoadDone() {
   VLOG(3) << "DatasetImpl<T>::WaitPreLoadDone() begin";
@@ -694,6 +739,15 @@ void DatasetImpl<T>::ReleaseMemoryFun() {
   input_records_.clear();
   std::vector<T>().swap(input_records_);
   std::vector<T>().swap(slots_shuffle_original_data_);
+  // all the Records of the pass are gone, so is their memory at once
+  for (auto& reader : preload_readers_) {
+    reader->SetRecordArena(nullptr);
+  }
+  if (record_arena_) {
+    VLOG(3) << "release record arena of " << record_arena_->Bytes()
+            << " bytes";
+    record_arena_ = nullptr;
+  }
   VLOG(3) << "DatasetImpl<T>::ReleaseMemory() end";
   VLOG(3) << "total_feasign_num_(" << STAT_GET(STAT_total_feasign_num_in_mem)
           << ") - current_fea_num_(" << total_fea_num_ << ") = ("
@@ -717,11 +771,8 @@ void DatasetImpl<T>::LocalShuffle() {
   input_channel_->Close();
   std::vector<T> data;
   input_channel_->ReadAll(data);
-  std::shuffle(data.begin(), data.end(), fleet_ptr->LocalRandomEngine());
   input_channel_->Open();
-  input_channel_->Write(std::move(data));
-  data.clear();
-  data.shrink_to_fit();
+  WriteShuffled(&data, &fleet_ptr->LocalRandomEngine(), input_channel_.get());
   input_channel_->Close();
 
   timeline.Pause();
@@ -768,6 +819,90 @@ void DatasetImpl<T>::DumpSampleNeighbors(std::string dump_path) {
 #endif
 }
 
+std::vector<std::string> MultiSlotDataset::DumpColumnarRecords(
+    const std::string& path_prefix, int compress_level) {
+  VLOG(3) << "MultiSlotDataset::DumpColumnarRecords() begin";
+  platform::Timer timeline;
+  timeline.Start();
+  // the records are in the input channel after loading, and in the output or
+  // consume channels after a shuffle or a pass of training
+  std::vector<Channel<Record>> channels;
+  if (input_channel_ && input_channel_->Size() != 0) {
+    channels.push_back(input_channel_);
+  }
+  for (auto& channel : multi_output_channel_) {
+    if (channel && channel->Size() != 0) {
+      channels.push_back(channel);
+    }
+  }
+  for (auto& channel : multi_consume_channel_) {
+    if (channel && channel->Size() != 0) {
+      channels.push_back(channel);
+    }
+  }
+  PADDLE_ENFORCE_EQ(
+      channels.empty(),
+      false,
+      platform::errors::PreconditionNotMet(
+          "Please load the data into memory before dumping columnar records."));
+  std::vector<Record> data;
+  std::vector<size_t> channel_sizes;
+  for (auto& channel : channels) {
+    std::vector<Record> channel_data;
+    channel->Close();
+    channel->ReadAll(channel_data);
+    channel_sizes.push_back(channel_data.size());
+    data.insert(data.end(),
+                std::make_move_iterator(channel_data.begin()),
+                std::make_move_iterator(channel_data.end()));
+  }
+
+  uint64_t slots_fingerprint = ColumnarSlotsFingerprint(data_feed_desc_);
+  size_t file_num = std::max(thread_num_, 1);
+  size_t file_record_num = (data.size() + file_num - 1) / file_num;
+  std::vector<std::string> filenames(file_num);
+  std::vector<std::exception_ptr> errors(file_num);
+  std::vector<std::thread> dump_threads;
+  for (size_t i = 0; i < file_num; ++i) {
+    filenames[i] = string::Sprintf("%s-%05d", path_prefix, i);
+    dump_threads.emplace_back([&, i]() {
+      try {
+        ColumnarRecordWriter writer(
+            filenames[i], slots_fingerprint, compress_level);
+        size_t begin = std::min(data.size(), i * file_record_num);
+        size_t end = std::min(data.size(), begin + file_record_num);
+        for (size_t j = begin; j < end; ++j) {
+          writer.Write(data[j]);
+        }
+        writer.Close();
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+  for (std::thread& t : dump_threads) {
+    t.join();
+  }
+
+  // the records stay in memory, each in the channel it was read from
+  size_t offset = 0;
+  for (size_t i = 0; i < channels.size(); ++i) {
+    channels[i]->Open();
+    channels[i]->WriteMove(channel_sizes[i], data.data() + offset);
+    channels[i]->Close();
+    offset += channel_sizes[i];
+  }
+  for (auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  timeline.Pause();
+  VLOG(3) << "MultiSlotDataset::DumpColumnarRecords() end, file num="
+          << file_num << ", cost time=" << timeline.ElapsedSec() << " seconds";
+  return filenames;
+}
+
 // do tdm sample
 void MultiSlotDataset::TDMSample(const std::string tree_name,
                                  const std::string tree_path,
@@ -846,6 +981,98 @@ void MultiSlotDataset::TDMSample(const std::string tree_name,
   return;
 }
 
+// The archive writes into buffer directly and only copies the message if it
+// outgrows the capacity kept from the former batches.
+void SerializeRecords(const std::vector<const Record*>& records,
+                      std::string* buffer) {
+  buffer->resize(buffer->capacity());
+  paddle::framework::BinaryArchive ar;
+  ar.SetWriteBuffer(&(*buffer)[0], buffer->size(), nullptr);
+  ar << static_cast<uint64_t>(records.size());
+  for (const Record* record : records) {
+    ar << *record;
+  }
+  if (ar.Buffer() == buffer->data()) {
+    buffer->resize(ar.Length());
+  } else {
+    buffer->assign(ar.Buffer(), ar.Length());
+  }
+}
+
+// Reads a record like operator>>(Archive&, Record&) does, but checks every
+// size read against the bytes left, so that a broken message fails rather
+// than reading past its end or sizing a huge allocation.
+static bool ReadRecord(paddle::framework::BinaryArchive* ar, Record* record) {
+  auto left = [ar] { return static_cast<size_t>(ar->Finish() - ar->Cursor()); };
+  auto read_size = [ar, &left](size_t unit, size_t* size) {
+    if (left() < sizeof(size_t)) {
+      return false;
+    }
+    *size = ar->Get<size_t>();
+    return *size <= left() / unit;
+  };
+  static const size_t item_bytes = [] {
+    paddle::framework::BinaryArchive item_ar;
+    item_ar << FeatureItem(FeatureFeasign(), 0);
+    return item_ar.Length();
+  }();
+  for (auto* feasigns : {&record->uint64_feasigns_, &record->float_feasigns_}) {
+    size_t size = 0;
+    if (!read_size(item_bytes, &size)) {
+      return false;
+    }
+    feasigns->resize(size);
+    for (auto& item : *feasigns) {
+      *ar >> item;
+    }
+  }
+  size_t length = 0;
+  if (!read_size(1, &length)) {
+    return false;
+  }
+  record->ins_id_.assign(ar->Cursor(), length);
+  ar->AdvanceCursor(length);
+  return true;
+}
+
+bool DeserializeRecords(const std::string& msg, std::vector<Record>* records) {
+  records->clear();
+  if (msg.empty()) {
+    return true;
+  }
+  paddle::framework::BinaryArchive ar;
+  ar.SetReadBuffer(const_cast<char*>(msg.data()), msg.size(), nullptr);
+  if (msg.size() < sizeof(uint64_t)) {
+    return false;
+  }
+  // the count comes from the remote trainer, so it is checked against the
+  // bytes of the message, an empty record taking three sizes, before it
+  // sizes the allocation
+  uint64_t count = ar.Get<uint64_t>();
+  if (count > (msg.size() - sizeof(uint64_t)) / (3 * sizeof(size_t))) {
+    LOG(WARNING) << "GlobalShuffle message of " << msg.size()
+                 << " bytes can not hold " << count << " records";
+    return false;
+  }
+  // the records are deserialized in place
+  records->resize(count);
+  for (uint64_t i = 0; i < count; ++i) {
+    if (!ReadRecord(&ar, &(*records)[i])) {
+      LOG(WARNING) << "GlobalShuffle message of " << msg.size()
+                   << " bytes is truncated at record " << i;
+      records->clear();
+      return false;
+    }
+  }
+  if (ar.Cursor() != ar.Finish()) {
+    LOG(WARNING) << "GlobalShuffle message of " << msg.size() << " bytes has "
+                 << ar.Finish() - ar.Cursor() << " bytes after its records";
+    records->clear();
+    return false;
+  }
+  return true;
+}
+
 void MultiSlotDataset::GlobalShuffle(int thread_num) {
   VLOG(3) << "MultiSlotDataset::GlobalShuffle() begin";
   platform::Timer timeline;
@@ -865,11 +1092,8 @@ void MultiSlotDataset::GlobalShuffle(int thread_num) {
   input_channel_->Close();
   std::vector<Record> data;
   input_channel_->ReadAll(data);
-  std::shuffle(data.begin(), data.end(), fleet_ptr->LocalRandomEngine());
   input_channel_->Open();
-  input_channel_->Write(std::move(data));
-  data.clear();
-  data.shrink_to_fit();
+  WriteShuffled(&data, &fleet_ptr->LocalRandomEngine(), input_channel_.get());
 
   input_channel_->Close();
   input_channel_->SetBlockSize(fleet_send_batch_size_);
@@ -888,43 +1112,59 @@ void MultiSlotDataset::GlobalShuffle(int thread_num) {
     }
   };
 
-  auto global_shuffle_func = [this, get_client_id]() {
+  // The batches sent to a trainer are serialized into a ring of buffers, so
+  // that the next batches are serialized while the former ones are still in
+  // flight. A buffer is reused once its send finished, keeping its capacity.
+  struct SendSlot {
+    std::string buffer;
+    std::future<int32_t> status;
+  };
+  auto wait_send = [](SendSlot* slot) {
+    if (slot->status.valid()) {
+      slot->status.wait();
+      slot->status = std::future<int32_t>();
+    }
+  };
+
+  auto global_shuffle_func = [this, get_client_id, wait_send]() {
 #ifdef PADDLE_WITH_PSCORE
     auto fleet_ptr = distributed::FleetWrapper::GetInstance();
 #else
     auto fleet_ptr = framework::FleetWrapper::GetInstance();
 #endif
-    // auto fleet_ptr = framework::FleetWrapper::GetInstance();
+    size_t inflight_batches = static_cast<size_t>(
+        std::max(FLAGS_dataset_global_shuffle_inflight_batches, 1));
+    std::vector<std::vector<SendSlot>> send_slots(this->trainer_num_);
+    for (auto& slots : send_slots) {
+      slots.resize(inflight_batches);
+    }
+    std::vector<size_t> send_num(this->trainer_num_, 0);
+    std::vector<std::vector<const Record*>> client_records(this->trainer_num_);
+    std::vector<int> send_index(this->trainer_num_);
+    for (int i = 0; i < this->trainer_num_; ++i) {
+      send_index[i] = i;
+    }
     std::vector<Record> data;
     while (this->input_channel_->Read(data)) {
-      std::vector<paddle::framework::BinaryArchive> ars(this->trainer_num_);
-      for (auto& t : data) {
-        auto client_id = get_client_id(t);
-        ars[client_id] << t;
+      for (auto& records : client_records) {
+        records.clear();
       }
-      std::vector<std::future<int32_t>> total_status;
-      std::vector<int> send_index(this->trainer_num_);
-      for (int i = 0; i < this->trainer_num_; ++i) {
-        send_index[i] = i;
+      for (auto& t : data) {
+        client_records[get_client_id(t)].push_back(&t);
       }
       std::shuffle(
           send_index.begin(), send_index.end(), fleet_ptr->LocalRandomEngine());
       for (int index = 0; index < this->trainer_num_; ++index) {
         int i = send_index[index];
-        if (ars[i].Length() == 0) {
+        if (client_records[i].empty()) {
           continue;
         }
-        std::string msg(ars[i].Buffer(), ars[i].Length());
-        auto ret = fleet_ptr->SendClientToClientMsg(0, i, msg);
-        total_status.push_back(std::move(ret));
-      }
-      for (auto& t : total_status) {
-        t.wait();
+        SendSlot& slot = send_slots[i][send_num[i]++ % inflight_batches];
+        wait_send(&slot);
+        SerializeRecords(client_records[i], &slot.buffer);
+        slot.status = fleet_ptr->SendClientToClientMsg(0, i, slot.buffer);
       }
-      ars.clear();
-      ars.shrink_to_fit();
       data.clear();
-      data.shrink_to_fit();
       // currently we find bottleneck is server not able to handle large data
       // in time, so we can remove this sleep and set fleet_send_batch_size to
       // 1024, and set server thread to 24.
@@ -932,6 +1172,11 @@ void MultiSlotDataset::GlobalShuffle(int thread_num) {
         sleep(this->fleet_send_sleep_seconds_);
       }
     }
+    for (auto& slots : send_slots) {
+      for (auto& slot : slots) {
+        wait_send(&slot);
+      }
+    }
   };
 
   std::vector<std::thread> global_shuffle_threads;
@@ -1003,8 +1248,7 @@ void DatasetImpl<T>::DynamicAdjustChannelNum(int channel_num,
   CHECK(origin_pv_channels != nullptr);  // NOLINT
   CHECK(other_pv_channels != nullptr);   // NOLINT
 
-  paddle::framework::Channel<T> total_data_channel =
-      paddle::framework::MakeChannel<T>();
+  paddle::framework::Channel<T> total_data_channel = NewChannel<T>();
   std::vector<paddle::framework::Channel<T>> new_channels;
   std::vector<paddle::framework::Channel<T>> new_other_channels;
   std::vector<paddle::framework::Channel<PvInstance>> new_pv_channels;
@@ -1036,12 +1280,11 @@ void DatasetImpl<T>::DynamicAdjustChannelNum(int channel_num,
   for (int i = 0; i < channel_num; ++i) {
     local_vec.clear();
     total_data_channel->Read(local_vec);
-    new_other_channels.push_back(paddle::framework::MakeChannel<T>());
-    new_channels.push_back(paddle::framework::MakeChannel<T>());
+    new_other_channels.push_back(NewChannel<T>());
+    new_channels.push_back(NewChannel<T>());
     new_channels[i]->Write(std::move(local_vec));
-    new_other_pv_channels.push_back(
-        paddle::framework::MakeChannel<PvInstance>());
-    new_pv_channels.push_back(paddle::framework::MakeChannel<PvInstance>());
+    new_other_pv_channels.push_back(NewChannel<PvInstance>());
+    new_pv_channels.push_back(NewChannel<PvInstance>());
   }
 
   total_data_channel->Clear();
@@ -1090,6 +1333,21 @@ void DatasetImpl<T>::SetFleetSendSleepSeconds(int seconds) {
   fleet_send_sleep_seconds_ = seconds;
 }
 
+template <typename T>
+void DatasetImpl<T>::SetLockFreeChannel(bool lock_free) {
+#if defined(PADDLE_WITH_HETERPS) || defined(PADDLE_WITH_BOX_PS)
+  // PSGPUWrapper and BoxWrapper build passes from the deque returned by
+  // Channel::GetData(), which a lock-free channel does not have
+  PADDLE_ENFORCE_EQ(lock_free,
+                    false,
+                    platform::errors::Unimplemented(
+                        "Lock-free channels are not supported with HeterPS "
+                        "or BoxPS, which read the input channel in place."));
+#endif
+  lock_free_channel_ = lock_free;
+  VLOG(3) << "dataset uses lock-free channels: " << lock_free;
+}
+
 template <typename T>
 void DatasetImpl<T>::CreateReaders() {
   VLOG(3) << "Calling CreateReaders()";
@@ -1287,16 +1545,16 @@ int MultiSlotDataset::ReceiveFromClient(int msg_type,
   if (msg.length() == 0) {
     return 0;
   }
-  paddle::framework::BinaryArchive ar;
-  ar.SetReadBuffer(const_cast<char*>(msg.c_str()), msg.length(), nullptr);
-  if (ar.Cursor() == ar.Finish()) {
-    return 0;
-  }
+  // the records are deserialized into the arena of the pass
+  RecordArenaScope arena_scope(record_arena_.get());
   std::vector<Record> data;
-  while (ar.Cursor() < ar.Finish()) {
-    data.push_back(ar.Get<Record>());
-  }
-  CHECK(ar.Cursor() == ar.Finish());
+  PADDLE_ENFORCE_EQ(DeserializeRecords(msg, &data),
+                    true,
+                    platform::errors::InvalidArgument(
+                        "The GlobalShuffle message of %d bytes from client "
+                        "%d is malformed.",
+                        msg.length(),
+                        client_id));
 
   auto fleet_ptr = framework::FleetWrapper::GetInstance();
   // not use random because it doesn't perform well here.
@@ -1880,7 +2138,7 @@ void MultiSlotDataset::SlotsShuffle(
 template class DatasetImpl<SlotRecord>;
 void SlotRecordDataset::CreateChannel() {
   if (input_channel_ == nullptr) {
-    input_channel_ = paddle::framework::MakeChannel<SlotRecord>();
+    input_channel_ = NewChannel<SlotRecord>();
   }
 }
 void SlotRecordDataset::CreateReaders() {
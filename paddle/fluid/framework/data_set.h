@@ -17,6 +17,7 @@
 #include <ThreadPool.h>
 
 #include <fstream>
+#include <limits>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <set>
@@ -164,6 +165,8 @@ class Dataset {
   virtual void DynamicAdjustReadersNum(int thread_num) = 0;
   // set fleet send sleep seconds
   virtual void SetFleetSendSleepSeconds(int seconds) = 0;
+  // use lock-free channels, see ChannelObject::SetLockFree
+  virtual void SetLockFreeChannel(bool lock_free) = 0;
 
   virtual std::vector<std::string> GetSlots() = 0;
 
@@ -177,6 +180,13 @@ class Dataset {
 
   virtual void DumpWalkPath(std::string dump_path, size_t dump_rate) = 0;
   virtual void DumpSampleNeighbors(std::string dump_path) = 0;
+  // dump the records in memory to columnar record files, one per thread,
+  // which MultiSlotColumnarInMemoryDataFeed loads without parsing them
+  virtual std::vector<std::string> DumpColumnarRecords(
+      const std::string& path_prefix UNUSED, int compress_level UNUSED) {
+    PADDLE_THROW(platform::errors::Unimplemented(
+        "DumpColumnarRecords is only supported by MultiSlotDataset."));
+  }
   virtual const std::vector<uint64_t>& GetGpuGraphTotalKeys() = 0;
   virtual const std::vector<std::vector<uint64_t>*>& GetPassKeysVec() = 0;
   virtual const std::vector<std::vector<uint32_t>*>& GetPassRanksVec() = 0;
@@ -275,6 +285,7 @@ class DatasetImpl : public Dataset {
                                        bool discard_remaining_ins = false);
   virtual void DynamicAdjustReadersNum(int thread_num);
   virtual void SetFleetSendSleepSeconds(int seconds);
+  virtual void SetLockFreeChannel(bool lock_free);
   virtual std::vector<std::string> GetSlots();
   virtual bool GetEpochFinish();
   virtual void ClearSampleState();
@@ -316,6 +327,18 @@ class DatasetImpl : public Dataset {
     // TODO(yaoxuefeng) for SlotRecordDataset
     return -1;
   }
+  // makes a channel of the dataset, lock-free if set
+  template <typename U>
+  paddle::framework::Channel<U> NewChannel() {
+    return paddle::framework::MakeChannel<U>(
+        (std::numeric_limits<size_t>::max)(), lock_free_channel_);
+  }
+  // creates the record arena of the pass if it is enabled and not created
+  // yet, and hands it to the readers
+  void PrepareRecordArena();
+  // the arena of the Records of the pass, released by ReleaseMemory. It is
+  // declared first to outlive the readers and channels holding them.
+  std::shared_ptr<RecordArena> record_arena_;
   std::vector<std::shared_ptr<paddle::framework::DataFeed>> readers_;
   std::vector<std::shared_ptr<paddle::framework::DataFeed>> preload_readers_;
   paddle::framework::Channel<T> input_channel_;
@@ -367,6 +390,7 @@ class DatasetImpl : public Dataset {
   std::vector<T> input_records_;  // only for paddleboxdatafeed
   std::vector<std::string> use_slots_;
   bool enable_heterps_ = false;
+  bool lock_free_channel_ = false;
   int gpu_graph_mode_ = 0;
   std::vector<uint64_t> gpu_graph_total_keys_;
   typedef std::vector<uint64_t> KEYS;
@@ -380,6 +404,14 @@ class DatasetImpl : public Dataset {
   uint32_t pass_id_ = 0;
 };
 
+// The messages of MultiSlotDataset::GlobalShuffle hold the number of their
+// records, then the records. SerializeRecords reuses the capacity of buffer.
+void SerializeRecords(const std::vector<const Record*>& records,
+                      std::string* buffer);
+// Returns false, records being left empty, if msg is not a whole message,
+// e.g. it is truncated or its count does not fit in its bytes.
+bool DeserializeRecords(const std::string& msg, std::vector<Record>* records);
+
 // use std::vector<MultiSlotType> or Record as data type
 class MultiSlotDataset : public DatasetImpl<Record> {
  public:
@@ -418,6 +450,8 @@ class MultiSlotDataset : public DatasetImpl<Record> {
   virtual void GlobalShuffle(int thread_num = -1);
   virtual void DynamicAdjustReadersNum(int thread_num);
   virtual void PrepareTrain();
+  virtual std::vector<std::string> DumpColumnarRecords(
+      const std::string& path_prefix, int compress_level);
 
  protected:
   virtual int ReceiveFromClient(int msg_type,
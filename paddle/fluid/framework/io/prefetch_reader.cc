@@ -0,0 +1,304 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/io/prefetch_reader.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <limits>
+
+#include "glog/logging.h"
+#include "paddle/fluid/framework/io/fs.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+class PrefetchMemoryBudget {
+ public:
+  static PrefetchMemoryBudget& Instance() {
+    static PrefetchMemoryBudget budget;
+    return budget;
+  }
+
+  size_t limit() const { return limit_.load(); }
+
+  void set_limit(size_t x) {
+    limit_.store(x);
+    cond_.notify_all();
+  }
+
+  // Waits until the bytes fit into the budget, unless urgent() returns
+  // true. Returns false if stopped while waiting.
+  template <class Urgent>
+  bool Acquire(size_t bytes,
+               Urgent urgent,
+               const std::atomic<bool>& stopped) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (used_ + bytes > limit_.load() && !urgent()) {
+      if (stopped.load()) {
+        return false;
+      }
+      // neither the consumers nor the readers stopping notify the budget
+      cond_.wait_for(lock, std::chrono::milliseconds(50));
+    }
+    used_ += bytes;
+    return true;
+  }
+
+  void Release(size_t bytes) {
+    if (bytes == 0) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      used_ -= bytes;
+    }
+    cond_.notify_all();
+  }
+
+ private:
+  std::atomic<size_t> limit_{size_t(1) << 30};
+  size_t used_ = 0;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+};
+
+bool IsPlainConverter(const std::string& converter) {
+  std::string trimmed = string::trim_spaces(converter);
+  return trimmed.empty() || trimmed == "cat";
+}
+
+}  // namespace
+
+size_t fs_prefetch_memory_budget() {
+  return PrefetchMemoryBudget::Instance().limit();
+}
+
+void fs_prefetch_set_memory_budget(size_t x) {
+  PrefetchMemoryBudget::Instance().set_limit(x);
+}
+
+PrefetchFileReader::PrefetchFileReader(const std::string& path,
+                                       const std::string& converter,
+                                       const Options& options)
+    : path_(path),
+      options_(options),
+      buffer_num_((std::numeric_limits<size_t>::max)()) {
+  PADDLE_ENFORCE_GT(options_.buffer_size,
+                    0UL,
+                    platform::errors::InvalidArgument(
+                        "The buffer size of PrefetchFileReader must be "
+                        "larger than 0."));
+  options_.read_ahead = std::max(options_.read_ahead, 1);
+  options_.parallel_reads =
+      std::min(std::max(options_.parallel_reads, 1), options_.read_ahead);
+
+#ifndef _WIN32
+  if (fs_select_internal(path) == 0 && !string::ends_with(path, ".gz") &&
+      IsPlainConverter(converter)) {
+    fd_ = open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd_ >= 0 && fstat(fd_, &st) == 0 && S_ISREG(st.st_mode)) {
+      file_size_ = static_cast<uint64_t>(st.st_size);
+      buffer_num_ = static_cast<size_t>(
+          (file_size_ + options_.buffer_size - 1) / options_.buffer_size);
+#ifdef POSIX_FADV_SEQUENTIAL
+      posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    } else if (fd_ >= 0) {
+      // not a regular file, such as a fifo, which is read as a stream
+      close(fd_);
+      fd_ = -1;
+    }
+  }
+#endif
+  int thread_num = options_.parallel_reads;
+  if (fd_ < 0) {
+    int err_no = 0;
+    fp_ = fs_open_read(path, &err_no, converter, true);
+    PADDLE_ENFORCE_NOT_NULL(
+        fp_,
+        platform::errors::Unavailable("Failed to open file %s.", path));
+    // a stream is read in order
+    thread_num = 1;
+  }
+  VLOG(3) << "PrefetchFileReader opens " << path
+          << (fd_ >= 0 ? " by pread" : " as a stream")
+          << ", threads=" << thread_num;
+  threads_.reserve(thread_num);
+  for (int i = 0; i < thread_num; ++i) {
+    threads_.emplace_back(&PrefetchFileReader::ReadThread, this);
+  }
+}
+
+PrefetchFileReader::~PrefetchFileReader() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_.store(true);
+  }
+  room_cond_.notify_all();
+  for (auto& t : threads_) {
+    t.join();
+  }
+  for (auto& buffer : buffers_) {
+    PrefetchMemoryBudget::Instance().Release(buffer.reserved);
+  }
+#ifndef _WIN32
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+#endif
+  // a stream not read to the end is closed by fs_open_read's deleter
+  fp_ = nullptr;
+}
+
+void PrefetchFileReader::ReadThread() {
+  auto& budget = PrefetchMemoryBudget::Instance();
+  while (true) {
+    size_t index = 0;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      room_cond_.wait(lock, [this]() {
+        return stopped_.load() || !error_.empty() ||
+               next_index_ >= buffer_num_ ||
+               next_index_ <=
+                   consumed_ + static_cast<size_t>(options_.read_ahead);
+      });
+      if (stopped_.load() || !error_.empty() || next_index_ >= buffer_num_) {
+        return;
+      }
+      index = next_index_++;
+      buffers_.emplace_back();
+    }
+
+    // the buffer next to the one being consumed is read whatever the other
+    // readers hold, so that every reader makes progress
+    size_t reserved = options_.buffer_size;
+    if (!budget.Acquire(
+            reserved,
+            [this, index]() { return index <= consumed_.load() + 1; },
+            stopped_)) {
+      return;
+    }
+    std::unique_ptr<char[]> data(new char[options_.buffer_size]);
+    std::string error;
+    size_t size = ReadBuffer(index, data.get(), &error);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      // the consumer does not pass a buffer which is not ready
+      Buffer& buffer = buffers_[index - consumed_];
+      buffer.data = std::move(data);
+      buffer.size = size;
+      buffer.reserved = reserved;
+      if (!error.empty()) {
+        error_ = error;
+      } else {
+        buffer.ready = true;
+        if (fd_ < 0 && size < options_.buffer_size) {
+          // the end of the stream, which is read by a single thread
+          buffer_num_ = size > 0 ? index + 1 : index;
+        }
+      }
+    }
+    ready_cond_.notify_all();
+    room_cond_.notify_all();
+  }
+}
+
+size_t PrefetchFileReader::ReadBuffer(size_t index,
+                                      char* data,
+                                      std::string* error) {
+  size_t size = 0;
+#ifndef _WIN32
+  if (fd_ >= 0) {
+    uint64_t offset = static_cast<uint64_t>(index) * options_.buffer_size;
+    size_t total = static_cast<size_t>(std::min<uint64_t>(
+        options_.buffer_size, file_size_ > offset ? file_size_ - offset : 0));
+    while (size < total) {
+      ssize_t ret = pread(fd_, data + size, total - size, offset + size);
+      if (ret < 0 && errno == EINTR) {
+        continue;
+      }
+      if (ret <= 0) {
+        *error = ret < 0 ? strerror(errno) : "unexpected end of file";
+        break;
+      }
+      size += static_cast<size_t>(ret);
+    }
+    return size;
+  }
+#endif
+  // fread only returns less than asked at the end of the stream or on error
+  size = fread(data, 1, options_.buffer_size, fp_.get());
+  if (size < options_.buffer_size && ferror(fp_.get())) {
+    *error = strerror(errno);
+  }
+  return size;
+}
+
+bool PrefetchFileReader::Next(const char** data, size_t* size) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (holding_) {
+    PrefetchMemoryBudget::Instance().Release(buffers_.front().reserved);
+    buffers_.pop_front();
+    ++consumed_;
+    holding_ = false;
+    room_cond_.notify_all();
+  }
+  ready_cond_.wait(lock, [this]() {
+    return consumed_ >= buffer_num_ || !error_.empty() ||
+           (!buffers_.empty() && buffers_.front().ready);
+  });
+  if (consumed_ >= buffer_num_) {
+    return false;
+  }
+  if (buffers_.empty() || !buffers_.front().ready) {
+    PADDLE_THROW(platform::errors::Unavailable(
+        "Failed to read file %s: %s.", path_, error_));
+  }
+  holding_ = true;
+  *data = buffers_.front().data.get();
+  *size = buffers_.front().size;
+  return true;
+}
+
+size_t PrefetchFileReader::read(char* buf, size_t n) {
+  while (current_offset_ == current_size_) {
+    if (!Next(&current_data_, &current_size_)) {
+      current_data_ = nullptr;
+      current_size_ = current_offset_ = 0;
+      return 0;
+    }
+    current_offset_ = 0;
+  }
+  size_t bytes = std::min(n, current_size_ - current_offset_);
+  memcpy(buf, current_data_ + current_offset_, bytes);
+  current_offset_ += bytes;
+  return bytes;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,119 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "paddle/utils/string/string_helper.h"
+
+namespace paddle {
+namespace framework {
+
+// The bytes of all the buffers read ahead by the PrefetchFileReaders of the
+// process. A reader can always hold one buffer, so that it does not wait for
+// the others forever.
+extern size_t fs_prefetch_memory_budget();
+
+extern void fs_prefetch_set_memory_budget(size_t x);
+
+// Reads a file ahead of its consumer, in buffers, by background threads.
+//
+// A local file read without converter is read by parallel_reads threads with
+// pread, each reading the next buffer of the file not taken yet. Any other
+// file, such as a hdfs file or a local file read through a converter, is
+// opened by fs_open_read and read sequentially by one thread. In both cases
+// at most read_ahead buffers are read before they are consumed.
+//
+// The buffers are consumed in order, by Next() or as a string::BlockSource.
+class PrefetchFileReader : public string::BlockSource {
+ public:
+  struct Options {
+    size_t buffer_size = 4 << 20;
+    int read_ahead = 4;
+    int parallel_reads = 4;
+  };
+
+  PrefetchFileReader(const std::string& path,
+                     const std::string& converter,
+                     const Options& options);
+  ~PrefetchFileReader() override;
+
+  PrefetchFileReader(const PrefetchFileReader&) = delete;
+  PrefetchFileReader& operator=(const PrefetchFileReader&) = delete;
+
+  // Returns the next buffer of the file, which is valid until the next call,
+  // or false at the end of the file.
+  bool Next(const char** data, size_t* size);
+
+  // Copies the next bytes of the file.
+  size_t read(char* buf, size_t n) override;
+
+  const std::string& path() const { return path_; }
+
+ private:
+  struct Buffer {
+    std::unique_ptr<char[]> data;
+    size_t size = 0;
+    // the bytes taken from the memory budget
+    size_t reserved = 0;
+    bool ready = false;
+  };
+
+  void ReadThread();
+  // Reads the buffer of the given index into data. Returns its size, which
+  // is less than the buffer size at the end of the file.
+  size_t ReadBuffer(size_t index, char* data, std::string* error);
+
+  std::string path_;
+  Options options_;
+
+  // local files are read by pread, other ones through fp_
+  int fd_ = -1;
+  uint64_t file_size_ = 0;
+  std::shared_ptr<FILE> fp_;
+
+  std::mutex mutex_;
+  std::condition_variable ready_cond_;
+  std::condition_variable room_cond_;
+  // the buffers from the one being consumed on, the first of which has the
+  // index consumed_, and is held by the consumer if holding_
+  std::deque<Buffer> buffers_;
+  std::atomic<size_t> consumed_{0};
+  bool holding_ = false;
+  size_t next_index_ = 0;
+  // the number of buffers of the file, known once the end is reached
+  size_t buffer_num_;
+  std::string error_;
+  std::atomic<bool> stopped_{false};
+  std::vector<std::thread> threads_;
+
+  // the buffer being copied by read()
+  const char* current_data_ = nullptr;
+  size_t current_size_ = 0;
+  size_t current_offset_ = 0;
+};
+
+}  // namespace framework
+}  // namespace paddle
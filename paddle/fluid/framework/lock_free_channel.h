@@ -0,0 +1,453 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <new>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+// The storage of a lock-free ChannelObject: a FIFO queue of cells, each of
+// which is given a ticket, stored in a linked list of segments of
+// kSegmentSize cells.
+//
+// A batch of n items takes n consecutive tickets by a single CAS on the tail
+// (writers) or on the head (readers). The items are then moved into or out of
+// their cells without any lock, so that the threads only contend on the two
+// counters, once per batch. Readers only take the tickets below the tail,
+// whose cells a writer has committed to fill, and wait for the cells still
+// being filled.
+//
+// Writers link new segments as the tail grows, readers unlink the segments
+// whose cells are all consumed. An unlinked segment is freed once the
+// operations that may still walk it are finished, which are tracked by two
+// counters of operations in progress, one per phase: new operations count
+// in the current phase, and the phase is flipped before waiting for the
+// operations of the former one.
+//
+// Threads only block when the queue is empty or full, on condition variables
+// which are notified if the other side counts waiters.
+template <class T>
+class LockFreeChannelQueue {
+ public:
+  static constexpr size_t kSegmentSize = 1024;
+
+  explicit LockFreeChannelQueue(size_t capacity) : capacity_(capacity) {
+    Init();
+  }
+
+  ~LockFreeChannelQueue() { Destroy(); }
+
+  LockFreeChannelQueue(const LockFreeChannelQueue&) = delete;
+  LockFreeChannelQueue& operator=(const LockFreeChannelQueue&) = delete;
+
+  // a zero capacity is taken as 1, since readers do not meet writers
+  void SetCapacity(size_t capacity) {
+    capacity_.store(capacity);
+    NotifyAll(&write_cond_);
+  }
+
+  void SetClosed(bool closed) {
+    closed_.store(closed);
+    NotifyAll(&read_cond_);
+    NotifyAll(&write_cond_);
+  }
+
+  // includes the items being written, but not those being read
+  size_t Size() {
+    uint64_t head = head_.load();
+    return static_cast<size_t>(tail_.load() - head);
+  }
+
+  // must not be called concurrently with other methods
+  void Clear() {
+    Destroy();
+    Init();
+  }
+
+  // Blocks until n items are read, or fewer if the queue is closed and
+  // empty. If once, returns as soon as some items are read.
+  size_t Read(size_t n, T* p, bool once) {
+    size_t finished = 0;
+    while (finished < n) {
+      uint64_t ticket = 0;
+      size_t m = 0;
+      if (!ReserveRead(n - finished, &ticket, &m)) {
+        break;
+      }
+      NotifyWaiters(&write_waiters_, &write_cond_);
+      {
+        OperationGuard guard(this);
+        Segment* segment = FindSegment(ticket / kSegmentSize);
+        size_t consumed = 0;
+        for (size_t i = 0; i < m; ++i) {
+          uint64_t t = ticket + i;
+          if (t / kSegmentSize != segment->id) {
+            segment->consumed.fetch_add(consumed);
+            consumed = 0;
+            segment = NextSegment(segment, false);
+          }
+          Cell& cell = segment->cells[t % kSegmentSize];
+          WaitReady(&cell);
+          p[finished + i] = std::move(*cell.Get());
+          cell.Get()->~T();
+          ++consumed;
+        }
+        segment->consumed.fetch_add(consumed);
+        UnlinkConsumedSegments();
+      }
+      finished += m;
+      if (once) {
+        break;
+      }
+    }
+    if (retired_num_.load(std::memory_order_relaxed) >= kReclaimThreshold) {
+      Reclaim();
+    }
+    return finished;
+  }
+
+  // Blocks until n items are written, or fewer if the queue is closed.
+  size_t Write(size_t n, const T* p) {
+    return WriteImpl(n, [p](size_t i, void* cell) { new (cell) T(p[i]); });
+  }
+
+  size_t WriteMove(size_t n, T* p) {
+    return WriteImpl(
+        n, [p](size_t i, void* cell) { new (cell) T(std::move(p[i])); });
+  }
+
+ private:
+  static constexpr size_t kReclaimThreshold = 4;
+  static constexpr int kSpinTimes = 64;
+
+  struct Cell {
+    T* Get() { return reinterpret_cast<T*>(storage); }
+
+    std::atomic<bool> ready{false};
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  struct Segment {
+    explicit Segment(uint64_t id) : id(id) {}
+
+    const uint64_t id;
+    std::atomic<Segment*> next{nullptr};
+    std::atomic<size_t> consumed{0};
+    Cell cells[kSegmentSize];
+  };
+
+  class OperationGuard {
+   public:
+    explicit OperationGuard(LockFreeChannelQueue* queue) : queue_(queue) {
+      // an operation counts in the phase it saw after counting itself, so
+      // that Reclaim() waits for it if it started before the flip
+      while (true) {
+        phase_ = queue_->phase_.load();
+        queue_->active_ops_[phase_].fetch_add(1);
+        if (queue_->phase_.load() == phase_) {
+          break;
+        }
+        queue_->active_ops_[phase_].fetch_sub(1);
+      }
+    }
+
+    ~OperationGuard() { queue_->active_ops_[phase_].fetch_sub(1); }
+
+   private:
+    LockFreeChannelQueue* queue_;
+    int phase_;
+  };
+
+  void Init() {
+    Segment* segment = new Segment(0);
+    head_segment_.store(segment);
+    tail_segment_.store(segment);
+    head_.store(0);
+    tail_.store(0);
+  }
+
+  void Destroy() {
+    uint64_t tail = tail_.load();
+    Segment* segment = head_segment_.load();
+    for (uint64_t t = head_.load(); t < tail; ++t) {
+      while (segment->id < t / kSegmentSize) {
+        segment = segment->next.load();
+      }
+      segment->cells[t % kSegmentSize].Get()->~T();
+    }
+    segment = head_segment_.load();
+    while (segment != nullptr) {
+      Segment* next = segment->next.load();
+      delete segment;
+      segment = next;
+    }
+    for (Segment* retired : retired_) {
+      delete retired;
+    }
+    retired_.clear();
+    retired_num_.store(0);
+  }
+
+  static void Pause(int* spin) {
+    if (++*spin > kSpinTimes) {
+      std::this_thread::yield();
+    }
+  }
+
+  static void WaitReady(Cell* cell) {
+    int spin = 0;
+    while (!cell->ready.load(std::memory_order_acquire)) {
+      Pause(&spin);
+    }
+  }
+
+  // The head segment does not pass a segment that has cells not consumed
+  // yet, and the tail segment only moves forward, so either is before the
+  // segment of a ticket held by the caller.
+  Segment* FindSegment(uint64_t id) {
+    Segment* segment = tail_segment_.load(std::memory_order_acquire);
+    if (segment->id > id) {
+      segment = head_segment_.load(std::memory_order_acquire);
+    }
+    while (segment->id < id) {
+      // a reader may find the segment of its ticket not linked yet, in
+      // which case creating it is the same as waiting for the writer
+      segment = NextSegment(segment, true);
+    }
+    return segment;
+  }
+
+  // Readers wait for the writer of the next segment to link it, writers
+  // link it if it does not exist yet.
+  Segment* NextSegment(Segment* segment, bool create) {
+    int spin = 0;
+    while (true) {
+      Segment* next = segment->next.load(std::memory_order_acquire);
+      if (next != nullptr) {
+        return next;
+      }
+      if (create) {
+        Segment* new_segment = new Segment(segment->id + 1);
+        if (segment->next.compare_exchange_strong(next, new_segment)) {
+          return new_segment;
+        }
+        delete new_segment;
+        return next;
+      }
+      Pause(&spin);
+    }
+  }
+
+  void AdvanceTailSegment(Segment* segment) {
+    Segment* tail = tail_segment_.load();
+    while (tail->id < segment->id &&
+           !tail_segment_.compare_exchange_weak(tail, segment)) {
+    }
+  }
+
+  void UnlinkConsumedSegments() {
+    Segment* segment = head_segment_.load();
+    while (segment->consumed.load() == kSegmentSize) {
+      Segment* next = segment->next.load();
+      if (next == nullptr) {
+        break;
+      }
+      if (!head_segment_.compare_exchange_strong(segment, next)) {
+        continue;
+      }
+      AdvanceTailSegment(next);
+      {
+        std::lock_guard<std::mutex> guard(retired_mutex_);
+        retired_.push_back(segment);
+      }
+      retired_num_.fetch_add(1);
+      segment = next;
+    }
+  }
+
+  // Frees the segments unlinked before, once the operations which may still
+  // walk them are finished.
+  void Reclaim() {
+    std::unique_lock<std::mutex> reclaim_lock(reclaim_mutex_,
+                                              std::try_to_lock);
+    if (!reclaim_lock.owns_lock()) {
+      return;
+    }
+    std::vector<Segment*> segments;
+    {
+      std::lock_guard<std::mutex> guard(retired_mutex_);
+      segments.swap(retired_);
+      retired_num_.store(0);
+    }
+    int phase = phase_.load();
+    phase_.store(1 - phase);
+    int spin = 0;
+    while (active_ops_[phase].load() != 0) {
+      Pause(&spin);
+    }
+    for (Segment* segment : segments) {
+      delete segment;
+    }
+  }
+
+  bool ReserveRead(size_t n, uint64_t* ticket, size_t* m) {
+    while (true) {
+      uint64_t head = head_.load();
+      uint64_t tail = tail_.load();
+      if (tail == head) {
+        if (closed_.load() && tail_.load() == head) {
+          return false;
+        }
+        Wait(&read_waiters_, &read_cond_, [this]() {
+          return tail_.load() != head_.load() || closed_.load();
+        });
+        continue;
+      }
+      *m = static_cast<size_t>(
+          (std::min)(static_cast<uint64_t>(n), tail - head));
+      if (head_.compare_exchange_weak(head, head + *m)) {
+        *ticket = head;
+        return true;
+      }
+    }
+  }
+
+  bool ReserveWrite(size_t n, uint64_t* ticket, size_t* m) {
+    while (true) {
+      if (closed_.load()) {
+        return false;
+      }
+      uint64_t head = head_.load();
+      uint64_t tail = tail_.load();
+      size_t room = Room(head, tail);
+      if (room == 0) {
+        Wait(&write_waiters_, &write_cond_, [this]() {
+          uint64_t new_head = head_.load();
+          return Room(new_head, tail_.load()) != 0 || closed_.load();
+        });
+        continue;
+      }
+      *m = (std::min)(n, room);
+      if (tail_.compare_exchange_weak(tail, tail + *m)) {
+        *ticket = tail;
+        return true;
+      }
+    }
+  }
+
+  size_t Room(uint64_t head, uint64_t tail) {
+    size_t capacity = (std::max)(capacity_.load(), static_cast<size_t>(1));
+    size_t size = static_cast<size_t>(tail - head);
+    return size >= capacity ? 0 : capacity - size;
+  }
+
+  template <class Construct>
+  size_t WriteImpl(size_t n, Construct construct) {
+    size_t finished = 0;
+    while (finished < n) {
+      uint64_t ticket = 0;
+      size_t m = 0;
+      if (!ReserveWrite(n - finished, &ticket, &m)) {
+        break;
+      }
+      {
+        OperationGuard guard(this);
+        Segment* segment = FindSegment(ticket / kSegmentSize);
+        // before the cells are filled, since a segment whose cells are all
+        // consumed may be unlinked and the tail segment must not point to it
+        AdvanceTailSegment(segment);
+        for (size_t i = 0; i < m; ++i) {
+          uint64_t t = ticket + i;
+          if (t / kSegmentSize != segment->id) {
+            segment = NextSegment(segment, true);
+            AdvanceTailSegment(segment);
+          }
+          Cell& cell = segment->cells[t % kSegmentSize];
+          construct(finished + i, cell.storage);
+          cell.ready.store(true, std::memory_order_release);
+        }
+      }
+      finished += m;
+      NotifyWaiters(&read_waiters_, &read_cond_);
+    }
+    return finished;
+  }
+
+  // The waiter counts itself before checking the condition, and the other
+  // side updates the condition before checking the waiters, so that either
+  // the waiter sees the update or it is notified.
+  template <class Condition>
+  void Wait(std::atomic<int>* waiters,
+            std::condition_variable* cond,
+            Condition condition) {
+    int spin = 0;
+    while (spin < kSpinTimes) {
+      if (condition()) {
+        return;
+      }
+      Pause(&spin);
+    }
+    std::unique_lock<std::mutex> lock(wait_mutex_);
+    waiters->fetch_add(1);
+    while (!condition()) {
+      cond->wait(lock);
+    }
+    waiters->fetch_sub(1);
+  }
+
+  void NotifyWaiters(std::atomic<int>* waiters, std::condition_variable* cond) {
+    if (waiters->load() != 0) {
+      NotifyAll(cond);
+    }
+  }
+
+  void NotifyAll(std::condition_variable* cond) {
+    std::lock_guard<std::mutex> lock(wait_mutex_);
+    cond->notify_all();
+  }
+
+  alignas(64) std::atomic<uint64_t> head_{0};
+  alignas(64) std::atomic<uint64_t> tail_{0};
+  alignas(64) std::atomic<Segment*> head_segment_{nullptr};
+  std::atomic<Segment*> tail_segment_{nullptr};
+  alignas(64) std::atomic<size_t> active_ops_[2] = {{0}, {0}};
+  std::atomic<int> phase_{0};
+
+  std::atomic<size_t> capacity_;
+  std::atomic<bool> closed_{false};
+
+  std::mutex retired_mutex_;
+  std::vector<Segment*> retired_;
+  std::atomic<size_t> retired_num_{0};
+  std::mutex reclaim_mutex_;
+
+  std::mutex wait_mutex_;
+  std::condition_variable read_cond_;
+  std::condition_variable write_cond_;
+  std::atomic<int> read_waiters_{0};
+  std::atomic<int> write_waiters_{0};
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "glog/logging.h"
+#include "paddle/fluid/framework/new_executor/workqueue/inlined_task.h"
 #include "paddle/fluid/platform/flags.h"
 #include "paddle/fluid/platform/os_info.h"
 #include "paddle/fluid/platform/profiler/utils.h"
@@ -554,6 +555,14 @@ void StatisticsEngine::Log(const std::string& filepath) {
                                    evt_stat.count,
                                    evt_stat.normalization_time);
   }
+  // Heap allocations made to store WorkQueue tasks since the process started,
+  // it should stay flat across steps once the executor is warmed up.
+  ofs << platform::string_format(std::string(R"JSON(
+  {
+    "statistical item" : "WorkQueue task heap allocations",
+    "total number of times" : %llu
+  },)JSON"),
+                                 TaskHeapAllocationCount());
   ofs.seekp(-1, std::ios_base::end);
   ofs << "]";
   if (ofs) {
@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/framework/new_executor/interpreter/dependency_builder.h"
 
+#include <algorithm>
 #include <queue>
 #include <sstream>
 #include <stack>
@@ -156,6 +157,40 @@ const std::map<size_t, std::set<size_t>>& DependencyBuilder::OpDownstreamMap()
   return *op_downstream_map_;
 }
 
+std::vector<size_t> DependencyBuilder::CriticalPathLength(
+    size_t op_num) const {
+  const std::map<size_t, std::set<size_t>>& downstream_map = OpDownstreamMap();
+  std::vector<size_t> path_length(op_num, 1);
+  // visit ops in reverse topological order, starting from the ones without
+  // downstream ops
+  std::vector<size_t> pending_downstream(op_num, 0);
+  std::vector<std::vector<size_t>> upstream_ops(op_num);
+  for (const auto& item : downstream_map) {
+    for (size_t next_op_idx : item.second) {
+      upstream_ops[next_op_idx].push_back(item.first);
+      ++pending_downstream[item.first];
+    }
+  }
+  std::vector<size_t> ready_ops;
+  for (size_t op_idx = 0; op_idx < op_num; ++op_idx) {
+    if (pending_downstream[op_idx] == 0) {
+      ready_ops.push_back(op_idx);
+    }
+  }
+  while (!ready_ops.empty()) {
+    size_t op_idx = ready_ops.back();
+    ready_ops.pop_back();
+    for (size_t prior_op_idx : upstream_ops[op_idx]) {
+      path_length[prior_op_idx] =
+          std::max(path_length[prior_op_idx], path_length[op_idx] + 1);
+      if (--pending_downstream[prior_op_idx] == 0) {
+        ready_ops.push_back(prior_op_idx);
+      }
+    }
+  }
+  return path_length;
+}
+
 void DependencyBuilder::AddDependencyForCoalesceTensorOp() {
   for (size_t op_idx = 0; op_idx < op_num_; ++op_idx) {
     if (instructions_->at(op_idx).OpBaseValid() &&
@@ -48,6 +48,11 @@ class DependencyBuilder {
 
   const std::map<size_t, std::set<size_t>>& OpDownstreamMap() const;
 
+  // the number of ops on the longest path from each op to the end of the
+  // graph, the op itself included. Ops with a longer remaining path are on
+  // the critical path and should be scheduled first.
+  std::vector<size_t> CriticalPathLength(size_t op_num) const;
+
   bool OpHappensBefore(size_t prior_op_idx, size_t posterior_op_idx) const {
     PADDLE_ENFORCE_GE(
         op_happens_before_->size(),
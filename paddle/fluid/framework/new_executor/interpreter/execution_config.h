@@ -33,6 +33,9 @@ struct ExecutionConfig {
 
   size_t device_num_threads{0};
   size_t host_num_threads{0};
+  // NUMA placement of the host threads, see WorkQueueOptions.numa_node.
+  // Taken from FLAGS_cpu_numa_node if it is left as -1.
+  int numa_node{-1};
 
   std::set<std::string> force_root_scope_vars;
   std::set<std::string> jit_input_vars;
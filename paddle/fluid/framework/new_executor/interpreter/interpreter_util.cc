@@ -90,7 +90,10 @@ class SingleStreamGuard {
 };
 
 const std::vector<WorkQueueOptions> ConstructWorkQueueOptions(
-    size_t host_num_threads, size_t device_num_threads, EventsWaiter* waiter) {
+    size_t host_num_threads,
+    size_t device_num_threads,
+    EventsWaiter* waiter,
+    int numa_node) {
   std::vector<WorkQueueOptions> group_options;
   // for execute host Kernel
   group_options.emplace_back(/*name*/ "HostTasks",
@@ -100,6 +103,7 @@ const std::vector<WorkQueueOptions> ConstructWorkQueueOptions(
                              /*track_task*/ false,
                              /*detached*/ true,
                              /*events_waiter*/ waiter);
+  group_options.back().numa_node = numa_node;
   // for launch device Kernel
   group_options.emplace_back(/*name*/ "DeviceKernelLaunch",
                              /*num_threads*/ device_num_threads,
@@ -113,18 +117,25 @@ const std::vector<WorkQueueOptions> ConstructWorkQueueOptions(
 
 AsyncWorkQueue::AsyncWorkQueue(size_t host_num_threads,
                                size_t device_num_threads,
-                               EventsWaiter* waiter)
+                               EventsWaiter* waiter,
+                               int numa_node)
     : host_num_thread_(host_num_threads),
       queue_group_(CreateWorkQueueGroup(ConstructWorkQueueOptions(
-          host_num_threads, device_num_threads, waiter))) {}
+          host_num_threads, device_num_threads, waiter, numa_node))) {}
 
-void AsyncWorkQueue::AddTask(const OpFuncType& op_func_type,
-                             std::function<void()> fn) {
+void AsyncWorkQueue::AddTask(const OpFuncType& op_func_type, InlinedTask fn) {
   // queue_idx=0 : kCpuSync or kGpuSync
   // queue_idx=1 : kGPUAsync
   queue_group_->AddTask(op_func_type == OpFuncType::kGpuAsync, std::move(fn));
 }
 
+void AsyncWorkQueue::AddTask(const OpFuncType& op_func_type,
+                             InlinedTask fn,
+                             int64_t priority) {
+  queue_group_->AddTask(
+      op_func_type == OpFuncType::kGpuAsync, std::move(fn), priority);
+}
+
 bool IsCommunicationOp(const OperatorBase* op) {
   const std::string& op_name = op->Type();
   const std::set<std::string> special_comm_op_set = {
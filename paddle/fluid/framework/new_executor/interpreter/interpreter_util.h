@@ -49,11 +49,16 @@ class AsyncWorkQueue {
  public:
   AsyncWorkQueue(size_t host_num_threads,
                  size_t device_num_threads,
-                 EventsWaiter* waiter);
+                 EventsWaiter* waiter,
+                 int numa_node = kNoNumaNode);
 
   // void WaitEmpty() { queue_group_->WaitQueueGroupEmpty(); }
 
-  void AddTask(const OpFuncType& op_func_type, std::function<void()> fn);
+  void AddTask(const OpFuncType& op_func_type, InlinedTask fn);
+
+  void AddTask(const OpFuncType& op_func_type,
+               InlinedTask fn,
+               int64_t priority);
 
   void Cancel() { queue_group_->Cancel(); }
 
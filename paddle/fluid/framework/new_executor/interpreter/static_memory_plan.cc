@@ -0,0 +1,388 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/interpreter/static_memory_plan.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <utility>
+
+#include "paddle/fluid/memory/allocation/allocator.h"
+#include "paddle/fluid/memory/malloc.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/phi/core/dense_tensor.h"
+
+namespace paddle {
+namespace framework {
+namespace interpreter {
+
+// The preallocated memory of a plan and the owner of each of its blocks. The
+// owner is the serial number of the allocation currently holding the block,
+// 0 if the block is free. Allocations are freed by the garbage collector,
+// possibly on another thread, after the block was logically released and
+// handed out again, so a release only takes effect if the serial matches.
+struct StaticMemoryArena {
+  StaticMemoryArena(const platform::Place& place, size_t size, size_t num)
+      : size(size), owners(new std::atomic<uint64_t>[num]) {
+    if (size > 0) {
+      memory = memory::AllocShared(place, size);
+    }
+    for (size_t i = 0; i < num; ++i) {
+      owners[i].store(0);
+    }
+  }
+
+  bool IsFree(size_t index) const { return owners[index].load() == 0; }
+
+  void Release(size_t index, uint64_t serial) {
+    owners[index].compare_exchange_strong(serial, 0);
+  }
+
+  size_t size;
+  std::shared_ptr<phi::Allocation> memory;
+  std::unique_ptr<std::atomic<uint64_t>[]> owners;
+  uint64_t next_serial{1};
+};
+
+namespace {
+
+constexpr size_t kAlignment = 64;
+constexpr size_t kAlive = std::numeric_limits<size_t>::max();
+
+size_t AlignUp(size_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// A block of the arena set as the holder of an output tensor.
+class PlannedAllocation : public memory::allocation::Allocation {
+ public:
+  PlannedAllocation(void* ptr,
+                    size_t size,
+                    const platform::Place& place,
+                    std::shared_ptr<StaticMemoryArena> arena,
+                    size_t index,
+                    uint64_t serial)
+      : Allocation(ptr, size, place),
+        arena_(std::move(arena)),
+        index_(index),
+        serial_(serial) {}
+
+  ~PlannedAllocation() override { Release(); }
+
+  void Release() { arena_->Release(index_, serial_); }
+
+  const StaticMemoryArena* arena() const { return arena_.get(); }
+
+ private:
+  std::shared_ptr<StaticMemoryArena> arena_;
+  size_t index_;
+  uint64_t serial_;
+};
+
+const std::shared_ptr<phi::Allocation>& HolderOf(Variable* var) {
+  static const std::shared_ptr<phi::Allocation> empty;
+  if (var == nullptr || !var->IsType<phi::DenseTensor>()) {
+    return empty;
+  }
+  return var->Get<phi::DenseTensor>().Holder();
+}
+
+}  // namespace
+
+StaticMemoryPlanner::StaticMemoryPlanner(
+    const platform::Place& place,
+    size_t record_runs,
+    std::vector<std::vector<Variable*>> step_outputs)
+    : place_(place),
+      record_runs_(std::max<size_t>(record_runs, 1)),
+      step_outputs_(std::move(step_outputs)) {
+  had_holder_.resize(step_outputs_.size());
+  for (size_t step = 0; step < step_outputs_.size(); ++step) {
+    had_holder_[step].resize(step_outputs_[step].size());
+  }
+}
+
+StaticMemoryPlanner::~StaticMemoryPlanner() = default;
+
+size_t StaticMemoryPlanner::ArenaSize() const {
+  return arena_ ? arena_->size : 0;
+}
+
+void StaticMemoryPlanner::ResetRecord() {
+  blocks_.clear();
+  recorded_runs_ = 0;
+  missed_runs_ = 0;
+}
+
+void StaticMemoryPlanner::BeginRun() {
+  current_step_ = 0;
+  if (IsReplaying()) {
+    handed_out_.assign(blocks_.size(), nullptr);
+    run_misses_ = 0;
+  } else {
+    run_blocks_.clear();
+    live_blocks_.clear();
+  }
+}
+
+void StaticMemoryPlanner::BeforeStep(size_t step) {
+  current_step_ = step;
+  if (!IsReplaying()) {
+    for (size_t i = 0; i < step_outputs_[step].size(); ++i) {
+      had_holder_[step][i] = HolderOf(step_outputs_[step][i]) != nullptr;
+    }
+    return;
+  }
+
+  for (size_t index : step_blocks_[step]) {
+    const Block& block = blocks_[index];
+    Variable* var = step_outputs_[step][block.output];
+    if (!var->IsType<phi::DenseTensor>()) {
+      continue;
+    }
+    auto* tensor = var->GetMutable<phi::DenseTensor>();
+    if (tensor->Holder() || tensor->meta().offset != 0) {
+      continue;
+    }
+    // the block or one sharing its bytes is still held, e.g. by a tensor
+    // fetched in the last run
+    bool is_free = arena_->IsFree(index);
+    for (size_t i = 0; is_free && i < block.conflicts.size(); ++i) {
+      is_free = arena_->IsFree(block.conflicts[i]);
+    }
+    if (!is_free) {
+      VLOG(6) << "Block " << index << " of static memory plan is in use";
+      continue;
+    }
+    uint64_t serial = arena_->next_serial++;
+    arena_->owners[index].store(serial);
+    void* ptr =
+        reinterpret_cast<uint8_t*>(arena_->memory->ptr()) + block.offset;
+    auto holder = std::make_shared<PlannedAllocation>(
+        ptr, block.size, place_, arena_, index, serial);
+    handed_out_[index] = holder.get();
+    tensor->ResetHolder(holder);
+  }
+}
+
+void StaticMemoryPlanner::AfterStep(size_t step) {
+  if (IsReplaying()) {
+    for (size_t index : step_blocks_[step]) {
+      if (handed_out_[index] != nullptr &&
+          HolderOf(step_outputs_[step][blocks_[index].output]).get() !=
+              handed_out_[index]) {
+        VLOG(6) << "Block " << index << " of static memory plan is replaced";
+        ++run_misses_;
+      }
+    }
+    return;
+  }
+
+  // The garbage collector may free an allocation asynchronously, in which
+  // case it is only seen freed here. The step is later than the real end of
+  // the allocation, which only makes the plan conservative.
+  for (auto it = live_blocks_.begin(); it != live_blocks_.end();) {
+    if (it->second.holder.expired()) {
+      run_blocks_[it->second.index].last_step = step;
+      it = live_blocks_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (size_t i = 0; i < step_outputs_[step].size(); ++i) {
+    if (had_holder_[step][i]) {
+      continue;
+    }
+    const auto& holder = HolderOf(step_outputs_[step][i]);
+    if (holder == nullptr || live_blocks_.count(holder.get())) {
+      continue;
+    }
+    live_blocks_.emplace(holder.get(), LiveBlock{holder, run_blocks_.size()});
+    run_blocks_.push_back(Block{step, i, holder->size(), kAlive, false, 0, {}});
+  }
+}
+
+void StaticMemoryPlanner::OnGarbage(Variable* var) {
+  const auto& holder = HolderOf(var);
+  // the allocation outlives the variable if it is shared with another one
+  if (holder == nullptr || holder.use_count() != 1) {
+    return;
+  }
+  if (IsReplaying()) {
+    auto* allocation = dynamic_cast<PlannedAllocation*>(holder.get());
+    if (allocation != nullptr && allocation->arena() == arena_.get()) {
+      allocation->Release();
+    }
+  } else {
+    EndLiveBlock(holder.get(), current_step_);
+  }
+}
+
+void StaticMemoryPlanner::EndLiveBlock(const phi::Allocation* allocation,
+                                       size_t last_step) {
+  auto it = live_blocks_.find(allocation);
+  if (it != live_blocks_.end()) {
+    run_blocks_[it->second.index].last_step = last_step;
+    live_blocks_.erase(it);
+  }
+}
+
+void StaticMemoryPlanner::EndRun(bool success) {
+  if (IsReplaying()) {
+    if (!success) {
+      return;
+    }
+    missed_runs_ = run_misses_ > 0 ? missed_runs_ + 1 : 0;
+    if (missed_runs_ >= record_runs_) {
+      VLOG(1) << "Drop static memory plan after " << missed_runs_
+              << " runs with mismatched tensors, record again";
+      arena_.reset();
+      step_blocks_.clear();
+      handed_out_.clear();
+      ResetRecord();
+    }
+    return;
+  }
+
+  if (!success) {
+    ResetRecord();
+    return;
+  }
+  for (auto& pair : live_blocks_) {
+    Block& block = run_blocks_[pair.second.index];
+    if (pair.second.holder.expired()) {
+      block.last_step = current_step_;
+    } else {
+      block.escaped = true;
+    }
+  }
+  live_blocks_.clear();
+
+  if (MergeTrace()) {
+    ++recorded_runs_;
+  } else {
+    blocks_ = std::move(run_blocks_);
+    recorded_runs_ = 1;
+  }
+  run_blocks_.clear();
+  VLOG(4) << "Record " << blocks_.size() << " blocks for static memory plan, "
+          << recorded_runs_ << " of " << record_runs_ << " runs";
+  if (recorded_runs_ >= record_runs_) {
+    BuildPlan();
+  }
+}
+
+bool StaticMemoryPlanner::MergeTrace() {
+  if (recorded_runs_ == 0 || blocks_.size() != run_blocks_.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < blocks_.size(); ++i) {
+    const Block& a = blocks_[i];
+    const Block& b = run_blocks_[i];
+    if (a.step != b.step || a.output != b.output || a.size != b.size) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < blocks_.size(); ++i) {
+    blocks_[i].last_step =
+        std::max(blocks_[i].last_step, run_blocks_[i].last_step);
+    blocks_[i].escaped = blocks_[i].escaped || run_blocks_[i].escaped;
+  }
+  return true;
+}
+
+void StaticMemoryPlanner::BuildPlan() {
+  std::vector<size_t> order;
+  for (size_t i = 0; i < blocks_.size(); ++i) {
+    if (!blocks_[i].escaped && blocks_[i].last_step != kAlive &&
+        blocks_[i].size > 0) {
+      order.push_back(i);
+    }
+  }
+  // place the large blocks first, they are the hardest to fit into gaps
+  std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+    return blocks_[a].size > blocks_[b].size;
+  });
+
+  auto live_together = [](const Block& a, const Block& b) {
+    return !(a.last_step < b.step || b.last_step < a.step);
+  };
+  auto share_bytes = [](const Block& a, const Block& b) {
+    return a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+  };
+
+  size_t arena_size = 0;
+  std::vector<size_t> placed;
+  std::vector<std::pair<size_t, size_t>> used;
+  for (size_t index : order) {
+    Block& block = blocks_[index];
+    used.clear();
+    for (size_t other : placed) {
+      if (live_together(block, blocks_[other])) {
+        used.emplace_back(blocks_[other].offset,
+                          blocks_[other].offset + blocks_[other].size);
+      }
+    }
+    std::sort(used.begin(), used.end());
+    size_t offset = 0;
+    for (auto& range : used) {
+      if (offset + block.size <= range.first) {
+        break;
+      }
+      offset = std::max(offset, AlignUp(range.second));
+    }
+    block.offset = offset;
+    arena_size = std::max(arena_size, offset + block.size);
+    placed.push_back(index);
+  }
+
+  size_t total_size = 0;
+  step_blocks_.assign(step_outputs_.size(), std::vector<size_t>());
+  for (size_t index : placed) {
+    Block& block = blocks_[index];
+    block.conflicts.clear();
+    for (size_t other : placed) {
+      if (other != index && share_bytes(block, blocks_[other])) {
+        block.conflicts.push_back(other);
+      }
+    }
+    step_blocks_[block.step].push_back(index);
+    total_size += block.size;
+  }
+
+  size_t peak_size = 0;
+  for (size_t step = 0; step < step_outputs_.size(); ++step) {
+    size_t live_size = 0;
+    for (size_t index : placed) {
+      if (blocks_[index].step <= step && step <= blocks_[index].last_step) {
+        live_size += blocks_[index].size;
+      }
+    }
+    peak_size = std::max(peak_size, live_size);
+  }
+
+  arena_ = std::make_shared<StaticMemoryArena>(
+      place_, arena_size, blocks_.size());
+  handed_out_.assign(blocks_.size(), nullptr);
+  missed_runs_ = 0;
+  VLOG(1) << "Build static memory plan of " << placed.size() << " of "
+          << blocks_.size() << " blocks on " << place_ << ", arena size "
+          << arena_size << " bytes, peak live size " << peak_size
+          << " bytes, total size " << total_size << " bytes";
+}
+
+}  // namespace interpreter
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,124 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/framework/variable.h"
+#include "paddle/fluid/platform/place.h"
+#include "paddle/phi/core/allocator.h"
+
+namespace paddle {
+namespace framework {
+namespace interpreter {
+
+struct StaticMemoryArena;
+
+// StaticMemoryPlanner serves the intermediate tensors of a program that is
+// run step by step in a fixed order, e.g. by the trace mode of
+// PirInterpreter, from one preallocated arena.
+//
+// During the first record_runs runs it records, for every step, the outputs
+// that get a new allocation and the step at which the allocation is given to
+// the garbage collector. Once record_runs consecutive runs produced the same
+// trace, the blocks are packed into an arena by their lifetimes, blocks that
+// are never alive at the same time sharing the same bytes. In the following
+// runs the output tensors are handed their slice of the arena before their
+// step runs, so the kernels find a large enough holder and do not allocate.
+//
+// A tensor whose slice is too small, e.g. because the input shapes changed,
+// is allocated by the kernel as usual. If that keeps happening for
+// record_runs runs, the plan is dropped and a new trace is recorded.
+class StaticMemoryPlanner {
+ public:
+  // step_outputs[i] holds the variables written by the i-th step which are
+  // not also read by it.
+  StaticMemoryPlanner(const platform::Place& place,
+                      size_t record_runs,
+                      std::vector<std::vector<Variable*>> step_outputs);
+
+  ~StaticMemoryPlanner();
+
+  void BeginRun();
+
+  void BeforeStep(size_t step);
+
+  void AfterStep(size_t step);
+
+  // Called before var is given to the garbage collector at the current step.
+  void OnGarbage(Variable* var);
+
+  // A run that failed is not recorded.
+  void EndRun(bool success);
+
+  bool IsReplaying() const { return arena_ != nullptr; }
+
+  // Size of the arena, 0 if not replaying.
+  size_t ArenaSize() const;
+
+ private:
+  struct Block {
+    size_t step;
+    size_t output;
+    size_t size;
+    // the last step during which the block is alive
+    size_t last_step;
+    // still alive at the end of a run, e.g. a fetched tensor
+    bool escaped;
+    size_t offset;
+    // the blocks placed before this one which share some of its bytes
+    std::vector<size_t> conflicts;
+  };
+
+  struct LiveBlock {
+    std::weak_ptr<phi::Allocation> holder;
+    size_t index;
+  };
+
+  void ResetRecord();
+
+  void EndLiveBlock(const phi::Allocation* allocation, size_t last_step);
+
+  bool MergeTrace();
+
+  void BuildPlan();
+
+  platform::Place place_;
+  size_t record_runs_;
+  std::vector<std::vector<Variable*>> step_outputs_;
+
+  size_t current_step_{0};
+
+  // recording
+  std::vector<std::vector<bool>> had_holder_;
+  std::vector<Block> run_blocks_;
+  std::unordered_map<const phi::Allocation*, LiveBlock> live_blocks_;
+  std::vector<Block> blocks_;
+  size_t recorded_runs_{0};
+
+  // replaying
+  std::vector<std::vector<size_t>> step_blocks_;
+  std::shared_ptr<StaticMemoryArena> arena_;
+  std::vector<const phi::Allocation*> handed_out_;
+  size_t run_misses_{0};
+  size_t missed_runs_{0};
+};
+
+}  // namespace interpreter
+}  // namespace framework
+}  // namespace paddle
@@ -42,6 +42,8 @@ COMMON_DECLARE_bool(new_executor_serial_run);
 PD_DECLARE_bool(new_executor_static_build);
 PD_DECLARE_bool(new_executor_use_inplace);
 PD_DECLARE_bool(new_executor_use_local_scope);
+PD_DECLARE_bool(new_executor_critical_path_priority);
+PD_DECLARE_int32(new_executor_static_memory_plan_runs);
 
 COMMON_DECLARE_bool(check_nan_inf);
 PD_DECLARE_bool(benchmark);
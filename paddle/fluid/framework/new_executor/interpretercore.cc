@@ -30,6 +30,20 @@ PADDLE_DEFINE_EXPORTED_bool(
 PADDLE_DEFINE_EXPORTED_bool(new_executor_use_inplace,
                             false,
                             "Use inplace in new executor");
+PADDLE_DEFINE_EXPORTED_bool(
+    new_executor_critical_path_priority,
+    false,
+    "Schedule ready ops by the length of their remaining critical path, so "
+    "that ops on the critical path do not wait behind side branches. The "
+    "prioritized ops go through one heap shared by the workers instead of "
+    "their own queues, so it only pays off for programs with wide side "
+    "branches.");
+PADDLE_DEFINE_EXPORTED_int32(
+    new_executor_static_memory_plan_runs,
+    0,
+    "Serve the intermediate tensors of a program run by the trace mode of "
+    "the pir interpreter on CPU from one preallocated arena, planned from "
+    "the allocations of this many identical runs. 0 means disabled.");
 PADDLE_DEFINE_EXPORTED_bool(new_executor_use_local_scope,
                             true,
                             "Use local_scope in new executor(especially used "
@@ -412,7 +412,8 @@ std::shared_ptr<interpreter::AsyncWorkQueue> PirInterpreter::GetWorkQueue() {
     async_work_queue_ = std::make_shared<interpreter::AsyncWorkQueue>(
         execution_config_.host_num_threads,
         execution_config_.device_num_threads,
-        nullptr);
+        nullptr,
+        execution_config_.numa_node);
   }
   return async_work_queue_;
 }
@@ -1040,6 +1041,12 @@ void PirInterpreter::BuildInstructionDependences() {
     instructions_ptr.push_back(instr.get());
   }
   auto downstream_map = ir_dependency_builder_.Build(instructions_ptr);
+  critical_path_length_.clear();
+  if (FLAGS_new_executor_critical_path_priority &&
+      !FLAGS_new_executor_serial_run) {
+    critical_path_length_ =
+        ir_dependency_builder_.CriticalPathLength(instr_num);
+  }
 
   for (size_t instr_id = 0; instr_id < instr_num; ++instr_id) {
     InstructionBase* cur_instr = vec_instruction_base_[instr_id].get();
@@ -1060,13 +1067,22 @@ void PirInterpreter::BuildInstructionDependences() {
           }
         }
       } else {
-        bool has_instr_in_same_thread = false;
+        // keep the next instruction on the longest remaining path in this
+        // thread
+        size_t same_thread_instr_id = instr_num;
+        for (size_t next_instr_id : next_instr_ids) {
+          if (vec_instruction_base_[next_instr_id]->KernelType() !=
+                  OpFuncType::kGpuAsync &&
+              (same_thread_instr_id == instr_num ||
+               (!critical_path_length_.empty() &&
+                critical_path_length_[next_instr_id] >
+                    critical_path_length_[same_thread_instr_id]))) {
+            same_thread_instr_id = next_instr_id;
+          }
+        }
         for (size_t next_instr_id : next_instr_ids) {
-          if (!has_instr_in_same_thread &&
-              vec_instruction_base_[next_instr_id]->KernelType() !=
-                  OpFuncType::kGpuAsync) {
+          if (next_instr_id == same_thread_instr_id) {
             cur_instr->AddNextInstrInSameThread(next_instr_id);
-            has_instr_in_same_thread = true;
           } else {
             cur_instr->AddNextInstrInDifferentThread(next_instr_id);
           }
@@ -1258,11 +1274,17 @@ void PirInterpreter::CheckGC(InstructionBase* instr) {
     if (is_ready) {
       VLOG(6) << "Async delete variable with name : "
               << value_exe_info_->GetNameById(static_cast<int>(var_id));
+      if (static_memory_planner_) {
+        static_memory_planner_->OnGarbage(refs_[var_id]->Var());
+      }
       gc_->Add(refs_[var_id]->Var(), instr);
     }
   }
 
   for (auto var : instr->EagerGCVars()) {
+    if (static_memory_planner_) {
+      static_memory_planner_->OnGarbage(var);
+    }
     gc_->Add(var, instr);
   }
   instr->ClearEagerGCVars();
@@ -1596,6 +1618,12 @@ void PirInterpreter::TraceRunImpl() {
     gc_ = CreateInterpreterCoreGarbageCollector(place_, vec_instruction_base_);
   }
 
+  if (!static_memory_planner_ &&
+      FLAGS_new_executor_static_memory_plan_runs > 0 &&
+      platform::is_cpu_place(place_)) {
+    BuildStaticMemoryPlanner();
+  }
+
   interpreter::ResetAtomicGuard guard(&deps_, &refs_);
   VLOG(4) << "Tracing Instruction List";
 
@@ -1608,6 +1636,41 @@ void PirInterpreter::TraceRunImpl() {
 #endif
 }
 
+void PirInterpreter::BuildStaticMemoryPlanner() {
+  std::vector<std::vector<Variable*>> step_outputs;
+  step_outputs.reserve(trace_execute_order_.size());
+  const auto& var_list = value_exe_info_->GetVarList();
+  for (auto instr_id : trace_execute_order_) {
+    InstructionBase* instr = vec_instruction_base_.at(instr_id).get();
+    std::unordered_set<int> input_ids;
+    for (auto& item : instr->Inputs()) {
+      input_ids.insert(item.second.begin(), item.second.end());
+    }
+    std::unordered_set<int> output_ids;
+    std::vector<Variable*> outputs;
+    for (auto& item : instr->Outputs()) {
+      for (auto var_id : item.second) {
+        // inplace outputs reuse the memory of their inputs, and parameters
+        // are never released
+        if (var_id < 0 || static_cast<size_t>(var_id) >= var_list.size() ||
+            input_ids.count(var_id) || !output_ids.insert(var_id).second ||
+            parameter_var_names_.count(value_exe_info_->GetNameById(var_id))) {
+          continue;
+        }
+        outputs.push_back(var_list[var_id]);
+      }
+    }
+    step_outputs.emplace_back(std::move(outputs));
+  }
+  VLOG(4) << "Build static memory planner of " << step_outputs.size()
+          << " steps, record " << FLAGS_new_executor_static_memory_plan_runs
+          << " runs";
+  static_memory_planner_ = std::make_unique<interpreter::StaticMemoryPlanner>(
+      place_,
+      static_cast<size_t>(FLAGS_new_executor_static_memory_plan_runs),
+      std::move(step_outputs));
+}
+
 void PirInterpreter::MultiThreadRunImpl() {
   // lazy initialization of gc, do not create gc is the program only run once
   if (!gc_) {
@@ -1658,13 +1721,23 @@ void PirInterpreter::TraceRunInstructionList(
     }
   }
 
+  if (static_memory_planner_) {
+    static_memory_planner_->BeginRun();
+  }
+
   for (size_t idx = 0; idx < trace_execute_order_.size(); idx++) {
     auto instr_id = trace_execute_order_[idx];
     InstructionBase* instr_node = vec_instruction_base_.at(instr_id).get();
 
     VLOG(6) << "Run InstructionBase " << instr_node->Name() << "[" << instr_id
             << "]";
-    RunInstructionBase(instr_node);
+    if (static_memory_planner_) {
+      static_memory_planner_->BeforeStep(idx);
+      RunInstructionBase(instr_node);
+      static_memory_planner_->AfterStep(idx);
+    } else {
+      RunInstructionBase(instr_node);
+    }
 
     if (UNLIKELY(exception_holder_.IsCaught())) {
       VLOG(4) << "Exception caught";
@@ -1672,6 +1745,10 @@ void PirInterpreter::TraceRunInstructionList(
     }
   }
 
+  if (static_memory_planner_) {
+    static_memory_planner_->EndRun(!exception_holder_.IsCaught());
+  }
+
   if (UNLIKELY(exception_holder_.IsCaught())) {
     VLOG(1) << "Exception caught " << exception_holder_.Type();
     PADDLE_ENFORCE_EQ(
@@ -1715,8 +1792,7 @@ void PirInterpreter::MultiThreadRunInstructionList(
       if (FLAGS_new_executor_serial_run) {
         RunInstructionBaseAsync(i);
       } else {
-        async_work_queue_->AddTask(vec_instr.at(i)->KernelType(),
-                                   [this, i] { RunInstructionBaseAsync(i); });
+        AddInstructionTask(i);
       }
     }
   }
@@ -1779,6 +1855,18 @@ void PirInterpreter::MultiThreadRunInstructionList(
   }
 }
 
+void PirInterpreter::AddInstructionTask(size_t instr_id) {
+  auto task = [this, instr_id]() { RunInstructionBaseAsync(instr_id); };
+  if (critical_path_length_.empty()) {
+    async_work_queue_->AddTask(vec_instruction_base_[instr_id]->KernelType(),
+                               task);
+  } else {
+    async_work_queue_->AddTask(vec_instruction_base_[instr_id]->KernelType(),
+                               task,
+                               critical_path_length_[instr_id]);
+  }
+}
+
 void PirInterpreter::RunInstructionBaseAsync(size_t instr_id) {
   // NOTE(Ruibiao): Due to the uncertain order in multi-threading asynchronous
   // scheduling, the priority order involved cross-thread scheduling is not
@@ -1826,9 +1914,7 @@ void PirInterpreter::RunNextInstructions(InstructionBase* instr,
 
   for (size_t next_instr_id : instr->NextInstrsInDifferenceThread()) {
     if (IsReady(next_instr_id)) {
-      async_work_queue_->AddTask(
-          vec_instruction_base_[next_instr_id]->KernelType(),
-          [this, next_instr_id]() { RunInstructionBaseAsync(next_instr_id); });
+      AddInstructionTask(next_instr_id);
     }
   }
 
@@ -1974,6 +2060,9 @@ void PirInterpreter::PreAnalysis() {
                               ir_instruction_scheduling_priority_less);
   VLOG(4) << "Done AnalyseExecuteOrderForTrace";
 
+  // the steps of the trace have changed
+  static_memory_planner_.reset();
+
   UpdateSyncOpNum();
   VLOG(4) << "Done UpdateSyncOpNum";
 
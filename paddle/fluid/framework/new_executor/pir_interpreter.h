@@ -15,6 +15,7 @@
 #pragma once
 #include <memory>
 #include "paddle/fluid/framework/new_executor/instruction/instruction_base.h"
+#include "paddle/fluid/framework/new_executor/interpreter/static_memory_plan.h"
 #include "paddle/fluid/framework/new_executor/interpreter_base_impl.h"
 #include "paddle/pir/include/core/value.h"
 
@@ -195,6 +196,12 @@ class PirInterpreter : public InterpreterBaseImpl {
   // op need to wait
   std::shared_ptr<std::vector<size_t>> dependency_count_;
 
+  // critical_path_length_[i] is the number of instructions on the longest
+  // path from the i-th instruction to the end of the block, used as its
+  // scheduling priority. Empty if FLAGS_new_executor_critical_path_priority
+  // is off.
+  std::vector<size_t> critical_path_length_;
+
   std::vector<std::shared_ptr<interpreter::OpDepInfo>> deps_;
   std::vector<std::shared_ptr<interpreter::VarRefInfo>> refs_;
 
@@ -204,6 +211,10 @@ class PirInterpreter : public InterpreterBaseImpl {
   int64_t onednn_op_num_{-1};
   std::vector<size_t> trace_execute_order_;
 
+  // Serves the intermediate tensors of trace runs from one arena, only
+  // created if FLAGS_new_executor_static_memory_plan_runs is set.
+  std::unique_ptr<interpreter::StaticMemoryPlanner> static_memory_planner_;
+
   std::vector<PirHookFunc> pir_output_hookfuncs_;
   std::vector<PirHookFunc> pir_input_hookfuncs_;
 
@@ -220,6 +231,8 @@ class PirInterpreter : public InterpreterBaseImpl {
 
   void PreAnalysis();
 
+  void BuildStaticMemoryPlanner();
+
   void BuildInstruction();
 
   void BuildInstructionDependences();
@@ -236,6 +249,8 @@ class PirInterpreter : public InterpreterBaseImpl {
 
   void RunInstructionBaseAsync(size_t instr_id);
 
+  void AddInstructionTask(size_t instr_id);
+
   void RunNextInstructions(InstructionBase* instr,
                            SchedulingQueue* reserved_next_ops);
 
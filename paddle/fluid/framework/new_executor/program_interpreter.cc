@@ -410,7 +410,8 @@ ProgramInterpreter::GetWorkQueue() {
     async_work_queue_ = std::make_shared<interpreter::AsyncWorkQueue>(
         execution_config_.host_num_threads,
         execution_config_.device_num_threads,
-        nullptr);
+        nullptr,
+        execution_config_.numa_node);
   }
   return async_work_queue_;
 }
@@ -634,6 +635,11 @@ void ProgramInterpreter::BuildOperatorDependences() {
   }
 
   auto downstream_map = dependency_builder_.Build(vec_instruction_);
+  critical_path_length_.clear();
+  if (FLAGS_new_executor_critical_path_priority &&
+      !FLAGS_new_executor_serial_run) {
+    critical_path_length_ = dependency_builder_.CriticalPathLength(instr_num);
+  }
 
   for (size_t instr_id = 0; instr_id < instr_num; ++instr_id) {
     Instruction& cur_instr = vec_instruction_[instr_id];
@@ -654,13 +660,21 @@ void ProgramInterpreter::BuildOperatorDependences() {
           }
         }
       } else {
-        bool has_instr_in_same_thread = false;
+        // keep the next op on the longest remaining path in this thread
+        size_t same_thread_instr_id = instr_num;
+        for (size_t next_instr_id : next_instr_ids) {
+          if (vec_instruction_[next_instr_id].KernelType() !=
+                  OpFuncType::kGpuAsync &&
+              (same_thread_instr_id == instr_num ||
+               (!critical_path_length_.empty() &&
+                critical_path_length_[next_instr_id] >
+                    critical_path_length_[same_thread_instr_id]))) {
+            same_thread_instr_id = next_instr_id;
+          }
+        }
         for (size_t next_instr_id : next_instr_ids) {
-          if (!has_instr_in_same_thread &&
-              vec_instruction_[next_instr_id].KernelType() !=
-                  OpFuncType::kGpuAsync) {
+          if (next_instr_id == same_thread_instr_id) {
             cur_instr.AddNextInstrInSameThread(next_instr_id);
-            has_instr_in_same_thread = true;
           } else {
             cur_instr.AddNextInstrInDifferentThread(next_instr_id);
           }
@@ -1269,8 +1283,7 @@ void ProgramInterpreter::ExecuteInstructionList(
       if (FLAGS_new_executor_serial_run) {
         RunInstructionAsync(i);
       } else {
-        async_work_queue_->AddTask(vec_instr.at(i).KernelType(),
-                                   [this, i] { RunInstructionAsync(i); });
+        AddInstructionTask(i);
       }
     }
   }
@@ -1346,9 +1359,7 @@ void ProgramInterpreter::RunNextInstructions(
 
   for (size_t next_instr_id : instr.NextInstrsInDifferenceThread()) {
     if (IsReady(next_instr_id)) {
-      async_work_queue_->AddTask(
-          vec_instruction_[next_instr_id].KernelType(),
-          [this, next_instr_id]() { RunInstructionAsync(next_instr_id); });
+      AddInstructionTask(next_instr_id);
     }
   }
 
@@ -1359,6 +1370,17 @@ void ProgramInterpreter::RunNextInstructions(
   }
 }
 
+void ProgramInterpreter::AddInstructionTask(size_t instr_id) {
+  auto task = [this, instr_id]() { RunInstructionAsync(instr_id); };
+  if (critical_path_length_.empty()) {
+    async_work_queue_->AddTask(vec_instruction_[instr_id].KernelType(), task);
+  } else {
+    async_work_queue_->AddTask(vec_instruction_[instr_id].KernelType(),
+                               task,
+                               critical_path_length_[instr_id]);
+  }
+}
+
 void ProgramInterpreter::RunInstructionAsync(size_t instr_id) {
   // NOTE(Ruibiao): Due to the uncertain order in multi-threading asynchronous
   // scheduling, the priority order involved cross-thread scheduling is not
@@ -146,6 +146,7 @@ class ProgramInterpreter : public InterpreterBaseImpl {
   void RunImpl();
   void ExecuteInstructionList(const std::vector<Instruction>& vec_instr);
   void RunInstructionAsync(size_t instr_id);
+  void AddInstructionTask(size_t instr_id);
   void RunInstruction(const Instruction& instr_node);
   void RunNextInstructions(const Instruction& instr_id,
                            SchedulingQueue* reserved_next_ops);
@@ -229,6 +230,11 @@ class ProgramInterpreter : public InterpreterBaseImpl {
   // op need to wait
   std::shared_ptr<std::vector<size_t>> dependency_count_;
 
+  // critical_path_length_[i] is the number of ops on the longest path from
+  // the i-th op to the end of the program, used as its scheduling priority.
+  // Empty if FLAGS_new_executor_critical_path_priority is off.
+  std::vector<size_t> critical_path_length_;
+
   std::vector<std::shared_ptr<interpreter::OpDepInfo>> deps_;
   std::vector<std::shared_ptr<interpreter::VarRefInfo>> refs_;
 
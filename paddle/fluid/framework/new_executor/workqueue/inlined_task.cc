@@ -0,0 +1,112 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/workqueue/inlined_task.h"
+
+#include <atomic>
+#include <mutex>
+
+#include "paddle/fluid/memory/allocation/spin_lock.h"
+
+namespace paddle::framework {
+
+namespace {
+
+std::atomic<uint64_t> task_heap_allocations{0};
+
+// Free blocks shared by all threads, linked through their first word.
+// Blocks are never given back to the heap allocator, so the list is bounded
+// by the peak number of large tasks in flight.
+class TaskBlockList {
+ public:
+  void Push(void** blocks, size_t num) {
+    std::lock_guard<paddle::memory::SpinLock> guard(lock_);
+    for (size_t i = 0; i < num; ++i) {
+      *static_cast<void**>(blocks[i]) = head_;
+      head_ = blocks[i];
+    }
+  }
+
+  size_t Pop(void** blocks, size_t num) {
+    std::lock_guard<paddle::memory::SpinLock> guard(lock_);
+    size_t i = 0;
+    for (; i < num && head_ != nullptr; ++i) {
+      blocks[i] = head_;
+      head_ = *static_cast<void**>(head_);
+    }
+    return i;
+  }
+
+ private:
+  paddle::memory::SpinLock lock_;
+  void* head_{nullptr};
+};
+
+TaskBlockList& GlobalTaskBlocks() {
+  // leaked on purpose, threads may exit after static destruction
+  static TaskBlockList* list = new TaskBlockList();
+  return *list;
+}
+
+struct TaskBlockCache {
+  static constexpr size_t kCapacity = 64;
+  static constexpr size_t kBatch = kCapacity / 2;
+
+  ~TaskBlockCache() {
+    if (size > 0) {
+      GlobalTaskBlocks().Push(blocks, size);
+    }
+  }
+
+  void* blocks[kCapacity];
+  size_t size{0};
+};
+
+thread_local TaskBlockCache task_block_cache;
+
+}  // namespace
+
+void* AllocTaskStorage(size_t size) {
+  if (size <= kTaskBlockSize) {
+    TaskBlockCache& cache = task_block_cache;
+    if (cache.size == 0) {
+      cache.size = GlobalTaskBlocks().Pop(cache.blocks, TaskBlockCache::kBatch);
+    }
+    if (cache.size > 0) {
+      return cache.blocks[--cache.size];
+    }
+    size = kTaskBlockSize;
+  }
+  task_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+  return ::operator new(size);
+}
+
+void FreeTaskStorage(void* ptr, size_t size) {
+  if (size > kTaskBlockSize) {
+    ::operator delete(ptr);
+    return;
+  }
+  TaskBlockCache& cache = task_block_cache;
+  if (cache.size == TaskBlockCache::kCapacity) {
+    cache.size -= TaskBlockCache::kBatch;
+    GlobalTaskBlocks().Push(cache.blocks + cache.size, TaskBlockCache::kBatch);
+  }
+  cache.blocks[cache.size++] = ptr;
+}
+
+uint64_t TaskHeapAllocationCount() {
+  return task_heap_allocations.load(std::memory_order_relaxed);
+}
+
+}  // namespace paddle::framework
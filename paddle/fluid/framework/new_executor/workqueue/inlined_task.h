@@ -0,0 +1,174 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace paddle {
+namespace framework {
+
+// Storage for the closures that do not fit into an InlinedTask. Sizes up to
+// kTaskBlockSize are served from a per-thread freelist of fixed-size blocks,
+// which trades batches of blocks with a pool-wide list, so tasks created on
+// one thread and destroyed on another still recycle their blocks.
+constexpr size_t kTaskBlockSize = 256;
+
+void* AllocTaskStorage(size_t size);
+
+void FreeTaskStorage(void* ptr, size_t size);
+
+// Number of times AllocTaskStorage had to call the heap allocator, i.e. the
+// closure was larger than kTaskBlockSize or no free block was available.
+uint64_t TaskHeapAllocationCount();
+
+// InlinedTask is a move-only replacement of std::function<void()> for the
+// tasks of a WorkQueue. Closures of up to kInlineSize bytes, like the
+// [this, instr_id] lambdas of the interpreters, are stored in the task
+// itself, larger ones in a block from AllocTaskStorage. Being move-only, it
+// also accepts closures that capture move-only objects.
+class InlinedTask {
+ public:
+  // together with the ops pointer, a RunQueue element stays one cache line
+  static constexpr size_t kInlineSize = 48;
+
+  InlinedTask() noexcept {}
+
+  InlinedTask(std::nullptr_t) noexcept {}  // NOLINT
+
+  template <typename F,
+            typename Fn = typename std::decay<F>::type,
+            typename = typename std::enable_if<
+                !std::is_same<Fn, InlinedTask>::value>::type>
+  InlinedTask(F&& f) {  // NOLINT
+    if (IsNull(f)) {
+      return;
+    }
+    if constexpr (sizeof(Fn) <= kInlineSize &&
+                  alignof(Fn) <= alignof(void*) &&
+                  std::is_nothrow_move_constructible<Fn>::value) {
+      new (storage_) Fn(std::forward<F>(f));
+      ops_ = InlineOps<Fn>::Get();
+    } else {
+      void* ptr = AllocTaskStorage(sizeof(Fn));
+      new (ptr) Fn(std::forward<F>(f));
+      *reinterpret_cast<void**>(storage_) = ptr;
+      ops_ = HeapOps<Fn>::Get();
+    }
+  }
+
+  InlinedTask(InlinedTask&& other) noexcept : ops_(other.ops_) {
+    if (ops_ != nullptr) {
+      ops_->relocate(storage_, other.storage_);
+      other.ops_ = nullptr;
+    }
+  }
+
+  InlinedTask& operator=(InlinedTask&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      ops_ = other.ops_;
+      if (ops_ != nullptr) {
+        ops_->relocate(storage_, other.storage_);
+        other.ops_ = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  InlinedTask(const InlinedTask&) = delete;
+  InlinedTask& operator=(const InlinedTask&) = delete;
+
+  ~InlinedTask() { Reset(); }
+
+  void operator()() { ops_->invoke(storage_); }
+
+  explicit operator bool() const { return ops_ != nullptr; }
+
+  // whether the closure lives in the task itself, for tests
+  bool IsInlined() const { return ops_ != nullptr && !ops_->on_heap; }
+
+ private:
+  struct Ops {
+    void (*invoke)(void* storage);
+    // move constructs the closure at dst and destroys the one at src
+    void (*relocate)(void* dst, void* src);
+    void (*destroy)(void* storage);
+    bool on_heap;
+  };
+
+  template <typename Fn>
+  struct InlineOps {
+    static void Invoke(void* storage) { (*static_cast<Fn*>(storage))(); }
+    static void Relocate(void* dst, void* src) {
+      Fn* fn = static_cast<Fn*>(src);
+      new (dst) Fn(std::move(*fn));
+      fn->~Fn();
+    }
+    static void Destroy(void* storage) { static_cast<Fn*>(storage)->~Fn(); }
+    static const Ops* Get() {
+      static constexpr Ops ops = {&Invoke, &Relocate, &Destroy, false};
+      return &ops;
+    }
+  };
+
+  template <typename Fn>
+  struct HeapOps {
+    static Fn* Ptr(void* storage) { return *static_cast<Fn**>(storage); }
+    static void Invoke(void* storage) { (*Ptr(storage))(); }
+    static void Relocate(void* dst, void* src) {
+      *static_cast<Fn**>(dst) = Ptr(src);
+    }
+    static void Destroy(void* storage) {
+      Fn* fn = Ptr(storage);
+      fn->~Fn();
+      FreeTaskStorage(fn, sizeof(Fn));
+    }
+    static const Ops* Get() {
+      static constexpr Ops ops = {&Invoke, &Relocate, &Destroy, true};
+      return &ops;
+    }
+  };
+
+  template <typename Fn>
+  static bool IsNull(const Fn&) {
+    return false;
+  }
+  template <typename R, typename... Args>
+  static bool IsNull(const std::function<R(Args...)>& f) {
+    return !f;
+  }
+  template <typename R, typename... Args>
+  static bool IsNull(R (*f)(Args...)) {
+    return f == nullptr;
+  }
+
+  void Reset() {
+    if (ops_ != nullptr) {
+      ops_->destroy(storage_);
+      ops_ = nullptr;
+    }
+  }
+
+  const Ops* ops_{nullptr};
+  alignas(void*) unsigned char storage_[kInlineSize];
+};
+
+}  // namespace framework
+}  // namespace paddle
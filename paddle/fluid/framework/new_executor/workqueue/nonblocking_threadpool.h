@@ -19,6 +19,7 @@
 #include "paddle/fluid/framework/new_executor/workqueue/thread_environment.h"
 #include "paddle/fluid/platform/os_info.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
+#include "paddle/phi/backends/cpu/numa.h"
 
 namespace paddle {
 namespace framework {
@@ -28,11 +29,16 @@ class ThreadPoolTempl {
  public:
   typedef typename Environment::Task Task;
   typedef RunQueue<Task, 1024> Queue;
+  typedef PriorityRunQueue<Task> PriorityQueue;
 
+  // numa_node: pin all the threads to this NUMA node if it is >= 0, or
+  // spread them over all the nodes if it is kAllNumaNodes, see
+  // WorkQueueOptions.numa_node. Ignored on single node machines.
   ThreadPoolTempl(const std::string& name,
                   int num_threads,
                   bool allow_spinning,
                   bool always_spinning,
+                  int numa_node = -1,
                   Environment env = Environment())
       : env_(env),
         allow_spinning_(allow_spinning),
@@ -60,6 +66,9 @@ class ThreadPoolTempl {
     }
     for (int i = 0; i < num_threads_; i++) {
       SetStealPartition(i, EncodePartition(0, num_threads_));
+    }
+    PlaceThreadsOnNumaNodes(numa_node);
+    for (int i = 0; i < num_threads_; i++) {
       thread_data_[i].thread.reset(
           env_.CreateThread([this, i]() { WorkerLoop(i); }));
     }
@@ -79,6 +88,7 @@ class ThreadPoolTempl {
       for (size_t i = 0; i < thread_data_.size(); i++) {
         thread_data_[i].queue.Flush();
       }
+      priority_queue_.Flush();
     }
     // Join threads explicitly (by destroying) to avoid destruction order within
     // this class.
@@ -101,11 +111,11 @@ class ThreadPoolTempl {
     }
   }
 
-  void AddTask(std::function<void()> fn) {
+  void AddTask(InlinedTask fn) {
     AddTaskWithHint(std::move(fn), 0, num_threads_);
   }
 
-  void AddTaskWithHint(std::function<void()> fn, int start, int limit) {
+  void AddTaskWithHint(InlinedTask fn, int start, int limit) {
     Task t = env_.CreateTask(std::move(fn));
     PerThread* pt = GetPerThread();
     if (pt->pool == this) {
@@ -140,6 +150,16 @@ class ThreadPoolTempl {
     }
   }
 
+  // Tasks added with a priority are taken by any worker before the tasks in
+  // the per-thread queues, higher priority first. They are kept in one
+  // pool-wide queue, since stealing from per-thread deques can not respect
+  // the priority of tasks across threads.
+  void AddTaskWithPriority(InlinedTask fn, int64_t priority) {
+    priority_queue_.Push(env_.CreateTask(std::move(fn)), priority);
+    VLOG(6) << "Add task with priority " << priority << ", Notify";
+    ec_.Notify(false);
+  }
+
   void Cancel() {
     cancelled_ = true;
     done_ = true;
@@ -200,6 +220,33 @@ class ThreadPoolTempl {
     return thread_data_[i].steal_partition.load(std::memory_order_relaxed);
   }
 
+  // Assigns a NUMA node to each thread. When the threads are spread over
+  // all the nodes, each node gets a contiguous range of threads which is
+  // also their steal partition, so work is stolen within a node first.
+  void PlaceThreadsOnNumaNodes(int numa_node) {
+    const std::vector<int>& node_ids = phi::backends::cpu::NumaNodeIds();
+    const int node_num = static_cast<int>(node_ids.size());
+    if (numa_node == -1 || node_num <= 1) {
+      return;
+    }
+    if (numa_node >= 0) {
+      for (int i = 0; i < num_threads_; i++) {
+        thread_data_[i].numa_node = numa_node;
+      }
+      VLOG(1) << name_ << " pinned to NUMA node " << numa_node;
+      return;
+    }
+    for (int i = 0; i < num_threads_; i++) {
+      int node = i * node_num / num_threads_;
+      // threads [start, limit) share the node
+      int start = (node * num_threads_ + node_num - 1) / node_num;
+      int limit = ((node + 1) * num_threads_ + node_num - 1) / node_num;
+      thread_data_[i].numa_node = node_ids[node];
+      SetStealPartition(i, EncodePartition(start, limit));
+    }
+    VLOG(1) << name_ << " spread over " << node_num << " NUMA nodes";
+  }
+
   inline void ComputeCoprimes(int n, std::vector<unsigned>* coprimes) {
     for (int i = 1; i <= n; i++) {
       unsigned a = i;
@@ -226,9 +273,11 @@ class ThreadPoolTempl {
   };
 
   struct ThreadData {
-    constexpr ThreadData() : thread(), steal_partition(0), queue() {}
+    constexpr ThreadData()
+        : thread(), steal_partition(0), numa_node(-1), queue() {}
     std::unique_ptr<Thread> thread;
     std::atomic<unsigned> steal_partition;
+    int numa_node;  // the thread is pinned to this node if >= 0
     Queue queue;
   };
 
@@ -243,6 +292,7 @@ class ThreadPoolTempl {
   EventCount ec_;
   const int num_threads_;
   std::vector<ThreadData> thread_data_;
+  PriorityQueue priority_queue_;
   std::string name_;
 
   // Main worker thread loop.
@@ -254,6 +304,10 @@ class ThreadPoolTempl {
     pt->pool = this;
     pt->rand = GlobalThreadIdHash();
     pt->thread_id = thread_id;
+    if (thread_data_[thread_id].numa_node >= 0) {
+      phi::backends::cpu::BindCurrentThreadToNumaNode(
+          thread_data_[thread_id].numa_node);
+    }
     Queue& q = thread_data_[thread_id].queue;
     EventCount::Waiter* waiter = ec_.GetWaiter(thread_id);
     // TODO(dvyukov,rmlarsen): The time spent in NonEmptyQueueIndex() is
@@ -270,10 +324,10 @@ class ThreadPoolTempl {
       // counter-productive for the types of I/O workloads the single thread
       // pools tend to be used for.
       while (!cancelled_) {
-        Task t = q.PopFront();
+        Task t = PopLocal(&q);
         for (int i = 0; i < spin_count && !t.f; i++) {
           if (!cancelled_.load(std::memory_order_relaxed)) {
-            t = q.PopFront();
+            t = PopLocal(&q);
           }
         }
         if (!t.f) {
@@ -287,7 +341,7 @@ class ThreadPoolTempl {
       }
     } else {
       while (!cancelled_) {
-        Task t = q.PopFront();
+        Task t = PopLocal(&q);
         if (!t.f) {
           t = LocalSteal();
           if (!t.f) {
@@ -296,7 +350,10 @@ class ThreadPoolTempl {
               if (allow_spinning_) {
                 for (int i = 0; i < spin_count && !t.f; i++) {
                   if (!cancelled_.load(std::memory_order_relaxed)) {
-                    t = GlobalSteal();
+                    t = priority_queue_.Pop();
+                    if (!t.f) {
+                      t = GlobalSteal();
+                    }
                   } else {
                     return;
                   }
@@ -317,6 +374,16 @@ class ThreadPoolTempl {
     }
   }
 
+  // PopLocal takes the most urgent prioritized task, or else the front of
+  // the thread's own queue.
+  Task PopLocal(Queue* q) {
+    Task t = priority_queue_.Pop();
+    if (!t.f) {
+      t = q->PopFront();
+    }
+    return t;
+  }
+
   // Steal tries to steal work from other worker threads in the range [start,
   // limit) in best-effort manner.
   Task Steal(unsigned start, unsigned limit) {
@@ -380,6 +447,12 @@ class ThreadPoolTempl {
     blocked_++;
 
     // Now do a reliable emptiness check.
+    if (!priority_queue_.Empty()) {
+      ec_.CancelWait();
+      *t = priority_queue_.Pop();
+      blocked_--;
+      return true;
+    }
     int victim = NonEmptyQueueIndex();
     if (victim != -1) {
       ec_.CancelWait();
@@ -398,7 +471,7 @@ class ThreadPoolTempl {
       // right after incrementing blocked_ above. Now a free-standing thread
       // submits work and calls destructor (which sets done_). If we don't
       // re-check queues, we will exit leaving the work unexecuted.
-      if (NonEmptyQueueIndex() != -1) {
+      if (!priority_queue_.Empty() || NonEmptyQueueIndex() != -1) {
         // Note: we must not pop from queues before we decrement blocked_,
         // otherwise the following scenario is possible. Consider that instead
         // of checking for emptiness we popped the only element from queues.
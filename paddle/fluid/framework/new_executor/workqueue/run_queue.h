@@ -37,6 +37,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <cstdint>
@@ -266,5 +267,72 @@ class RunQueue {
   }
 };
 
+// PriorityRunQueue is a pool-wide queue of Work items ordered by priority,
+// higher priority first and FIFO among equal priorities. Unlike RunQueue
+// it is not owned by a thread: any thread may push and pop, serialized by a
+// SpinLock. Empty() is lock free so idle workers can poll it cheaply.
+template <typename Work>
+class PriorityRunQueue {
+ public:
+  PriorityRunQueue() : size_(0), seq_(0) {}
+
+  PriorityRunQueue(const PriorityRunQueue&) = delete;
+  void operator=(const PriorityRunQueue&) = delete;
+
+  void Push(Work w, int64_t priority) {
+    std::lock_guard<paddle::memory::SpinLock> guard(lock_);
+    heap_.push_back(Elem{priority, seq_++, std::move(w)});
+    std::push_heap(heap_.begin(), heap_.end(), Less);
+    size_.store(heap_.size(), std::memory_order_release);
+  }
+
+  // Pop removes and returns the item of the highest priority.
+  // If the queue was empty returns default-constructed Work.
+  Work Pop() {
+    if (Empty()) {
+      return Work();
+    }
+    std::lock_guard<paddle::memory::SpinLock> guard(lock_);
+    if (heap_.empty()) {
+      return Work();
+    }
+    std::pop_heap(heap_.begin(), heap_.end(), Less);
+    Work w = std::move(heap_.back().w);
+    heap_.pop_back();
+    size_.store(heap_.size(), std::memory_order_release);
+    return w;
+  }
+
+  // Flush removes all items from the queue.
+  void Flush() {
+    std::lock_guard<paddle::memory::SpinLock> guard(lock_);
+    heap_.clear();
+    size_.store(0, std::memory_order_release);
+  }
+
+  bool Empty() const { return size_.load(std::memory_order_acquire) == 0; }
+
+  size_t Size() const { return size_.load(std::memory_order_acquire); }
+
+ private:
+  struct Elem {
+    int64_t priority;
+    uint64_t seq;
+    Work w;
+  };
+
+  static bool Less(const Elem& lhs, const Elem& rhs) {
+    if (lhs.priority != rhs.priority) {
+      return lhs.priority < rhs.priority;
+    }
+    return lhs.seq > rhs.seq;
+  }
+
+  paddle::memory::SpinLock lock_;
+  std::vector<Elem> heap_;
+  std::atomic<size_t> size_;
+  uint64_t seq_;
+};
+
 }  // namespace framework
 }  // namespace paddle
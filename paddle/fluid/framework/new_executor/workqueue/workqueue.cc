@@ -24,6 +24,11 @@ void WorkQueueOptions::Validate() const {
       std::string::npos,
       platform::errors::InvalidArgument(
           "WorkQueueOptions.name shouldn't contain an underline"));
+  PADDLE_ENFORCE_GE(numa_node,
+                    kAllNumaNodes,
+                    platform::errors::InvalidArgument(
+                        "WorkQueueOptions.numa_node must be a node id, "
+                        "kNoNumaNode or kAllNumaNodes"));
   PADDLE_ENFORCE_EQ(
       allow_spinning == false && always_spinning == true,
       false,
@@ -50,7 +55,8 @@ class WorkQueueImpl : public WorkQueue {
     queue_ = new NonblockingThreadPool(options_.name,
                                        static_cast<int>(options_.num_threads),
                                        options_.allow_spinning,
-                                       options_.always_spinning);
+                                       options_.always_spinning,
+                                       options_.numa_node);
   }
 
   ~WorkQueueImpl() override {
@@ -64,7 +70,7 @@ class WorkQueueImpl : public WorkQueue {
     }
   }
 
-  void AddTask(std::function<void()> fn) override {
+  void AddTask(InlinedTask fn) override {
     platform::RecordEvent record("WorkQueue::AddTask",
                                  platform::TracerEventType::UserDefined,
                                  10 /*level*/);
@@ -75,6 +81,17 @@ class WorkQueueImpl : public WorkQueue {
     queue_->AddTask(std::move(fn));
   }
 
+  void AddTask(InlinedTask fn, int64_t priority) override {
+    platform::RecordEvent record("WorkQueue::AddTask",
+                                 platform::TracerEventType::UserDefined,
+                                 10 /*level*/);
+    if (tracker_ != nullptr) {
+      fn = [task = std::move(fn),
+            raii = CounterGuard<TaskTracker>(tracker_)]() mutable { task(); };
+    }
+    queue_->AddTaskWithPriority(std::move(fn), priority);
+  }
+
   void Cancel() override {
     queue_->Cancel();
     queue_->WaitThreadsExit();
@@ -96,7 +113,9 @@ class WorkQueueGroupImpl : public WorkQueueGroup {
 
   ~WorkQueueGroupImpl() override;
 
-  void AddTask(size_t queue_idx, std::function<void()> fn) override;
+  void AddTask(size_t queue_idx, InlinedTask fn) override;
+
+  void AddTask(size_t queue_idx, InlinedTask fn, int64_t priority) override;
 
   size_t QueueNumThreads(size_t queue_idx) const override;
 
@@ -143,7 +162,8 @@ WorkQueueGroupImpl::WorkQueueGroupImpl(
         NonblockingThreadPool(options.name,
                               static_cast<int>(options.num_threads),
                               options.allow_spinning,
-                              options.always_spinning);
+                              options.always_spinning,
+                              options.numa_node);
   }
 }
 
@@ -163,7 +183,7 @@ WorkQueueGroupImpl::~WorkQueueGroupImpl() {
   }
 }
 
-void WorkQueueGroupImpl::AddTask(size_t queue_idx, std::function<void()> fn) {
+void WorkQueueGroupImpl::AddTask(size_t queue_idx, InlinedTask fn) {
   platform::RecordEvent record("WorkQueue::AddTask",
                                platform::TracerEventType::UserDefined,
                                10 /*level*/);
@@ -179,6 +199,24 @@ void WorkQueueGroupImpl::AddTask(size_t queue_idx, std::function<void()> fn) {
   queues_[queue_idx]->AddTask(std::move(fn));
 }
 
+void WorkQueueGroupImpl::AddTask(size_t queue_idx,
+                                 InlinedTask fn,
+                                 int64_t priority) {
+  platform::RecordEvent record("WorkQueue::AddTask",
+                               platform::TracerEventType::UserDefined,
+                               10 /*level*/);
+  assert(queue_idx < queues_.size());
+  PADDLE_ENFORCE_NOT_NULL(
+      queues_.at(queue_idx),
+      platform::errors::NotFound("Workqueue of index %d is not initialized.",
+                                 queue_idx));
+  if (queues_options_.at(queue_idx).track_task) {
+    fn = [task = std::move(fn),
+          raii = CounterGuard<TaskTracker>(tracker_)]() mutable { task(); };
+  }
+  queues_[queue_idx]->AddTaskWithPriority(std::move(fn), priority);
+}
+
 size_t WorkQueueGroupImpl::QueueNumThreads(size_t queue_idx) const {
   assert(queue_idx < queues_.size());
   if (!queues_.at(queue_idx)) {
@@ -21,6 +21,7 @@
 #include <type_traits>
 #include <vector>
 
+#include "paddle/fluid/framework/new_executor/workqueue/inlined_task.h"
 #include "paddle/fluid/platform/enforce.h"
 
 namespace paddle {
@@ -29,6 +30,10 @@ namespace framework {
 constexpr const char* kQueueEmptyEvent = "QueueEmpty";
 constexpr const char* kQueueDestructEvent = "QueueDestruct";
 
+// Values of WorkQueueOptions.numa_node besides a node id
+constexpr int kNoNumaNode = -1;
+constexpr int kAllNumaNodes = -2;
+
 // For std::function
 // https://stackoverflow.com/questions/25421346/how-to-create-an-stdfunction-from-a-move-capturing-lambda-expression
 template <typename OnlyMovable>
@@ -102,6 +107,10 @@ struct WorkQueueOptions {
   // false and set events_waiter.
   bool detached{true};
   EventsWaiter* events_waiter{nullptr};  // not owned
+  // Pin the worker threads to a NUMA node, or with kAllNumaNodes spread them
+  // over all the nodes and let them steal tasks within their node first.
+  // Has no effect on single node machines.
+  int numa_node{kNoNumaNode};
 };
 
 class WorkQueue {
@@ -114,7 +123,12 @@ class WorkQueue {
 
   virtual ~WorkQueue() = default;
 
-  virtual void AddTask(std::function<void()> fn) = 0;
+  // Small closures are stored inline in the task, see InlinedTask
+  virtual void AddTask(InlinedTask fn) = 0;
+
+  // Tasks added with a priority run before the ones added by AddTask, higher
+  // priority first, e.g. the length of the remaining critical path of an op.
+  virtual void AddTask(InlinedTask fn, int64_t priority) = 0;
 
   // Higher cost than AddTask
   template <typename F, typename... Args>
@@ -153,7 +167,10 @@ class WorkQueueGroup {
 
   virtual ~WorkQueueGroup() = default;
 
-  virtual void AddTask(size_t queue_idx, std::function<void()> fn) = 0;
+  virtual void AddTask(size_t queue_idx, InlinedTask fn) = 0;
+
+  // See WorkQueue::AddTask(fn, priority) for details
+  virtual void AddTask(size_t queue_idx, InlinedTask fn, int64_t priority) = 0;
 
   // Higher cost than AddTask
   template <typename F, typename... Args>
@@ -0,0 +1,271 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>  // NOLINT
+#include <new>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+// An arena of the feasigns of the Records loaded into an in-memory dataset
+// for a pass. The threads which load the Records allocate from blocks of
+// their own by bumping a pointer, while a RecordArenaScope is alive, and all
+// the blocks are freed at once when the arena is destroyed, instead of one
+// free per vector. A thread keeps filling its block across the scopes of the
+// same arena, so that many short scopes, e.g. one per received shuffle
+// message, do not take a block each.
+//
+// The Records of the arena must be destroyed before it, but their vectors
+// do not free anything then.
+class RecordArena {
+ public:
+  static constexpr size_t kBlockSize = 4 << 20;
+
+  RecordArena() : id_(NextId()) {}
+  ~RecordArena() {
+    for (char* block : blocks_) {
+      free(block);
+    }
+  }
+
+  RecordArena(const RecordArena&) = delete;
+  RecordArena& operator=(const RecordArena&) = delete;
+
+  // unique in the process, unlike the address of the arena
+  uint64_t id() const { return id_; }
+
+  // the bytes of the blocks
+  size_t Bytes() const { return bytes_.load(); }
+
+  size_t NumBlocks() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return blocks_.size();
+  }
+
+  char* NewBlock(size_t bytes) {
+    char* block = static_cast<char*>(malloc(bytes));
+    if (block == nullptr) {
+      throw std::bad_alloc();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      blocks_.push_back(block);
+    }
+    bytes_.fetch_add(bytes);
+    return block;
+  }
+
+ private:
+  static uint64_t NextId() {
+    static std::atomic<uint64_t> next_id{1};
+    return next_id.fetch_add(1);
+  }
+
+  const uint64_t id_;
+  std::mutex mutex_;
+  std::vector<char*> blocks_;
+  std::atomic<size_t> bytes_{0};
+};
+
+namespace detail {
+
+struct RecordArenaThreadState {
+  RecordArena* arena = nullptr;
+  uint64_t arena_id = 0;
+  char* cursor = nullptr;
+  char* end = nullptr;
+};
+
+inline thread_local RecordArenaThreadState record_arena_state;
+
+// The free tails of the blocks of the arenas whose outermost scopes ended in
+// the thread, the most recent first, resumed by the next scopes of the
+// arenas. A tail is owned by one state only: the current, a saved or a
+// parked one.
+constexpr int kParkedRecordArenas = 4;
+inline thread_local RecordArenaThreadState
+    parked_record_arena_states[kParkedRecordArenas];
+
+inline void UnparkRecordArena(RecordArenaThreadState* state) {
+  for (auto& parked : parked_record_arena_states) {
+    if (parked.arena_id == state->arena_id) {
+      state->cursor = parked.cursor;
+      state->end = parked.end;
+      parked = RecordArenaThreadState();
+      return;
+    }
+  }
+}
+
+// The tail parked the longest ago is dropped if there is no room.
+inline void ParkRecordArena(const RecordArenaThreadState& state) {
+  RecordArenaThreadState* slots = parked_record_arena_states;
+  int i = 0;
+  while (i < kParkedRecordArenas - 1 && slots[i].arena_id != 0 &&
+         slots[i].arena_id != state.arena_id) {
+    ++i;
+  }
+  for (; i > 0; --i) {
+    slots[i] = slots[i - 1];
+  }
+  slots[0] = state;
+}
+
+// Each allocation is preceded by a tag telling whether it is from the heap
+// or from an arena, so that Records of both kinds can be mixed.
+constexpr size_t kRecordAllocHeader = 8;
+constexpr uint64_t kRecordHeapTag = 0;
+constexpr uint64_t kRecordArenaTag = 1;
+
+inline void* RecordAllocate(size_t bytes) {
+  RecordArenaThreadState& state = record_arena_state;
+  size_t total = (kRecordAllocHeader + bytes + 7) & ~static_cast<size_t>(7);
+  char* p = nullptr;
+  if (state.arena == nullptr) {
+    p = static_cast<char*>(malloc(total));
+    if (p == nullptr) {
+      throw std::bad_alloc();
+    }
+    *reinterpret_cast<uint64_t*>(p) = kRecordHeapTag;
+    return p + kRecordAllocHeader;
+  }
+  if (total > static_cast<size_t>(state.end - state.cursor)) {
+    if (total > RecordArena::kBlockSize / 4) {
+      // a large vector takes a block of its own
+      p = state.arena->NewBlock(total);
+    } else {
+      state.cursor = state.arena->NewBlock(RecordArena::kBlockSize);
+      state.end = state.cursor + RecordArena::kBlockSize;
+    }
+  }
+  if (p == nullptr) {
+    p = state.cursor;
+    state.cursor += total;
+  }
+  *reinterpret_cast<uint64_t*>(p) = kRecordArenaTag;
+  return p + kRecordAllocHeader;
+}
+
+inline void RecordDeallocate(void* p) {
+  char* header = static_cast<char*>(p) - kRecordAllocHeader;
+  if (*reinterpret_cast<uint64_t*>(header) == kRecordHeapTag) {
+    free(header);
+  }
+}
+
+}  // namespace detail
+
+// Makes the Records allocate their feasigns from arena in the current
+// thread while it is alive, or from the heap if arena is nullptr.
+class RecordArenaScope {
+ public:
+  explicit RecordArenaScope(RecordArena* arena)
+      : saved_(detail::record_arena_state), outer_(Innermost()) {
+    Innermost() = this;
+    detail::RecordArenaThreadState& state = detail::record_arena_state;
+    state = detail::RecordArenaThreadState();
+    state.arena = arena;
+    if (arena == nullptr) {
+      return;
+    }
+    state.arena_id = arena->id();
+    // borrow the tail of the innermost enclosing scope of the arena, which
+    // can not allocate before this one ends, or resume the last ended one
+    for (RecordArenaScope* scope = this; scope != nullptr;
+         scope = scope->outer_) {
+      if (scope->saved_.arena_id == state.arena_id) {
+        lender_ = &scope->saved_;
+        TakeTail(lender_, &state);
+        return;
+      }
+    }
+    detail::UnparkRecordArena(&state);
+  }
+  ~RecordArenaScope() {
+    detail::RecordArenaThreadState& state = detail::record_arena_state;
+    detail::RecordArenaThreadState current = state;
+    state = saved_;
+    Innermost() = outer_;
+    if (current.arena == nullptr) {
+      return;
+    }
+    if (lender_ == &saved_) {
+      TakeTail(&current, &state);
+    } else if (lender_ != nullptr) {
+      TakeTail(&current, lender_);
+    } else {
+      detail::ParkRecordArena(current);
+    }
+  }
+
+  RecordArenaScope(const RecordArenaScope&) = delete;
+  RecordArenaScope& operator=(const RecordArenaScope&) = delete;
+
+ private:
+  static RecordArenaScope*& Innermost() {
+    static thread_local RecordArenaScope* scope = nullptr;
+    return scope;
+  }
+
+  static void TakeTail(detail::RecordArenaThreadState* from,
+                       detail::RecordArenaThreadState* to) {
+    to->cursor = from->cursor;
+    to->end = from->end;
+    from->cursor = nullptr;
+    from->end = nullptr;
+  }
+
+  // the state of the thread out of the scope
+  detail::RecordArenaThreadState saved_;
+  RecordArenaScope* outer_;
+  detail::RecordArenaThreadState* lender_ = nullptr;
+};
+
+// The allocator of the vectors of Record. It has no state, the arena being
+// the one of the allocating thread.
+template <class T>
+struct RecordAllocator {
+  static_assert(alignof(T) <= 8, "RecordAllocator aligns to 8 bytes");
+
+  using value_type = T;
+
+  RecordAllocator() = default;
+  template <class U>
+  RecordAllocator(const RecordAllocator<U>&) {}  // NOLINT
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(detail::RecordAllocate(n * sizeof(T)));
+  }
+  void deallocate(T* p, size_t) { detail::RecordDeallocate(p); }
+
+  template <class U>
+  bool operator==(const RecordAllocator<U>&) const {
+    return true;
+  }
+  template <class U>
+  bool operator!=(const RecordAllocator<U>&) const {
+    return false;
+  }
+};
+
+}  // namespace framework
+}  // namespace paddle
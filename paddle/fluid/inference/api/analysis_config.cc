@@ -545,6 +545,7 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(use_optimized_model_);
 
   CP_MEMBER(cpu_math_library_num_threads_);
+  CP_MEMBER(cpu_numa_node_);
 
   CP_MEMBER(serialized_info_cache_);
 
@@ -1188,6 +1189,7 @@ std::string AnalysisConfig::SerializeInfoCache() {
 
   ss << specify_input_name_;
   ss << cpu_math_library_num_threads_;
+  ss << cpu_numa_node_;
 
   ss << use_xpu_;
   ss << xpu_config_.device_id;
@@ -1241,6 +1243,18 @@ void AnalysisConfig::SetCpuMathLibraryNumThreads(
   Update();
 }
 
+void AnalysisConfig::SetCpuNumaNode(int numa_node) {
+  PADDLE_ENFORCE_GE(numa_node,
+                    -2,
+                    platform::errors::InvalidArgument(
+                        "The NUMA node should be a node id, -1 or -2, "
+                        "but received %d.",
+                        numa_node));
+  cpu_numa_node_ = numa_node;
+
+  Update();
+}
+
 float AnalysisConfig::fraction_of_gpu_memory_for_pool() const {
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   // Get the GPU memory details and calculate the fraction of memory for the
@@ -1343,6 +1357,9 @@ std::string AnalysisConfig::Summary() {
   // cpu info
   os.InsertRow(
       {"cpu_math_thread", std::to_string(cpu_math_library_num_threads_)});
+  if (cpu_numa_node_ != -1) {
+    os.InsertRow({"cpu_numa_node", std::to_string(cpu_numa_node_)});
+  }
   os.InsertRow({"enable_mkldnn", use_mkldnn_ ? "true" : "false"});
   os.InsertRow(
       {"mkldnn_cache_capacity", std::to_string(mkldnn_cache_capacity_)});
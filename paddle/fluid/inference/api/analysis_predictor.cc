@@ -64,6 +64,7 @@
 #include "paddle/phi/api/include/context_pool.h"
 #include "paddle/phi/api/include/tensor.h"
 #include "paddle/phi/backends/context_pool.h"
+#include "paddle/phi/backends/cpu/numa.h"
 #include "paddle/phi/common/backend.h"
 #include "paddle/phi/common/data_type.h"
 #include "paddle/phi/common/place.h"
@@ -370,6 +371,15 @@ bool PaddleTensorToDenseTensor(const PaddleTensor &pt,
   t->set_lod(lod);
   return true;
 }
+
+// Sets the threads of the CPU math library for the calling thread, which
+// runs on the NUMA node of the predictor only while the returned binding
+// lives, i.e. for the duration of the call.
+phi::backends::cpu::ScopedNumaNodeBinding SetCallerThreadCpuConfig(
+    const AnalysisConfig &config) {
+  paddle::platform::SetNumThreads(config.cpu_math_library_num_threads());
+  return phi::backends::cpu::ScopedNumaNodeBinding(config.cpu_numa_node());
+}
 }  // namespace
 
 AnalysisPredictor::AnalysisPredictor(const AnalysisConfig &config)
@@ -436,7 +446,7 @@ bool AnalysisPredictor::Init(
   }
 
   // no matter with or without OneDNN
-  paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
+  auto numa_binding = SetCallerThreadCpuConfig(config_);
 
   // Use Optimized model to inference
   if (config_.use_optimized_model_) {
@@ -1177,6 +1187,7 @@ bool AnalysisPredictor::PrepareExecutor() {
     framework::interpreter::ExecutionConfig execution_config;
     execution_config.create_local_scope = false;
     execution_config.used_for_inference = true;
+    execution_config.numa_node = config_.cpu_numa_node();
 
     auto input_names = GetInputNames();
 
@@ -1566,7 +1577,7 @@ void AnalysisPredictor::MkldnnPostReset() {
 bool AnalysisPredictor::Run(const std::vector<PaddleTensor> &inputs,
                             std::vector<PaddleTensor> *output_data,
                             int batch_size) {
-  paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
+  auto numa_binding = SetCallerThreadCpuConfig(config_);
 #ifdef PADDLE_WITH_DNNL
   if (config_.use_mkldnn_) MkldnnPreSet(inputs);
 #endif
@@ -1643,7 +1654,7 @@ bool AnalysisPredictor::Run(const std::vector<paddle::Tensor> &inputs,
     auto &pool = paddle::experimental::DeviceContextPool::Instance();
     pool.SyncDeviceContext(place_);
   }
-  paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
+  auto numa_binding = SetCallerThreadCpuConfig(config_);
 #ifdef PADDLE_WITH_DNNL
   if (config_.use_mkldnn_) MkldnnPreSet(inputs);
 #endif
@@ -2623,7 +2634,7 @@ bool AnalysisPredictor::ZeroCopyRun(bool switch_stream) {
     auto &pool = paddle::experimental::DeviceContextPool::Instance();
     pool.SyncDeviceContext(place_);
   }
-  paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
+  auto numa_binding = SetCallerThreadCpuConfig(config_);
 #ifdef PADDLE_WITH_DNNL
   if (config_.use_mkldnn_) {
     std::vector<std::vector<int>> shape_vector;
@@ -3656,6 +3667,15 @@ int GetNumBytesOfDataType(DataType dtype) {
       return sizeof(int32_t);
     case DataType::UINT8:
       return sizeof(uint8_t);
+    case DataType::INT8:
+      return sizeof(int8_t);
+    case DataType::FLOAT16:
+    case DataType::BFLOAT16:
+      return sizeof(int16_t);
+    case DataType::BOOL:
+      return sizeof(bool);
+    case DataType::FLOAT64:
+      return sizeof(double);
     default:
       assert(false);
       return -1;
@@ -0,0 +1,514 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstring>
+#include <deque>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <unordered_set>
+
+#include "paddle/fluid/inference/api/paddle_inference_api.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/float16.h"
+#include "paddle/phi/common/bfloat16.h"
+
+namespace paddle_infer {
+namespace services {
+
+namespace {
+
+using float16 = paddle::platform::float16;
+using bfloat16 = phi::dtype::bfloat16;
+using Clock = std::chrono::steady_clock;
+
+void CopyFromHost(Tensor* tensor, DataType dtype, const char* data) {
+  switch (dtype) {
+    case DataType::FLOAT32:
+      tensor->CopyFromCpu(reinterpret_cast<const float*>(data));
+      break;
+    case DataType::INT64:
+      tensor->CopyFromCpu(reinterpret_cast<const int64_t*>(data));
+      break;
+    case DataType::INT32:
+      tensor->CopyFromCpu(reinterpret_cast<const int32_t*>(data));
+      break;
+    case DataType::UINT8:
+      tensor->CopyFromCpu(reinterpret_cast<const uint8_t*>(data));
+      break;
+    case DataType::INT8:
+      tensor->CopyFromCpu(reinterpret_cast<const int8_t*>(data));
+      break;
+    case DataType::FLOAT16:
+      tensor->CopyFromCpu(reinterpret_cast<const float16*>(data));
+      break;
+    case DataType::BOOL:
+      tensor->CopyFromCpu(reinterpret_cast<const bool*>(data));
+      break;
+    case DataType::FLOAT64:
+      tensor->CopyFromCpu(reinterpret_cast<const double*>(data));
+      break;
+    case DataType::BFLOAT16:
+      tensor->CopyFromCpu(reinterpret_cast<const bfloat16*>(data));
+      break;
+  }
+}
+
+void CopyToHost(const Tensor& tensor, DataType dtype, char* data) {
+  switch (dtype) {
+    case DataType::FLOAT32:
+      tensor.CopyToCpu(reinterpret_cast<float*>(data));
+      break;
+    case DataType::INT64:
+      tensor.CopyToCpu(reinterpret_cast<int64_t*>(data));
+      break;
+    case DataType::INT32:
+      tensor.CopyToCpu(reinterpret_cast<int32_t*>(data));
+      break;
+    case DataType::UINT8:
+      tensor.CopyToCpu(reinterpret_cast<uint8_t*>(data));
+      break;
+    case DataType::INT8:
+      tensor.CopyToCpu(reinterpret_cast<int8_t*>(data));
+      break;
+    case DataType::FLOAT16:
+      tensor.CopyToCpu(reinterpret_cast<float16*>(data));
+      break;
+    case DataType::BOOL:
+      tensor.CopyToCpu(reinterpret_cast<bool*>(data));
+      break;
+    case DataType::FLOAT64:
+      tensor.CopyToCpu(reinterpret_cast<double*>(data));
+      break;
+    case DataType::BFLOAT16:
+      tensor.CopyToCpu(reinterpret_cast<bfloat16*>(data));
+      break;
+  }
+}
+
+int64_t Numel(const std::vector<int>& shape, size_t begin = 0) {
+  int64_t numel = 1;
+  for (size_t i = begin; i < shape.size(); ++i) {
+    numel *= shape[i];
+  }
+  return numel;
+}
+
+void Record(BatchingPredictor::Histogram* histogram, int64_t latency_us) {
+  size_t i = std::lower_bound(histogram->bounds_us.begin(),
+                              histogram->bounds_us.end(),
+                              latency_us) -
+             histogram->bounds_us.begin();
+  ++histogram->counts[i];
+  ++histogram->count;
+  histogram->sum_us += static_cast<double>(latency_us);
+}
+
+}  // namespace
+
+struct BatchingPredictor::Impl {
+  struct Request {
+    std::vector<HostTensor> inputs;  // in the order of the input names
+    int rows{0};
+    int length{0};  // of the padded inputs, before padding
+    int padded_length{0};
+    // the requests of the same signature can be batched together
+    std::vector<int64_t> signature;
+    Clock::time_point submit_time;
+    std::promise<std::vector<HostTensor>> promise;
+  };
+
+  Impl(PredictorPool* pool, const Options& options);
+  ~Impl();
+
+  std::unique_ptr<Request> NewRequest(std::vector<HostTensor> inputs) const;
+  int PaddedLength(int length) const;
+  // Returns an empty batch when stopped and there is no request left.
+  std::vector<std::unique_ptr<Request>> NextBatch();
+  void RunBatch(Predictor* predictor,
+                std::vector<std::unique_ptr<Request>>* batch);
+  void Work(size_t idx);
+
+  PredictorPool* pool_;
+  Options options_;
+  std::vector<std::string> input_names_;
+  std::vector<std::string> output_names_;
+  std::unordered_set<std::string> padded_inputs_;
+  std::unordered_set<std::string> padded_outputs_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::unique_ptr<Request>> queue_;
+  bool stop_{false};
+  std::vector<std::thread> threads_;
+
+  mutable std::mutex stats_mutex_;
+  Stats stats_;
+};
+
+BatchingPredictor::Impl::Impl(PredictorPool* pool, const Options& options)
+    : pool_(pool),
+      options_(options),
+      padded_inputs_(options.padded_inputs.begin(),
+                     options.padded_inputs.end()),
+      padded_outputs_(options.padded_outputs.begin(),
+                      options.padded_outputs.end()) {
+  PADDLE_ENFORCE_NOT_NULL(
+      pool,
+      paddle::platform::errors::InvalidArgument(
+          "The predictor pool of the BatchingPredictor should not be null."));
+  PADDLE_ENFORCE_GE(options.max_batch_size,
+                    1UL,
+                    paddle::platform::errors::InvalidArgument(
+                        "The max_batch_size should be at least 1, but it's "
+                        "(%d).",
+                        options.max_batch_size));
+  PADDLE_ENFORCE_EQ(
+      std::is_sorted(options.padding_buckets.begin(),
+                     options.padding_buckets.end()),
+      true,
+      paddle::platform::errors::InvalidArgument(
+          "The padding_buckets should be in ascending order."));
+  PADDLE_ENFORCE_EQ(
+      std::is_sorted(options.histogram_bounds_us.begin(),
+                     options.histogram_bounds_us.end()),
+      true,
+      paddle::platform::errors::InvalidArgument(
+          "The histogram_bounds_us should be in ascending order."));
+
+  Predictor* predictor = pool->Retrieve(0);
+  input_names_ = predictor->GetInputNames();
+  output_names_ = predictor->GetOutputNames();
+  for (Histogram* histogram : {&stats_.queue_latency, &stats_.batch_latency}) {
+    histogram->bounds_us = options.histogram_bounds_us;
+    histogram->counts.assign(options.histogram_bounds_us.size() + 1, 0);
+  }
+
+  for (size_t i = 0; i < pool->size(); ++i) {
+    threads_.emplace_back([this, i] { Work(i); });
+  }
+}
+
+BatchingPredictor::Impl::~Impl() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+int BatchingPredictor::Impl::PaddedLength(int length) const {
+  auto it = std::lower_bound(options_.padding_buckets.begin(),
+                             options_.padding_buckets.end(),
+                             length);
+  return it == options_.padding_buckets.end() ? length : *it;
+}
+
+std::unique_ptr<BatchingPredictor::Impl::Request>
+BatchingPredictor::Impl::NewRequest(std::vector<HostTensor> inputs) const {
+  PADDLE_ENFORCE_EQ(inputs.size(),
+                    input_names_.size(),
+                    paddle::platform::errors::InvalidArgument(
+                        "The model has (%d) inputs, but the request has (%d).",
+                        input_names_.size(),
+                        inputs.size()));
+  std::unordered_map<std::string, size_t> input_idx;
+  for (size_t i = 0; i < input_names_.size(); ++i) {
+    input_idx[input_names_[i]] = i;
+  }
+
+  auto request = std::make_unique<Request>();
+  request->inputs.resize(inputs.size());
+  std::unordered_set<std::string> given;
+  for (auto& input : inputs) {
+    auto it = input_idx.find(input.name);
+    PADDLE_ENFORCE_EQ(
+        it != input_idx.end(),
+        true,
+        paddle::platform::errors::NotFound(
+            "The model has no input called (%s).", input.name));
+    PADDLE_ENFORCE_EQ(given.insert(input.name).second,
+                      true,
+                      paddle::platform::errors::AlreadyExists(
+                          "The input (%s) is given twice in a request.",
+                          input.name));
+    bool padded = padded_inputs_.count(input.name) > 0;
+    PADDLE_ENFORCE_GE(
+        input.shape.size(),
+        padded ? 2UL : 1UL,
+        paddle::platform::errors::InvalidArgument(
+            "The input (%s) should have a batch dimension, and a length "
+            "dimension if padded.",
+            input.name));
+    PADDLE_ENFORCE_EQ(
+        input.shape[0] >= 1 &&
+            static_cast<size_t>(input.shape[0]) <= options_.max_batch_size,
+        true,
+        paddle::platform::errors::InvalidArgument(
+            "The batch size of the input (%s) should be in [1, %d], but it's "
+            "(%d).",
+            input.name,
+            options_.max_batch_size,
+            input.shape[0]));
+    PADDLE_ENFORCE_EQ(
+        static_cast<int64_t>(input.data.size()),
+        Numel(input.shape) * GetNumBytesOfDataType(input.dtype),
+        paddle::platform::errors::InvalidArgument(
+            "The input (%s) should have (%d) bytes of data, but it has (%d).",
+            input.name,
+            Numel(input.shape) * GetNumBytesOfDataType(input.dtype),
+            input.data.size()));
+    if (request->rows == 0) {
+      request->rows = input.shape[0];
+    }
+    PADDLE_ENFORCE_EQ(input.shape[0],
+                      request->rows,
+                      paddle::platform::errors::InvalidArgument(
+                          "The inputs of a request should have the same "
+                          "batch size, but the input (%s) has (%d) rather "
+                          "than (%d).",
+                          input.name,
+                          input.shape[0],
+                          request->rows));
+    if (padded) {
+      request->length = std::max(request->length, input.shape[1]);
+    }
+    request->inputs[it->second] = std::move(input);
+  }
+  request->padded_length = PaddedLength(request->length);
+
+  // the inputs of a batch must match but for the batch size, and the length
+  // of the padded ones but for the bucket
+  auto& signature = request->signature;
+  for (auto& input : request->inputs) {
+    bool padded = padded_inputs_.count(input.name) > 0;
+    signature.push_back(static_cast<int64_t>(input.dtype));
+    signature.push_back(static_cast<int64_t>(input.shape.size()));
+    for (size_t i = 1; i < input.shape.size(); ++i) {
+      signature.push_back(i == 1 && padded ? request->padded_length
+                                           : input.shape[i]);
+    }
+  }
+  return request;
+}
+
+std::vector<std::unique_ptr<BatchingPredictor::Impl::Request>>
+BatchingPredictor::Impl::NextBatch() {
+  std::vector<std::unique_ptr<Request>> batch;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    if (queue_.empty()) {
+      if (stop_) {
+        return batch;
+      }
+      cv_.wait(lock);
+      continue;
+    }
+    const Request& head = *queue_.front();
+    size_t rows = 0;
+    for (auto& request : queue_) {
+      if (request->signature == head.signature) {
+        rows += request->rows;
+      }
+    }
+    auto deadline = head.submit_time +
+                    std::chrono::microseconds(options_.batch_timeout_us);
+    if (rows >= options_.max_batch_size || stop_ || Clock::now() >= deadline) {
+      break;
+    }
+    // another thread may take the batch meanwhile
+    cv_.wait_until(lock, deadline);
+  }
+
+  // the first request always fits, the later ones while there is room
+  size_t rows = 0;
+  std::vector<int64_t> signature = queue_.front()->signature;
+  for (auto it = queue_.begin(); it != queue_.end();) {
+    if ((*it)->signature == signature &&
+        rows + (*it)->rows <= options_.max_batch_size) {
+      rows += (*it)->rows;
+      batch.emplace_back(std::move(*it));
+      it = queue_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  lock.unlock();
+  // the requests left may make a batch for the other threads
+  cv_.notify_all();
+  return batch;
+}
+
+void BatchingPredictor::Impl::RunBatch(
+    Predictor* predictor, std::vector<std::unique_ptr<Request>>* batch) {
+  const Request& head = *batch->front();
+  int rows = 0;
+  for (auto& request : *batch) {
+    rows += request->rows;
+  }
+
+  std::vector<char> buffer;
+  for (size_t i = 0; i < input_names_.size(); ++i) {
+    const HostTensor& head_input = head.inputs[i];
+    bool padded = padded_inputs_.count(head_input.name) > 0;
+    std::vector<int> shape = head_input.shape;
+    shape[0] = rows;
+    if (padded) {
+      shape[1] = head.padded_length;
+    }
+    const size_t bytes = GetNumBytesOfDataType(head_input.dtype);
+    const size_t row_bytes = Numel(shape, 1) * bytes;
+    buffer.assign(rows * row_bytes, 0);
+    char* dst = buffer.data();
+    for (auto& request : *batch) {
+      const HostTensor& input = request->inputs[i];
+      if (padded && input.shape[1] != shape[1]) {
+        const size_t src_row_bytes = Numel(input.shape, 1) * bytes;
+        for (int r = 0; r < request->rows; ++r) {
+          std::memcpy(dst + r * row_bytes,
+                      input.data.data() + r * src_row_bytes,
+                      src_row_bytes);
+        }
+      } else {
+        std::memcpy(dst, input.data.data(), input.data.size());
+      }
+      dst += request->rows * row_bytes;
+    }
+    auto tensor = predictor->GetInputHandle(head_input.name);
+    tensor->Reshape(shape);
+    CopyFromHost(tensor.get(), head_input.dtype, buffer.data());
+  }
+
+  PADDLE_ENFORCE_EQ(predictor->Run(),
+                    true,
+                    paddle::platform::errors::Fatal(
+                        "The predictor failed to run a batch of (%d) rows.",
+                        rows));
+
+  std::vector<std::vector<HostTensor>> outputs(batch->size());
+  for (auto& name : output_names_) {
+    auto tensor = predictor->GetOutputHandle(name);
+    std::vector<int> shape = tensor->shape();
+    DataType dtype = tensor->type();
+    PADDLE_ENFORCE_EQ(
+        !shape.empty() && shape[0] == rows,
+        true,
+        paddle::platform::errors::PreconditionNotMet(
+            "The output (%s) should have the (%d) rows of its batch.",
+            name,
+            rows));
+    const size_t bytes = GetNumBytesOfDataType(dtype);
+    const size_t row_bytes = Numel(shape, 1) * bytes;
+    buffer.resize(rows * row_bytes);
+    CopyToHost(*tensor, dtype, buffer.data());
+
+    // a padded output is cut back to the length of each request
+    bool padded = padded_outputs_.count(name) > 0 && shape.size() >= 2 &&
+                  shape[1] == head.padded_length;
+    const char* src = buffer.data();
+    for (size_t j = 0; j < batch->size(); ++j) {
+      const Request& request = *(*batch)[j];
+      HostTensor output;
+      output.name = name;
+      output.dtype = dtype;
+      output.shape = shape;
+      output.shape[0] = request.rows;
+      if (padded) {
+        output.shape[1] = request.length;
+      }
+      const size_t dst_row_bytes = Numel(output.shape, 1) * bytes;
+      output.data.resize(request.rows * dst_row_bytes);
+      for (int r = 0; r < request.rows; ++r) {
+        std::memcpy(output.data.data() + r * dst_row_bytes,
+                    src + r * row_bytes,
+                    dst_row_bytes);
+      }
+      src += request.rows * row_bytes;
+      outputs[j].emplace_back(std::move(output));
+    }
+  }
+  for (size_t j = 0; j < batch->size(); ++j) {
+    (*batch)[j]->promise.set_value(std::move(outputs[j]));
+  }
+}
+
+void BatchingPredictor::Impl::Work(size_t idx) {
+  Predictor* predictor = pool_->Retrieve(idx);
+  while (true) {
+    auto batch = NextBatch();
+    if (batch.empty()) {
+      return;
+    }
+    auto start = Clock::now();
+    try {
+      RunBatch(predictor, &batch);
+    } catch (...) {
+      LOG(WARNING) << "Failed to run a batch of " << batch.size()
+                   << " requests.";
+      for (auto& request : batch) {
+        request->promise.set_exception(std::current_exception());
+      }
+    }
+    auto end = Clock::now();
+
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    ++stats_.batches;
+    Record(&stats_.batch_latency,
+           std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+               .count());
+    for (auto& request : batch) {
+      ++stats_.requests;
+      stats_.rows += request->rows;
+      Record(&stats_.queue_latency,
+             std::chrono::duration_cast<std::chrono::microseconds>(
+                 start - request->submit_time)
+                 .count());
+    }
+  }
+}
+
+BatchingPredictor::BatchingPredictor(PredictorPool* pool,
+                                     const Options& options)
+    : impl_(new Impl(pool, options)) {}
+
+BatchingPredictor::~BatchingPredictor() = default;
+
+std::future<std::vector<BatchingPredictor::HostTensor>>
+BatchingPredictor::Submit(std::vector<HostTensor> inputs) {
+  auto request = impl_->NewRequest(std::move(inputs));
+  auto future = request->promise.get_future();
+  request->submit_time = Clock::now();
+  {
+    std::lock_guard<std::mutex> lock(impl_->mutex_);
+    impl_->queue_.emplace_back(std::move(request));
+  }
+  impl_->cv_.notify_all();
+  return future;
+}
+
+BatchingPredictor::Stats BatchingPredictor::GetStats() const {
+  std::lock_guard<std::mutex> lock(impl_->stats_mutex_);
+  return impl_->stats_;
+}
+
+}  // namespace services
+}  // namespace paddle_infer
@@ -955,6 +955,24 @@ struct PD_INFER_DECL AnalysisConfig {
     return cpu_math_library_num_threads_;
   }
 
+  ///
+  /// \brief Assign the predictor to a NUMA node. The threads that run the
+  /// predictor are pinned to the cpus of the node, and memory they grow is
+  /// allocated on it. The thread calling Run is pinned only while the call
+  /// lasts and gets its own affinity back afterwards. -2 spreads the worker
+  /// threads over all the nodes and -1, the default, leaves the placement to
+  /// the OS. Has no effect on single node machines.
+  ///
+  /// \param numa_node The NUMA node id, -1 or -2.
+  ///
+  void SetCpuNumaNode(int numa_node);
+  ///
+  /// \brief The NUMA node the predictor is assigned to.
+  ///
+  /// \return int The NUMA node id, -1 if not assigned, -2 if spread.
+  ///
+  int cpu_numa_node() const { return cpu_numa_node_; }
+
   ///
   /// \brief Transform the AnalysisConfig to NativeConfig.
   ///
@@ -1336,6 +1354,8 @@ struct PD_INFER_DECL AnalysisConfig {
 
   int cpu_math_library_num_threads_{1};
 
+  int cpu_numa_node_{-1};
+
   bool with_profile_{false};
 
   bool with_glog_info_{true};
@@ -22,6 +22,8 @@ limitations under the License. */
 #pragma once
 
 #include <cassert>
+#include <cstdint>
+#include <future>
 #include <map>
 #include <memory>
 #include <string>
@@ -269,10 +271,96 @@ class PD_INFER_DECL PredictorPool {
   /// \brief Get \param id-th predictor.
   Predictor* Retrieve(size_t idx);
 
+  /// \brief The number of predictors in the pool.
+  size_t size() const { return preds_.size() + 1; }
+
  private:
   std::shared_ptr<Predictor> main_pred_;
   std::vector<std::unique_ptr<Predictor>> preds_;
 };
+
+///
+/// \class BatchingPredictor
+///
+/// \brief BatchingPredictor gathers the requests submitted by many threads
+/// into batches, which are run by the predictors of a PredictorPool, one
+/// thread per predictor. The inputs of the requests of a batch are
+/// concatenated along their dimension 0, and the outputs are split back
+/// along it. A batch is run when it has max_batch_size rows, or when its
+/// first request has waited for batch_timeout_us.
+///
+/// The inputs in padded_inputs have a variable length in their dimension 1,
+/// and are padded with zeros to the smallest of padding_buckets which is not
+/// shorter, so that only the requests of the same bucket are batched
+/// together. The outputs in padded_outputs are cut back to the length of
+/// each request. The requests of a batch which fails get its error.
+///
+class PD_INFER_DECL BatchingPredictor {
+ public:
+  struct Options {
+    /// The most rows of a batch.
+    size_t max_batch_size{8};
+    /// The longest time a request waits for its batch to fill.
+    int64_t batch_timeout_us{1000};
+    /// The lengths a padded input is padded to, ascending. A request longer
+    /// than the last one is batched with the requests of its own length.
+    std::vector<int> padding_buckets;
+    std::vector<std::string> padded_inputs;
+    std::vector<std::string> padded_outputs;
+    /// The upper bounds of the buckets of the latency histograms.
+    std::vector<int64_t> histogram_bounds_us{
+        100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000};
+  };
+
+  /// \brief An input or an output of a request, on CPU.
+  struct HostTensor {
+    std::string name;
+    DataType dtype{DataType::FLOAT32};
+    std::vector<int> shape;
+    std::vector<char> data;
+  };
+
+  struct Histogram {
+    std::vector<int64_t> bounds_us;
+    /// counts[i] is the number of latencies in (bounds_us[i - 1],
+    /// bounds_us[i]], the last one counting the ones above all the bounds.
+    std::vector<uint64_t> counts;
+    uint64_t count{0};
+    double sum_us{0};
+  };
+
+  struct Stats {
+    uint64_t requests{0};
+    uint64_t batches{0};
+    uint64_t rows{0};
+    /// From the submission of a request to the start of its batch.
+    Histogram queue_latency;
+    /// From the start of a batch to its outputs being split.
+    Histogram batch_latency;
+  };
+
+  BatchingPredictor() = delete;
+  BatchingPredictor(const BatchingPredictor&) = delete;
+  BatchingPredictor& operator=(const BatchingPredictor&) = delete;
+
+  /// \brief Run the batches with the predictors of \param pool, which must
+  /// outlive the BatchingPredictor and not be used by others meanwhile.
+  BatchingPredictor(PredictorPool* pool, const Options& options);
+
+  /// \brief Run the requests still queued and stop the threads.
+  ~BatchingPredictor();
+
+  /// \brief Queue a request, whose inputs are all the inputs of the model.
+  /// \return The future of the outputs of the request, in the order of the
+  /// output names of the model.
+  std::future<std::vector<HostTensor>> Submit(std::vector<HostTensor> inputs);
+
+  Stats GetStats() const;
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
 }  // namespace services
 
 }  // namespace paddle_infer
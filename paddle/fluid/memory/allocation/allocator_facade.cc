@@ -25,6 +25,7 @@
 #include "paddle/fluid/memory/allocation/naive_best_fit_allocator.h"
 #include "paddle/fluid/memory/allocation/retry_allocator.h"
 #include "paddle/fluid/memory/allocation/stat_allocator.h"
+#include "paddle/fluid/memory/allocation/thread_local_caching_allocator.h"
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/place.h"
@@ -111,6 +112,19 @@ PADDLE_DEFINE_EXPORTED_bool(
     "Whether to use AutoGrowthBestFitAllocatorV2 for auto_growth "
     "strategy");
 
+PADDLE_DEFINE_EXPORTED_bool(
+    use_cpu_thread_local_cache,
+    false,
+    "Whether to allocate CPU memory from an AutoGrowthBestFitAllocator with "
+    "a per-thread cache of small blocks in front of it, only available for "
+    "auto_growth strategy");
+
+PADDLE_DEFINE_EXPORTED_uint64(
+    cpu_thread_local_cache_size_in_mb,
+    16,
+    "The maximum size of CPU memory cached by each thread when "
+    "FLAGS_use_cpu_thread_local_cache is true");
+
 COMMON_DECLARE_string(allocator_strategy);
 COMMON_DECLARE_uint64(auto_growth_chunk_size_in_mb);
 COMMON_DECLARE_bool(use_auto_growth_pinned_allocator);
@@ -242,7 +256,11 @@ class AllocatorFacadePrivate {
       }
 
       case AllocatorStrategy::kAutoGrowth: {
-        InitNaiveBestFitCPUAllocator();
+        if (FLAGS_use_cpu_thread_local_cache) {
+          InitAutoGrowthCPUAllocator(allow_free_idle_chunk);
+        } else {
+          InitNaiveBestFitCPUAllocator();
+        }
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
         allow_free_idle_chunk_ = allow_free_idle_chunk;
         for (int dev_id = 0; dev_id < platform::GetGPUDeviceCount(); ++dev_id) {
@@ -810,6 +828,24 @@ class AllocatorFacadePrivate {
 #endif
   }
 
+  void InitAutoGrowthCPUAllocator(bool allow_free_idle_chunk) {
+    // Small tensors are served by the thread caches, the chunks only need to
+    // be large enough to hold many of the largest cached blocks.
+    constexpr size_t kAlignment = 64;
+    constexpr size_t kChunkSize = 64UL << 20;
+    auto auto_growth_allocator = std::make_shared<AutoGrowthBestFitAllocator>(
+        std::make_shared<CPUAllocator>(),
+        kAlignment,
+        kChunkSize,
+        allow_free_idle_chunk);
+    VLOG(4) << "FLAGS_cpu_thread_local_cache_size_in_mb is "
+            << FLAGS_cpu_thread_local_cache_size_in_mb;
+    allocators_[platform::CPUPlace()] =
+        std::make_shared<ThreadLocalCachingAllocator>(
+            auto_growth_allocator,
+            FLAGS_cpu_thread_local_cache_size_in_mb << 20);
+  }
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   void InitNaiveBestFitCUDAPinnedAllocator() {
     if (FLAGS_use_auto_growth_pinned_allocator) {
@@ -18,6 +18,7 @@
 
 #include "paddle/fluid/memory/stats.h"
 #include "paddle/fluid/platform/enforce.h"
+#include "paddle/phi/backends/cpu/numa.h"
 
 namespace paddle::memory::allocation {
 
@@ -46,6 +47,13 @@ phi::Allocation *CPUAllocator::AllocateImpl(size_t size) {
       0,
       platform::errors::ResourceExhausted(
           "Fail to alloc memory of %ld size, error code is %d.", size, error));
+  // Chunks grown by a thread pinned to a NUMA node, e.g. the chunks of
+  // AutoGrowthBestFitAllocator, are placed on that node. Small blocks are
+  // left alone, they share pages with other allocations.
+  int numa_node = phi::backends::cpu::CurrentThreadNumaNode();
+  if (numa_node >= 0 && size >= kNumaBindMinSize) {
+    phi::backends::cpu::BindMemoryToNumaNode(p, size, numa_node);
+  }
 #endif
   HOST_MEMORY_STAT_UPDATE(Reserved, 0, size);
   return new Allocation(p, size, platform::CPUPlace());
@@ -34,6 +34,9 @@ namespace allocation {
 class CPUAllocator : public Allocator {
  public:
   constexpr static size_t kAlignment = 4096UL;
+  // allocations from this size on are bound to the NUMA node of the
+  // allocating thread, if it was pinned to one
+  constexpr static size_t kNumaBindMinSize = 1UL << 20;
   bool IsAllocThreadSafe() const override;
 
  protected:
@@ -0,0 +1,313 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/thread_local_caching_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <utility>
+
+#include "paddle/fluid/memory/allocation/spin_lock.h"
+#include "paddle/fluid/memory/stats.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle::memory::allocation {
+
+// The blocks cached by one thread for one allocator. The lock is only
+// contended when Release() or the destructor of the allocator runs on
+// another thread.
+struct ThreadBlockCache {
+  explicit ThreadBlockCache(Allocator* underlying_allocator)
+      : underlying_allocator(underlying_allocator) {}
+
+  SpinLock lock;
+  Allocator* underlying_allocator;
+  // set when the thread exits or the allocator is destroyed, the cache is
+  // empty and never used again afterwards
+  bool detached{false};
+  std::vector<phi::Allocation*>
+      blocks[ThreadLocalCachingAllocator::kSizeClassNum];
+  // the least number of cached blocks of each class since the last release
+  size_t low_watermarks[ThreadLocalCachingAllocator::kSizeClassNum]{};
+  size_t cached_size{0};
+  size_t free_times{0};
+};
+
+namespace {
+
+constexpr size_t kMinCachedSizeBits = 8;
+static_assert(ThreadLocalCachingAllocator::kMinCachedSize ==
+                  (1UL << kMinCachedSizeBits),
+              "kMinCachedSizeBits does not match kMinCachedSize");
+
+std::atomic<uint64_t> next_allocator_id{1};
+
+size_t FloorLog2(size_t n) {
+#ifdef __GNUC__
+  return sizeof(unsigned long long) * 8 - 1 -  // NOLINT
+         __builtin_clzll(n);
+#else
+  size_t bits = 0;
+  while (n >>= 1) {
+    ++bits;
+  }
+  return bits;
+#endif
+}
+
+void UpdateCachedStat(const phi::Allocation* allocation, int64_t size) {
+  if (platform::is_cpu_place(allocation->place())) {
+    HOST_MEMORY_STAT_UPDATE(ThreadLocalCached, 0, size);
+  }
+}
+
+// Gives back the first num blocks of a class, which are the ones that were
+// freed the longest time ago. The lock of the cache must be held.
+uint64_t ReleaseBlocks(ThreadBlockCache* cache, size_t index, size_t num) {
+  auto& blocks = cache->blocks[index];
+  num = std::min(num, blocks.size());
+  if (num == 0) {
+    return 0;
+  }
+  uint64_t bytes = 0;
+  for (size_t i = 0; i < num; ++i) {
+    bytes += blocks[i]->size();
+  }
+  UpdateCachedStat(blocks[0], -static_cast<int64_t>(bytes));
+  for (size_t i = 0; i < num; ++i) {
+    cache->underlying_allocator->Free(blocks[i]);
+  }
+  blocks.erase(blocks.begin(), blocks.begin() + num);
+  cache->cached_size -= bytes;
+  return bytes;
+}
+
+uint64_t ReleaseAllBlocks(ThreadBlockCache* cache) {
+  uint64_t bytes = 0;
+  for (size_t i = 0; i < ThreadLocalCachingAllocator::kSizeClassNum; ++i) {
+    bytes += ReleaseBlocks(cache, i, cache->blocks[i].size());
+    cache->low_watermarks[i] = 0;
+  }
+  return bytes;
+}
+
+// Gives back the blocks that stayed in the cache during the current release
+// interval, and starts a new interval if asked.
+uint64_t ReleaseIdleBlocks(ThreadBlockCache* cache, bool new_interval) {
+  uint64_t bytes = 0;
+  for (size_t i = 0; i < ThreadLocalCachingAllocator::kSizeClassNum; ++i) {
+    bytes += ReleaseBlocks(cache, i, cache->low_watermarks[i]);
+    cache->low_watermarks[i] = new_interval ? cache->blocks[i].size() : 0;
+  }
+  return bytes;
+}
+
+void DetachThreadCache(ThreadBlockCache* cache) {
+  std::lock_guard<SpinLock> guard(cache->lock);
+  if (!cache->detached) {
+    ReleaseAllBlocks(cache);
+    cache->detached = true;
+  }
+}
+
+bool IsDetached(ThreadBlockCache* cache) {
+  std::lock_guard<SpinLock> guard(cache->lock);
+  return cache->detached;
+}
+
+// The caches of the calling thread, by allocator id. The last used one is
+// kept aside, since a thread nearly always allocates from a single
+// allocator.
+struct ThreadCacheHolder {
+  ThreadCacheHolder() {
+    // The caches are emptied into the underlying allocator on thread exit,
+    // which updates the memory stats of the thread, so the thread data of
+    // the stats must be created first to be destroyed after the holder.
+    ThreadDataRegistry<HostMemoryStatThreadLocalCached0>::GetInstance()
+        .GetCurrentThreadData();
+    ThreadDataRegistry<HostMemoryStatReserved0>::GetInstance()
+        .GetCurrentThreadData();
+  }
+
+  ~ThreadCacheHolder() {
+    for (auto& pair : caches) {
+      DetachThreadCache(pair.second.get());
+    }
+  }
+
+  uint64_t last_id{0};
+  ThreadBlockCache* last_cache{nullptr};
+  std::unordered_map<uint64_t, std::shared_ptr<ThreadBlockCache>> caches;
+};
+
+thread_local ThreadCacheHolder thread_cache_holder;
+
+}  // namespace
+
+ThreadLocalCachingAllocator::ThreadLocalCachingAllocator(
+    std::shared_ptr<Allocator> underlying_allocator,
+    size_t thread_cache_capacity)
+    : underlying_allocator_(std::move(underlying_allocator)),
+      thread_cache_capacity_(thread_cache_capacity),
+      id_(next_allocator_id.fetch_add(1)) {
+  PADDLE_ENFORCE_NOT_NULL(
+      underlying_allocator_,
+      platform::errors::InvalidArgument(
+          "Underlying allocator of ThreadLocalCachingAllocator is NULL"));
+  PADDLE_ENFORCE_EQ(
+      underlying_allocator_->IsAllocThreadSafe(),
+      true,
+      platform::errors::PreconditionNotMet(
+          "Underlying allocator of ThreadLocalCachingAllocator is not thread "
+          "safe"));
+}
+
+ThreadLocalCachingAllocator::~ThreadLocalCachingAllocator() {
+  std::lock_guard<std::mutex> guard(caches_mutex_);
+  for (auto& cache : caches_) {
+    DetachThreadCache(cache.get());
+  }
+}
+
+size_t ThreadLocalCachingAllocator::SizeClassIndex(size_t size) {
+  if (size <= kMinCachedSize) {
+    return 0;
+  }
+  if (size > kMaxCachedSize) {
+    return kSizeClassNum;
+  }
+  size_t bits = FloorLog2(size - 1);
+  size_t quarter = ((size - 1) >> (bits - 2)) & 3;
+  return (bits - kMinCachedSizeBits) * 4 + quarter + 1;
+}
+
+size_t ThreadLocalCachingAllocator::SizeClassSize(size_t index) {
+  if (index == 0) {
+    return kMinCachedSize;
+  }
+  size_t bits = (index - 1) / 4 + kMinCachedSizeBits;
+  size_t quarter = (index - 1) % 4;
+  return (quarter + 5) << (bits - 2);
+}
+
+size_t ThreadLocalCachingAllocator::ThreadCachedSize() {
+  ThreadBlockCache* cache = GetThreadCache();
+  std::lock_guard<SpinLock> guard(cache->lock);
+  return cache->cached_size;
+}
+
+ThreadBlockCache* ThreadLocalCachingAllocator::GetThreadCache() {
+  ThreadCacheHolder& holder = thread_cache_holder;
+  if (LIKELY(holder.last_id == id_)) {
+    return holder.last_cache;
+  }
+  auto iter = holder.caches.find(id_);
+  if (iter == holder.caches.end()) {
+    // drop the caches of the allocators destroyed meanwhile
+    for (auto it = holder.caches.begin(); it != holder.caches.end();) {
+      if (IsDetached(it->second.get())) {
+        it = holder.caches.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    auto cache =
+        std::make_shared<ThreadBlockCache>(underlying_allocator_.get());
+    auto is_detached = [](const std::shared_ptr<ThreadBlockCache>& other) {
+      return IsDetached(other.get());
+    };
+    {
+      std::lock_guard<std::mutex> guard(caches_mutex_);
+      // and the caches of the threads exited meanwhile
+      caches_.erase(
+          std::remove_if(caches_.begin(), caches_.end(), is_detached),
+          caches_.end());
+      caches_.push_back(cache);
+    }
+    iter = holder.caches.emplace(id_, std::move(cache)).first;
+  }
+  holder.last_id = id_;
+  holder.last_cache = iter->second.get();
+  return holder.last_cache;
+}
+
+phi::Allocation* ThreadLocalCachingAllocator::AllocateImpl(size_t size) {
+  size_t index = SizeClassIndex(size);
+  if (index == kSizeClassNum) {
+    return underlying_allocator_->Allocate(size).release();
+  }
+  ThreadBlockCache* cache = GetThreadCache();
+  {
+    std::lock_guard<SpinLock> guard(cache->lock);
+    auto& blocks = cache->blocks[index];
+    if (!blocks.empty()) {
+      phi::Allocation* allocation = blocks.back();
+      blocks.pop_back();
+      cache->low_watermarks[index] =
+          std::min(cache->low_watermarks[index], blocks.size());
+      cache->cached_size -= allocation->size();
+      UpdateCachedStat(allocation, -static_cast<int64_t>(allocation->size()));
+      VLOG(10) << "Allocate " << size << " bytes from thread cache, ptr = "
+               << allocation->ptr();
+      return allocation;
+    }
+  }
+  return underlying_allocator_->Allocate(SizeClassSize(index)).release();
+}
+
+void ThreadLocalCachingAllocator::FreeImpl(phi::Allocation* allocation) {
+  size_t size = allocation->size();
+  size_t index = SizeClassIndex(size);
+  // blocks not of a class size, e.g. rounded up by the underlying allocator,
+  // are not cached
+  if (index == kSizeClassNum || SizeClassSize(index) != size ||
+      size > thread_cache_capacity_) {
+    underlying_allocator_->Free(allocation);
+    return;
+  }
+  ThreadBlockCache* cache = GetThreadCache();
+  std::lock_guard<SpinLock> guard(cache->lock);
+  if (cache->cached_size + size > thread_cache_capacity_) {
+    ReleaseIdleBlocks(cache, /*new_interval=*/false);
+    if (cache->cached_size + size > thread_cache_capacity_) {
+      underlying_allocator_->Free(allocation);
+      return;
+    }
+  }
+  cache->blocks[index].push_back(allocation);
+  cache->cached_size += size;
+  UpdateCachedStat(allocation, static_cast<int64_t>(size));
+  if (++cache->free_times % kReleaseInterval == 0) {
+    uint64_t bytes = ReleaseIdleBlocks(cache, /*new_interval=*/true);
+    VLOG(4) << "Release " << bytes << " idle bytes of thread cache, "
+            << cache->cached_size << " bytes remain";
+  }
+}
+
+uint64_t ThreadLocalCachingAllocator::ReleaseImpl(
+    const platform::Place& place) {
+  uint64_t bytes = 0;
+  {
+    std::lock_guard<std::mutex> guard(caches_mutex_);
+    for (auto& cache : caches_) {
+      std::lock_guard<SpinLock> cache_guard(cache->lock);
+      bytes += ReleaseAllBlocks(cache.get());
+    }
+  }
+  VLOG(2) << "Release " << bytes << " bytes of thread caches";
+  return underlying_allocator_->Release(place);
+}
+
+}  // namespace paddle::memory::allocation
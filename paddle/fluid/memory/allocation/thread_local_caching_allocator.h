@@ -0,0 +1,87 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "paddle/fluid/memory/allocation/allocator.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+struct ThreadBlockCache;
+
+// ThreadLocalCachingAllocator keeps the recently freed small blocks of an
+// underlying allocator in per-thread free lists, so that most allocations
+// and frees of short-lived tensors do not take the lock of the underlying
+// allocator. It is meant to sit in front of an AutoGrowthBestFitAllocator
+// for CPUPlace, where many predictors running concurrently would otherwise
+// contend for its spin lock.
+//
+// Requests are rounded up to one of kSizeClassNum size classes, four per
+// power of two from kMinCachedSize to kMaxCachedSize, so that at most a
+// quarter of a block is wasted. Larger requests go to the underlying
+// allocator directly. A block is cached by the thread that frees it, up to
+// thread_cache_capacity bytes per thread, and every kReleaseInterval frees a
+// thread gives back the blocks it has not used during the interval.
+// Release() empties the caches of all the threads.
+class ThreadLocalCachingAllocator : public Allocator {
+ public:
+  static constexpr size_t kMinCachedSize = 256;
+  static constexpr size_t kMaxCachedSize = 1UL << 20;
+  static constexpr size_t kSizeClassNum = 49;
+  static constexpr size_t kReleaseInterval = 4096;
+
+  ThreadLocalCachingAllocator(std::shared_ptr<Allocator> underlying_allocator,
+                              size_t thread_cache_capacity);
+
+  ~ThreadLocalCachingAllocator() override;
+
+  bool IsAllocThreadSafe() const override { return true; }
+
+  // Index of the smallest size class holding size bytes, or kSizeClassNum if
+  // the size is not cached.
+  static size_t SizeClassIndex(size_t size);
+
+  static size_t SizeClassSize(size_t index);
+
+  // Bytes cached by the calling thread.
+  size_t ThreadCachedSize();
+
+ protected:
+  phi::Allocation* AllocateImpl(size_t size) override;
+
+  void FreeImpl(phi::Allocation* allocation) override;
+
+  uint64_t ReleaseImpl(const platform::Place& place) override;
+
+ private:
+  ThreadBlockCache* GetThreadCache();
+
+  std::shared_ptr<Allocator> underlying_allocator_;
+  size_t thread_cache_capacity_;
+  uint64_t id_;
+
+  std::mutex caches_mutex_;
+  std::vector<std::shared_ptr<ThreadBlockCache>> caches_;
+};
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
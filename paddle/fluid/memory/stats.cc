@@ -167,6 +167,7 @@ int RegisterAllStats() {
 
   HOST_MEMORY_STAT_REGISTER(Allocated);
   HOST_MEMORY_STAT_REGISTER(Reserved);
+  HOST_MEMORY_STAT_REGISTER(ThreadLocalCached);
   return 0;
 }
 
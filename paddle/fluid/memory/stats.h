@@ -230,6 +230,8 @@ DEVICE_MEMORY_STAT_DECLARE(Reserved);
 
 HOST_MEMORY_STAT_DECLARE(Allocated);
 HOST_MEMORY_STAT_DECLARE(Reserved);
+// host memory kept by the per-thread caches of ThreadLocalCachingAllocator
+HOST_MEMORY_STAT_DECLARE(ThreadLocalCached);
 
 }  // namespace memory
 }  // namespace paddle
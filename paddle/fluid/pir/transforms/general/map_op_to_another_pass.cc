@@ -70,6 +70,19 @@ class MapOpToAnotherPass : public pir::PatternRewritePass {
     ps.Add(paddle::drr::Create<DepthWiseConv2d2Conv2dPattern>(context));
     return ps;
   }
+
+  pir::GreedyRewriteConfig InitializeConfig() override {
+    pir::GreedyRewriteConfig config =
+        pir::PatternRewritePass::InitializeConfig();
+    // Keep the producers from above out of the worklist, so that the pass
+    // only visits the operations in the regions it runs on.
+    config.strict_mode = pir::GreedyRewriteStrictness::ExistingAndNewOps;
+    return config;
+  }
+
+  // The pattern only replaces its root operation in place and reuses its
+  // operands, which leaves the operations outside the region untouched.
+  bool IsRegionLocal() const override { return true; }
 };
 
 }  // namespace
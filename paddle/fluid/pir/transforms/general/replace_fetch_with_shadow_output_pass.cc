@@ -51,6 +51,9 @@ class ReplaceFetchWithShadowOutputPass : public pir::PatternRewritePass {
     return op->isa<::pir::ModuleOp>() && op->num_regions() > 0;
   }
 
+  // Only runs on the module, whose operations it rewrites one by one.
+  bool IsRegionLocal() const override { return true; }
+
  private:
   pir::FrozenRewritePatternSet patterns_;
 };
@@ -370,6 +370,9 @@ void BindDataset(py::module *m) {
       .def("set_fleet_send_sleep_seconds",
            &framework::Dataset::SetFleetSendSleepSeconds,
            py::call_guard<py::gil_scoped_release>())
+      .def("set_lock_free_channel",
+           &framework::Dataset::SetLockFreeChannel,
+           py::call_guard<py::gil_scoped_release>())
       .def("enable_pv_merge",
            &framework::Dataset::EnablePvMerge,
            py::call_guard<py::gil_scoped_release>())
@@ -382,6 +385,9 @@ void BindDataset(py::module *m) {
       .def("get_pass_id",
            &framework::Dataset::GetPassID,
            py::call_guard<py::gil_scoped_release>())
+      .def("dump_columnar_records",
+           &framework::Dataset::DumpColumnarRecords,
+           py::call_guard<py::gil_scoped_release>())
       .def("dump_walk_path",
            &framework::Dataset::DumpWalkPath,
            py::call_guard<py::gil_scoped_release>())
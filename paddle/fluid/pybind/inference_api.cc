@@ -992,6 +992,8 @@ void BindAnalysisConfig(py::module *m) {
            &AnalysisConfig::SetCpuMathLibraryNumThreads)
       .def("cpu_math_library_num_threads",
            &AnalysisConfig::cpu_math_library_num_threads)
+      .def("set_cpu_numa_node", &AnalysisConfig::SetCpuNumaNode)
+      .def("cpu_numa_node", &AnalysisConfig::cpu_numa_node)
       .def("to_native_config", &AnalysisConfig::ToNativeConfig)
       .def("enable_quantizer", &AnalysisConfig::EnableMkldnnQuantizer)
       .def("enable_mkldnn_bfloat16", &AnalysisConfig::EnableMkldnnBfloat16)
@@ -0,0 +1,259 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/backends/cpu/numa.h"
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "glog/logging.h"
+
+namespace phi {
+namespace backends {
+namespace cpu {
+
+namespace {
+
+struct NumaTopology {
+  // indexed by node id, empty for the nodes without cpus
+  std::vector<std::vector<int>> node_cpus;
+  std::vector<int> node_ids;
+  std::vector<int> cpu_node;
+};
+
+// parses the sysfs list format, e.g. "0-3,8-11"
+std::vector<int> ParseCpuList(const std::string& list) {
+  std::vector<int> ids;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty() || range == "\n") {
+      continue;
+    }
+    size_t dash = range.find('-');
+    try {
+      int first = std::stoi(range.substr(0, dash));
+      int last =
+          dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+      for (int id = first; id <= last; ++id) {
+        ids.push_back(id);
+      }
+    } catch (const std::exception&) {
+      VLOG(3) << "Ignore bad cpu list entry " << range;
+    }
+  }
+  return ids;
+}
+
+bool ReadFirstLine(const std::string& path, std::string* line) {
+  std::ifstream fin(path);
+  return fin.good() && std::getline(fin, *line).good();
+}
+
+NumaTopology LoadNumaTopology() {
+  NumaTopology topology;
+#ifdef __linux__
+  std::string line;
+  if (ReadFirstLine("/sys/devices/system/node/online", &line)) {
+    for (int node : ParseCpuList(line)) {
+      std::string cpus;
+      if (!ReadFirstLine("/sys/devices/system/node/node" +
+                             std::to_string(node) + "/cpulist",
+                         &cpus)) {
+        continue;
+      }
+      std::vector<int> node_cpus = ParseCpuList(cpus);
+      if (node_cpus.empty()) {
+        VLOG(1) << "Skip NUMA node " << node << " without cpus";
+        continue;
+      }
+      if (static_cast<int>(topology.node_cpus.size()) <= node) {
+        topology.node_cpus.resize(node + 1);
+      }
+      topology.node_cpus[node] = std::move(node_cpus);
+      topology.node_ids.push_back(node);
+    }
+  }
+#endif
+  if (topology.node_ids.empty()) {
+    // no NUMA information, one node with all the cpus
+    int cpu_num = static_cast<int>(std::thread::hardware_concurrency());
+    topology.node_cpus.assign(1, std::vector<int>());
+    for (int cpu = 0; cpu < cpu_num; ++cpu) {
+      topology.node_cpus[0].push_back(cpu);
+    }
+    topology.node_ids.assign(1, 0);
+  }
+  for (int node : topology.node_ids) {
+    for (int cpu : topology.node_cpus[node]) {
+      if (static_cast<int>(topology.cpu_node.size()) <= cpu) {
+        topology.cpu_node.resize(cpu + 1, 0);
+      }
+      topology.cpu_node[cpu] = node;
+    }
+  }
+  VLOG(1) << "NUMA topology: " << topology.node_ids.size() << " node(s)";
+  return topology;
+}
+
+const NumaTopology& GetNumaTopology() {
+  static const NumaTopology topology = LoadNumaTopology();
+  return topology;
+}
+
+thread_local int current_thread_numa_node = -1;
+
+}  // namespace
+
+int NumaNodeCount() {
+  return static_cast<int>(GetNumaTopology().node_ids.size());
+}
+
+const std::vector<int>& NumaNodeIds() { return GetNumaTopology().node_ids; }
+
+const std::vector<int>& NumaNodeCpus(int node) {
+  static const std::vector<int> empty;
+  const auto& node_cpus = GetNumaTopology().node_cpus;
+  if (node < 0 || node >= static_cast<int>(node_cpus.size())) {
+    return empty;
+  }
+  return node_cpus[node];
+}
+
+int NumaNodeOfCpu(int cpu) {
+  const auto& cpu_node = GetNumaTopology().cpu_node;
+  if (cpu < 0 || cpu >= static_cast<int>(cpu_node.size())) {
+    return 0;
+  }
+  return cpu_node[cpu];
+}
+
+bool BindCurrentThreadToNumaNode(int node) {
+  const std::vector<int>& cpus = NumaNodeCpus(node);
+  if (cpus.empty()) {
+    LOG(WARNING) << "Cannot bind thread to unknown NUMA node " << node;
+    return false;
+  }
+#ifdef __linux__
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  for (int cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &mask);
+    }
+  }
+  if (sched_setaffinity(0, sizeof(mask), &mask) != 0) {
+    LOG(WARNING) << "Fail to bind thread to NUMA node " << node;
+    return false;
+  }
+  current_thread_numa_node = node;
+  return true;
+#else
+  return false;
+#endif
+}
+
+int CurrentThreadNumaNode() { return current_thread_numa_node; }
+
+ScopedNumaNodeBinding::ScopedNumaNodeBinding(int node) {
+  if (node < 0 || NumaNodeCount() <= 1 || CurrentThreadNumaNode() == node) {
+    return;
+  }
+#ifdef __linux__
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  if (sched_getaffinity(0, sizeof(mask), &mask) != 0) {
+    LOG(WARNING) << "Fail to get the cpu affinity of the thread, leave it "
+                    "unbound";
+    return;
+  }
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &mask)) {
+      saved_cpus_.push_back(cpu);
+    }
+  }
+  saved_node_ = current_thread_numa_node;
+  bound_ = BindCurrentThreadToNumaNode(node);
+#endif
+}
+
+ScopedNumaNodeBinding::~ScopedNumaNodeBinding() {
+  if (!bound_) {
+    return;
+  }
+#ifdef __linux__
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  for (int cpu : saved_cpus_) {
+    CPU_SET(cpu, &mask);
+  }
+  if (sched_setaffinity(0, sizeof(mask), &mask) != 0) {
+    LOG(WARNING) << "Fail to restore the cpu affinity of the thread";
+  }
+  current_thread_numa_node = saved_node_;
+#endif
+}
+
+bool BindMemoryToNumaNode(void* ptr, size_t size, int node) {
+  if (NumaNodeCount() == 1 || node < 0 ||
+      node >= static_cast<int>(GetNumaTopology().node_cpus.size())) {
+    return false;
+  }
+#if defined(__linux__) && defined(SYS_mbind)
+  // values of <numaif.h>, which comes with libnuma and is not required here
+  constexpr int kMpolPreferred = 1;
+  constexpr unsigned kMpolMfMove = 1 << 1;
+  const uintptr_t page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  uintptr_t begin = reinterpret_cast<uintptr_t>(ptr);
+  uintptr_t end = begin + size;
+  begin = (begin + page_size - 1) / page_size * page_size;
+  end = end / page_size * page_size;
+  if (begin >= end) {
+    return false;
+  }
+  constexpr int kBitsPerWord = 8 * sizeof(unsigned long);  // NOLINT
+  std::vector<unsigned long> node_mask(node / kBitsPerWord + 1, 0);  // NOLINT
+  node_mask[node / kBitsPerWord] = 1UL << (node % kBitsPerWord);
+  long ret = syscall(SYS_mbind,  // NOLINT
+                     reinterpret_cast<void*>(begin),
+                     end - begin,
+                     kMpolPreferred,
+                     node_mask.data(),
+                     node_mask.size() * kBitsPerWord + 1,
+                     kMpolMfMove);
+  if (ret != 0) {
+    VLOG(3) << "mbind to NUMA node " << node << " failed, errno " << errno;
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+}  // namespace cpu
+}  // namespace backends
+}  // namespace phi
@@ -0,0 +1,80 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "paddle/utils/test_macros.h"
+
+namespace phi {
+namespace backends {
+namespace cpu {
+
+// NUMA topology of the host, read from sysfs on Linux. Other systems, and
+// Linux machines without NUMA support, look like a single node holding all
+// the cpus, so that every caller works unchanged on them. Nodes without
+// cpus, e.g. memory-only or CXL memory nodes, are left out: no thread can
+// run on them.
+
+//! Get the number of online NUMA nodes with cpus, at least 1.
+TEST_API int NumaNodeCount();
+
+//! Get the ids of the online NUMA nodes with cpus, in increasing order. The
+//! ids are those of sysfs and need not be contiguous.
+TEST_API const std::vector<int>& NumaNodeIds();
+
+//! Get the cpus of a NUMA node, empty for an unknown node.
+TEST_API const std::vector<int>& NumaNodeCpus(int node);
+
+//! Get the NUMA node of a cpu, 0 if unknown.
+TEST_API int NumaNodeOfCpu(int cpu);
+
+//! Pin the calling thread to the cpus of a NUMA node and remember the node
+//! as the thread's home node. Returns false if the thread could not be
+//! pinned, e.g. the node does not exist.
+TEST_API bool BindCurrentThreadToNumaNode(int node);
+
+//! Get the node the calling thread was pinned to by
+//! BindCurrentThreadToNumaNode, or -1.
+TEST_API int CurrentThreadNumaNode();
+
+//! Pin the calling thread to a NUMA node for the lifetime of the object,
+//! then give the thread back its previous cpu affinity and home node. A
+//! negative node, or a single node host, leaves the thread alone.
+class TEST_API ScopedNumaNodeBinding {
+ public:
+  explicit ScopedNumaNodeBinding(int node);
+  ~ScopedNumaNodeBinding();
+
+  ScopedNumaNodeBinding(const ScopedNumaNodeBinding&) = delete;
+  ScopedNumaNodeBinding& operator=(const ScopedNumaNodeBinding&) = delete;
+
+ private:
+  bool bound_ = false;
+  int saved_node_ = -1;
+  std::vector<int> saved_cpus_;
+};
+
+//! Ask the kernel to place the pages of [ptr, ptr + size) on a NUMA node,
+//! moving pages that are already faulted in. The node is preferred, not
+//! mandatory, so the allocation still succeeds when the node is full. Only
+//! the whole pages inside the range are affected.
+TEST_API bool BindMemoryToNumaNode(void* ptr, size_t size, int node);
+
+}  // namespace cpu
+}  // namespace backends
+}  // namespace phi
@@ -18,9 +18,11 @@
 
 #include "glog/logging.h"
 #include "paddle/common/flags.h"
+#include "paddle/phi/backends/cpu/numa.h"
 #include "paddle/phi/core/enforce.h"
 
 COMMON_DECLARE_int32(dist_threadpool_size);
+COMMON_DECLARE_int32(cpu_numa_node);
 PD_DEFINE_int32(io_threadpool_size,
                 100,
                 "number of threads used for doing IO, default 100");
@@ -47,15 +49,28 @@ void ThreadPool::Init() {
         num_threads,
         0,
         phi::errors::InvalidArgument("The number of threads is 0."));
-    threadpool_ = std::make_unique<ThreadPool>(num_threads);
+    threadpool_ =
+        std::make_unique<ThreadPool>(num_threads, FLAGS_cpu_numa_node);
   }
 }
 
-ThreadPool::ThreadPool(int num_threads) : running_(true) {
+ThreadPool::ThreadPool(int num_threads, int numa_node) : running_(true) {
   threads_.resize(num_threads);
-  for (auto& thread : threads_) {
-    // TODO(Yancey1989): binding the thread on the specify CPU number
-    thread = std::make_unique<std::thread>([this] { ThreadPool::TaskLoop(); });
+  const std::vector<int>& node_ids = backends::cpu::NumaNodeIds();
+  const int node_num = static_cast<int>(node_ids.size());
+  for (int i = 0; i < num_threads; ++i) {
+    int node = -1;
+    if (node_num > 1 && numa_node >= 0) {
+      node = numa_node;
+    } else if (node_num > 1 && numa_node == -2) {
+      node = node_ids[i * node_num / num_threads];
+    }
+    threads_[i] = std::make_unique<std::thread>([this, node] {
+      if (node >= 0) {
+        backends::cpu::BindCurrentThreadToNumaNode(node);
+      }
+      ThreadPool::TaskLoop();
+    });
   }
 }
 
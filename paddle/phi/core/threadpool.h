@@ -50,7 +50,9 @@ struct ExceptionHandler {
 // number of threads.
 class ThreadPool {
  public:
-  explicit ThreadPool(int num_threads);
+  // numa_node: pin the threads to this NUMA node if it is >= 0, or spread
+  // them over all the nodes if it is -2, see FLAGS_cpu_numa_node.
+  explicit ThreadPool(int num_threads, int numa_node = -1);
 
   using Task =
       std::packaged_task<std::unique_ptr<common::enforce::EnforceNotMet>()>;
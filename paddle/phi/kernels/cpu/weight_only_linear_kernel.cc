@@ -0,0 +1,615 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/kernels/weight_only_linear_kernel.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/backends/cpu/cpu_info.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/funcs/blas/blas.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define WEIGHT_ONLY_WITH_X86
+#if defined(_MSC_VER)
+#define WEIGHT_ONLY_TARGET(isa)
+#else
+#define WEIGHT_ONLY_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace phi {
+
+namespace {
+
+// weight_quantize lays the int8/int4 weights of arch 75/80/86 out by
+// column: the rows of a column are permuted, and split into chunks of 64
+// rows, the chunks of 16 / bits columns being interleaved. The values are
+// biased to be unsigned, and the lanes of each 32 bits register are
+// interleaved. For arch 70 the weights are stored by row, biased and
+// interleaved alike.
+//
+// The kernels decode a chunk of a column in order, and multiply it by the
+// activations permuted once to the order of the decoded weights, so that
+// the weights are never reordered.
+constexpr int64_t kChunkRows = 64;
+// The rows up to which the weights are dequantized in registers for each
+// row of x, instead of into tiles multiplied by blas.
+constexpr int64_t kMaxGemvRows = 4;
+constexpr int64_t kGemvBlockCols = 16;
+constexpr int64_t kTileBytes = 1 << 20;
+
+struct WeightOnlyArgs {
+  const uint8_t* weight;
+  // [k / group_size, n]
+  const float* scale;
+  int64_t n;
+  int64_t k;
+  int64_t group_size;
+};
+
+template <int kBits>
+constexpr float ZeroPoint() {
+  return kBits == 8 ? 128.f : 8.f;
+}
+
+// The lane of a register moved to lane d by add_bias_and_interleave_inplace.
+template <int kBits>
+int RegisterLane(int d) {
+  if (kBits == 8) {
+    return d == 1 ? 2 : (d == 2 ? 1 : d);
+  }
+  return d < 4 ? 2 * d : 2 * (d - 4) + 1;
+}
+
+// The row moved to row r by permute_B_rows_for_mixed_gemm.
+template <int kBits>
+int64_t PermutedRow(int64_t r) {
+  constexpr int kEltsPerReg = 32 / kBits;
+  constexpr int kRowsPerMma = 8 * (16 / kBits);
+  int t = static_cast<int>(r % kRowsPerMma);
+  return r - t + 8 * ((t % kEltsPerReg) / 2) + t % 2 + 2 * (t / kEltsPerReg);
+}
+
+// The int4 weights are decoded by 8 bytes, the low nibbles first, which
+// gives the decoded element q of a chunk this position in the chunk.
+template <int kBits>
+int StoredPos(int q) {
+  if (kBits == 8) {
+    return q;
+  }
+  int c = q % 16;
+  return q - c + (c < 8 ? 2 * c : 2 * (c - 8) + 1);
+}
+
+// The row of the weight decoded at the position q of the chunk t of a
+// column, for arch 75/80/86.
+template <int kBits>
+int64_t DecodedRow(int64_t t, int q) {
+  constexpr int kEltsPerReg = 32 / kBits;
+  int p = StoredPos<kBits>(q);
+  int lane = RegisterLane<kBits>(p % kEltsPerReg);
+  return PermutedRow<kBits>(t * kChunkRows + p - p % kEltsPerReg + lane);
+}
+
+template <int kBits>
+const uint8_t* ColumnChunk(const WeightOnlyArgs& args,
+                           int64_t col,
+                           int64_t t) {
+  constexpr int64_t kInterleave = 16 / kBits;
+  int64_t offset = (col / kInterleave) * args.k * kInterleave +
+                   t * kChunkRows * kInterleave +
+                   (col % kInterleave) * kChunkRows;
+  return args.weight + offset * kBits / 8;
+}
+
+inline float ChunkScale(const WeightOnlyArgs& args, int64_t col, int64_t t) {
+  return args.scale[(t * kChunkRows / args.group_size) * args.n + col];
+}
+
+template <int kBits>
+inline float DecodeRef(const uint8_t* chunk, int q) {
+  if (kBits == 8) {
+    return chunk[q];
+  }
+  int c = q % 16;
+  uint8_t b = chunk[(q - c) / 2 + c % 8];
+  return c < 8 ? (b & 15) : (b >> 4);
+}
+
+// Computes the columns [begin, end) of kRows rows of out = x * w, x being
+// permuted to the decoded order.
+template <int kBits, int kRows>
+void GemvRef(const WeightOnlyArgs& args,
+             const float* x,
+             float* out,
+             int64_t begin,
+             int64_t end) {
+  for (int64_t col = begin; col < end; ++col) {
+    float acc[kRows] = {0.f};
+    for (int64_t t = 0; t < args.k / kChunkRows; ++t) {
+      const uint8_t* chunk = ColumnChunk<kBits>(args, col, t);
+      float scale = ChunkScale(args, col, t);
+      const float* xt = x + t * kChunkRows;
+      for (int q = 0; q < kChunkRows; ++q) {
+        float w = scale * (DecodeRef<kBits>(chunk, q) - ZeroPoint<kBits>());
+        for (int r = 0; r < kRows; ++r) {
+          acc[r] += xt[r * args.k + q] * w;
+        }
+      }
+    }
+    for (int r = 0; r < kRows; ++r) {
+      out[r * args.n + col] = acc[r];
+    }
+  }
+}
+
+// Dequantizes a column in the decoded order.
+template <int kBits>
+void DequantRef(const WeightOnlyArgs& args, int64_t col, float* dst) {
+  for (int64_t t = 0; t < args.k / kChunkRows; ++t) {
+    const uint8_t* chunk = ColumnChunk<kBits>(args, col, t);
+    float scale = ChunkScale(args, col, t);
+    for (int q = 0; q < kChunkRows; ++q) {
+      dst[t * kChunkRows + q] =
+          scale * (DecodeRef<kBits>(chunk, q) - ZeroPoint<kBits>());
+    }
+  }
+}
+
+#ifdef WEIGHT_ONLY_WITH_X86
+// The lanes [8 * i, 8 * i + 8) of a chunk.
+template <int kBits>
+WEIGHT_ONLY_TARGET("avx2,fma")
+inline __m256 DecodeAvx2(const uint8_t* chunk, int i) {
+  if (kBits == 8) {
+    __m128i b =
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(chunk + 8 * i));
+    return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(b));
+  }
+  __m256i b = _mm256_cvtepu8_epi32(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(chunk + 8 * (i / 2))));
+  b = i % 2 == 0 ? _mm256_and_si256(b, _mm256_set1_epi32(15))
+                 : _mm256_srli_epi32(b, 4);
+  return _mm256_cvtepi32_ps(b);
+}
+
+WEIGHT_ONLY_TARGET("avx2,fma")
+inline float ReduceAddAvx2(__m256 a) {
+  __m128 v = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+  v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+  v = _mm_add_ss(v, _mm_movehdup_ps(v));
+  return _mm_cvtss_f32(v);
+}
+
+template <int kBits, int kRows>
+WEIGHT_ONLY_TARGET("avx2,fma")
+void GemvAvx2(const WeightOnlyArgs& args,
+              const float* x,
+              float* out,
+              int64_t begin,
+              int64_t end) {
+  for (int64_t col = begin; col < end; ++col) {
+    __m256 acc[kRows][2];
+    for (int r = 0; r < kRows; ++r) {
+      acc[r][0] = _mm256_setzero_ps();
+      acc[r][1] = _mm256_setzero_ps();
+    }
+    for (int64_t t = 0; t < args.k / kChunkRows; ++t) {
+      const uint8_t* chunk = ColumnChunk<kBits>(args, col, t);
+      float scale = ChunkScale(args, col, t);
+      __m256 vscale = _mm256_set1_ps(scale);
+      __m256 vbias = _mm256_set1_ps(-scale * ZeroPoint<kBits>());
+      const float* xt = x + t * kChunkRows;
+      for (int i = 0; i < kChunkRows / 8; ++i) {
+        __m256 w = _mm256_fmadd_ps(DecodeAvx2<kBits>(chunk, i), vscale, vbias);
+        for (int r = 0; r < kRows; ++r) {
+          acc[r][i % 2] = _mm256_fmadd_ps(
+              _mm256_loadu_ps(xt + r * args.k + 8 * i), w, acc[r][i % 2]);
+        }
+      }
+    }
+    for (int r = 0; r < kRows; ++r) {
+      out[r * args.n + col] =
+          ReduceAddAvx2(_mm256_add_ps(acc[r][0], acc[r][1]));
+    }
+  }
+}
+
+template <int kBits>
+WEIGHT_ONLY_TARGET("avx2,fma")
+void DequantAvx2(const WeightOnlyArgs& args, int64_t col, float* dst) {
+  for (int64_t t = 0; t < args.k / kChunkRows; ++t) {
+    const uint8_t* chunk = ColumnChunk<kBits>(args, col, t);
+    float scale = ChunkScale(args, col, t);
+    __m256 vscale = _mm256_set1_ps(scale);
+    __m256 vbias = _mm256_set1_ps(-scale * ZeroPoint<kBits>());
+    for (int i = 0; i < kChunkRows / 8; ++i) {
+      _mm256_storeu_ps(
+          dst + t * kChunkRows + 8 * i,
+          _mm256_fmadd_ps(DecodeAvx2<kBits>(chunk, i), vscale, vbias));
+    }
+  }
+}
+
+// The lanes [16 * i, 16 * i + 16) of a chunk.
+template <int kBits>
+WEIGHT_ONLY_TARGET("avx512f")
+inline __m512 DecodeAvx512(const uint8_t* chunk, int i) {
+  if (kBits == 8) {
+    __m128i b =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(chunk + 16 * i));
+    return _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(b));
+  }
+  // the 8 bytes in both halves, shifted by 0 in the low one and by 4 in the
+  // high one
+  __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(chunk + 8 * i));
+  __m512i v = _mm512_cvtepu8_epi32(_mm_unpacklo_epi64(b, b));
+  v = _mm512_srlv_epi32(
+      v, _mm512_set_epi32(4, 4, 4, 4, 4, 4, 4, 4, 0, 0, 0, 0, 0, 0, 0, 0));
+  v = _mm512_and_si512(v, _mm512_set1_epi32(15));
+  return _mm512_cvtepi32_ps(v);
+}
+
+template <int kBits, int kRows>
+WEIGHT_ONLY_TARGET("avx512f")
+void GemvAvx512(const WeightOnlyArgs& args,
+                const float* x,
+                float* out,
+                int64_t begin,
+                int64_t end) {
+  for (int64_t col = begin; col < end; ++col) {
+    __m512 acc[kRows][2];
+    for (int r = 0; r < kRows; ++r) {
+      acc[r][0] = _mm512_setzero_ps();
+      acc[r][1] = _mm512_setzero_ps();
+    }
+    for (int64_t t = 0; t < args.k / kChunkRows; ++t) {
+      const uint8_t* chunk = ColumnChunk<kBits>(args, col, t);
+      float scale = ChunkScale(args, col, t);
+      __m512 vscale = _mm512_set1_ps(scale);
+      __m512 vbias = _mm512_set1_ps(-scale * ZeroPoint<kBits>());
+      const float* xt = x + t * kChunkRows;
+      for (int i = 0; i < kChunkRows / 16; ++i) {
+        __m512 w =
+            _mm512_fmadd_ps(DecodeAvx512<kBits>(chunk, i), vscale, vbias);
+        for (int r = 0; r < kRows; ++r) {
+          acc[r][i % 2] = _mm512_fmadd_ps(
+              _mm512_loadu_ps(xt + r * args.k + 16 * i), w, acc[r][i % 2]);
+        }
+      }
+    }
+    for (int r = 0; r < kRows; ++r) {
+      out[r * args.n + col] =
+          _mm512_reduce_add_ps(_mm512_add_ps(acc[r][0], acc[r][1]));
+    }
+  }
+}
+
+template <int kBits>
+WEIGHT_ONLY_TARGET("avx512f")
+void DequantAvx512(const WeightOnlyArgs& args, int64_t col, float* dst) {
+  for (int64_t t = 0; t < args.k / kChunkRows; ++t) {
+    const uint8_t* chunk = ColumnChunk<kBits>(args, col, t);
+    float scale = ChunkScale(args, col, t);
+    __m512 vscale = _mm512_set1_ps(scale);
+    __m512 vbias = _mm512_set1_ps(-scale * ZeroPoint<kBits>());
+    for (int i = 0; i < kChunkRows / 16; ++i) {
+      _mm512_storeu_ps(
+          dst + t * kChunkRows + 16 * i,
+          _mm512_fmadd_ps(DecodeAvx512<kBits>(chunk, i), vscale, vbias));
+    }
+  }
+}
+#endif
+
+using GemvFunc = void (*)(const WeightOnlyArgs&,
+                          const float*,
+                          float*,
+                          int64_t,
+                          int64_t);
+using DequantFunc = void (*)(const WeightOnlyArgs&, int64_t, float*);
+
+template <int kBits, int kRows>
+GemvFunc SelectGemv() {
+#ifdef WEIGHT_ONLY_WITH_X86
+  if (backends::cpu::MayIUse(backends::cpu::avx512f)) {
+    return GemvAvx512<kBits, kRows>;
+  }
+  if (backends::cpu::MayIUse(backends::cpu::avx2)) {
+    return GemvAvx2<kBits, kRows>;
+  }
+#endif
+  return GemvRef<kBits, kRows>;
+}
+
+template <int kBits>
+GemvFunc SelectGemv(int64_t rows) {
+  switch (rows) {
+    case 1:
+      return SelectGemv<kBits, 1>();
+    case 2:
+      return SelectGemv<kBits, 2>();
+    case 3:
+      return SelectGemv<kBits, 3>();
+    default:
+      return SelectGemv<kBits, 4>();
+  }
+}
+
+template <int kBits>
+DequantFunc SelectDequant() {
+#ifdef WEIGHT_ONLY_WITH_X86
+  if (backends::cpu::MayIUse(backends::cpu::avx512f)) {
+    return DequantAvx512<kBits>;
+  }
+  if (backends::cpu::MayIUse(backends::cpu::avx2)) {
+    return DequantAvx2<kBits>;
+  }
+#endif
+  return DequantRef<kBits>;
+}
+
+// The columns of a tile of dequantized weights, which stays in cache while
+// it is multiplied.
+int64_t TileCols(int64_t n, int64_t k) {
+  int64_t cols = kTileBytes / (k * static_cast<int64_t>(sizeof(float)));
+  cols = std::min<int64_t>(std::max<int64_t>(cols / 16 * 16, 16), 256);
+  return std::min(cols, n);
+}
+
+template <int kBits>
+void WeightOnlyMatmul(const CPUContext& dev_ctx,
+                      const WeightOnlyArgs& args,
+                      const float* x,
+                      int64_t m,
+                      int32_t arch,
+                      float* out) {
+  const int64_t n = args.n;
+  const int64_t k = args.k;
+#ifdef PADDLE_WITH_MKLML
+  int nth = omp_get_max_threads();
+#else
+  int nth = 1;
+#endif
+  auto blas = phi::funcs::GetBlas<CPUContext, float>(dev_ctx);
+  const int64_t tile_cols = TileCols(n, k);
+  const int64_t tile_num = (n + tile_cols - 1) / tile_cols;
+  DenseTensor tiles;
+
+  if (arch == 70) {
+    // the weights are stored by row, so they are dequantized into tiles
+    // [k, tile_cols] of the columns in order
+    constexpr int kEltsPerReg = 32 / kBits;
+    int stored_lane[kEltsPerReg];
+    for (int d = 0; d < kEltsPerReg; ++d) {
+      stored_lane[RegisterLane<kBits>(d)] = d;
+    }
+    tiles.Resize({nth, k * tile_cols});
+    float* tiles_data = dev_ctx.template Alloc<float>(&tiles);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int64_t tile = 0; tile < tile_num; ++tile) {
+#ifdef PADDLE_WITH_MKLML
+      int tid = omp_get_thread_num();
+#else
+      int tid = 0;
+#endif
+      float* w = tiles_data + tid * k * tile_cols;
+      int64_t col_begin = tile * tile_cols;
+      int64_t cols = std::min(tile_cols, n - col_begin);
+      for (int64_t row = 0; row < k; ++row) {
+        const uint8_t* src = args.weight + row * n * kBits / 8;
+        const float* scale = args.scale + (row / args.group_size) * n;
+        for (int64_t i = 0; i < cols; ++i) {
+          int64_t col = col_begin + i;
+          int64_t pos =
+              col - col % kEltsPerReg + stored_lane[col % kEltsPerReg];
+          float value = kBits == 8 ? src[pos]
+                                   : (src[pos / 2] >> (4 * (pos % 2))) & 15;
+          w[row * cols + i] = scale[col] * (value - ZeroPoint<kBits>());
+        }
+      }
+      blas.GEMM(false,
+                false,
+                m,
+                cols,
+                k,
+                1.f,
+                x,
+                k,
+                w,
+                cols,
+                0.f,
+                out + col_begin,
+                n);
+    }
+    return;
+  }
+
+  // the activations in the decoded order of the weights
+  std::vector<int64_t> rows(k);
+  for (int64_t t = 0; t < k / kChunkRows; ++t) {
+    for (int q = 0; q < kChunkRows; ++q) {
+      rows[t * kChunkRows + q] = DecodedRow<kBits>(t, q);
+    }
+  }
+  DenseTensor permuted_x;
+  permuted_x.Resize({m, k});
+  float* xp = dev_ctx.template Alloc<float>(&permuted_x);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t r = 0; r < m; ++r) {
+    for (int64_t j = 0; j < k; ++j) {
+      xp[r * k + j] = x[r * k + rows[j]];
+    }
+  }
+
+  if (m <= kMaxGemvRows) {
+    GemvFunc gemv = SelectGemv<kBits>(m);
+    const int64_t block_num = (n + kGemvBlockCols - 1) / kGemvBlockCols;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int64_t block = 0; block < block_num; ++block) {
+      int64_t begin = block * kGemvBlockCols;
+      gemv(args, xp, out, begin, std::min(begin + kGemvBlockCols, n));
+    }
+    return;
+  }
+
+  // the tiles are [tile_cols, k], in the decoded order
+  DequantFunc dequant = SelectDequant<kBits>();
+  tiles.Resize({nth, tile_cols * k});
+  float* tiles_data = dev_ctx.template Alloc<float>(&tiles);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t tile = 0; tile < tile_num; ++tile) {
+#ifdef PADDLE_WITH_MKLML
+    int tid = omp_get_thread_num();
+#else
+    int tid = 0;
+#endif
+    float* w = tiles_data + tid * tile_cols * k;
+    int64_t col_begin = tile * tile_cols;
+    int64_t cols = std::min(tile_cols, n - col_begin);
+    for (int64_t i = 0; i < cols; ++i) {
+      dequant(args, col_begin + i, w + i * k);
+    }
+    blas.GEMM(false,
+              true,
+              m,
+              cols,
+              k,
+              1.f,
+              xp,
+              k,
+              w,
+              k,
+              0.f,
+              out + col_begin,
+              n);
+  }
+}
+
+}  // namespace
+
+template <typename T, typename Context>
+void WeightOnlyLinearKernel(const Context& dev_ctx,
+                            const DenseTensor& x,
+                            const DenseTensor& weight,
+                            const paddle::optional<DenseTensor>& bias,
+                            const DenseTensor& weight_scale,
+                            const std::string& weight_dtype,
+                            const int32_t arch,
+                            const int32_t group_size,
+                            DenseTensor* out) {
+  PADDLE_ENFORCE_EQ(
+      ((arch == 80) || (arch == 70) || (arch == 75) || (arch == 86)),
+      true,
+      phi::errors::InvalidArgument(
+          "Currently, arch only support 70, 75, 80, 86, but got %d.", arch));
+  PADDLE_ENFORCE_EQ(
+      ((weight_dtype == "int8") || (weight_dtype == "int4")),
+      true,
+      phi::errors::InvalidArgument(
+          "The weight_dtype must be int8 or int4, but got %s.", weight_dtype));
+
+  T* out_data = dev_ctx.template Alloc<T>(out);
+  const auto w_dims = weight.dims();
+  int64_t n = group_size > 0 ? weight_scale.dims()[1] : weight_scale.dims()[0];
+  int64_t k = w_dims[1];
+  int64_t m = k > 0 ? x.numel() / k : 0;
+  PADDLE_ENFORCE_EQ(
+      k % kChunkRows,
+      0,
+      phi::errors::InvalidArgument(
+          "The second dimension of weight must be divisible by %d on CPU, "
+          "but got %d.",
+          kChunkRows,
+          k));
+  if (m == 0 || n == 0) {
+    return;
+  }
+
+  std::vector<float> scale(weight_scale.numel());
+  const T* weight_scale_data = weight_scale.data<T>();
+  for (size_t i = 0; i < scale.size(); ++i) {
+    scale[i] = static_cast<float>(weight_scale_data[i]);
+  }
+  WeightOnlyArgs args;
+  args.weight = reinterpret_cast<const uint8_t*>(weight.data<int8_t>());
+  args.scale = scale.data();
+  args.n = n;
+  args.k = k;
+  args.group_size = group_size > 0 ? group_size : k;
+
+  const float* x_data = nullptr;
+  float* out_float = nullptr;
+  DenseTensor x_float;
+  DenseTensor out_buffer;
+  if (std::is_same<T, float>::value) {
+    x_data = reinterpret_cast<const float*>(x.data<T>());
+    out_float = reinterpret_cast<float*>(out_data);
+  } else {
+    x_float.Resize({m, k});
+    float* x_float_data = dev_ctx.template Alloc<float>(&x_float);
+    const T* x_src = x.data<T>();
+    for (int64_t i = 0; i < m * k; ++i) {
+      x_float_data[i] = static_cast<float>(x_src[i]);
+    }
+    x_data = x_float_data;
+    out_buffer.Resize({m, n});
+    out_float = dev_ctx.template Alloc<float>(&out_buffer);
+  }
+
+  if (weight_dtype == "int8") {
+    WeightOnlyMatmul<8>(dev_ctx, args, x_data, m, arch, out_float);
+  } else {
+    WeightOnlyMatmul<4>(dev_ctx, args, x_data, m, arch, out_float);
+  }
+
+  const T* bias_data = bias ? bias.get().data<T>() : nullptr;
+  if (bias_data || !std::is_same<T, float>::value) {
+    for (int64_t r = 0; r < m; ++r) {
+      for (int64_t j = 0; j < n; ++j) {
+        float value = out_float[r * n + j];
+        if (bias_data) {
+          value += static_cast<float>(bias_data[j]);
+        }
+        out_data[r * n + j] = static_cast<T>(value);
+      }
+    }
+  }
+}
+
+}  // namespace phi
+
+PD_REGISTER_KERNEL(weight_only_linear,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::WeightOnlyLinearKernel,
+                   float,
+                   phi::dtype::bfloat16) {}
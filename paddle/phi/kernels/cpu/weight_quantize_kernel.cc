@@ -151,5 +151,6 @@ PD_REGISTER_KERNEL(weight_quantize,
                    CPU,
                    ALL_LAYOUT,
                    phi::WeightQuantizeKernel,
+                   float,
                    phi::dtype::float16,
                    phi::dtype::bfloat16) {}
@@ -0,0 +1,509 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "paddle/common/ddim.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/core/sparse_coo_tensor.h"
+#include "paddle/phi/core/sparse_csr_tensor.h"
+#include "paddle/phi/core/visit_type.h"
+
+namespace phi {
+namespace funcs {
+namespace sparse {
+namespace detail {
+
+// The bytes of the columns of B read by a block of SPMM, which are reused by
+// all the rows of the block.
+constexpr int64_t kSpmmBlockBytes = 256 * 1024;
+// The rows are split into chunks of at least this cost, in multiply-adds,
+// and at most kMaxRowChunks chunks, which the threads take dynamically.
+constexpr int64_t kMinRowChunkCost = 16 * 1024;
+constexpr int64_t kMaxRowChunks = 512;
+
+// A batch of sparse matrices in CSR layout, built from a CSR or COO tensor,
+// maybe transposed. The rows of all the batches are numbered together: the
+// entries of row i of batch b are [Begin(g), Begin(g + 1)) where
+// g = b * rows + i, their columns are cols[e] and their values are
+// values[pos[e]], or values[e] if pos is nullptr.
+template <typename IntT>
+struct CsrLayout {
+  int64_t batch_size = 1;
+  int64_t rows = 0;
+  int64_t cols = 0;
+  // batch_size * (rows + 1) offsets, from 0 in each batch
+  const IntT* crows = nullptr;
+  const IntT* cols_data = nullptr;
+  const int64_t* pos = nullptr;
+  // the first entry of each batch
+  std::vector<int64_t> batch_offsets;
+
+  std::vector<IntT> crows_buffer;
+  std::vector<IntT> cols_buffer;
+  std::vector<int64_t> pos_buffer;
+
+  int64_t Begin(int64_t g) const {
+    int64_t b = g / rows;
+    int64_t i = g - b * rows;
+    if (b == batch_size) {
+      return batch_offsets[b];
+    }
+    return batch_offsets[b] + static_cast<int64_t>(crows[b * (rows + 1) + i]);
+  }
+  int64_t Pos(int64_t e) const { return pos == nullptr ? e : pos[e]; }
+};
+
+inline int64_t GetBatchSize(const std::vector<int64_t>& dims) {
+  int64_t batch_size = 1;
+  for (size_t i = 0; i + 2 < dims.size(); ++i) {
+    batch_size *= dims[i];
+  }
+  return batch_size;
+}
+
+// Builds the layout of rows x cols matrices from the entries given by
+// for_each_entry(fn), which calls fn(pos, batch, row, col) for each entry,
+// by a counting sort on the rows.
+template <typename IntT, typename ForEachEntry>
+void BuildCsrLayout(int64_t batch_size,
+                    int64_t rows,
+                    int64_t cols,
+                    int64_t nnz,
+                    ForEachEntry for_each_entry,
+                    CsrLayout<IntT>* layout) {
+  layout->batch_size = batch_size;
+  layout->rows = rows;
+  layout->cols = cols;
+  std::vector<int64_t> next(batch_size * rows + 1, 0);
+  for_each_entry([&](int64_t, int64_t b, int64_t i, int64_t) {
+    ++next[b * rows + i + 1];
+  });
+  for (size_t g = 1; g < next.size(); ++g) {
+    next[g] += next[g - 1];
+  }
+  layout->batch_offsets.resize(batch_size + 1);
+  layout->crows_buffer.resize(batch_size * (rows + 1));
+  for (int64_t b = 0; b <= batch_size; ++b) {
+    layout->batch_offsets[b] = next[b * rows];
+  }
+  for (int64_t b = 0; b < batch_size; ++b) {
+    for (int64_t i = 0; i <= rows; ++i) {
+      layout->crows_buffer[b * (rows + 1) + i] =
+          static_cast<IntT>(next[b * rows + i] - next[b * rows]);
+    }
+  }
+  layout->cols_buffer.resize(nnz);
+  layout->pos_buffer.resize(nnz);
+  for_each_entry([&](int64_t pos, int64_t b, int64_t i, int64_t j) {
+    int64_t e = next[b * rows + i]++;
+    layout->cols_buffer[e] = static_cast<IntT>(j);
+    layout->pos_buffer[e] = pos;
+  });
+  layout->crows = layout->crows_buffer.data();
+  layout->cols_data = layout->cols_buffer.data();
+  layout->pos = layout->pos_buffer.data();
+}
+
+template <typename IntT>
+void BuildCsrLayout(const SparseCsrTensor& x,
+                    bool trans,
+                    CsrLayout<IntT>* layout) {
+  std::vector<int64_t> x_dims = common::vectorize(x.dims());
+  PADDLE_ENFORCE_GE(
+      x_dims.size(),
+      2,
+      phi::errors::InvalidArgument("the dim size of SparseCsrTensor must be "
+                                   "greater than or equal to 2."));
+  int64_t batch_size = GetBatchSize(x_dims);
+  int64_t rows = x_dims[x_dims.size() - 2];
+  int64_t cols = x_dims[x_dims.size() - 1];
+  PADDLE_ENFORCE_EQ(x.non_zero_crows().numel(),
+                    batch_size * (rows + 1),
+                    phi::errors::PreconditionNotMet(
+                        "the length of SparseCsrTensor crows is not right."));
+  const IntT* crows = x.non_zero_crows().data<IntT>();
+  const IntT* x_cols = x.non_zero_cols().data<IntT>();
+  std::vector<int64_t> batch_offsets(batch_size + 1, 0);
+  for (int64_t b = 0; b < batch_size; ++b) {
+    batch_offsets[b + 1] = batch_offsets[b] + crows[b * (rows + 1) + rows];
+  }
+  if (!trans) {
+    layout->batch_size = batch_size;
+    layout->rows = rows;
+    layout->cols = cols;
+    layout->crows = crows;
+    layout->cols_data = x_cols;
+    layout->pos = nullptr;
+    layout->batch_offsets = std::move(batch_offsets);
+    return;
+  }
+  BuildCsrLayout<IntT>(
+      batch_size,
+      cols,
+      rows,
+      x.nnz(),
+      [&](auto fn) {
+        for (int64_t b = 0; b < batch_size; ++b) {
+          const IntT* batch_crows = crows + b * (rows + 1);
+          for (int64_t i = 0; i < rows; ++i) {
+            for (int64_t e = batch_crows[i]; e < batch_crows[i + 1]; ++e) {
+              int64_t pos = batch_offsets[b] + e;
+              fn(pos, b, static_cast<int64_t>(x_cols[pos]), i);
+            }
+          }
+        }
+      },
+      layout);
+}
+
+template <typename IntT>
+void BuildCsrLayout(const SparseCooTensor& x,
+                    bool trans,
+                    CsrLayout<IntT>* layout) {
+  std::vector<int64_t> x_dims = common::vectorize(x.dims());
+  int64_t ndims = static_cast<int64_t>(x_dims.size());
+  PADDLE_ENFORCE_GE(
+      ndims,
+      2,
+      phi::errors::InvalidArgument("the dim size of SparseCooTensor must be "
+                                   "greater than or equal to 2."));
+  PADDLE_ENFORCE_EQ(x.sparse_dim(),
+                    ndims,
+                    phi::errors::InvalidArgument(
+                        "the SparseCooTensor of a sparse matmul must not have "
+                        "dense dims."));
+  int64_t batch_size = GetBatchSize(x_dims);
+  int64_t rows = x_dims[ndims - 2];
+  int64_t cols = x_dims[ndims - 1];
+  int64_t nnz = x.nnz();
+  const IntT* indices = x.non_zero_indices().data<IntT>();
+  auto for_each_entry = [&](auto fn) {
+    for (int64_t e = 0; e < nnz; ++e) {
+      int64_t b = 0;
+      for (int64_t d = 0; d < ndims - 2; ++d) {
+        b = b * x_dims[d] + static_cast<int64_t>(indices[d * nnz + e]);
+      }
+      int64_t i = indices[(ndims - 2) * nnz + e];
+      int64_t j = indices[(ndims - 1) * nnz + e];
+      if (trans) {
+        fn(e, b, j, i);
+      } else {
+        fn(e, b, i, j);
+      }
+    }
+  };
+  if (trans) {
+    BuildCsrLayout<IntT>(batch_size, cols, rows, nnz, for_each_entry, layout);
+  } else {
+    BuildCsrLayout<IntT>(batch_size, rows, cols, nnz, for_each_entry, layout);
+  }
+}
+
+inline DataType GetIndexType(const SparseCsrTensor& x) {
+  return x.non_zero_crows().dtype();
+}
+
+inline DataType GetIndexType(const SparseCooTensor& x) {
+  return x.non_zero_indices().dtype();
+}
+
+// Splits the rows of all the batches into chunks of about the same cost,
+// where a row costs row_cost plus entry_cost per entry. Returns the first
+// row of each chunk, followed by the number of rows.
+template <typename IntT>
+std::vector<int64_t> SplitRows(const CsrLayout<IntT>& layout,
+                               int64_t row_cost,
+                               int64_t entry_cost) {
+  int64_t row_num = layout.batch_size * layout.rows;
+  int64_t total_cost =
+      row_num * row_cost + layout.batch_offsets.back() * entry_cost;
+  int64_t chunk_cost =
+      std::max(total_cost / kMaxRowChunks + 1, kMinRowChunkCost);
+  std::vector<int64_t> chunks = {0};
+  int64_t cost = 0;
+  for (int64_t g = 0; g < row_num; ++g) {
+    cost += row_cost + (layout.Begin(g + 1) - layout.Begin(g)) * entry_cost;
+    if (cost >= chunk_cost) {
+      chunks.push_back(g + 1);
+      cost = 0;
+    }
+  }
+  if (chunks.back() != row_num) {
+    chunks.push_back(row_num);
+  }
+  return chunks;
+}
+
+// out = alpha * a @ b + beta * out, where b holds batch_size (or 1 if not
+// b_batched) row-major a.cols x n matrices.
+template <typename T, typename IntT>
+void CsrSpmm(const CsrLayout<IntT>& a,
+             const T* a_values,
+             T alpha,
+             const T* b,
+             int64_t n,
+             bool b_batched,
+             T beta,
+             T* out) {
+  int64_t k = a.cols;
+  // the columns of b and out are taken in blocks, so that the part of b
+  // read by the rows of a chunk stays in the cache
+  int64_t block = n;
+  if (k * n * static_cast<int64_t>(sizeof(T)) > kSpmmBlockBytes) {
+    block = kSpmmBlockBytes / static_cast<int64_t>(sizeof(T)) /
+            std::max<int64_t>(k, 1);
+    block = std::min(n, std::max<int64_t>((block + 15) / 16 * 16, 64));
+  }
+  std::vector<int64_t> chunks = SplitRows(a, n, n);
+  int64_t chunk_num = static_cast<int64_t>(chunks.size()) - 1;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int64_t c = 0; c < chunk_num; ++c) {
+    for (int64_t n0 = 0; n0 < n; n0 += block) {
+      int64_t n1 = std::min(n, n0 + block);
+      for (int64_t g = chunks[c]; g < chunks[c + 1]; ++g) {
+        const T* b_batch = b_batched ? b + (g / a.rows) * k * n : b;
+        T* out_row = out + g * n;
+        if (beta == static_cast<T>(0)) {
+          std::fill(out_row + n0, out_row + n1, static_cast<T>(0));
+        } else if (beta != static_cast<T>(1)) {
+          for (int64_t j = n0; j < n1; ++j) {
+            out_row[j] *= beta;
+          }
+        }
+        int64_t end = a.Begin(g + 1);
+        for (int64_t e = a.Begin(g); e < end; ++e) {
+          T value = alpha * a_values[a.Pos(e)];
+          const T* b_row = b_batch + static_cast<int64_t>(a.cols_data[e]) * n;
+          for (int64_t j = n0; j < n1; ++j) {
+            out_row[j] += value * b_row[j];
+          }
+        }
+      }
+    }
+  }
+}
+
+// values = alpha * (a @ bt') * mask + beta * values, where a holds row-major
+// mask.rows x k matrices, bt row-major mask.cols x k ones.
+template <typename T, typename IntT>
+void CsrSddmm(const CsrLayout<IntT>& mask,
+              T alpha,
+              const T* a,
+              const T* bt,
+              int64_t k,
+              T beta,
+              T* values) {
+  std::vector<int64_t> chunks = SplitRows(mask, 0, k);
+  int64_t chunk_num = static_cast<int64_t>(chunks.size()) - 1;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int64_t c = 0; c < chunk_num; ++c) {
+    for (int64_t g = chunks[c]; g < chunks[c + 1]; ++g) {
+      int64_t batch = g / mask.rows;
+      const T* a_row = a + g * k;
+      const T* bt_batch = bt + batch * mask.cols * k;
+      int64_t end = mask.Begin(g + 1);
+      for (int64_t e = mask.Begin(g); e < end; ++e) {
+        const T* bt_row =
+            bt_batch + static_cast<int64_t>(mask.cols_data[e]) * k;
+        T sum = static_cast<T>(0);
+        for (int64_t j = 0; j < k; ++j) {
+          sum += a_row[j] * bt_row[j];
+        }
+        T& value = values[mask.Pos(e)];
+        value = beta == static_cast<T>(0) ? alpha * sum
+                                          : alpha * sum + beta * value;
+      }
+    }
+  }
+}
+
+// Transposes the last two dims of batch_size row-major rows x cols matrices.
+template <typename T>
+void TransposeLastTwoDims(
+    const T* x, int64_t batch_size, int64_t rows, int64_t cols, T* out) {
+  constexpr int64_t kTile = 32;
+  int64_t row_tiles = (rows + kTile - 1) / kTile;
+  int64_t tile_num = batch_size * row_tiles;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int64_t t = 0; t < tile_num; ++t) {
+    int64_t b = t / row_tiles;
+    int64_t i0 = (t % row_tiles) * kTile;
+    int64_t i1 = std::min(rows, i0 + kTile);
+    const T* x_batch = x + b * rows * cols;
+    T* out_batch = out + b * rows * cols;
+    for (int64_t j0 = 0; j0 < cols; j0 += kTile) {
+      int64_t j1 = std::min(cols, j0 + kTile);
+      for (int64_t i = i0; i < i1; ++i) {
+        for (int64_t j = j0; j < j1; ++j) {
+          out_batch[j * rows + i] = x_batch[i * cols + j];
+        }
+      }
+    }
+  }
+}
+
+}  // namespace detail
+
+/************* SPARSE*DENSE->DENSE MATMUL ************/
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SPMM(bool transa,
+                                       bool transb,
+                                       T alpha,
+                                       const TensorType& mat_a,
+                                       const phi::DenseTensor& mat_b,
+                                       T beta,
+                                       phi::DenseTensor* mat_out) const {
+  PD_VISIT_BASE_INTEGRAL_TYPES(
+      detail::GetIndexType(mat_a), "SparseBlas<CPUContext>::SPMM", ([&] {
+        detail::CsrLayout<data_t> layout;
+        detail::BuildCsrLayout(mat_a, transa, &layout);
+        int64_t k = layout.cols;
+        int64_t n = mat_out->dims()[mat_out->dims().size() - 1];
+        bool b_batched = mat_b.numel() != k * n;
+        PADDLE_ENFORCE_EQ(
+            mat_b.numel(),
+            (b_batched ? layout.batch_size : 1) * k * n,
+            phi::errors::InvalidArgument(
+                "The shape of the dense matrix of SPMM is not right."));
+        PADDLE_ENFORCE_EQ(
+            mat_out->numel(),
+            layout.batch_size * layout.rows * n,
+            phi::errors::InvalidArgument(
+                "The shape of the output of SPMM is not right."));
+
+        const T* b_data = mat_b.data<T>();
+        std::vector<T> trans_b;
+        if (transb) {
+          trans_b.resize(mat_b.numel());
+          detail::TransposeLastTwoDims(b_data,
+                                       b_batched ? layout.batch_size : 1,
+                                       n,
+                                       k,
+                                       trans_b.data());
+          b_data = trans_b.data();
+        }
+        detail::CsrSpmm(layout,
+                        mat_a.non_zero_elements().template data<T>(),
+                        alpha,
+                        b_data,
+                        n,
+                        b_batched,
+                        beta,
+                        mat_out->data<T>());
+      }));
+}
+
+/************* SPARSE*DENSE->DENSE MV ************/
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SPMV(bool transa,
+                                       T alpha,
+                                       const TensorType& mat_a,
+                                       const phi::DenseTensor& vec_x,
+                                       T beta,
+                                       phi::DenseTensor* vec_out) const {
+  PD_VISIT_BASE_INTEGRAL_TYPES(
+      detail::GetIndexType(mat_a), "SparseBlas<CPUContext>::SPMV", ([&] {
+        detail::CsrLayout<data_t> layout;
+        detail::BuildCsrLayout(mat_a, transa, &layout);
+        PADDLE_ENFORCE_EQ(
+            vec_x.numel(),
+            layout.cols,
+            phi::errors::InvalidArgument(
+                "The size of the vector of SPMV is not right."));
+        PADDLE_ENFORCE_EQ(
+            vec_out->numel(),
+            layout.batch_size * layout.rows,
+            phi::errors::InvalidArgument(
+                "The size of the output of SPMV is not right."));
+        detail::CsrSpmm(layout,
+                        mat_a.non_zero_elements().template data<T>(),
+                        alpha,
+                        vec_x.data<T>(),
+                        1,
+                        false,
+                        beta,
+                        vec_out->data<T>());
+      }));
+}
+
+/************* DENSE*DENSE->SPARSE MATMUL ************/
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SDDMM(bool transa,
+                                        bool transb,
+                                        T alpha,
+                                        const phi::DenseTensor& mat_a,
+                                        const phi::DenseTensor& mat_b,
+                                        T beta,
+                                        TensorType* mat_out) const {
+  PD_VISIT_BASE_INTEGRAL_TYPES(
+      detail::GetIndexType(*mat_out), "SparseBlas<CPUContext>::SDDMM", ([&] {
+        detail::CsrLayout<data_t> layout;
+        detail::BuildCsrLayout(*mat_out, false, &layout);
+        int64_t batch_size = layout.batch_size;
+        int64_t m = layout.rows;
+        int64_t n = layout.cols;
+        const DDim& a_dims = mat_a.dims();
+        int64_t k = a_dims[a_dims.size() - (transa ? 2 : 1)];
+        PADDLE_ENFORCE_EQ(
+            mat_a.numel(),
+            batch_size * m * k,
+            phi::errors::InvalidArgument(
+                "The shape of the first dense matrix of SDDMM is not right."));
+        PADDLE_ENFORCE_EQ(
+            mat_b.numel(),
+            batch_size * k * n,
+            phi::errors::InvalidArgument(
+                "The shape of the second dense matrix of SDDMM is not "
+                "right."));
+
+        // the dot products read the rows of a and the columns of b
+        const T* a_data = mat_a.data<T>();
+        std::vector<T> trans_a;
+        if (transa) {
+          trans_a.resize(mat_a.numel());
+          detail::TransposeLastTwoDims(
+              a_data, batch_size, k, m, trans_a.data());
+          a_data = trans_a.data();
+        }
+        const T* bt_data = mat_b.data<T>();
+        std::vector<T> trans_b;
+        if (!transb) {
+          trans_b.resize(mat_b.numel());
+          detail::TransposeLastTwoDims(
+              bt_data, batch_size, k, n, trans_b.data());
+          bt_data = trans_b.data();
+        }
+        T* values = mat_out->mutable_non_zero_elements()->template data<T>();
+        detail::CsrSddmm(layout, alpha, a_data, bt_data, k, beta, values);
+      }));
+}
+
+}  // namespace sparse
+}  // namespace funcs
+}  // namespace phi
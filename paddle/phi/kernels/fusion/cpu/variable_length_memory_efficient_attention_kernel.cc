@@ -0,0 +1,312 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/funcs/blas/blas.h"
+
+namespace phi {
+namespace fusion {
+
+namespace {
+
+// The queries and keys of a block, the scores of which stay in cache.
+constexpr int64_t kBlockQueries = 64;
+constexpr int64_t kBlockKeys = 256;
+
+template <typename T>
+const float* ToFloat(const T* src, int64_t n, float* buffer) {
+  if (std::is_same<T, float>::value) {
+    return reinterpret_cast<const float*>(src);
+  }
+  for (int64_t i = 0; i < n; ++i) {
+    buffer[i] = static_cast<float>(src[i]);
+  }
+  return buffer;
+}
+
+}  // namespace
+
+// Computes the attention by blocks of queries and keys with an online
+// softmax, so that the scores are never materialized for the whole
+// sequence. The i-th query of a sequence attends to the first
+// kv_seq_lens + pre_cache_length keys, the cache being in front of them. As
+// in the cutlass kernel, a causal mask is aligned to the first key: the i-th
+// query attends to the keys up to the i-th one.
+template <typename T, typename Context>
+void MultiHeadAttentionVariableForwardKernel(
+    const Context& ctx,
+    const DenseTensor& query,
+    const DenseTensor& key,
+    const DenseTensor& value,
+    const DenseTensor& seq_lens,
+    const DenseTensor& kv_seq_lens,
+    const paddle::optional<DenseTensor>& mask,
+    const float scale,
+    const bool causal,
+    const int pre_cache_length,
+    DenseTensor* output) {
+  T* out_data = ctx.template Alloc<T>(output);
+
+  const int64_t num_batches = query.dims()[0];
+  const int64_t num_heads = query.dims()[1];
+  const int64_t query_seq_len = query.dims()[2];
+  const int64_t head_size = query.dims()[3];
+  const int64_t kv_num_heads = key.dims()[1];
+  const int64_t kv_seq_len = key.dims()[2];
+  const int64_t value_head_size = value.dims()[3];
+  const int64_t qhead_per_kv_head = num_heads / kv_num_heads;
+
+  const int* seq_lens_data = seq_lens.data<int>();
+  const int* kv_seq_lens_data = kv_seq_lens.data<int>();
+  for (int64_t b = 0; b < num_batches; ++b) {
+    int64_t q_len = seq_lens_data[b];
+    int64_t kv_len =
+        q_len == 0 ? 0 : kv_seq_lens_data[b] + int64_t{pre_cache_length};
+    PADDLE_ENFORCE_EQ(
+        q_len >= 0 && q_len <= query_seq_len,
+        true,
+        phi::errors::InvalidArgument(
+            "The seq_lens[%d] should be in [0, %d], but received %d.",
+            b,
+            query_seq_len,
+            q_len));
+    PADDLE_ENFORCE_EQ(
+        kv_len >= 0 && kv_len <= kv_seq_len,
+        true,
+        phi::errors::InvalidArgument(
+            "The kv_seq_lens[%d] plus pre_cache_length should be in [0, %d], "
+            "but received %d.",
+            b,
+            kv_seq_len,
+            kv_len));
+  }
+
+  const T* mask_data = nullptr;
+  int64_t mask_num_heads = 0;
+  int64_t mask_rows = 0;
+  int64_t mask_cols = 0;
+  if (mask) {
+    const auto& mask_dims = mask.get().dims();
+    PADDLE_ENFORCE_EQ(
+        mask_dims.size() == 4 && mask_dims[0] == num_batches &&
+            (mask_dims[1] == 1 || mask_dims[1] == num_heads) &&
+            mask_dims[2] >= query_seq_len && mask_dims[3] >= kv_seq_len,
+        true,
+        phi::errors::InvalidArgument(
+            "The mask should be [batch_size, 1 or num_heads, query_seq_len, "
+            "key_seq_len], but received [%s].",
+            mask_dims));
+    mask_data = mask.get().data<T>();
+    mask_num_heads = mask_dims[1];
+    mask_rows = mask_dims[2];
+    mask_cols = mask_dims[3];
+  }
+
+#ifdef PADDLE_WITH_MKLML
+  int nth = omp_get_max_threads();
+#else
+  int nth = 1;
+#endif
+  // per thread: the queries, the scores, the output, the running max and sum
+  // of the rows, and the keys and values converted to float
+  const int64_t kv_buffer_size =
+      std::is_same<T, float>::value
+          ? 0
+          : kBlockKeys * (head_size + value_head_size);
+  const int64_t buffer_size =
+      kBlockQueries * (head_size + kBlockKeys + value_head_size + 2) +
+      kv_buffer_size;
+  DenseTensor workspace;
+  workspace.Resize({nth, buffer_size});
+  float* workspace_data = ctx.template Alloc<float>(&workspace);
+  auto blas = phi::funcs::GetBlas<Context, float>(ctx);
+
+  const int64_t query_blocks =
+      (query_seq_len + kBlockQueries - 1) / kBlockQueries;
+  const int64_t task_num = num_batches * num_heads * query_blocks;
+  constexpr float kNegInf = -std::numeric_limits<float>::infinity();
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int64_t task = 0; task < task_num; ++task) {
+#ifdef PADDLE_WITH_MKLML
+    int tid = omp_get_thread_num();
+#else
+    int tid = 0;
+#endif
+    const int64_t b = task / (num_heads * query_blocks);
+    const int64_t h = task / query_blocks % num_heads;
+    const int64_t row_begin = task % query_blocks * kBlockQueries;
+    const int64_t rows = std::min(kBlockQueries, query_seq_len - row_begin);
+    const int64_t q_len = seq_lens_data[b];
+    const int64_t kv_len =
+        q_len == 0 ? 0 : kv_seq_lens_data[b] + int64_t{pre_cache_length};
+    const int64_t valid_rows =
+        std::max<int64_t>(std::min(q_len - row_begin, rows), 0);
+
+    T* out = out_data +
+             ((b * num_heads + h) * query_seq_len + row_begin) *
+                 value_head_size;
+    std::fill(out + valid_rows * value_head_size,
+              out + rows * value_head_size,
+              static_cast<T>(0));
+    if (valid_rows == 0) {
+      continue;
+    }
+
+    float* q_buffer = workspace_data + tid * buffer_size;
+    float* scores = q_buffer + kBlockQueries * head_size;
+    float* acc = scores + kBlockQueries * kBlockKeys;
+    float* row_max = acc + kBlockQueries * value_head_size;
+    float* row_sum = row_max + kBlockQueries;
+    float* k_buffer = row_sum + kBlockQueries;
+    float* v_buffer = k_buffer + kBlockKeys * head_size;
+
+    const int64_t kv_head = h / qhead_per_kv_head;
+    const T* q = query.data<T>() +
+                 ((b * num_heads + h) * query_seq_len + row_begin) * head_size;
+    const T* k =
+        key.data<T>() + (b * kv_num_heads + kv_head) * kv_seq_len * head_size;
+    const T* v = value.data<T>() +
+                 (b * kv_num_heads + kv_head) * kv_seq_len * value_head_size;
+    const T* mask_block =
+        mask_data ? mask_data + ((b * mask_num_heads +
+                                  (mask_num_heads == 1 ? 0 : h)) *
+                                     mask_rows +
+                                 row_begin) *
+                                    mask_cols
+                  : nullptr;
+    const float* q_float = ToFloat(q, valid_rows * head_size, q_buffer);
+
+    // the keys after the last query of the block are all masked, if causal
+    int64_t key_end = kv_len;
+    if (causal) {
+      key_end = std::min(key_end, row_begin + valid_rows);
+    }
+    std::fill(row_max, row_max + valid_rows, kNegInf);
+    std::fill(row_sum, row_sum + valid_rows, 0.f);
+    std::fill(acc, acc + valid_rows * value_head_size, 0.f);
+
+    for (int64_t col_begin = 0; col_begin < key_end; col_begin += kBlockKeys) {
+      const int64_t cols = std::min(kBlockKeys, key_end - col_begin);
+      const float* k_float =
+          ToFloat(k + col_begin * head_size, cols * head_size, k_buffer);
+      const float* v_float = ToFloat(
+          v + col_begin * value_head_size, cols * value_head_size, v_buffer);
+      blas.GEMM(false,
+                true,
+                valid_rows,
+                cols,
+                head_size,
+                scale,
+                q_float,
+                head_size,
+                k_float,
+                head_size,
+                0.f,
+                scores,
+                cols);
+
+      for (int64_t r = 0; r < valid_rows; ++r) {
+        float* s = scores + r * cols;
+        if (mask_block) {
+          const T* m = mask_block + r * mask_cols + col_begin;
+          for (int64_t c = 0; c < cols; ++c) {
+            s[c] += static_cast<float>(m[c]);
+          }
+        }
+        if (causal) {
+          int64_t visible = row_begin + r + 1 - col_begin;
+          for (int64_t c = std::max<int64_t>(visible, 0); c < cols; ++c) {
+            s[c] = kNegInf;
+          }
+        }
+        float new_max = row_max[r];
+        for (int64_t c = 0; c < cols; ++c) {
+          new_max = std::max(new_max, s[c]);
+        }
+        if (new_max == kNegInf) {
+          // no key is visible yet
+          std::fill(s, s + cols, kNegInf);
+          continue;
+        }
+        float correction = std::exp(row_max[r] - new_max);
+        row_max[r] = new_max;
+        row_sum[r] *= correction;
+        float* a = acc + r * value_head_size;
+        for (int64_t d = 0; d < value_head_size; ++d) {
+          a[d] *= correction;
+        }
+        for (int64_t c = 0; c < cols; ++c) {
+          s[c] -= new_max;
+        }
+      }
+      blas.VEXP(valid_rows * cols, scores, scores);
+      for (int64_t r = 0; r < valid_rows; ++r) {
+        const float* s = scores + r * cols;
+        float sum = 0.f;
+        for (int64_t c = 0; c < cols; ++c) {
+          sum += s[c];
+        }
+        row_sum[r] += sum;
+      }
+      blas.GEMM(false,
+                false,
+                valid_rows,
+                value_head_size,
+                cols,
+                1.f,
+                scores,
+                cols,
+                v_float,
+                value_head_size,
+                1.f,
+                acc,
+                value_head_size);
+    }
+
+    for (int64_t r = 0; r < valid_rows; ++r) {
+      // a query which sees no key gets zeros
+      float inv_sum = row_sum[r] > 0.f ? 1.f / row_sum[r] : 0.f;
+      for (int64_t d = 0; d < value_head_size; ++d) {
+        out[r * value_head_size + d] =
+            static_cast<T>(acc[r * value_head_size + d] * inv_sum);
+      }
+    }
+  }
+}
+
+}  // namespace fusion
+}  // namespace phi
+
+PD_REGISTER_KERNEL(variable_length_memory_efficient_attention,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::fusion::MultiHeadAttentionVariableForwardKernel,
+                   float,
+                   phi::dtype::bfloat16) {
+  kernel->InputAt(3).SetDataType(phi::DataType::INT32);
+  kernel->InputAt(4).SetDataType(phi::DataType::INT32);
+}
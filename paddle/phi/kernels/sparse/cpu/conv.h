@@ -14,7 +14,9 @@ limitations under the License. */
 
 #pragma once
 
-#include <set>
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/core/kernel_registry.h"
@@ -28,9 +30,62 @@ namespace sparse {
 
 using Dims4D = phi::funcs::sparse::Dims4D;
 
+// The rulebook is built by tasks of a kernel offset and a chunk of the
+// non zero elements of this size, which the threads take in parallel.
+constexpr int64_t kRulebookChunkSize = 4096;
+
+// An open addressing hash set of the indices of the non zero elements,
+// which is only read once built, so that the threads look up in parallel.
+template <typename IntT>
+class IndexHashSet {
+ public:
+  explicit IndexHashSet(int64_t size) {
+    int64_t capacity = 16;
+    while (capacity < size * 2) {
+      capacity <<= 1;
+    }
+    mask_ = capacity - 1;
+    slots_.assign(capacity, static_cast<IntT>(-1));
+  }
+
+  void Insert(IntT key) {
+    for (int64_t s = Slot(key);; s = (s + 1) & mask_) {
+      if (slots_[s] == key) {
+        return;
+      }
+      if (slots_[s] < 0) {
+        slots_[s] = key;
+        return;
+      }
+    }
+  }
+
+  bool Contains(IntT key) const {
+    for (int64_t s = Slot(key);; s = (s + 1) & mask_) {
+      if (slots_[s] == key) {
+        return true;
+      }
+      if (slots_[s] < 0) {
+        return false;
+      }
+    }
+  }
+
+ private:
+  int64_t Slot(IntT key) const {
+    uint64_t h = static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<int64_t>(h ^ (h >> 32)) & mask_;
+  }
+
+  int64_t mask_;
+  // the indices are not negative, -1 marks an empty slot
+  std::vector<IntT> slots_;
+};
+
 // such as: kernel(3, 3, 3), kernel_size = 27
 // counter_per_weight: (kernel_size)
-// TODO(zhangkaihuo): optimize performance with multithreading
+// The rulebook is sorted by kernel offset, then by input, whatever the
+// number of threads.
 template <typename T, typename Context, typename IntT = int>
 void ProductRuleBook(const Context& dev_ctx,
                      const SparseCooTensor& x,
@@ -48,10 +103,7 @@ void ProductRuleBook(const Context& dev_ctx,
   const IntT* indices_ptr = indices.data<IntT>();
   int kernel_size = is2D ? kernel_sizes[0] * kernel_sizes[1]
                          : kernel_sizes[0] * kernel_sizes[1] * kernel_sizes[2];
-  memset(counter_per_kernel, 0, kernel_size * sizeof(int));
 
-  int rulebook_len = 0;
-  // calc the rulebook_len
   const auto& x_dims = x.dims();
 
   int xdim0, xdim1, xdim2, xdim3;
@@ -98,7 +150,7 @@ void ProductRuleBook(const Context& dev_ctx,
   const Dims4D c_strides(sdim0, sdim1, sdim2, sdim3);
   const Dims4D c_dilations(ddim0, ddim1, ddim2, ddim3);
 
-  std::set<IntT> hash_in;
+  IndexHashSet<IntT> hash_in(subm ? non_zero_num : 0);
   if (subm) {
     for (int i = 0; i < non_zero_num; i++) {
       IntT batch = indices_ptr[i];
@@ -109,79 +161,126 @@ void ProductRuleBook(const Context& dev_ctx,
                        : indices_ptr[i + 3 * non_zero_num];
       IntT index = phi::funcs::sparse::PointToIndex<Dims4D>(
           batch, in_x, in_y, in_z, c_x_dims);
-      hash_in.insert(index);
+      hash_in.Insert(index);
     }
   }
 
-  auto f_calc_rulebook = [&](IntT* rulebook_ptr) {
-    int kernel_index = 0, rulebook_index = 0;
-    int zceil = is2D ? 1 : kernel_sizes[0];
-    int yceil = is2D ? kernel_sizes[0] : kernel_sizes[1];
-    int xceil = is2D ? kernel_sizes[1] : kernel_sizes[2];
-    for (int kz = 0; kz < zceil; kz++) {
-      for (int ky = 0; ky < yceil; ky++) {
-        for (int kx = 0; kx < xceil; kx++) {
-          ++kernel_index;
-          for (int64_t i = 0; i < non_zero_num; i++) {
-            IntT batch = indices_ptr[i];
-            IntT in_z = is2D ? 0 : indices_ptr[i + non_zero_num];
-            IntT in_y = is2D ? indices_ptr[i + non_zero_num]
-                             : indices_ptr[i + 2 * non_zero_num];
-            IntT in_x = is2D ? indices_ptr[i + 2 * non_zero_num]
-                             : indices_ptr[i + 3 * non_zero_num];
-
-            IntT out_z =
-                is2D ? 0
-                     : (in_z + paddings[0] - kz * dilations[0]) / strides[0];
-            IntT out_y =
-                (in_y + c_paddings[2] - ky * c_dilations[2]) / c_strides[2];
-            IntT out_x =
-                (in_x + c_paddings[3] - kx * c_dilations[3]) / c_strides[3];
-            if (phi::funcs::sparse::Check(c_x_dims,
-                                          c_kernel_dims,
-                                          c_paddings,
-                                          c_dilations,
-                                          c_strides,
-                                          in_x,
-                                          in_y,
-                                          in_z,
-                                          kx,
-                                          ky,
-                                          kz)) {
-              if (subm) {
-                IntT out_index = phi::funcs::sparse::PointToIndex<Dims4D>(
-                    batch, out_x, out_y, out_z, c_out_dims);
-                if (hash_in.find(out_index) == hash_in.end()) {
-                  continue;
-                }
-              }
-
-              if (rulebook_ptr == nullptr) {
-                counter_per_kernel[kernel_index - 1] += 1;
-                ++rulebook_len;
-              } else {
-                rulebook_ptr[rulebook_index] = kernel_index - 1;
-                rulebook_ptr[rulebook_index + rulebook_len] = i;  // in_i
-                rulebook_ptr[rulebook_index + rulebook_len * 2] =
-                    phi::funcs::sparse::PointToIndex<Dims4D>(
-                        batch, out_x, out_y, out_z, c_out_dims);  // out_index
-                ++rulebook_index;
-              }
-            }
-          }
-        }
+  const int yceil = is2D ? kernel_sizes[0] : kernel_sizes[1];
+  const int xceil = is2D ? kernel_sizes[1] : kernel_sizes[2];
+  const int64_t chunk_num =
+      (non_zero_num + kRulebookChunkSize - 1) / kRulebookChunkSize;
+  const int64_t task_num = kernel_size * chunk_num;
+
+  // The input in of an axis has the output (in + offset) / stride by the
+  // kernel offset, if in + offset >= 0, the stride divides it and
+  // in + upper_offset < dim, which is phi::funcs::sparse::Check.
+  struct AxisRule {
+    IntT offset;
+    IntT upper_offset;
+    int stride;
+    int dim;
+  };
+  // axis is that of Dims4D
+  auto f_axis_rule = [&](int axis, int k) {
+    AxisRule rule;
+    rule.offset = c_paddings[axis] - k * c_dilations[axis];
+    rule.upper_offset = (c_kernel_dims[axis] - k - 1) * c_dilations[axis] -
+                        c_paddings[axis];
+    rule.stride = c_strides[axis];
+    rule.dim = c_x_dims[axis];
+    return rule;
+  };
+  auto f_out_coord = [](const AxisRule& rule, IntT in, IntT* out) {
+    IntT lower = in + rule.offset;
+    if (lower < 0 || in + rule.upper_offset >= rule.dim) {
+      return false;
+    }
+    if (rule.stride == 1) {
+      *out = lower;
+      return true;
+    }
+    if (lower % rule.stride != 0) {
+      return false;
+    }
+    *out = lower / rule.stride;
+    return true;
+  };
+
+  // calls fn(in_i, out_index) for each pair of the task, in order
+  auto f_visit_rulebook = [&](int64_t task, auto&& fn) {
+    const int kernel_index = static_cast<int>(task / chunk_num);
+    const int kx = kernel_index % xceil;
+    const int ky = kernel_index / xceil % yceil;
+    const int kz = kernel_index / xceil / yceil;
+    const AxisRule z_rule = f_axis_rule(1, kz);
+    const AxisRule y_rule = f_axis_rule(2, ky);
+    const AxisRule x_rule = f_axis_rule(3, kx);
+    const int64_t begin = task % chunk_num * kRulebookChunkSize;
+    const int64_t end = std::min(non_zero_num, begin + kRulebookChunkSize);
+    for (int64_t i = begin; i < end; i++) {
+      IntT batch = indices_ptr[i];
+      IntT in_z = is2D ? 0 : indices_ptr[i + non_zero_num];
+      IntT in_y = is2D ? indices_ptr[i + non_zero_num]
+                       : indices_ptr[i + 2 * non_zero_num];
+      IntT in_x = is2D ? indices_ptr[i + 2 * non_zero_num]
+                       : indices_ptr[i + 3 * non_zero_num];
+
+      IntT out_z = 0, out_y, out_x;
+      if ((!is2D && !f_out_coord(z_rule, in_z, &out_z)) ||
+          !f_out_coord(y_rule, in_y, &out_y) ||
+          !f_out_coord(x_rule, in_x, &out_x)) {
+        continue;
       }
+      IntT out_index = phi::funcs::sparse::PointToIndex<Dims4D>(
+          batch, out_x, out_y, out_z, c_out_dims);
+      if (subm && !hash_in.Contains(out_index)) {
+        continue;
+      }
+      fn(i, out_index);
     }
   };
 
-  f_calc_rulebook(nullptr);
+  // the pairs of each task are kept, then copied from their offsets
+  std::vector<std::vector<std::pair<IntT, IntT>>> task_pairs(task_num);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int64_t task = 0; task < task_num; task++) {
+    auto* pairs = &task_pairs[task];
+    f_visit_rulebook(task, [&](int64_t i, IntT out_index) {
+      pairs->emplace_back(static_cast<IntT>(i), out_index);
+    });
+  }
+  std::vector<int64_t> task_offsets(task_num + 1, 0);
+  for (int64_t task = 0; task < task_num; task++) {
+    task_offsets[task + 1] = task_offsets[task] + task_pairs[task].size();
+  }
+  for (int i = 0; i < kernel_size; i++) {
+    counter_per_kernel[i] = static_cast<int>(task_offsets[(i + 1) * chunk_num] -
+                                             task_offsets[i * chunk_num]);
+  }
+  const int64_t rulebook_len = task_offsets[task_num];
+
   // alloc the rulebook
   *rulebook = phi::Empty(dev_ctx,
                          DenseTensorMeta(phi::CppTypeToDataType<IntT>::Type(),
                                          {3, rulebook_len},
                                          DataLayout::NCHW));
   IntT* rulebook_ptr = rulebook->data<IntT>();
-  f_calc_rulebook(rulebook_ptr);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int64_t task = 0; task < task_num; task++) {
+    const IntT kernel_index = static_cast<IntT>(task / chunk_num);
+    int64_t rulebook_index = task_offsets[task];
+    for (const auto& pair : task_pairs[task]) {
+      rulebook_ptr[rulebook_index] = kernel_index;
+      rulebook_ptr[rulebook_index + rulebook_len] = pair.first;  // in_i
+      rulebook_ptr[rulebook_index + rulebook_len * 2] = pair.second;
+      ++rulebook_index;
+    }
+    std::vector<std::pair<IntT, IntT>>().swap(task_pairs[task]);
+  }
 }
 
 template <typename T, typename Context, typename IntT = int>
@@ -194,12 +293,13 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
                                SparseCooTensor* out) {
   const bool is2D = out_dims.size() == 4 ? true : false;
 
-  std::set<IntT> out_indexs;
+  // the sorted and unique out indexs
   int n = rulebook->dims()[1];
   IntT* rulebook_ptr = rulebook->data<IntT>();
-  for (int i = 0; i < n; i++) {
-    out_indexs.insert(rulebook_ptr[i + n * 2]);
-  }
+  std::vector<IntT> out_indexs(rulebook_ptr + n * 2, rulebook_ptr + n * 3);
+  std::sort(out_indexs.begin(), out_indexs.end());
+  out_indexs.erase(std::unique(out_indexs.begin(), out_indexs.end()),
+                   out_indexs.end());
 
   int out_non_zero_num = out_indexs.size();
   const int64_t sparse_dim = is2D ? 3 : 4;
@@ -211,7 +311,6 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
   phi::DenseTensor out_indices = phi::Empty(dev_ctx, std::move(indices_meta));
   phi::DenseTensor out_values = phi::Empty(dev_ctx, std::move(values_meta));
   IntT* out_indices_ptr = out_indices.data<IntT>();
-  int i = 0;
 
   int odim0, odim1, odim2, odim3;
   odim0 = out_dims[0];
@@ -220,8 +319,11 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
   odim3 = is2D ? 1 : out_dims[1];
   const Dims4D c_out_dims(odim0, odim1, odim2, odim3);
 
-  for (auto it = out_indexs.begin(); it != out_indexs.end(); it++, i++) {
-    const IntT index = *it;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int i = 0; i < out_non_zero_num; i++) {
+    const IntT index = out_indexs[i];
     IntT batch, x, y, z;
     phi::funcs::sparse::IndexToPoint<Dims4D>(
         index, c_out_dims, &batch, &x, &y, &z);
@@ -235,10 +337,14 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
       out_indices_ptr[i + out_non_zero_num * 3] = x;
     }
   }
-  for (i = 0; i < n; i++) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int i = 0; i < n; i++) {
     IntT out_index = rulebook_ptr[i + n * 2];
     rulebook_ptr[i + n * 2] =
-        std::distance(out_indexs.begin(), out_indexs.find(out_index));
+        std::lower_bound(out_indexs.begin(), out_indexs.end(), out_index) -
+        out_indexs.begin();
   }
 
   out->SetMember(out_indices, out_values, out_dims, true);
@@ -247,6 +353,9 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
 template <typename T, typename IntT = int>
 void Gather(
     const T* x, const IntT* indexs, const int n, const int channels, T* out) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
   for (int i = 0; i < n; i++) {
     IntT real_i = indexs[i];
     memcpy(out + i * channels, x + real_i * channels, channels * sizeof(T));
@@ -22,6 +22,9 @@ limitations under the License. */
 namespace phi {
 namespace sparse {
 
+// the rows of the rulebook gathered and multiplied at once
+constexpr int kConvBlockRows = 256;
+
 /**
  * x: (N, D, H, W, C)
  * kernel: (D, H, W, C, OC)
@@ -122,23 +125,6 @@ void Conv3dCooCPUKernel(const CPUContext& dev_ctx,
         dev_ctx, x, key, tmp_rulebook, h_counter, out, rulebook, counter);
   }
 
-  // 2. gather
-  DenseTensorMeta in_features_meta(
-      x.dtype(), {n, in_channels}, DataLayout::NHWC);
-  DenseTensorMeta out_features_meta(
-      x.dtype(), {n, out_channels}, DataLayout::NHWC);
-  phi::DenseTensor in_features =
-      phi::Empty(dev_ctx, std::move(in_features_meta));
-  phi::DenseTensor out_features =
-      phi::Empty(dev_ctx, std::move(out_features_meta));
-  T* in_features_ptr = in_features.data<T>();
-  T* out_features_ptr = out_features.data<T>();
-
-  Gather<T, IntT>(
-      x.values().data<T>(), rulebook_ptr + n, n, in_channels, in_features_ptr);
-
-  // 3. call gemm for every weight
-  auto blas = phi::funcs::GetBlas<CPUContext, T>(dev_ctx);
   int offset = 0;
   for (int i = 0; i < kernel_size; i++) {
     h_offsets_ptr[i] = offset;
@@ -146,36 +132,54 @@ void Conv3dCooCPUKernel(const CPUContext& dev_ctx,
   }
   h_offsets_ptr[kernel_size] = offset;
 
+  // 2. gather, gemm and scatter the rows of each weight by blocks, which
+  // stay in the cache. The rows of a weight have different outputs, so
+  // that its blocks are scattered in parallel.
+  const T* x_values_ptr = x.values().data<T>();
   const T* kernel_ptr = kernel.data<T>();
+  T* out_values_ptr = out->mutable_values()->data<T>();
+  memset(out_values_ptr, 0, sizeof(T) * out->nnz() * out_channels);
+  auto blas = phi::funcs::GetBlas<CPUContext, T>(dev_ctx);
   for (int i = 0; i < kernel_size; i++) {
     if (h_counter_ptr[i] <= 0) {
       continue;
     }
-
-    // call gemm: (n, in_channels) * (in_channels, out_channels)
-    const int M = h_counter_ptr[i];
-    const int K = in_channels;   // in_channels
-    const int N = out_channels;  // out_channels
-    T* tmp_in_ptr = in_features_ptr + h_offsets_ptr[i] * in_channels;
-    const T* tmp_kernel_ptr = kernel_ptr + i * K * N;
-    T* tmp_out_ptr = out_features_ptr + h_offsets_ptr[i] * out_channels;
-    blas.GEMM(CblasNoTrans,
-              CblasNoTrans,
-              M,
-              N,
-              K,
-              static_cast<T>(1),
-              tmp_in_ptr,
-              tmp_kernel_ptr,
-              static_cast<T>(0),
-              tmp_out_ptr);
+    const IntT* in_indexs = rulebook_ptr + n + h_offsets_ptr[i];
+    const IntT* out_indexs = rulebook_ptr + n * 2 + h_offsets_ptr[i];
+    const T* tmp_kernel_ptr = kernel_ptr + i * in_channels * out_channels;
+    const int block_num =
+        (h_counter_ptr[i] + kConvBlockRows - 1) / kConvBlockRows;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int b = 0; b < block_num; b++) {
+      const int begin = b * kConvBlockRows;
+      // call gemm: (M, in_channels) * (in_channels, out_channels)
+      const int M = std::min(kConvBlockRows, h_counter_ptr[i] - begin);
+      std::vector<T> in_features(M * in_channels);
+      std::vector<T> out_features(M * out_channels);
+      Gather<T, IntT>(x_values_ptr,
+                      in_indexs + begin,
+                      M,
+                      in_channels,
+                      in_features.data());
+      blas.GEMM(CblasNoTrans,
+                CblasNoTrans,
+                M,
+                out_channels,
+                in_channels,
+                static_cast<T>(1),
+                in_features.data(),
+                tmp_kernel_ptr,
+                static_cast<T>(0),
+                out_features.data());
+      Scatter<T, IntT>(out_features.data(),
+                       out_indexs + begin,
+                       M,
+                       out_channels,
+                       out_values_ptr);
+    }
   }
-
-  // 4. scatter
-  T* out_values_ptr = out->mutable_values()->data<T>();
-  memset(out_values_ptr, 0, sizeof(T) * out->nnz() * out_channels);
-  Scatter<T, IntT>(
-      out_features_ptr, rulebook_ptr + n * 2, n, out_channels, out_values_ptr);
 }
 
 template <typename T, typename Context>
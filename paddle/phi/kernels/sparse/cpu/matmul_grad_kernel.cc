@@ -14,33 +14,122 @@ limitations under the License. */
 
 #include "paddle/phi/kernels/sparse/matmul_grad_kernel.h"
 
+#include <type_traits>
+#include <vector>
+
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/core/meta_tensor.h"
+#include "paddle/phi/kernels/empty_kernel.h"
+#include "paddle/phi/kernels/funcs/sparse/sparse_blas.h"
+#include "paddle/phi/kernels/sparse/empty_kernel.h"
+#include "paddle/phi/kernels/transpose_kernel.h"
 
 namespace phi::sparse {
 
-// TODO(zhouwei25): implement CPU backward kernel of " CSR @ DENSE -> DENSE"
+template <typename T, typename Context, typename TensorType>
+void MatmulSparseDenseGradKernelImpl(const Context& dev_ctx,
+                                     const TensorType& x,
+                                     const DenseTensor& y,
+                                     const DenseTensor& dout,
+                                     TensorType* dx,
+                                     DenseTensor* dy) {
+  auto sparse_blas = phi::funcs::sparse::GetSparseBlas<Context, T>(dev_ctx);
+
+  // dx{Sparse} = dout{Dense} * y'{Dense}
+  if (dx) {
+    // InferMeta of 'dx', CreateLikeInferMeta
+    if constexpr (std::is_same<TensorType, SparseCooTensor>::value) {
+      EmptyLikeCooKernel<T, Context>(dev_ctx, x, dx);
+    } else {
+      EmptyLikeCsrKernel<T, Context>(dev_ctx, x, dx);
+    }
+
+    sparse_blas.SDDMM(
+        false, true, static_cast<T>(1), dout, y, static_cast<T>(0), dx);
+  }
+
+  // dy{Dense} = x'{Sparse} * dout{Dense}
+  if (dy) {
+    // InferMeta of DenseTensor 'dy'
+    MetaTensor meta_dy(dy);
+    meta_dy.set_dims(y.dims());
+    meta_dy.set_dtype(y.dtype());
+
+    dev_ctx.template Alloc<T>(dy);
+
+    sparse_blas.SPMM(
+        true, false, static_cast<T>(1), x, dout, static_cast<T>(0), dy);
+  }
+}
+
+template <typename T, typename Context>
+void MatmulCooDenseGradKernel(const Context& dev_ctx,
+                              const SparseCooTensor& x,
+                              const DenseTensor& y,
+                              const DenseTensor& dout,
+                              SparseCooTensor* dx,
+                              DenseTensor* dy) {
+  MatmulSparseDenseGradKernelImpl<T>(dev_ctx, x, y, dout, dx, dy);
+}
+
 template <typename T, typename Context>
-void MatmulCsrDenseGradKernel(const Context& dev_ctx UNUSED,
-                              const SparseCsrTensor& x UNUSED,
-                              const DenseTensor& y UNUSED,
-                              const DenseTensor& dout UNUSED,
-                              SparseCsrTensor* dx UNUSED,
-                              DenseTensor* dy UNUSED) {
-  PADDLE_THROW(phi::errors::Unimplemented(
-      "Not support CPU backward kernel of 'sparse.matmul' now."));
+void MatmulCsrDenseGradKernel(const Context& dev_ctx,
+                              const SparseCsrTensor& x,
+                              const DenseTensor& y,
+                              const DenseTensor& dout,
+                              SparseCsrTensor* dx,
+                              DenseTensor* dy) {
+  MatmulSparseDenseGradKernelImpl<T>(dev_ctx, x, y, dout, dx, dy);
 }
 
-// TODO(zhouwei25): implement CPU kernel of " DENSE @ DENSE * CSR_MASK -> CSR"
 template <typename T, typename Context>
-void MaskedMatmulCsrGradKernel(const Context& dev_ctx UNUSED,
-                               const DenseTensor& x UNUSED,
-                               const DenseTensor& y UNUSED,
-                               const SparseCsrTensor& dout UNUSED,
-                               DenseTensor* dx UNUSED,
-                               DenseTensor* dy UNUSED) {
-  PADDLE_THROW(phi::errors::Unimplemented(
-      "Not support CPU backward kernel of 'sparse.masked_matmul' now."));
+void MaskedMatmulCsrGradKernel(const Context& dev_ctx,
+                               const DenseTensor& x,
+                               const DenseTensor& y,
+                               const SparseCsrTensor& dout,
+                               DenseTensor* dx,
+                               DenseTensor* dy) {
+  auto sparse_blas = phi::funcs::sparse::GetSparseBlas<Context, T>(dev_ctx);
+
+  // dx{Dense} = dout{SparseCsr} * y'{Dense}
+  if (dx) {
+    // InferMeta of DenseTensor 'dx'
+    MetaTensor meta_dx(dx);
+    meta_dx.set_dims(x.dims());
+    meta_dx.set_dtype(x.dtype());
+
+    dev_ctx.template Alloc<T>(dx);
+    sparse_blas.SPMM(
+        false, true, static_cast<T>(1), dout, y, static_cast<T>(0), dx);
+  }
+
+  // dy{Dense} = x'{Dense} * dout{SparseCsr}
+  // That is: dy'{Dense} = dout'{SparseCsr} * x{Dense}
+  if (dy) {
+    std::vector<int> trans_dim_vec = common::vectorize<int>(y.dims());
+    size_t rank = trans_dim_vec.size();
+    std::swap(trans_dim_vec[rank - 1], trans_dim_vec[rank - 2]);
+    DenseTensor trans_dy = phi::Empty<T, Context>(dev_ctx, trans_dim_vec);
+
+    sparse_blas.SPMM(
+        true, false, static_cast<T>(1), dout, x, static_cast<T>(0), &trans_dy);
+
+    // InferMeta of DenseTensor 'dy'
+    MetaTensor meta_dy(dy);
+    meta_dy.set_dims(y.dims());
+    meta_dy.set_dtype(y.dtype());
+
+    dev_ctx.template Alloc<T>(dy);
+
+    size_t y_ndim = y.dims().size();
+    std::vector<int> axis(y_ndim);
+    for (size_t i = 0; i < y_ndim; ++i) {
+      axis[i] = i;
+    }
+    std::swap(axis[y_ndim - 1], axis[y_ndim - 2]);
+    TransposeKernel<T, Context>(dev_ctx, trans_dy, axis, dy);
+  }
 }
 
 }  // namespace phi::sparse
@@ -54,6 +143,15 @@ PD_REGISTER_KERNEL(matmul_csr_dense_grad,
   kernel->InputAt(0).SetDataLayout(phi::DataLayout::SPARSE_CSR);
 }
 
+PD_REGISTER_KERNEL(matmul_coo_dense_grad,
+                   CPU,
+                   ALL_LAYOUT,
+                   phi::sparse::MatmulCooDenseGradKernel,
+                   float,
+                   double) {
+  kernel->InputAt(0).SetDataLayout(phi::DataLayout::SPARSE_COO);
+}
+
 PD_REGISTER_KERNEL(masked_matmul_csr_grad,
                    CPU,
                    ALL_LAYOUT,
@@ -14,27 +14,59 @@ limitations under the License. */
 
 #include "paddle/phi/kernels/sparse/mv_kernel.h"
 
+#include <vector>
+
+#include "paddle/common/ddim.h"
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/funcs/sparse/sparse_blas.h"
 
 namespace phi::sparse {
 
+template <typename T, typename Context, typename TensorType>
+void MvKernelImpl(const Context& dev_ctx,
+                  const TensorType& x,
+                  const DenseTensor& vec,
+                  DenseTensor* out) {
+  std::vector<int64_t> x_dim = common::vectorize(x.dims());
+  std::vector<int64_t> vec_dim = common::vectorize(vec.dims());
+  auto x_ndims = x_dim.size();
+  auto vec_ndims = vec_dim.size();
+  PADDLE_ENFORCE_EQ(x_ndims,
+                    2,
+                    phi::errors::InvalidArgument(
+                        "the dims size of Input(x) must be equal to 2."));
+  PADDLE_ENFORCE_EQ(vec_ndims,
+                    1,
+                    phi::errors::InvalidArgument(
+                        "the dims size of Input(vec) must be equal to 1."));
+  PADDLE_ENFORCE_EQ(x_dim[x_ndims - 1],
+                    vec_dim[vec_ndims - 1],
+                    phi::errors::PreconditionNotMet(
+                        "The shape of Input(x) and Input(vec) is not "
+                        "suitable for mv opetation, "
+                        "x_dim[-1] must be equal to vec_dim[-1]."));
+  std::vector<int64_t> out_dim = {x_dim[x_ndims - 2]};
+  out->Resize(common::make_ddim(out_dim));
+  dev_ctx.template Alloc<T>(out);
+  auto sparse_blas = phi::funcs::sparse::GetSparseBlas<Context, T>(dev_ctx);
+  sparse_blas.SPMV(false, static_cast<T>(1), x, vec, static_cast<T>(0), out);
+}
+
 template <typename T, typename Context>
-void MvCsrKernel(const Context& dev_ctx UNUSED,
-                 const SparseCsrTensor& x UNUSED,
-                 const DenseTensor& vec UNUSED,
-                 DenseTensor* out UNUSED) {
-  PADDLE_THROW(
-      phi::errors::Unimplemented("Not support CPU kernel of 'sparse.mv' now."));
+void MvCooKernel(const Context& dev_ctx,
+                 const SparseCooTensor& x,
+                 const DenseTensor& vec,
+                 DenseTensor* out) {
+  MvKernelImpl<T>(dev_ctx, x, vec, out);
 }
 
 template <typename T, typename Context>
-void MvCooKernel(const Context& dev_ctx UNUSED,
-                 const SparseCooTensor& x UNUSED,
-                 const DenseTensor& vec UNUSED,
-                 DenseTensor* out UNUSED) {
-  PADDLE_THROW(
-      phi::errors::Unimplemented("Not support CPU kernel of 'sparse.mv' now."));
+void MvCsrKernel(const Context& dev_ctx,
+                 const SparseCsrTensor& x,
+                 const DenseTensor& vec,
+                 DenseTensor* out) {
+  MvKernelImpl<T>(dev_ctx, x, vec, out);
 }
 
 }  // namespace phi::sparse
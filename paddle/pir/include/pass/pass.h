@@ -16,6 +16,7 @@
 
 #include <any>
 #include <cstdint>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -163,16 +164,25 @@ class IR_API Pass {
 
   virtual bool Initialize(IrContext* context) { return true; }
 
+  // A region-local pass only reads and rewrites the IR nested in the regions
+  // of the operation it runs on, and keeps no state across runs but the
+  // statistics. PassManager may run the passes of a pipeline concurrently on
+  // independent operations if all of them are region-local.
+  virtual bool IsRegionLocal() const { return false; }
+
   void AddStatistics(int64_t match_count) {
+    std::lock_guard<std::mutex> guard(statistics_mutex_);
     Set<int64_t>("__match_count__", new int64_t{match_count});
   }
 
   void AddStatistics(int64_t match_count_1, int64_t match_count_2) {
+    std::lock_guard<std::mutex> guard(statistics_mutex_);
     Set<int64_t>("__match_count_1__", new int64_t{match_count_1});
     Set<int64_t>("__match_count_2__", new int64_t{match_count_2});
   }
 
   void AddStatistics(const std::string& custom_log) {
+    std::lock_guard<std::mutex> guard(statistics_mutex_);
     Set<std::string>("__custom_log__", new std::string{custom_log});
   }
 
@@ -185,8 +195,13 @@ class IR_API Pass {
  private:
   detail::PassInfo pass_info_;
 
+  // The state of the thread running the PassManager, the worker threads of
+  // PassAdaptor keep their own ones.
   std::optional<detail::PassExecutionState> pass_state_;
 
+  // Guards the statistics, which are set by the passes run concurrently.
+  std::mutex statistics_mutex_;
+
   friend class PassManager;
   friend class detail::PassAdaptor;
 
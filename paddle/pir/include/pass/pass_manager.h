@@ -113,6 +113,11 @@ class IR_API PassManager {
 
   void EnablePrintStatistics();
 
+  // Runs the pipeline on the independent operations nested in a block with
+  // `num_threads` threads if all the passes are region-local. The default
+  // is FLAGS_pir_pass_num_threads.
+  void EnableMultiThreading(int num_threads);
+
   void AddInstrumentation(std::unique_ptr<PassInstrumentation> pi);
 
  private:
@@ -129,6 +134,11 @@ class IR_API PassManager {
 
   bool disable_log_{false};
 
+  int num_threads_;
+
+  // Printing the whole module reads the IR rewritten by other threads.
+  bool print_module_ir_{false};
+
   std::vector<std::unique_ptr<Pass>> passes_;
 
   std::unique_ptr<Pass> pass_adaptor_;
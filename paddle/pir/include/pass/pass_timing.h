@@ -0,0 +1,99 @@
+// Copyright (c) 2023 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "paddle/pir/include/core/dll_decl.h"
+#include "paddle/pir/include/pass/pass_instrumentation.h"
+
+namespace pir {
+
+namespace detail {
+class Timer {
+ public:
+  Timer() = default;
+
+  ~Timer() = default;
+
+  void Start() { start_time_ = std::chrono::steady_clock::now(); }
+
+  // Returns the time since the last Start.
+  std::chrono::nanoseconds Stop() {
+    auto time = std::chrono::steady_clock::now() - start_time_;
+    walk_time += time;
+    return time;
+  }
+
+  double GetTimePerSecond() const {
+    return std::chrono::duration_cast<std::chrono::duration<double>>(walk_time)
+        .count();
+  }
+
+ private:
+  std::chrono::time_point<std::chrono::steady_clock> start_time_;
+
+  std::chrono::nanoseconds walk_time = std::chrono::nanoseconds(0);
+};
+}  // namespace detail
+
+/// Measures the wall-clock time of the pass pipelines and of the passes in
+/// them. The time of a pass adds up over all the operations it runs on,
+/// including the nested ones, so it may exceed the time of the pipeline when
+/// the passes run on several threads.
+class IR_API PassTimer : public PassInstrumentation {
+ public:
+  explicit PassTimer(bool print_module, bool print_time = true)
+      : print_module_(print_module), print_time_(print_time) {}
+
+  ~PassTimer() override = default;
+
+  void RunBeforePipeline(Operation* op) override;
+
+  void RunAfterPipeline(Operation* op) override;
+
+  void RunBeforePass(Pass* pass, Operation* op) override;
+
+  void RunAfterPass(Pass* pass, Operation* op) override;
+
+  // The time of each pass in seconds, the slowest first. It should be called
+  // after PassManager::Run.
+  std::vector<std::pair<std::string, double>> GetPassTimes() const;
+
+ private:
+  void PrintTime(Operation* op, std::ostream& os);
+
+ private:
+  bool print_module_;
+
+  bool print_time_;
+
+  std::unordered_map<Operation*, detail::Timer> pipeline_timers_;
+
+  std::unordered_map<Operation*,
+                     std::unordered_map<std::string /*pass name*/,
+                                        detail::Timer>>
+      pass_timers_;
+
+  std::unordered_map<std::string /*pass name*/, std::chrono::nanoseconds>
+      pass_times_;
+};
+
+}  // namespace pir
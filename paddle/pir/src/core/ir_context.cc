@@ -101,6 +101,7 @@ class IrContextImpl {
   }
 
   bool IsOpInfoRegistered(const std::string &name) {
+    std::lock_guard<pir::SpinLock> guard(registed_op_infos_lock_);
     return registed_op_infos_.find(name) != registed_op_infos_.end();
   }
 
@@ -132,6 +133,7 @@ class IrContextImpl {
   }
 
   bool IsDialectRegistered(const std::string &name) {
+    std::lock_guard<pir::SpinLock> guard(registed_dialect_lock_);
     return registed_dialect_.find(name) != registed_dialect_.end();
   }
 
@@ -260,6 +262,7 @@ Dialect *IrContext::GetOrRegisterDialect(
 
 std::vector<Dialect *> IrContext::GetRegisteredDialects() {
   std::vector<Dialect *> result;
+  std::lock_guard<pir::SpinLock> guard(impl().registed_dialect_lock_);
   for (auto const &dialect_map : impl().registed_dialect_) {
     result.push_back(dialect_map.second);
   }
@@ -267,6 +270,7 @@ std::vector<Dialect *> IrContext::GetRegisteredDialects() {
 }
 
 Dialect *IrContext::GetRegisteredDialect(const std::string &dialect_name) {
+  std::lock_guard<pir::SpinLock> guard(impl().registed_dialect_lock_);
   for (auto const &dialect_map : impl().registed_dialect_) {
     if (dialect_map.first == dialect_name) {
       return dialect_map.second;
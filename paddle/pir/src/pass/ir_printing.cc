@@ -84,6 +84,7 @@ class IRPrinting : public PassInstrumentation {
 };
 
 void PassManager::EnableIRPrinting(std::unique_ptr<IRPrinterOption> option) {
+  print_module_ir_ = print_module_ir_ || option->print_module();
   AddInstrumentation(std::make_unique<IRPrinting>(std::move(option)));
 }
 
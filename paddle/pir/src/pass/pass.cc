@@ -13,6 +13,14 @@
 // limitations under the License.
 
 #include "paddle/pir/include/pass/pass.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <unordered_set>
+
+#include "paddle/pir/include/core/block.h"
 #include "paddle/pir/include/core/ir_context.h"
 #include "paddle/pir/include/core/operation.h"
 #include "paddle/pir/include/core/program.h"
@@ -24,9 +32,50 @@
 #include "paddle/pir/src/pass/pass_adaptor.h"
 
 #include "paddle/common/enforce.h"
+#include "paddle/common/flags.h"
+
+COMMON_DECLARE_int32(pir_pass_num_threads);
 
 namespace pir {
 
+namespace {
+// The execution states of the passes run on a worker thread of PassAdaptor.
+thread_local std::unordered_map<const Pass*,
+                                std::optional<detail::PassExecutionState>>*
+    worker_pass_states = nullptr;
+
+// Returns the values defined outside the operation and used in its regions.
+std::unordered_set<Value> GetValuesUsedFromAbove(Operation* op) {
+  std::unordered_set<Value> defined_values;
+  op->Walk([&](Operation* nested_op) {
+    for (size_t i = 0; i < nested_op->num_regions(); ++i) {
+      for (auto& block : nested_op->region(i)) {
+        defined_values.insert(block.args().begin(), block.args().end());
+        for (auto& [_, kwarg] : block.kwargs()) {
+          defined_values.insert(kwarg);
+        }
+      }
+    }
+    if (nested_op != op) {
+      for (auto result : nested_op->results()) {
+        defined_values.insert(result);
+      }
+    }
+  });
+
+  std::unordered_set<Value> used_values;
+  op->Walk([&](Operation* nested_op) {
+    if (nested_op == op) return;
+    for (auto operand : nested_op->operands_source()) {
+      if (operand && !defined_values.count(operand)) {
+        used_values.insert(operand);
+      }
+    }
+  });
+  return used_values;
+}
+}  // namespace
+
 //===----------------------------------------------------------------------===//
 // Pass
 //===----------------------------------------------------------------------===//
@@ -43,21 +92,26 @@ Pass::~Pass() {
 bool Pass::CanApplyOn(Operation* op) const { return op->num_regions() > 0; }
 
 std::optional<detail::PassExecutionState>& Pass::pass_state() {
+  if (worker_pass_states) {
+    return (*worker_pass_states)[this];
+  }
   return pass_state_;
 }
 
 void Pass::SignalPassFailure() {
-  PADDLE_ENFORCE_EQ(pass_state_.has_value(),
+  auto& state = pass_state();
+  PADDLE_ENFORCE_EQ(state.has_value(),
                     true,
                     phi::errors::InvalidArgument("pass state has no value"));
-  pass_state_->pass_failed = true;
+  state->pass_failed = true;
 }
 
 AnalysisManager Pass::analysis_manager() {
-  PADDLE_ENFORCE_EQ(pass_state_.has_value(),
+  auto& state = pass_state();
+  PADDLE_ENFORCE_EQ(state.has_value(),
                     true,
                     phi::errors::InvalidArgument("pass state has no value"));
-  return pass_state_->am;
+  return state->am;
 }
 //===----------------------------------------------------------------------===//
 // PatternRewritePass
@@ -102,10 +156,16 @@ void detail::PassAdaptor::RunImpl(Operation* op,
                                   uint8_t opt_level,
                                   bool verify) {
   auto last_am = analysis_manager();
+  bool run_in_parallel = CanRunInParallel(opt_level);
 
   for (size_t i = 0; i < op->num_regions(); ++i) {
     auto& region = op->region(i);
     for (auto& block : region) {
+      if (run_in_parallel) {
+        if (!RunInParallel(&block, last_am, opt_level, verify))
+          return SignalPassFailure();
+        continue;
+      }
       for (auto& op : block) {
         AnalysisManagerHolder am(&op, last_am.GetPassInstrumentor());
         if (!RunPipeline(*pm_, &op, am, opt_level, verify))
@@ -116,6 +176,102 @@ void detail::PassAdaptor::RunImpl(Operation* op,
   return;
 }
 
+bool detail::PassAdaptor::CanRunInParallel(uint8_t opt_level) const {
+  // The worker threads run the nested operations by themselves.
+  if (pm_->num_threads_ <= 1 || pm_->print_module_ir_ || worker_pass_states) {
+    return false;
+  }
+  return std::all_of(pm_->passes().begin(),
+                     pm_->passes().end(),
+                     [&](const std::unique_ptr<Pass>& pass) {
+                       return opt_level < pass->pass_info().opt_level ||
+                              pass->IsRegionLocal();
+                     });
+}
+
+bool detail::PassAdaptor::RunInParallel(Block* block,
+                                        AnalysisManager am,
+                                        uint8_t opt_level,
+                                        bool verify) {
+  // The use lists of values are not thread-safe, so the operations run
+  // concurrently must not use the same value from above in their regions.
+  std::vector<Operation*> parallel_ops;
+  std::vector<Operation*> serial_ops;
+  std::unordered_set<Value> claimed_values;
+  for (auto& op : *block) {
+    if (op.num_regions() == 0) {
+      serial_ops.push_back(&op);
+      continue;
+    }
+    auto used_values = GetValuesUsedFromAbove(&op);
+    bool independent = std::none_of(
+        used_values.begin(), used_values.end(), [&](const Value& value) {
+          return claimed_values.count(value) > 0;
+        });
+    if (independent) {
+      claimed_values.insert(used_values.begin(), used_values.end());
+      parallel_ops.push_back(&op);
+    } else {
+      serial_ops.push_back(&op);
+    }
+  }
+
+  auto* instrumentor = am.GetPassInstrumentor();
+  auto run_pipeline = [&](Operation* op) {
+    AnalysisManagerHolder op_am(op, instrumentor);
+    return RunPipeline(*pm_, op, op_am, opt_level, verify);
+  };
+  if (parallel_ops.size() <= 1) {
+    for (auto& op : *block) {
+      if (!run_pipeline(&op)) return false;
+    }
+    return true;
+  }
+
+  VLOG(6) << "Run the pipeline on " << parallel_ops.size()
+          << " operations in parallel and " << serial_ops.size()
+          << " operations serially.";
+  std::atomic<size_t> next_op{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr exception = nullptr;
+  std::mutex exception_mutex;
+  auto worker = [&]() {
+    std::unordered_map<const Pass*, std::optional<PassExecutionState>>
+        pass_states;
+    worker_pass_states = &pass_states;
+    for (size_t i = next_op++; i < parallel_ops.size() && !failed;
+         i = next_op++) {
+      try {
+        if (!run_pipeline(parallel_ops[i])) failed = true;
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(exception_mutex);
+        if (!exception) exception = std::current_exception();
+        failed = true;
+      }
+    }
+    worker_pass_states = nullptr;
+  };
+
+  // The current thread works as one of the threads.
+  size_t num_threads =
+      std::min(static_cast<size_t>(pm_->num_threads_), parallel_ops.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < num_threads; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (exception) std::rethrow_exception(exception);
+  if (failed) return false;
+
+  for (auto* op : serial_ops) {
+    if (!run_pipeline(op)) return false;
+  }
+  return true;
+}
+
 bool detail::PassAdaptor::RunPipeline(const PassManager& pm,
                                       Operation* op,
                                       AnalysisManager am,
@@ -153,7 +309,7 @@ bool detail::PassAdaptor::RunPass(Pass* pass,
                                   bool verify) {
   if (opt_level < pass->pass_info().opt_level) return true;
 
-  pass->pass_state_ = PassExecutionState(op, am);
+  pass->pass_state() = PassExecutionState(op, am);
 
   PassInstrumentor* instrumentor = am.GetPassInstrumentor();
 
@@ -162,7 +318,11 @@ bool detail::PassAdaptor::RunPass(Pass* pass,
   } else {
     if (instrumentor) instrumentor->RunBeforePass(pass, op);
     pass->Run(op);
-    if (instrumentor) instrumentor->RunAfterPass(pass, op);
+    if (instrumentor) {
+      // The instrumentations may read the statistics of the pass.
+      std::lock_guard<std::mutex> guard(pass->statistics_mutex_);
+      instrumentor->RunAfterPass(pass, op);
+    }
   }
 
   bool pass_failed = pass->pass_state()->pass_failed;
@@ -179,7 +339,9 @@ bool detail::PassAdaptor::RunPass(Pass* pass,
 // PassManager
 //----------------------------------------------------------------------------------------------//
 PassManager::PassManager(IrContext* context, uint8_t opt_level)
-    : context_(context), opt_level_(opt_level) {
+    : context_(context),
+      opt_level_(opt_level),
+      num_threads_(FLAGS_pir_pass_num_threads) {
   pass_adaptor_ = std::make_unique<detail::PassAdaptor>(this);
 }
 
@@ -205,6 +367,17 @@ bool PassManager::Initialize(IrContext* context) {
   return true;
 }
 
+void PassManager::EnableMultiThreading(int num_threads) {
+  PADDLE_ENFORCE_GE(
+      num_threads,
+      1,
+      phi::errors::InvalidArgument(
+          "The number of threads to run passes should be at least 1, but "
+          "received %d.",
+          num_threads));
+  num_threads_ = num_threads;
+}
+
 void PassManager::AddInstrumentation(std::unique_ptr<PassInstrumentation> pi) {
   if (!instrumentor_) instrumentor_ = std::make_unique<PassInstrumentor>();
 
@@ -216,7 +389,8 @@ void PassManager::AddInstrumentation(std::unique_ptr<PassInstrumentation> pi) {
 //----------------------------------------------------------------------------------------------//
 namespace detail {
 struct PassInstrumentorImpl {
-  // TODO(wilber): Support multi-thread.
+  // The passes may run on several threads, the callbacks are serialized.
+  std::mutex mutex;
   std::vector<std::unique_ptr<PassInstrumentation>> instrumentations;
 };
 }  // namespace detail
@@ -228,6 +402,7 @@ PassInstrumentor::~PassInstrumentor() = default;
 
 void PassInstrumentor::RunBeforePipeline(Operation* op) {
   if (op->num_regions() == 0) return;
+  std::lock_guard<std::mutex> guard(impl_->mutex);
   for (auto& instr : impl_->instrumentations) {
     instr->RunBeforePipeline(op);
   }
@@ -235,6 +410,7 @@ void PassInstrumentor::RunBeforePipeline(Operation* op) {
 
 void PassInstrumentor::RunAfterPipeline(Operation* op) {
   if (op->num_regions() == 0) return;
+  std::lock_guard<std::mutex> guard(impl_->mutex);
   for (auto it = impl_->instrumentations.rbegin();
        it != impl_->instrumentations.rend();
        ++it) {
@@ -244,6 +420,7 @@ void PassInstrumentor::RunAfterPipeline(Operation* op) {
 
 void PassInstrumentor::RunBeforePass(Pass* pass, Operation* op) {
   if (op->num_regions() == 0) return;
+  std::lock_guard<std::mutex> guard(impl_->mutex);
   for (auto& instr : impl_->instrumentations) {
     instr->RunBeforePass(pass, op);
   }
@@ -251,6 +428,7 @@ void PassInstrumentor::RunBeforePass(Pass* pass, Operation* op) {
 
 void PassInstrumentor::RunAfterPass(Pass* pass, Operation* op) {
   if (op->num_regions() == 0) return;
+  std::lock_guard<std::mutex> guard(impl_->mutex);
   for (auto it = impl_->instrumentations.rbegin();
        it != impl_->instrumentations.rend();
        ++it) {
@@ -262,6 +440,7 @@ void PassInstrumentor::RunBeforeAnalysis(const std::string& name,
                                          TypeId id,
                                          Operation* op) {
   if (op->num_regions() == 0) return;
+  std::lock_guard<std::mutex> guard(impl_->mutex);
   for (auto& instr : impl_->instrumentations) {
     instr->RunBeforeAnalysis(name, id, op);
   }
@@ -271,15 +450,17 @@ void PassInstrumentor::RunAfterAnalysis(const std::string& name,
                                         TypeId id,
                                         Operation* op) {
   if (op->num_regions() == 0) return;
+  std::lock_guard<std::mutex> guard(impl_->mutex);
   for (auto it = impl_->instrumentations.rbegin();
        it != impl_->instrumentations.rend();
        ++it) {
-    (*it)->RunBeforeAnalysis(name, id, op);
+    (*it)->RunAfterAnalysis(name, id, op);
   }
 }
 
 void PassInstrumentor::AddInstrumentation(
     std::unique_ptr<PassInstrumentation> pi) {
+  std::lock_guard<std::mutex> guard(impl_->mutex);
   impl_->instrumentations.emplace_back(std::move(pi));
 }
 
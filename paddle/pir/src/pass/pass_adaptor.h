@@ -18,6 +18,7 @@
 
 namespace pir {
 
+class Block;
 class Operation;
 class PassManager;
 
@@ -34,6 +35,15 @@ class PassAdaptor final : public Pass {
  private:
   void RunImpl(Operation* op, uint8_t opt_level, bool verify);
 
+  bool CanRunInParallel(uint8_t opt_level) const;
+
+  // Runs the pipeline on the independent operations of the block with
+  // several threads, and on the others one by one.
+  bool RunInParallel(Block* block,
+                     AnalysisManager am,
+                     uint8_t opt_level,
+                     bool verify);
+
   static bool RunPass(Pass* pass,
                       Operation* op,
                       AnalysisManager am,
@@ -17,7 +17,9 @@
 #include <cctype>
 #include <cstdio>
 
+#include <algorithm>
 #include <cstring>
+#include <new>
 #include <string>
 
 namespace paddle {
@@ -85,5 +87,75 @@ char* LineFileReader::getdelim(FILE* f, char delim) {
 #endif
 }
 
+template <class Read>
+char* BlockLineReader::getline(const void* source, Read read) {
+  if (source != _source) {
+    _source = source;
+    _begin = _end = 0;
+    _eof = false;
+  }
+  while (true) {
+    char* delim = nullptr;
+    if (_begin < _end) {
+      delim = static_cast<char*>(memchr(_buffer + _begin, '\n', _end - _begin));
+      if (delim == nullptr && _eof) {
+        // the last line of the file is not ended by a newline
+        delim = _buffer + _end;
+      }
+    }
+    if (delim != nullptr) {
+      *delim = 0;
+      _line = _buffer + _begin;
+      _length = static_cast<size_t>(delim - _line);
+      _begin = std::min(static_cast<size_t>(delim - _buffer) + 1, _end);
+      return _line;
+    }
+    if (_eof) {
+      _source = NULL;
+      _line = NULL;
+      _length = 0;
+      return nullptr;
+    }
+    fill(read);
+  }
+}
+
+template <class Read>
+void BlockLineReader::fill(Read read) {
+  size_t remain = _end - _begin;
+  if (remain > 0 && _begin > 0) {
+    memmove(_buffer, _buffer + _begin, remain);
+  }
+  _begin = 0;
+  _end = remain;
+  if (_buf_size - _end < _block_size / 2) {
+    // a line longer than the free space, grow the buffer
+    size_t buf_size = std::max(_buf_size * 2, _block_size);
+    // one more byte for ending the last line and the padding
+    char* buffer =
+        static_cast<char*>(::realloc(_buffer, buf_size + 1 + kPadding));
+    if (buffer == NULL) {
+      throw std::bad_alloc();
+    }
+    _buffer = buffer;
+    _buf_size = buf_size;
+  }
+  size_t bytes = read(_buffer + _end, _buf_size - _end);
+  _end += bytes;
+  memset(_buffer + _end, 0, 1 + kPadding);
+  if (bytes == 0) {
+    _eof = true;
+  }
+}
+
+char* BlockLineReader::getline(FILE* f) {
+  return getline(f, [f](char* buf, size_t n) { return fread(buf, 1, n, f); });
+}
+
+char* BlockLineReader::getline(BlockSource* source) {
+  return getline(
+      source, [source](char* buf, size_t n) { return source->read(buf, n); });
+}
+
 }  // end namespace string
 }  // end namespace paddle
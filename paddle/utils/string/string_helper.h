@@ -17,6 +17,7 @@
 #include <assert.h>
 #include <ctype.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <algorithm>
 #include <cstdint>
@@ -388,5 +389,152 @@ class LineFileReader {
   size_t _buf_size = 0;
   size_t _length = 0;
 };
+
+// A source of bytes for BlockLineReader other than a FILE*.
+class BlockSource {
+ public:
+  virtual ~BlockSource() {}
+  // Reads at most n bytes into buf. Returns 0 at the end.
+  virtual size_t read(char* buf, size_t n) = 0;
+};
+
+// A helper class for reading lines from file in large blocks. The lines are
+// returned in place in the block buffer, without being copied, and are
+// followed by at least kPadding readable bytes, so that they can be parsed
+// by str_to_uint64_padded and str_to_float_padded.
+class BlockLineReader {
+ public:
+  static constexpr size_t kPadding = 8;
+
+  explicit BlockLineReader(size_t block_size = 4 << 20)
+      : _block_size(block_size) {}
+  BlockLineReader(BlockLineReader&&) = delete;
+  BlockLineReader(const BlockLineReader&) = delete;
+  ~BlockLineReader() { ::free(_buffer); }
+  // Reading another file drops what is left of the previous one.
+  char* getline(FILE* f);
+  char* getline(BlockSource* source);
+  char* get() { return _line; }
+  size_t length() { return _length; }
+
+ private:
+  template <class Read>
+  char* getline(const void* source, Read read);
+  template <class Read>
+  void fill(Read read);
+
+  size_t _block_size;
+  char* _buffer = NULL;
+  size_t _buf_size = 0;
+  size_t _begin = 0;
+  size_t _end = 0;
+  const void* _source = NULL;
+  bool _eof = false;
+  char* _line = NULL;
+  size_t _length = 0;
+};
+
+namespace detail {
+
+inline uint64_t load_eight_bytes(const char* str) {
+  uint64_t value;
+  memcpy(&value, str, sizeof(value));
+  return value;
+}
+
+// Whether the 8 bytes are all ascii digits.
+inline bool is_eight_digits(uint64_t value) {
+  return ((value & 0xF0F0F0F0F0F0F0F0ULL) |
+          (((value + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+         0x3333333333333333ULL;
+}
+
+// Converts 8 ascii digits, the first one being in the lowest byte.
+inline uint64_t parse_eight_digits(uint64_t value) {
+  const uint64_t mask = 0x000000FF000000FFULL;
+  const uint64_t mul1 = 100 + (1000000ULL << 32);
+  const uint64_t mul2 = 1 + (10000ULL << 32);
+  value -= 0x3030303030303030ULL;
+  value = (value * 10) + (value >> 8);
+  return (((value & mask) * mul1) + (((value >> 16) & mask) * mul2)) >> 32;
+}
+
+inline bool is_digit(char c) {
+  return static_cast<unsigned char>(c - '0') < 10;
+}
+
+}  // namespace detail
+
+// Same as strtoull(str, endptr, 10), faster for plain decimal numbers which
+// are converted eight digits at a time. At least 8 bytes after the number
+// must be readable. Signs, other white spaces than ' ' and numbers out of
+// range are left to strtoull.
+inline uint64_t str_to_uint64_padded(const char* str, char** endptr) {
+  const char* p = str;
+  while (*p == ' ') {
+    ++p;
+  }
+  const char* digits = p;
+  uint64_t value = 0;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  while (detail::is_eight_digits(detail::load_eight_bytes(p))) {
+    value = value * 100000000 +
+            detail::parse_eight_digits(detail::load_eight_bytes(p));
+    p += 8;
+  }
+#endif
+  while (detail::is_digit(*p)) {
+    value = value * 10 + (*p - '0');
+    ++p;
+  }
+  // 20 digits fit if not larger than the maximum, as the value wrapped
+  // around otherwise
+  if (p == digits || p - digits > 20 ||
+      (p - digits == 20 && memcmp(digits, "18446744073709551615", 20) > 0)) {
+    return strtoull(str, endptr, 10);
+  }
+  *endptr = const_cast<char*>(p);
+  return value;
+}
+
+// Same as strtof(str, endptr), faster for plain decimal numbers like
+// "-12.375" whose digits fit into a float exactly, which are converted by a
+// single correctly rounded division. Other numbers are left to strtof.
+inline float str_to_float_padded(const char* str, char** endptr) {
+  static constexpr float kPow10[] = {
+      1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+  const char* p = str;
+  while (*p == ' ') {
+    ++p;
+  }
+  bool negative = *p == '-';
+  p += negative;
+  const char* digits = p;
+  uint64_t mantissa = 0;
+  while (detail::is_digit(*p)) {
+    mantissa = mantissa * 10 + (*p - '0');
+    ++p;
+  }
+  size_t int_digits = p - digits;
+  size_t frac_digits = 0;
+  if (*p == '.') {
+    const char* frac = ++p;
+    while (detail::is_digit(*p)) {
+      mantissa = mantissa * 10 + (*p - '0');
+      ++p;
+    }
+    frac_digits = p - frac;
+  }
+  char next = static_cast<char>(*p | 0x20);
+  if (int_digits + frac_digits == 0 || int_digits + frac_digits > 19 ||
+      frac_digits > 10 || mantissa > (1ULL << 24) || next == 'e' ||
+      next == 'x') {
+    return strtof(str, endptr);
+  }
+  *endptr = const_cast<char*>(p);
+  float value = static_cast<float>(mantissa) / kPow10[frac_digits];
+  return negative ? -value : value;
+}
+
 }  // end namespace string
 }  // end namespace paddle
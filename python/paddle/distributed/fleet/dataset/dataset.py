@@ -47,6 +47,8 @@ class DatasetBase:
         fs_name="",
         fs_ugi="",
         download_cmd="cat",
+        use_block_parser=False,
+        prefetch_read_ahead=0,
     ):
         """
         should be called only once in user's python scripts to initialize settings of dataset instance.
@@ -61,6 +63,8 @@ class DatasetBase:
             fs_name(str): fs name. default is "".
             fs_ugi(str): fs ugi. default is "".
             download_cmd(str): customized download command. default is "cat"
+            use_block_parser(bool): read the output of pipe command in large blocks and parse the lines in place, which is faster for large files. default is False.
+            prefetch_read_ahead(int): read the files ahead in the background by this number of buffers, local files in parallel, and open the next file while the current one is parsed. It implies use_block_parser. The memory of the buffers is bounded by FLAGS_dataset_prefetch_memory_budget_mb. default is 0, which disables it.
 
 
         """
@@ -71,6 +75,8 @@ class DatasetBase:
         self._set_input_type(input_type)
         self._set_hdfs_config(fs_name, fs_ugi)
         self._set_download_cmd(download_cmd)
+        self._set_use_block_parser(use_block_parser)
+        self._set_prefetch_read_ahead(prefetch_read_ahead)
 
     def _set_pipe_command(self, pipe_command):
         """
@@ -144,6 +150,12 @@ class DatasetBase:
     def _set_input_type(self, input_type):
         self.proto_desc.input_type = input_type
 
+    def _set_use_block_parser(self, use_block_parser):
+        self.proto_desc.use_block_parser = use_block_parser
+
+    def _set_prefetch_read_ahead(self, prefetch_read_ahead):
+        self.proto_desc.prefetch_read_ahead = prefetch_read_ahead
+
     def _set_uid_slot(self, uid_slot):
         """
         Set user slot name.
@@ -538,8 +550,11 @@ class InMemoryDataset(DatasetBase):
             fs_ugi(str): fs ugi. default is "".
             pipe_command(str): pipe command of current dataset. A pipe command is a UNIX pipeline command that can be used only. default is "cat"
             download_cmd(str): customized download command. default is "cat"
-            data_feed_type(str): data feed type used in c++ code. default is "MultiSlotInMemoryDataFeed".
+            data_feed_type(str): data feed type used in c++ code. default is "MultiSlotInMemoryDataFeed". Use "MultiSlotColumnarInMemoryDataFeed" to load the files written by ``_dump_columnar_records``.
             queue_num(int): Dataset output queue num, training threads get data from queues. default is -1, which is set same as thread number in c++.
+            use_block_parser(bool): read the output of pipe command in large blocks and parse the lines in place, which is faster for large files. default is False.
+            prefetch_read_ahead(int): read the files ahead in the background by this number of buffers, local files in parallel, and open the next file while the current one is parsed. It implies use_block_parser. The memory of the buffers is bounded by FLAGS_dataset_prefetch_memory_budget_mb. default is 0, which disables it.
+            lock_free_channel(bool): use lock-free channels between the readers, the shuffle and the trainers, which contend less with many threads. Not supported with ps gpu. default is False.
 
         Examples:
             .. code-block:: python
@@ -592,11 +607,15 @@ class InMemoryDataset(DatasetBase):
         fs_ugi = kwargs.get("fs_ugi", "")
         pipe_command = kwargs.get("pipe_command", "cat")
         download_cmd = kwargs.get("download_cmd", "cat")
+        use_block_parser = kwargs.get("use_block_parser", False)
+        prefetch_read_ahead = kwargs.get("prefetch_read_ahead", 0)
 
         if self.use_ps_gpu:
             data_feed_type = "SlotRecordInMemoryDataFeed"
         else:
-            data_feed_type = "MultiSlotInMemoryDataFeed"
+            data_feed_type = kwargs.get(
+                "data_feed_type", "MultiSlotInMemoryDataFeed"
+            )
         self._set_feed_type(data_feed_type)
 
         super().init(
@@ -608,12 +627,17 @@ class InMemoryDataset(DatasetBase):
             fs_name=fs_name,
             fs_ugi=fs_ugi,
             download_cmd=download_cmd,
+            use_block_parser=use_block_parser,
+            prefetch_read_ahead=prefetch_read_ahead,
         )
 
         if kwargs.get("queue_num", -1) > 0:
             queue_num = kwargs.get("queue_num", -1)
             self._set_queue_num(queue_num)
 
+        if kwargs.get("lock_free_channel", False):
+            self._set_lock_free_channel(True)
+
     def _set_feed_type(self, data_feed_type):
         """
         Set data_feed_desc
@@ -749,6 +773,25 @@ class InMemoryDataset(DatasetBase):
         """
         self.fleet_send_sleep_seconds = fleet_send_sleep_seconds
 
+    def _set_lock_free_channel(self, lock_free=True):
+        """
+        Set whether the channels of the dataset are lock-free, default is False.
+        It must be set before the data is loaded.
+
+        Args:
+            lock_free(bool): use lock-free channels
+
+        Examples:
+            .. code-block:: python
+
+                >>> import paddle
+                >>> paddle.enable_static()
+                >>> dataset = paddle.distributed.InMemoryDataset()
+                >>> dataset._set_lock_free_channel(True)
+
+        """
+        self.dataset.set_lock_free_channel(lock_free)
+
     def _set_merge_by_lineid(self, merge_size=2):
         """
         Set merge by line id, instances of same line id will be merged after
@@ -1070,6 +1113,60 @@ class InMemoryDataset(DatasetBase):
         if fleet is not None:
             fleet._role_maker.barrier_worker()
 
+    def _dump_columnar_records(self, path_prefix, compress_level=1):
+        """
+        :api_attr: Static Graph
+
+        Dump the data loaded into memory to local columnar record files, one
+        per thread, named ``path_prefix-00000`` and so on. The files hold the
+        parsed records, so a dataset initialized with the same slots and
+        ``data_feed_type="MultiSlotColumnarInMemoryDataFeed"`` loads them
+        without parsing any text. The data stays in memory.
+
+        Args:
+            path_prefix(str): prefix of the local files to write.
+            compress_level(int): zlib level of the blocks of the files, from 1 to 9, and 0 stores them uncompressed. default is 1.
+
+        Returns:
+            list[str], the files written.
+
+        Examples:
+            .. code-block:: python
+
+                >>> # doctest: +SKIP('No files to read')
+                >>> import paddle
+                >>> paddle.enable_static()
+
+                >>> dataset = paddle.distributed.InMemoryDataset()
+                >>> slots = ["slot1", "slot2", "slot3", "slot4"]
+                >>> slots_vars = []
+                >>> for slot in slots:
+                ...     var = paddle.static.data(
+                ...         name=slot, shape=[None, 1], dtype="int64", lod_level=1)
+                ...     slots_vars.append(var)
+                >>> dataset.init(
+                ...     batch_size=1,
+                ...     thread_num=2,
+                ...     input_type=1,
+                ...     pipe_command="cat",
+                ...     use_var=slots_vars)
+                >>> dataset.set_filelist(["a.txt", "b.txt"])
+                >>> dataset.load_into_memory()
+                >>> files = dataset._dump_columnar_records("./columnar")
+
+                >>> columnar_dataset = paddle.distributed.InMemoryDataset()
+                >>> columnar_dataset.init(
+                ...     batch_size=1,
+                ...     thread_num=2,
+                ...     input_type=1,
+                ...     data_feed_type="MultiSlotColumnarInMemoryDataFeed",
+                ...     use_var=slots_vars)
+                >>> columnar_dataset.set_filelist(files)
+                >>> columnar_dataset.load_into_memory()
+
+        """
+        return self.dataset.dump_columnar_records(path_prefix, compress_level)
+
     def release_memory(self):
         """
         :api_attr: Static Graph
@@ -759,6 +759,18 @@ class SparseTable(Table):
             table_proto.enable_revert = usr_table_proto.enable_revert
         if usr_table_proto.HasField("shard_merge_rate"):
             table_proto.shard_merge_rate = usr_table_proto.shard_merge_rate
+        if usr_table_proto.HasField("enable_value_slab"):
+            table_proto.enable_value_slab = usr_table_proto.enable_value_slab
+        if usr_table_proto.HasField("enable_swiss_map"):
+            table_proto.enable_swiss_map = usr_table_proto.enable_swiss_map
+        if usr_table_proto.HasField("enable_columnar_save"):
+            table_proto.enable_columnar_save = (
+                usr_table_proto.enable_columnar_save
+            )
+        if usr_table_proto.HasField("enable_columnar_lazy_load"):
+            table_proto.enable_columnar_lazy_load = (
+                usr_table_proto.enable_columnar_lazy_load
+            )
 
         if usr_table_proto.accessor.ByteSize() == 0:
             warnings.warn(
@@ -38,7 +38,9 @@ def variable_length_memory_efficient_attention(
 ):
     """
     Cutlass Memory Efficient Variable Attention.
-    This method requires SM_ARCH in sm70, sm75, sm80.
+    This method requires SM_ARCH in sm70, sm75, sm80. On CPU, it supports float32
+    and bfloat16, and the attention is computed by blocks of keys, so that its
+    memory does not grow with the square of the sequence length.
 
     Args:
         query (Tensor): The Query Tensor. Its shape is [batchsize, num_head, seq_len, head_size].
@@ -48,7 +50,7 @@ def variable_length_memory_efficient_attention(
         kv_seq_lens (Tensor): The sequence lengths of the sequences in the batch, used to index key and value. Its shape is [batchsize, 1].
         mask (Tensor): The Mask Tensor. Its shape is [batchsize, 1, query_seq_len, key_seq_len].
         scale (Float): The attention matrix's scale. Default is sqrt(1.0 / head_size).
-        causal (Bool): Whether causal masking is used or not. Default is False.
+        causal (Bool): Whether causal masking is used or not, the i-th query attending to the first i + 1 keys. Default is False.
         pre_cache_length (Int): The length of the pre-cache. Default is 0.
     Returns:
         Tensor: the output Tensor.
@@ -0,0 +1,125 @@
+// Copyright (c) 2024 CINN Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "paddle/cinn/cinn.h"
+#include "paddle/cinn/ir/group_schedule/search/x86_schedule_tuner.h"
+#include "paddle/cinn/ir/schedule/ir_schedule.h"
+#include "paddle/cinn/lang/lower.h"
+
+namespace cinn {
+namespace tests {
+
+using ir::search::X86ScheduleTuner;
+using ir::search::X86TuningResult;
+
+// Tunes the x86 schedule of the tensors, and compares the best schedule with
+// the default one.
+X86TuningResult TuneAndReport(const std::string& name,
+                              const std::vector<ir::Tensor>& args,
+                              const std::vector<ir::Tensor>& outputs) {
+  auto stages = CreateStages(outputs);
+  Target target = cinn::common::DefaultHostTarget();
+  auto funcs =
+      lang::LowerVec(name, stages, args, {}, {}, nullptr, target, true);
+  CHECK_EQ(funcs.size(), 1U);
+  const ir::LoweredFunc& func = funcs[0];
+
+  ir::ModuleExpr mod_expr({func->body});
+  ir::IRSchedule ir_sch(mod_expr);
+  auto func_builder = [&](const ir::Expr& body) {
+    return ir::_LoweredFunc_::Make(
+        func->name, func->args, body, func->temp_bufs);
+  };
+  std::optional<X86TuningResult> result =
+      X86ScheduleTuner(/* warmup = */ 3, /* repeat = */ 20)
+          .Tune(ir_sch, func_builder);
+  CHECK(result.has_value()) << name << " is not measurable";
+  LOG(INFO) << name << ": default " << result->default_cost_ms
+            << " ms, tuned " << result->best_cost_ms << " ms, speedup "
+            << result->default_cost_ms / result->best_cost_ms << "x with {"
+            << result->best_config.ToString() << "} out of "
+            << result->num_measured << " candidates";
+  return result.value();
+}
+
+TEST(X86ScheduleTuning, elementwise_chain) {
+  Expr M(1024), N(4096);
+  Placeholder<float> A("A", {M, N});
+  Placeholder<float> B("B", {M, N});
+  // relu(A * B + 1)
+  ir::Tensor C = Compute(
+      {M, N},
+      [&](Var i, Var j) {
+        return ir::Max::Make(A(i, j) * B(i, j) + Expr(1.f), Expr(0.f));
+      },
+      "C");
+  X86TuningResult result = TuneAndReport("elementwise_chain", {A, B, C}, {C});
+  EXPECT_LE(result.best_cost_ms, result.default_cost_ms);
+}
+
+TEST(X86ScheduleTuning, elementwise_row_reduce) {
+  Expr M(4096), N(1024);
+  Placeholder<float> A("A", {M, N});
+  Placeholder<float> B("B", {M, N});
+  Var k(N.as_int32(), "k0");
+  // sum(A * B + 1, axis=1)
+  ir::Tensor C = Compute(
+      {M},
+      [&](Var i) {
+        return lang::ReduceSum(A(i, k) * B(i, k) + Expr(1.f), {k});
+      },
+      "C");
+  X86TuningResult result =
+      TuneAndReport("elementwise_row_reduce", {A, B, C}, {C});
+  EXPECT_LE(result.best_cost_ms, result.default_cost_ms);
+}
+
+TEST(X86ScheduleTuning, elementwise_column_reduce) {
+  Expr M(1024), N(4096);
+  Placeholder<float> A("A", {M, N});
+  Var k(M.as_int32(), "k0");
+  // sum(relu(A), axis=0)
+  ir::Tensor C = Compute(
+      {N},
+      [&](Var j) {
+        return lang::ReduceSum(ir::Max::Make(A(k, j), Expr(0.f)), {k});
+      },
+      "C");
+  X86TuningResult result =
+      TuneAndReport("elementwise_column_reduce", {A, C}, {C});
+  EXPECT_LE(result.best_cost_ms, result.default_cost_ms);
+}
+
+TEST(X86ScheduleTuning, row_reduce_broadcast) {
+  Expr M(4096), N(1024);
+  Placeholder<float> A("A", {M, N});
+  Var k(N.as_int32(), "k0");
+  // A / sum(A, axis=1, keepdim=True)
+  ir::Tensor C = Compute(
+      {M}, [&](Var i) { return lang::ReduceSum(A(i, k), {k}); }, "C");
+  ir::Tensor D = Compute(
+      {M, N}, [&](Var i, Var j) { return A(i, j) / C(i); }, "D");
+  X86TuningResult result =
+      TuneAndReport("row_reduce_broadcast", {A, C, D}, {C, D});
+  EXPECT_LE(result.best_cost_ms, result.default_cost_ms);
+}
+
+}  // namespace tests
+}  // namespace cinn
@@ -0,0 +1,166 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/channel.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+// Writes items_per_producer items from each producer in blocks of
+// block_size, and reads them all back by the consumers. Returns the
+// seconds it took, and checks that every item is read exactly once.
+static double RunProducersConsumers(Channel<uint64_t> channel,
+                                    int producer_num,
+                                    int consumer_num,
+                                    size_t items_per_producer,
+                                    size_t block_size) {
+  std::vector<std::atomic<int>> seen(producer_num * items_per_producer);
+  for (auto& s : seen) {
+    s.store(0);
+  }
+  std::atomic<int> producers_left(producer_num);
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < producer_num; ++i) {
+    threads.emplace_back([&, i]() {
+      std::vector<uint64_t> block;
+      for (size_t j = 0; j < items_per_producer; j += block.size()) {
+        block.clear();
+        for (size_t k = j; k < items_per_producer && block.size() < block_size;
+             ++k) {
+          block.push_back(i * items_per_producer + k);
+        }
+        EXPECT_EQ(channel->Write(block), block.size());
+      }
+      if (--producers_left == 0) {
+        channel->Close();
+      }
+    });
+  }
+  for (int i = 0; i < consumer_num; ++i) {
+    threads.emplace_back([&]() {
+      std::vector<uint64_t> block;
+      while (channel->Read(block) != 0) {
+        for (uint64_t item : block) {
+          ++seen[item];
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  for (size_t i = 0; i < seen.size(); ++i) {
+    EXPECT_EQ(seen[i].load(), 1) << "item " << i;
+  }
+  EXPECT_TRUE(channel->Empty());
+  return seconds;
+}
+
+class ChannelTest : public ::testing::TestWithParam<bool> {};
+
+TEST_P(ChannelTest, read_write) {
+  auto channel = MakeChannel<std::string>(
+      std::numeric_limits<size_t>::max(), GetParam());
+  EXPECT_EQ(channel->LockFree(), GetParam());
+
+  std::vector<std::string> items = {"a", "b", "c", "d", "e"};
+  EXPECT_EQ(channel->Write(items), 5UL);
+  EXPECT_EQ(channel->Size(), 5UL);
+
+  std::vector<std::string> out;
+  EXPECT_EQ(channel->ReadOnce(out, 2), 2UL);
+  EXPECT_EQ(out, std::vector<std::string>({"a", "b"}));
+
+  channel->Close();
+  // nothing can be written once closed, but the items left can be read
+  EXPECT_EQ(channel->Write(items), 0UL);
+  EXPECT_EQ(channel->ReadAll(out), 3UL);
+  EXPECT_EQ(out, std::vector<std::string>({"c", "d", "e"}));
+  EXPECT_EQ(channel->ReadOnce(out, 2), 0UL);
+
+  channel->Open();
+  EXPECT_EQ(channel->Write(std::vector<std::string>(items)), 5UL);
+  channel->Clear();
+  EXPECT_TRUE(channel->Empty());
+}
+
+TEST_P(ChannelTest, inherit) {
+  auto channel = MakeChannel<int>(16, GetParam());
+  channel->SetBlockSize(4);
+  auto other = MakeChannel<int>(channel);
+  EXPECT_EQ(other->LockFree(), GetParam());
+  EXPECT_EQ(other->Capacity(), 16UL);
+  EXPECT_EQ(other->BlockSize(), 4UL);
+}
+
+TEST_P(ChannelTest, capacity) {
+  auto channel = MakeChannel<int>(8, GetParam());
+  std::vector<int> items(64);
+  std::thread writer([&]() { EXPECT_EQ(channel->Write(items), 64UL); });
+  std::vector<int> out;
+  size_t read_num = 0;
+  while (read_num < items.size()) {
+    EXPECT_LE(channel->Size(), 8UL);
+    read_num += channel->ReadOnce(out, 4);
+  }
+  writer.join();
+  EXPECT_TRUE(channel->Empty());
+}
+
+TEST_P(ChannelTest, multi_producer_multi_consumer) {
+  for (int thread_num : {1, 3, 8}) {
+    auto channel = MakeChannel<uint64_t>(100, GetParam());
+    channel->SetBlockSize(7);
+    RunProducersConsumers(channel, thread_num, thread_num, 5000, 13);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(LockFree, ChannelTest, ::testing::Bool());
+
+// Throughput of the two kinds of channels from 1 to 64 producers and
+// consumers, each moving blocks of 256 items through a channel of bounded
+// capacity. Disabled in channel_test, it runs as channel_benchmark.
+TEST(ChannelBenchmark, DISABLED_contention) {
+  const size_t items_per_producer = 1 << 16;
+  for (int thread_num = 1; thread_num <= 64; thread_num *= 2) {
+    double seconds[2];
+    for (bool lock_free : {false, true}) {
+      auto channel = MakeChannel<uint64_t>(1 << 16, lock_free);
+      channel->SetBlockSize(256);
+      seconds[lock_free] = RunProducersConsumers(
+          channel, thread_num, thread_num, items_per_producer, 256);
+    }
+    double items = static_cast<double>(thread_num * items_per_producer);
+    LOG(INFO) << thread_num << " producers and consumers: "
+              << items / seconds[0] / 1e6 << " M items/s locked, "
+              << items / seconds[1] / 1e6 << " M items/s lock-free";
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,112 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/data_set.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+static Record MakeRecord(int i) {
+  Record record;
+  for (int j = 0; j <= i % 4; ++j) {
+    FeatureFeasign sign;
+    sign.uint64_feasign_ = i * 100 + j;
+    record.uint64_feasigns_.emplace_back(sign, j);
+  }
+  FeatureFeasign sign;
+  sign.float_feasign_ = 0.5f * i;
+  record.float_feasigns_.emplace_back(sign, 7);
+  record.ins_id_ = "ins_" + std::to_string(i);
+  return record;
+}
+
+static std::string SerializeTestRecords(std::vector<Record>* records) {
+  for (int i = 0; i < 10; ++i) {
+    records->push_back(MakeRecord(i));
+  }
+  std::vector<const Record*> pointers;
+  for (auto& record : *records) {
+    pointers.push_back(&record);
+  }
+  std::string msg;
+  SerializeRecords(pointers, &msg);
+  return msg;
+}
+
+TEST(GlobalShuffleMessage, round_trip) {
+  std::vector<Record> records;
+  std::string msg = SerializeTestRecords(&records);
+
+  std::vector<Record> received;
+  ASSERT_TRUE(DeserializeRecords(msg, &received));
+  ASSERT_EQ(received.size(), records.size());
+  for (size_t i = 0; i < records.size(); ++i) {
+    ASSERT_EQ(received[i].ins_id_, records[i].ins_id_);
+    ASSERT_EQ(received[i].uint64_feasigns_.size(),
+              records[i].uint64_feasigns_.size());
+    for (size_t j = 0; j < records[i].uint64_feasigns_.size(); ++j) {
+      EXPECT_EQ(received[i].uint64_feasigns_[j].sign().uint64_feasign_,
+                records[i].uint64_feasigns_[j].sign().uint64_feasign_);
+      EXPECT_EQ(received[i].uint64_feasigns_[j].slot(),
+                records[i].uint64_feasigns_[j].slot());
+    }
+    ASSERT_EQ(received[i].float_feasigns_.size(), 1UL);
+    EXPECT_EQ(received[i].float_feasigns_[0].sign().float_feasign_,
+              records[i].float_feasigns_[0].sign().float_feasign_);
+  }
+
+  // the buffer is reused by the next message
+  std::string reused = msg;
+  std::vector<const Record*> first = {&records[0]};
+  SerializeRecords(first, &reused);
+  ASSERT_TRUE(DeserializeRecords(reused, &received));
+  ASSERT_EQ(received.size(), 1UL);
+  EXPECT_EQ(received[0].ins_id_, "ins_0");
+
+  // an empty message has no record
+  ASSERT_TRUE(DeserializeRecords(std::string(), &received));
+  EXPECT_TRUE(received.empty());
+}
+
+TEST(GlobalShuffleMessage, reject_malformed) {
+  std::vector<Record> records;
+  std::string msg = SerializeTestRecords(&records);
+  std::vector<Record> received;
+
+  // cut after the count, or before the last record
+  EXPECT_FALSE(DeserializeRecords(msg.substr(0, sizeof(uint64_t) + 3),
+                                  &received));
+  EXPECT_FALSE(DeserializeRecords(msg.substr(0, msg.size() - 20), &received));
+  EXPECT_TRUE(received.empty());
+  EXPECT_FALSE(DeserializeRecords(msg.substr(0, 5), &received));
+
+  // a huge count must not size an allocation
+  std::string huge = msg;
+  uint64_t count = uint64_t(1) << 60;
+  std::memcpy(&huge[0], &count, sizeof(count));
+  EXPECT_FALSE(DeserializeRecords(huge, &received));
+  EXPECT_TRUE(received.empty());
+
+  // bytes left after the records
+  EXPECT_FALSE(DeserializeRecords(msg + std::string(32, '\0'), &received));
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,127 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/io/prefetch_reader.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <string>
+
+#if defined _WIN32 || defined __APPLE__
+#else
+#define _LINUX
+#endif
+
+namespace paddle {
+namespace framework {
+
+#ifdef _LINUX
+static std::string WriteLines(const std::string& path, int line_num) {
+  std::string content;
+  for (int i = 0; i < line_num; ++i) {
+    content += std::to_string(i) + " " + std::string(i % 97, 'x') + "\n";
+  }
+  std::ofstream out(path);
+  out << content;
+  return content;
+}
+
+static std::string ReadAll(PrefetchFileReader* reader) {
+  std::string content;
+  const char* data = nullptr;
+  size_t size = 0;
+  while (reader->Next(&data, &size)) {
+    content.append(data, size);
+  }
+  return content;
+}
+
+TEST(PrefetchFileReader, read_local_file) {
+  std::string content = WriteLines("prefetch_local.txt", 10000);
+  PrefetchFileReader::Options options;
+  options.buffer_size = 4096;
+  for (int parallel_reads : {1, 4}) {
+    options.parallel_reads = parallel_reads;
+    PrefetchFileReader reader("prefetch_local.txt", "cat", options);
+    EXPECT_EQ(ReadAll(&reader), content);
+    // the end stays the end
+    const char* data = nullptr;
+    size_t size = 0;
+    EXPECT_FALSE(reader.Next(&data, &size));
+  }
+}
+
+TEST(PrefetchFileReader, read_stream) {
+  std::string content = WriteLines("prefetch_stream.txt", 10000);
+  PrefetchFileReader::Options options;
+  options.buffer_size = 4096;
+  // read through a converter, as a stream
+  PrefetchFileReader reader("prefetch_stream.txt", "cat | cat", options);
+  EXPECT_EQ(ReadAll(&reader), content);
+}
+
+TEST(PrefetchFileReader, empty_file) {
+  std::ofstream("prefetch_empty.txt").close();
+  PrefetchFileReader::Options options;
+  PrefetchFileReader local_reader("prefetch_empty.txt", "", options);
+  EXPECT_EQ(ReadAll(&local_reader), "");
+  PrefetchFileReader stream_reader("prefetch_empty.txt", "cat | cat", options);
+  EXPECT_EQ(ReadAll(&stream_reader), "");
+}
+
+TEST(PrefetchFileReader, memory_budget) {
+  std::string content = WriteLines("prefetch_budget.txt", 10000);
+  size_t budget = fs_prefetch_memory_budget();
+  // the readers still move on with a single buffer ahead
+  fs_prefetch_set_memory_budget(1);
+  PrefetchFileReader::Options options;
+  options.buffer_size = 1024;
+  PrefetchFileReader first("prefetch_budget.txt", "", options);
+  PrefetchFileReader second("prefetch_budget.txt", "", options);
+  EXPECT_EQ(ReadAll(&first), content);
+  EXPECT_EQ(ReadAll(&second), content);
+  fs_prefetch_set_memory_budget(budget);
+}
+
+TEST(PrefetchFileReader, block_line_reader) {
+  std::string content = WriteLines("prefetch_lines.txt", 1000);
+  PrefetchFileReader::Options options;
+  options.buffer_size = 100;
+  PrefetchFileReader reader("prefetch_lines.txt", "", options);
+  string::BlockLineReader line_reader(256);
+  int line_num = 0;
+  while (const char* line = line_reader.getline(&reader)) {
+    EXPECT_EQ(std::string(line),
+              std::to_string(line_num) + " " +
+                  std::string(line_num % 97, 'x'));
+    ++line_num;
+  }
+  EXPECT_EQ(line_num, 1000);
+}
+
+TEST(PrefetchFileReader, stop_early) {
+  WriteLines("prefetch_stop.txt", 10000);
+  PrefetchFileReader::Options options;
+  options.buffer_size = 1024;
+  PrefetchFileReader reader("prefetch_stop.txt", "cat | cat", options);
+  const char* data = nullptr;
+  size_t size = 0;
+  EXPECT_TRUE(reader.Next(&data, &size));
+  EXPECT_EQ(size, 1024UL);
+}
+#endif
+
+}  // namespace framework
+}  // namespace paddle
@@ -14,11 +14,17 @@
 
 #include "paddle/fluid/framework/new_executor/workqueue/workqueue.h"
 
+#include <array>
 #include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include "glog/logging.h"
 #include "gtest/gtest.h"
+#include "paddle/fluid/framework/new_executor/workqueue/inlined_task.h"
 #include "paddle/fluid/framework/new_executor/workqueue/workqueue_utils.h"
 
 TEST(WorkQueueUtils, TestEventsWaiter) {
@@ -203,3 +209,106 @@ TEST(WorkQueue, TestWorkQueueGroup) {
   queue_group.reset();
   waiter_thread.join();
 }
+
+TEST(WorkQueue, TestPriorityTask) {
+  using paddle::framework::CreateSingleThreadedWorkQueue;
+  using paddle::framework::WorkQueueOptions;
+  WorkQueueOptions options(/*name*/ "SingleThreadedWorkQueueForTesting",
+                           /*num_threads*/ 1,
+                           /*allow_spinning*/ true,
+                           /*track_task*/ false);
+  auto work_queue = CreateSingleThreadedWorkQueue(options);
+  // hold the only worker until all tasks are queued
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  work_queue->AddTask([released]() { released.wait(); });
+  std::mutex mutex;
+  std::vector<int> order;
+  auto record = [&mutex, &order](int id) {
+    return [&mutex, &order, id]() {
+      std::lock_guard<std::mutex> guard(mutex);
+      order.push_back(id);
+    };
+  };
+  work_queue->AddTask(record(0));
+  work_queue->AddTask(record(1), /*priority*/ 1);
+  work_queue->AddTask(record(5), /*priority*/ 5);
+  work_queue->AddTask(record(3), /*priority*/ 3);
+  work_queue->AddTask(record(4), /*priority*/ 3);
+  auto handle = work_queue->AddAwaitableTask([]() { return 0; });
+  release.set_value();
+  handle.wait();
+  // prioritized tasks first, FIFO among equal priorities
+  std::vector<int> expected = {5, 3, 4, 1, 0};
+  EXPECT_EQ(order, expected);
+}
+
+TEST(WorkQueueUtils, TestInlinedTask) {
+  using paddle::framework::InlinedTask;
+  int value = 0;
+  InlinedTask small([&value]() { value += 1; });
+  EXPECT_TRUE(small.IsInlined());
+  InlinedTask moved(std::move(small));
+  EXPECT_FALSE(static_cast<bool>(small));
+  moved();
+  EXPECT_EQ(value, 1);
+
+  std::array<int64_t, 16> payload;
+  payload.fill(2);
+  InlinedTask large([&value, payload]() { value += payload[15]; });
+  EXPECT_TRUE(static_cast<bool>(large));
+  EXPECT_FALSE(large.IsInlined());
+  moved = std::move(large);
+  moved();
+  EXPECT_EQ(value, 3);
+
+  // move-only captures are accepted
+  auto owned = std::make_unique<int>(4);
+  InlinedTask move_only([&value, owned = std::move(owned)]() {
+    value += *owned;
+  });
+  move_only();
+  EXPECT_EQ(value, 7);
+
+  std::function<void()> empty;
+  EXPECT_FALSE(static_cast<bool>(InlinedTask(empty)));
+}
+
+TEST(WorkQueue, TestNoAllocationInSteadyState) {
+  using paddle::framework::CreateMultiThreadedWorkQueue;
+  using paddle::framework::TaskHeapAllocationCount;
+  using paddle::framework::WorkQueueOptions;
+  WorkQueueOptions options(/*name*/ "MultiThreadedWorkQueueForTesting",
+                           /*num_threads*/ 4,
+                           /*allow_spinning*/ true,
+                           /*track_task*/ false);
+  constexpr unsigned kTaskNum = 10000;
+  std::atomic<unsigned> counter{0};
+  std::vector<int> runs(kTaskNum, 0);
+  auto work_queue = CreateMultiThreadedWorkQueue(options);
+  auto run_tasks = [&](bool with_priority) {
+    counter = 0;
+    for (unsigned i = 0; i < kTaskNum; ++i) {
+      // same shape as the tasks submitted by the interpreters
+      auto task = [&counter, &runs, i]() {
+        ++runs[i];
+        ++counter;
+      };
+      if (with_priority) {
+        work_queue->AddTask(task, /*priority*/ i % 8);
+      } else {
+        work_queue->AddTask(task);
+      }
+    }
+    while (counter.load() < kTaskNum) {
+      std::this_thread::yield();
+    }
+  };
+  run_tasks(false);
+  run_tasks(true);
+  uint64_t allocations = TaskHeapAllocationCount();
+  run_tasks(false);
+  run_tasks(true);
+  EXPECT_EQ(TaskHeapAllocationCount(), allocations);
+  EXPECT_EQ(runs, std::vector<int>(kTaskNum, 4));
+}
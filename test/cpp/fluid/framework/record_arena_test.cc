@@ -0,0 +1,174 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/record_arena.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+using ArenaVector = std::vector<uint64_t, RecordAllocator<uint64_t>>;
+
+static ArenaVector MakeVector(size_t n) {
+  ArenaVector v;
+  v.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    v.push_back(i);
+  }
+  return v;
+}
+
+TEST(RecordArena, heap_without_scope) {
+  ArenaVector v = MakeVector(100);
+  EXPECT_EQ(v.size(), 100UL);
+  EXPECT_EQ(v[99], 99UL);
+}
+
+TEST(RecordArena, allocate_from_arena) {
+  RecordArena arena;
+  std::vector<ArenaVector> vectors;
+  {
+    RecordArenaScope scope(&arena);
+    for (size_t i = 0; i < 1000; ++i) {
+      vectors.push_back(MakeVector(i));
+    }
+    // a large vector takes a block of its own
+    vectors.push_back(MakeVector(RecordArena::kBlockSize / 8));
+  }
+  EXPECT_GE(arena.Bytes(), RecordArena::kBlockSize);
+  for (size_t i = 0; i < 1000; ++i) {
+    ASSERT_EQ(vectors[i].size(), i);
+    for (size_t j = 0; j < i; ++j) {
+      ASSERT_EQ(vectors[i][j], j);
+    }
+  }
+  // vectors from the heap and from the arena are mixed
+  vectors.push_back(MakeVector(10));
+  std::swap(vectors.front(), vectors.back());
+  vectors.clear();
+}
+
+TEST(RecordArena, nested_scopes) {
+  RecordArena outer;
+  RecordArena inner;
+  {
+    RecordArenaScope outer_scope(&outer);
+    ArenaVector a = MakeVector(10);
+    {
+      RecordArenaScope inner_scope(&inner);
+      ArenaVector b = MakeVector(10);
+      {
+        // back to the heap
+        RecordArenaScope heap_scope(nullptr);
+        ArenaVector c = MakeVector(10);
+      }
+    }
+    ArenaVector d = MakeVector(10);
+  }
+  EXPECT_EQ(outer.Bytes(), static_cast<size_t>(RecordArena::kBlockSize));
+  EXPECT_EQ(inner.Bytes(), static_cast<size_t>(RecordArena::kBlockSize));
+}
+
+TEST(RecordArena, many_small_scopes) {
+  RecordArena arena;
+  std::vector<ArenaVector> vectors;
+  // e.g. the shuffle messages received one by one, each in a scope of its
+  // own, keep filling the same block
+  for (size_t i = 0; i < 10000; ++i) {
+    RecordArenaScope scope(&arena);
+    for (size_t j = 0; j < 4; ++j) {
+      vectors.push_back(MakeVector(j + 1));
+    }
+  }
+  EXPECT_EQ(arena.NumBlocks(), 1UL);
+  EXPECT_EQ(arena.Bytes(), static_cast<size_t>(RecordArena::kBlockSize));
+  for (size_t i = 0; i < vectors.size(); ++i) {
+    ASSERT_EQ(vectors[i].size(), i % 4 + 1);
+    ASSERT_EQ(vectors[i].back(), i % 4);
+  }
+}
+
+TEST(RecordArena, resume_in_nested_scopes) {
+  RecordArena arena;
+  RecordArena other;
+  std::vector<ArenaVector> vectors;
+  // each vector holds distinct values, which the ones overlapping it would
+  // overwrite
+  auto push_vector = [&vectors]() {
+    ArenaVector v = MakeVector(8);
+    for (auto& x : v) {
+      x += vectors.size() * 8;
+    }
+    vectors.push_back(std::move(v));
+  };
+  for (size_t i = 0; i < 100; ++i) {
+    RecordArenaScope outer_scope(&arena);
+    push_vector();
+    {
+      RecordArenaScope other_scope(&other);
+      push_vector();
+      {
+        RecordArenaScope inner_scope(&arena);
+        push_vector();
+      }
+      push_vector();
+    }
+    {
+      RecordArenaScope inner_scope(&arena);
+      push_vector();
+    }
+    push_vector();
+  }
+  for (size_t i = 0; i < vectors.size(); ++i) {
+    for (size_t j = 0; j < vectors[i].size(); ++j) {
+      ASSERT_EQ(vectors[i][j], i * 8 + j);
+    }
+  }
+  EXPECT_EQ(arena.NumBlocks(), 1UL);
+  EXPECT_EQ(other.NumBlocks(), 1UL);
+}
+
+TEST(RecordArena, multi_thread) {
+  RecordArena arena;
+  const int thread_num = 4;
+  std::vector<std::vector<ArenaVector>> vectors(thread_num);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_num; ++i) {
+    threads.emplace_back([&, i]() {
+      RecordArenaScope scope(&arena);
+      for (size_t j = 0; j < 10000; ++j) {
+        vectors[i].push_back(MakeVector(j % 100));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  // the vectors may be freed by any thread
+  for (auto& v : vectors) {
+    for (size_t j = 0; j < v.size(); ++j) {
+      ASSERT_EQ(v[j].size(), j % 100);
+    }
+    v.clear();
+  }
+  EXPECT_GE(arena.Bytes(), thread_num * RecordArena::kBlockSize);
+}
+
+}  // namespace framework
+}  // namespace paddle
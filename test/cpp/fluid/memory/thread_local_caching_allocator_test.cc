@@ -0,0 +1,238 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/memory/allocation/thread_local_caching_allocator.h"
+
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/memory/stats.h"
+
+namespace paddle {
+namespace memory {
+namespace allocation {
+
+using CachingAllocator = ThreadLocalCachingAllocator;
+
+class CountedAllocator : public Allocator {
+ public:
+  bool IsAllocThreadSafe() const override { return true; }
+
+  size_t AllocatedSize() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return allocated_size_;
+  }
+
+  size_t AllocTimes() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return alloc_times_;
+  }
+
+ protected:
+  phi::Allocation *AllocateImpl(size_t size) override {
+    std::lock_guard<std::mutex> guard(mutex_);
+    allocated_size_ += size;
+    ++alloc_times_;
+    return new Allocation(malloc(size), size, platform::CPUPlace());  // NOLINT
+  }
+
+  void FreeImpl(phi::Allocation *allocation) override {
+    std::lock_guard<std::mutex> guard(mutex_);
+    allocated_size_ -= allocation->size();
+    free(allocation->ptr());  // NOLINT
+    delete allocation;
+  }
+
+ private:
+  std::mutex mutex_;
+  size_t allocated_size_{0};
+  size_t alloc_times_{0};
+};
+
+TEST(ThreadLocalCachingAllocator, size_class) {
+  EXPECT_EQ(CachingAllocator::SizeClassIndex(1), 0UL);
+  EXPECT_EQ(CachingAllocator::SizeClassIndex(CachingAllocator::kMaxCachedSize),
+            CachingAllocator::kSizeClassNum - 1);
+  EXPECT_EQ(
+      CachingAllocator::SizeClassIndex(CachingAllocator::kMaxCachedSize + 1),
+      CachingAllocator::kSizeClassNum);
+  for (size_t size = 1; size <= CachingAllocator::kMaxCachedSize; size += 7) {
+    size_t index = CachingAllocator::SizeClassIndex(size);
+    ASSERT_LT(index, CachingAllocator::kSizeClassNum);
+    size_t class_size = CachingAllocator::SizeClassSize(index);
+    ASSERT_GE(class_size, size);
+    ASSERT_EQ(class_size % 64, 0UL);
+    if (index > 0) {
+      ASSERT_LT(CachingAllocator::SizeClassSize(index - 1), size);
+      // at most a quarter of a block is wasted
+      ASSERT_LE(class_size - size, class_size / 4);
+    }
+    ASSERT_EQ(CachingAllocator::SizeClassIndex(class_size), index);
+  }
+}
+
+TEST(ThreadLocalCachingAllocator, reuse_and_release) {
+  auto underlying_allocator = std::make_shared<CountedAllocator>();
+  auto allocator =
+      std::make_shared<CachingAllocator>(underlying_allocator, 1UL << 20);
+
+  int64_t cached_stat = HostMemoryStatCurrentValue("ThreadLocalCached", 0);
+  for (size_t i = 0; i < 100; ++i) {
+    auto allocation = allocator->Allocate(1000);
+    EXPECT_EQ(allocation->size(), 1024UL);
+  }
+  // the first allocation is kept by the thread and reused afterwards
+  EXPECT_EQ(underlying_allocator->AllocTimes(), 1UL);
+  EXPECT_EQ(allocator->ThreadCachedSize(), 1024UL);
+  EXPECT_EQ(HostMemoryStatCurrentValue("ThreadLocalCached", 0),
+            cached_stat + 1024);
+
+  // large requests are not cached
+  allocator->Allocate(CachingAllocator::kMaxCachedSize + 1);
+  EXPECT_EQ(underlying_allocator->AllocTimes(), 2UL);
+  EXPECT_EQ(allocator->ThreadCachedSize(), 1024UL);
+
+  allocator->Release(platform::CPUPlace());
+  EXPECT_EQ(allocator->ThreadCachedSize(), 0UL);
+  EXPECT_EQ(underlying_allocator->AllocatedSize(), 0UL);
+  EXPECT_EQ(HostMemoryStatCurrentValue("ThreadLocalCached", 0), cached_stat);
+}
+
+TEST(ThreadLocalCachingAllocator, capacity) {
+  auto underlying_allocator = std::make_shared<CountedAllocator>();
+  size_t capacity = 4096;
+  auto allocator =
+      std::make_shared<CachingAllocator>(underlying_allocator, capacity);
+
+  std::vector<AllocationPtr> allocations;
+  for (size_t i = 0; i < 16; ++i) {
+    allocations.emplace_back(allocator->Allocate(1024));
+  }
+  allocations.clear();
+  EXPECT_EQ(allocator->ThreadCachedSize(), capacity);
+  EXPECT_EQ(underlying_allocator->AllocatedSize(), capacity);
+}
+
+TEST(ThreadLocalCachingAllocator, release_idle_blocks) {
+  auto underlying_allocator = std::make_shared<CountedAllocator>();
+  auto allocator =
+      std::make_shared<CachingAllocator>(underlying_allocator, 1UL << 20);
+
+  std::vector<AllocationPtr> allocations;
+  for (size_t i = 0; i < 8; ++i) {
+    allocations.emplace_back(allocator->Allocate(4096));
+  }
+  allocations.clear();
+  EXPECT_EQ(allocator->ThreadCachedSize(), 8 * 4096UL);
+
+  // the 4096 bytes blocks stay unused for two release intervals
+  for (size_t i = 0; i < 2 * CachingAllocator::kReleaseInterval; ++i) {
+    allocator->Allocate(512);
+  }
+  EXPECT_EQ(allocator->ThreadCachedSize(), 512UL);
+  EXPECT_EQ(underlying_allocator->AllocatedSize(), 512UL);
+}
+
+TEST(ThreadLocalCachingAllocator, steady_state) {
+  auto underlying_allocator = std::make_shared<CountedAllocator>();
+  auto allocator =
+      std::make_shared<CachingAllocator>(underlying_allocator, 16UL << 20);
+
+  std::vector<size_t> sizes = {
+      64, 300, 300, 1000, 4000, 4000, 4000, 50000, 200000, 1UL << 20};
+  auto run_cycle = [&](size_t cycle) {
+    std::vector<AllocationPtr> allocations;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+      size_t size = sizes[(i + cycle) % sizes.size()];
+      allocations.emplace_back(allocator->Allocate(size));
+      ASSERT_GE(allocations.back()->size(), size);
+    }
+    if (cycle % 2 == 1) {
+      while (!allocations.empty()) {
+        allocations.pop_back();
+      }
+    }
+  };
+
+  // the first cycle fills the cache
+  run_cycle(0);
+  size_t alloc_times = underlying_allocator->AllocTimes();
+  size_t cached_size = allocator->ThreadCachedSize();
+  EXPECT_EQ(alloc_times, sizes.size());
+
+  // later cycles, running over several release intervals, only reuse the
+  // cached blocks
+  size_t cycle_num = 3 * CachingAllocator::kReleaseInterval / sizes.size();
+  for (size_t cycle = 1; cycle <= cycle_num; ++cycle) {
+    run_cycle(cycle);
+    ASSERT_EQ(underlying_allocator->AllocTimes(), alloc_times)
+        << "cycle " << cycle;
+  }
+  EXPECT_EQ(allocator->ThreadCachedSize(), cached_size);
+  EXPECT_EQ(underlying_allocator->AllocatedSize(), cached_size);
+}
+
+TEST(ThreadLocalCachingAllocator, multi_thread) {
+  auto underlying_allocator = std::make_shared<CountedAllocator>();
+  auto allocator =
+      std::make_shared<CachingAllocator>(underlying_allocator, 1UL << 20);
+
+  size_t thread_num = 8;
+  std::vector<std::vector<AllocationPtr>> allocations(thread_num);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < thread_num; ++i) {
+    threads.emplace_back([&, i]() {
+      for (size_t step = 0; step < 10000; ++step) {
+        size_t size = (step * 131 + i * 17) % 8192 + 1;
+        auto allocation = allocator->Allocate(size);
+        ASSERT_GE(allocation->size(), size);
+        if (step % 10 == 0) {
+          // freed by the next thread
+          allocations[i].emplace_back(std::move(allocation));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  threads.clear();
+  for (size_t i = 0; i < thread_num; ++i) {
+    threads.emplace_back(
+        [&, i]() { allocations[(i + 1) % thread_num].clear(); });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  // the caches of the exited threads are given back to the underlying
+  // allocator, the main thread did not cache anything
+  EXPECT_EQ(underlying_allocator->AllocatedSize(), 0UL);
+}
+
+TEST(ThreadLocalCachingAllocator, destroy_before_thread_exit) {
+  auto underlying_allocator = std::make_shared<CountedAllocator>();
+  auto allocator =
+      std::make_shared<CachingAllocator>(underlying_allocator, 1UL << 20);
+  allocator->Allocate(1000);
+  EXPECT_EQ(underlying_allocator->AllocatedSize(), 1024UL);
+  allocator.reset();
+  EXPECT_EQ(underlying_allocator->AllocatedSize(), 0UL);
+}
+
+}  // namespace allocation
+}  // namespace memory
+}  // namespace paddle
@@ -0,0 +1,276 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <numeric>
+#include <random>
+
+#include "paddle/common/flags.h"
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/inference/analysis/helper.h"
+#include "test/cpp/inference/api/tester_helper.h"
+
+namespace paddle_infer {
+
+using services::BatchingPredictor;
+
+static Config GetConfig() {
+  std::string model_dir = FLAGS_infer_model + "/model";
+  Config config;
+  config.SetModel(model_dir + "/model", model_dir + "/params");
+  config.DisableGpu();
+  config.SetCpuMathLibraryNumThreads(1);
+  return config;
+}
+
+static BatchingPredictor::HostTensor RandomImage(const std::string& name,
+                                                 int seed) {
+  BatchingPredictor::HostTensor image;
+  image.name = name;
+  image.dtype = DataType::FLOAT32;
+  image.shape = {1, 3, 224, 224};
+  std::vector<float> data(3 * 224 * 224);
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+  for (auto& x : data) {
+    x = dist(rng);
+  }
+  image.data.resize(data.size() * sizeof(float));
+  std::memcpy(image.data.data(), data.data(), image.data.size());
+  return image;
+}
+
+TEST(BatchingPredictor, resnet50) {
+  Config config = GetConfig();
+  auto predictor = CreatePredictor(config);
+  std::string input_name = predictor->GetInputNames()[0];
+  std::string output_name = predictor->GetOutputNames()[0];
+
+  const int request_num = 6;
+  std::vector<std::vector<float>> expected(request_num);
+  for (int i = 0; i < request_num; ++i) {
+    auto image = RandomImage(input_name, i);
+    auto input_t = predictor->GetInputHandle(input_name);
+    input_t->Reshape(image.shape);
+    input_t->CopyFromCpu(reinterpret_cast<const float*>(image.data.data()));
+    ASSERT_TRUE(predictor->Run());
+    auto output_t = predictor->GetOutputHandle(output_name);
+    std::vector<int> output_shape = output_t->shape();
+    expected[i].resize(std::accumulate(output_shape.begin(),
+                                       output_shape.end(),
+                                       1,
+                                       std::multiplies<int>()));
+    output_t->CopyToCpu(expected[i].data());
+  }
+
+  services::PredictorPool pool(config, 2);
+  BatchingPredictor::Options options;
+  options.max_batch_size = 4;
+  options.batch_timeout_us = 10000;
+  BatchingPredictor batching_predictor(&pool, options);
+  std::vector<std::future<std::vector<BatchingPredictor::HostTensor>>> futures;
+  for (int i = 0; i < request_num; ++i) {
+    futures.emplace_back(
+        batching_predictor.Submit({RandomImage(input_name, i)}));
+  }
+  for (int i = 0; i < request_num; ++i) {
+    auto outputs = futures[i].get();
+    ASSERT_EQ(outputs[0].name, output_name);
+    ASSERT_EQ(outputs[0].shape[0], 1);
+    ASSERT_EQ(outputs[0].data.size(), expected[i].size() * sizeof(float));
+    const float* output =
+        reinterpret_cast<const float*>(outputs[0].data.data());
+    for (size_t j = 0; j < expected[i].size(); ++j) {
+      EXPECT_NEAR(output[j], expected[i][j], 1e-4);
+    }
+  }
+
+  auto stats = batching_predictor.GetStats();
+  EXPECT_EQ(stats.requests, static_cast<uint64_t>(request_num));
+  EXPECT_EQ(stats.rows, static_cast<uint64_t>(request_num));
+  EXPECT_LE(stats.batches, stats.requests);
+  EXPECT_EQ(stats.queue_latency.count, stats.requests);
+  EXPECT_EQ(stats.batch_latency.count, stats.batches);
+  EXPECT_EQ(stats.queue_latency.counts.size(),
+            options.histogram_bounds_us.size() + 1);
+}
+
+TEST(BatchingPredictor, wrong_request) {
+  Config config = GetConfig();
+  services::PredictorPool pool(config, 1);
+  BatchingPredictor::Options options;
+  BatchingPredictor batching_predictor(&pool, options);
+  auto image = RandomImage("no_such_input", 0);
+  EXPECT_ANY_THROW(batching_predictor.Submit({image}));
+  image.name = pool.Retrieve(0)->GetInputNames()[0];
+  image.data.pop_back();
+  EXPECT_ANY_THROW(batching_predictor.Submit({image}));
+}
+
+static void AddScaleOp(paddle::framework::BlockDesc* block,
+                       const std::string& x,
+                       const std::string& out,
+                       float scale,
+                       float bias) {
+  auto* var = block->Var(out);
+  var->SetType(paddle::framework::proto::VarType::LOD_TENSOR);
+  var->SetDataType(paddle::framework::proto::VarType::FP32);
+  var->SetShape({-1, -1});
+  auto* op = block->AppendOp();
+  op->SetType("scale");
+  op->SetInput("X", {x});
+  op->SetOutput("Out", {out});
+  op->SetAttr("scale", scale);
+  op->SetAttr("bias", bias);
+  op->SetAttr("bias_after_scale", true);
+}
+
+// Saves a model without parameters into model_dir. Its inputs are x, of a
+// variable length in dimension 1, and y. Its outputs are
+//   out = 2 * x + 1, x_copy = x and y_out = 3 * y.
+static void SaveScaleModel(const std::string& model_dir) {
+  paddle::framework::ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  auto* feed = block->Var("feed");
+  feed->SetType(paddle::framework::proto::VarType::FEED_MINIBATCH);
+  feed->SetPersistable(true);
+  auto* fetch = block->Var("fetch");
+  fetch->SetType(paddle::framework::proto::VarType::FETCH_LIST);
+  fetch->SetPersistable(true);
+  std::vector<std::string> inputs = {"x", "y"};
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    auto* var = block->Var(inputs[i]);
+    var->SetType(paddle::framework::proto::VarType::LOD_TENSOR);
+    var->SetDataType(paddle::framework::proto::VarType::FP32);
+    var->SetShape({-1, -1});
+    auto* op = block->AppendOp();
+    op->SetType("feed");
+    op->SetInput("X", {"feed"});
+    op->SetOutput("Out", {inputs[i]});
+    op->SetAttr("col", static_cast<int>(i));
+  }
+  AddScaleOp(block, "x", "out", 2.f, 1.f);
+  AddScaleOp(block, "x", "x_copy", 1.f, 0.f);
+  AddScaleOp(block, "y", "y_out", 3.f, 0.f);
+  std::vector<std::string> outputs = {"out", "x_copy", "y_out"};
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    auto* op = block->AppendOp();
+    op->SetType("fetch");
+    op->SetInput("X", {outputs[i]});
+    op->SetOutput("Out", {"fetch"});
+    op->SetAttr("col", static_cast<int>(i));
+  }
+  MKDIR(model_dir.c_str());
+  std::ofstream fout(model_dir + "/__model__", std::ios::binary);
+  fout << program.Proto()->SerializeAsString();
+}
+
+static BatchingPredictor::HostTensor FloatTensor(
+    const std::string& name, int rows, int length, float first) {
+  BatchingPredictor::HostTensor tensor;
+  tensor.name = name;
+  tensor.dtype = DataType::FLOAT32;
+  tensor.shape = {rows, length};
+  std::vector<float> data(rows * length);
+  std::iota(data.begin(), data.end(), first);
+  tensor.data.resize(data.size() * sizeof(float));
+  std::memcpy(tensor.data.data(), data.data(), tensor.data.size());
+  return tensor;
+}
+
+static const float* FloatData(const BatchingPredictor::HostTensor& tensor) {
+  return reinterpret_cast<const float*>(tensor.data.data());
+}
+
+TEST(BatchingPredictor, padding_buckets) {
+  const std::string model_dir = "batching_predictor_scale_model";
+  SaveScaleModel(model_dir);
+  Config config;
+  config.SetModel(model_dir);
+  config.DisableGpu();
+  services::PredictorPool pool(config, 1);
+
+  BatchingPredictor::Options options;
+  options.max_batch_size = 16;
+  // long enough for all the requests to be queued before the first batch
+  options.batch_timeout_us = 500000;
+  options.padding_buckets = {4, 8};
+  options.padded_inputs = {"x"};
+  options.padded_outputs = {"out"};
+  BatchingPredictor batching_predictor(&pool, options);
+
+  // lengths 2, 3 and 4 fall in the bucket 4, lengths 5 and 7 in the bucket 8
+  const std::vector<int> lengths = {2, 5, 3, 7, 4};
+  const std::vector<int> rows = {1, 2, 1, 1, 2};
+  std::vector<std::future<std::vector<BatchingPredictor::HostTensor>>> futures;
+  for (size_t i = 0; i < lengths.size(); ++i) {
+    futures.emplace_back(batching_predictor.Submit(
+        {FloatTensor("x", rows[i], lengths[i], 100.f * i),
+         FloatTensor("y", rows[i], 1, 10.f * i)}));
+  }
+  for (size_t i = 0; i < lengths.size(); ++i) {
+    auto outputs = futures[i].get();
+    ASSERT_EQ(outputs.size(), 3UL);
+    const int bucket = lengths[i] <= 4 ? 4 : 8;
+
+    // the padded output is cut back to the length of the request
+    ASSERT_EQ(outputs[0].name, "out");
+    ASSERT_EQ(outputs[0].shape, std::vector<int>({rows[i], lengths[i]}));
+    for (int j = 0; j < rows[i] * lengths[i]; ++j) {
+      EXPECT_FLOAT_EQ(FloatData(outputs[0])[j], 2.f * (100.f * i + j) + 1.f);
+    }
+
+    // the other outputs keep the padding, which is made of zeros
+    ASSERT_EQ(outputs[1].name, "x_copy");
+    ASSERT_EQ(outputs[1].shape, std::vector<int>({rows[i], bucket}));
+    for (int r = 0; r < rows[i]; ++r) {
+      for (int j = 0; j < bucket; ++j) {
+        float expected = j < lengths[i] ? 100.f * i + r * lengths[i] + j : 0.f;
+        EXPECT_FLOAT_EQ(FloatData(outputs[1])[r * bucket + j], expected);
+      }
+    }
+
+    ASSERT_EQ(outputs[2].name, "y_out");
+    ASSERT_EQ(outputs[2].shape, std::vector<int>({rows[i], 1}));
+    for (int r = 0; r < rows[i]; ++r) {
+      EXPECT_FLOAT_EQ(FloatData(outputs[2])[r], 3.f * (10.f * i + r));
+    }
+  }
+
+  // one batch per bucket, although all the rows fit in one batch
+  auto stats = batching_predictor.GetStats();
+  EXPECT_EQ(stats.requests, lengths.size());
+  EXPECT_EQ(stats.rows, 7UL);
+  EXPECT_EQ(stats.batches, 2UL);
+}
+
+TEST(BatchingPredictor, duplicate_input) {
+  const std::string model_dir = "batching_predictor_scale_model";
+  SaveScaleModel(model_dir);
+  Config config;
+  config.SetModel(model_dir);
+  config.DisableGpu();
+  services::PredictorPool pool(config, 1);
+  BatchingPredictor batching_predictor(&pool, BatchingPredictor::Options());
+  // as many inputs as the model has, but x twice and no y
+  EXPECT_ANY_THROW(batching_predictor.Submit(
+      {FloatTensor("x", 1, 2, 0.f), FloatTensor("x", 1, 2, 0.f)}));
+}
+
+}  // namespace paddle_infer
@@ -219,6 +219,83 @@ TEST(StandaloneExecutor, run_inplace_sqrt) {
   EXPECT_EQ(res3, true);
 }
 
+// A long chain of dependent ops next to many cheap independent branches,
+// the shape where the host threads should prefer the chain. Reports the
+// average latency with and without critical path priority.
+static double RunBranchyProgram(bool critical_path_priority,
+                                float* chain_out) {
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  pir::Program program((ctx));
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  pir::Builder builder = pir::Builder(ctx, program.block());
+
+  const int chain_len = 64;
+  const int branch_num = 256;
+  paddle::dialect::FullOp base = builder.Build<paddle::dialect::FullOp>(
+      std::vector<int64_t>{256, 256},
+      1.0,
+      phi::DataType::FLOAT32,
+      phi::CPUPlace());
+  pir::Value chain = base->result(0);
+  for (int i = 0; i < chain_len; ++i) {
+    auto add = builder.Build<paddle::dialect::AddOp>(chain, base->result(0));
+    chain = builder.Build<paddle::dialect::SqrtOp>(add->result(0))->result(0);
+  }
+  std::string out_name = "chain_out";
+  builder.Build<pir::ShadowOutputOp>(chain, out_name);
+
+  for (int i = 0; i < branch_num; ++i) {
+    paddle::dialect::FullOp small = builder.Build<paddle::dialect::FullOp>(
+        std::vector<int64_t>{2, 2},
+        1.0,
+        phi::DataType::FLOAT32,
+        phi::CPUPlace());
+    auto add = builder.Build<paddle::dialect::AddOp>(small->result(0),
+                                                     small->result(0));
+    builder.Build<pir::ShadowOutputOp>(add->result(0),
+                                       "branch_out_" + std::to_string(i));
+  }
+
+  auto kernel_program = paddle::dialect::PdOpLowerToKernelPass(&program);
+
+  FLAGS_new_executor_critical_path_priority = critical_path_priority;
+  auto place = platform::CPUPlace();
+  Scope scope;
+  InterpreterCore test_core(place, {}, kernel_program->block(), &scope);
+  test_core.SetSkipGcVars({out_name});
+
+  // the first run builds the instructions and the dependencies
+  test_core.Run({});
+  const int repeat = 20;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeat; ++i) {
+    test_core.Run({});
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  auto out_tensor =
+      test_core.local_scope() == nullptr
+          ? scope.FindVar(out_name)->Get<phi::DenseTensor>()
+          : test_core.local_scope()->FindVar(out_name)->Get<phi::DenseTensor>();
+  *chain_out = out_tensor.data<float>()[0];
+  return std::chrono::duration<double, std::micro>(end - start).count() /
+         repeat;
+}
+
+TEST(StandaloneExecutor, critical_path_priority_benchmark) {
+  bool saved = FLAGS_new_executor_critical_path_priority;
+  float fifo_out = 0, priority_out = 0;
+  double fifo_us = RunBranchyProgram(false, &fifo_out);
+  double priority_us = RunBranchyProgram(true, &priority_out);
+  FLAGS_new_executor_critical_path_priority = saved;
+
+  LOG(INFO) << "branchy cpu program latency: fifo " << fifo_us
+            << " us, critical path priority " << priority_us << " us";
+  // the chain converges to the golden ratio whatever the schedule
+  EXPECT_TRUE(simple_cmp(fifo_out, priority_out));
+  EXPECT_TRUE(simple_cmp(priority_out, 1.618034f));
+}
+
 TEST(StandaloneExecutor, if_op) {
   pir::IrContext* ctx = pir::IrContext::Instance();
   ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
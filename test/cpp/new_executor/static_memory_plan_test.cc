@@ -0,0 +1,111 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/interpreter/static_memory_plan.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "paddle/phi/core/dense_tensor.h"
+
+namespace paddle {
+namespace framework {
+namespace interpreter {
+
+// A chain of four steps, a -> b -> c -> d, each output being collected by
+// the garbage collector once the next step has run, except d which is
+// fetched.
+class StaticMemoryPlanTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    vars_.resize(4);
+    planner_ = std::make_unique<StaticMemoryPlanner>(
+        platform::CPUPlace(),
+        2,
+        std::vector<std::vector<Variable*>>{
+            {&vars_[0]}, {&vars_[1]}, {&vars_[2]}, {&vars_[3]}});
+  }
+
+  phi::DenseTensor* Tensor(size_t i) {
+    return vars_[i].GetMutable<phi::DenseTensor>();
+  }
+
+  // returns the data pointers of the outputs of the steps
+  std::vector<void*> RunOnce(int64_t numel) {
+    // the fetched tensor is taken by the caller
+    Tensor(3)->clear();
+    std::vector<void*> ptrs;
+    planner_->BeginRun();
+    for (size_t step = 0; step < vars_.size(); ++step) {
+      planner_->BeforeStep(step);
+      phi::DenseTensor* out = Tensor(step);
+      out->Resize({step == 3 ? 16 : numel});
+      ptrs.push_back(out->mutable_data<float>(platform::CPUPlace()));
+      if (step > 0) {
+        planner_->OnGarbage(&vars_[step - 1]);
+        Tensor(step - 1)->MoveMemoryHolder();
+      }
+      planner_->AfterStep(step);
+    }
+    planner_->EndRun(true);
+    return ptrs;
+  }
+
+  std::vector<Variable> vars_;
+  std::unique_ptr<StaticMemoryPlanner> planner_;
+};
+
+TEST_F(StaticMemoryPlanTest, replay) {
+  RunOnce(1024);
+  EXPECT_FALSE(planner_->IsReplaying());
+  RunOnce(1024);
+  ASSERT_TRUE(planner_->IsReplaying());
+  // a and c are never alive at the same time, d is not planned
+  EXPECT_EQ(planner_->ArenaSize(), 2 * 1024 * sizeof(float));
+
+  for (size_t i = 0; i < 3; ++i) {
+    std::vector<void*> ptrs = RunOnce(1024);
+    EXPECT_EQ(ptrs[0], ptrs[2]);
+    EXPECT_NE(ptrs[0], ptrs[1]);
+  }
+  EXPECT_TRUE(planner_->IsReplaying());
+}
+
+TEST_F(StaticMemoryPlanTest, fallback_and_record_again) {
+  RunOnce(1024);
+  RunOnce(1024);
+  ASSERT_TRUE(planner_->IsReplaying());
+
+  // smaller tensors still fit into their blocks
+  std::vector<void*> ptrs = RunOnce(512);
+  EXPECT_EQ(ptrs[0], ptrs[2]);
+  EXPECT_TRUE(planner_->IsReplaying());
+
+  // larger ones are allocated as usual, and the plan is dropped if that
+  // keeps happening
+  RunOnce(4096);
+  EXPECT_TRUE(planner_->IsReplaying());
+  RunOnce(4096);
+  EXPECT_FALSE(planner_->IsReplaying());
+
+  RunOnce(4096);
+  RunOnce(4096);
+  ASSERT_TRUE(planner_->IsReplaying());
+  EXPECT_EQ(planner_->ArenaSize(), 2 * 4096 * sizeof(float));
+}
+
+}  // namespace interpreter
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,141 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/backends/cpu/numa.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/phi/core/threadpool.h"
+
+namespace phi {
+namespace backends {
+namespace cpu {
+
+TEST(Numa, topology) {
+  int node_num = NumaNodeCount();
+  EXPECT_GE(node_num, 1);
+  ASSERT_EQ(NumaNodeIds().size(), static_cast<size_t>(node_num));
+  for (int node : NumaNodeIds()) {
+    // nodes without cpus are not counted
+    EXPECT_FALSE(NumaNodeCpus(node).empty());
+    for (int cpu : NumaNodeCpus(node)) {
+      EXPECT_EQ(NumaNodeOfCpu(cpu), node);
+    }
+  }
+  EXPECT_TRUE(NumaNodeCpus(NumaNodeIds().back() + 1).empty());
+  EXPECT_TRUE(NumaNodeCpus(-1).empty());
+}
+
+TEST(Numa, bind_thread) {
+  EXPECT_EQ(CurrentThreadNumaNode(), -1);
+  int node = NumaNodeIds().back();
+  std::thread worker([node]() {
+    if (!BindCurrentThreadToNumaNode(node)) {
+      LOG(WARNING) << "Thread binding is not supported here";
+      return;
+    }
+    EXPECT_EQ(CurrentThreadNumaNode(), node);
+  });
+  worker.join();
+  // only the bound thread is affected
+  EXPECT_EQ(CurrentThreadNumaNode(), -1);
+  EXPECT_FALSE(BindCurrentThreadToNumaNode(NumaNodeIds().back() + 1));
+}
+
+TEST(Numa, scoped_binding_restores_affinity) {
+  std::thread worker([]() {
+    {
+      ScopedNumaNodeBinding binding(NumaNodeIds().back());
+      if (NumaNodeCount() > 1) {
+        EXPECT_EQ(CurrentThreadNumaNode(), NumaNodeIds().back());
+      }
+    }
+    // the thread is back to the state it had before the binding
+    EXPECT_EQ(CurrentThreadNumaNode(), -1);
+  });
+  worker.join();
+}
+
+TEST(Numa, spread_thread_pool) {
+  ThreadPool pool(4, /*numa_node*/ -2);
+  std::atomic<int> counter{0};
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < 16; ++i) {
+    futures.emplace_back(pool.Run([&counter]() { ++counter; }));
+  }
+  for (auto& f : futures) {
+    f.wait();
+  }
+  EXPECT_EQ(counter.load(), 16);
+}
+
+// Bandwidth of summing a buffer placed on the first node, read from a thread
+// on the first node and from a thread on the last node.
+static double ReadBandwidth(const float* data, size_t num, int node) {
+  double gbps = 0;
+  std::thread reader([&]() {
+    BindCurrentThreadToNumaNode(node);
+    volatile float sink = 0;
+    const int repeat = 5;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; ++r) {
+      float sum = 0;
+      for (size_t i = 0; i < num; i += 16) {
+        sum += data[i];
+      }
+      sink = sink + sum;
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    gbps = repeat * num * sizeof(float) / seconds / 1e9;
+  });
+  reader.join();
+  return gbps;
+}
+
+TEST(Numa, local_vs_remote_benchmark) {
+  const size_t num = 64UL << 20;  // 256MB of floats
+  void* ptr = nullptr;
+  ASSERT_EQ(posix_memalign(&ptr, 4096, num * sizeof(float)), 0);
+  float* data = static_cast<float*>(ptr);
+  const int first_node = NumaNodeIds().front();
+  bool bound = BindMemoryToNumaNode(data, num * sizeof(float), first_node);
+  std::fill(data, data + num, 1.0f);
+
+  double local = ReadBandwidth(data, num, first_node);
+  LOG(INFO) << "NUMA nodes: " << NumaNodeCount() << ", buffer bound: " << bound
+            << ", local read " << local << " GB/s";
+  if (NumaNodeCount() == 1) {
+    LOG(INFO) << "Single NUMA node, skip the remote read";
+    EXPECT_FALSE(bound);
+  } else {
+    double remote = ReadBandwidth(data, num, NumaNodeIds().back());
+    LOG(INFO) << "remote read " << remote << " GB/s";
+  }
+  free(ptr);  // NOLINT
+}
+
+}  // namespace cpu
+}  // namespace backends
+}  // namespace phi
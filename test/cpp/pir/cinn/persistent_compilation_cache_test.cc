@@ -0,0 +1,154 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/cinn/hlir/framework/pir/persistent_compilation_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "paddle/cinn/backends/compiler.h"
+#include "paddle/cinn/cinn.h"
+#include "paddle/cinn/common/test_helper.h"
+#include "paddle/cinn/runtime/use_extern_funcs.h"
+#include "paddle/fluid/framework/commit.h"
+
+namespace cinn::hlir::framework {
+
+namespace {
+
+constexpr int kM = 64;
+constexpr int kN = 32;
+
+ir::Module CreateAddModule() {
+  Expr M(kM), N(kN);
+  Placeholder<float> A("A", {M, N});
+  Placeholder<float> B("B", {M, N});
+  auto C = Compute(
+      {M, N}, [=](Expr i, Expr j) { return A(i, j) + B(i, j); }, "C");
+  auto stages = CreateStages({C});
+  auto fn = Lower("cached_add", stages, {A, B, C});
+  ir::Module::Builder builder("cached_module",
+                              cinn::common::DefaultHostTarget());
+  builder.AddFunction(fn);
+  return builder.Build();
+}
+
+// Runs fn_ptr, a kernel adding two kM x kN tensors, and checks the sum.
+void CheckAdd(void* fn_ptr) {
+  ASSERT_NE(fn_ptr, nullptr);
+  auto* a = cinn::common::BufferBuilder(Float(32), {kM, kN})
+                .set_random()
+                .Build();
+  auto* b = cinn::common::BufferBuilder(Float(32), {kM, kN})
+                .set_random()
+                .Build();
+  auto* c =
+      cinn::common::BufferBuilder(Float(32), {kM, kN}).set_zero().Build();
+  auto args = cinn::common::ArgsBuilder().Add(a).Add(b).Add(c).Build();
+  reinterpret_cast<void (*)(void*, int)>(fn_ptr)(args.data(), args.size());
+  auto* ad = reinterpret_cast<float*>(a->memory);
+  auto* bd = reinterpret_cast<float*>(b->memory);
+  auto* cd = reinterpret_cast<float*>(c->memory);
+  for (int i = 0; i < a->num_elements(); ++i) {
+    ASSERT_NEAR(ad[i] + bd[i], cd[i], 1e-5);
+  }
+}
+
+CompilationCacheEntry CompileEntry(const std::string& key) {
+  auto compiler =
+      backends::Compiler::Create(cinn::common::DefaultHostTarget());
+  compiler->Build(CreateAddModule());
+  CompilationCacheEntry entry;
+  entry.key = key;
+  entry.host_fn_name = "cached_add";
+  entry.infer_fn_name = "cached_add_infer_shape";
+  entry.int_args_map[3] = {0, 1};
+  entry.objects = compiler->GetObjects();
+  return entry;
+}
+
+}  // namespace
+
+TEST(PersistentCompilationCache, RoundTrip) {
+  const std::string path = "persistent_compilation_cache_round_trip.bin";
+  CompilationCacheEntry saved = CompileEntry("round trip");
+  ASSERT_FALSE(saved.objects.empty());
+  ASSERT_TRUE(WriteCompilationCacheEntry(path, saved));
+
+  CompilationCacheEntry loaded;
+  ASSERT_TRUE(ReadCompilationCacheEntry(path, "round trip", &loaded));
+  EXPECT_EQ(loaded.host_fn_name, saved.host_fn_name);
+  EXPECT_EQ(loaded.infer_fn_name, saved.infer_fn_name);
+  ASSERT_EQ(loaded.int_args_map.size(), 1UL);
+  EXPECT_EQ(loaded.int_args_map[3].arg_idx, 0);
+  EXPECT_EQ(loaded.int_args_map[3].dim_idx, 1);
+  EXPECT_EQ(loaded.objects, saved.objects);
+
+  // a fresh compiler links the objects without building the module
+  auto compiler =
+      backends::Compiler::Create(cinn::common::DefaultHostTarget());
+  for (const auto& object : loaded.objects) {
+    ASSERT_TRUE(compiler->AddObject(object));
+  }
+  CheckAdd(compiler->Lookup("cached_add"));
+  std::remove(path.c_str());
+}
+
+TEST(PersistentCompilationCache, RejectTruncatedEntry) {
+  const std::string path = "persistent_compilation_cache_truncated.bin";
+  ASSERT_TRUE(WriteCompilationCacheEntry(path, CompileEntry("truncated")));
+  std::string bytes;
+  {
+    std::ifstream is(path, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(is),
+                 std::istreambuf_iterator<char>());
+  }
+  CompilationCacheEntry loaded;
+  for (size_t size : {bytes.size() - 1, bytes.size() / 2, size_t{8}}) {
+    {
+      std::ofstream os(path, std::ios::binary | std::ios::trunc);
+      os.write(bytes.data(), size);
+    }
+    EXPECT_FALSE(ReadCompilationCacheEntry(path, "truncated", &loaded))
+        << "truncated to " << size << " bytes";
+  }
+  std::remove(path.c_str());
+}
+
+TEST(PersistentCompilationCache, RejectMismatchedKey) {
+  const std::string path = "persistent_compilation_cache_mismatch.bin";
+  const std::string key = "paddle 3.0.0 abc1234\nfusion";
+  ASSERT_TRUE(WriteCompilationCacheEntry(path, CompileEntry(key)));
+  CompilationCacheEntry loaded;
+  // another fusion group colliding on the file name
+  EXPECT_FALSE(ReadCompilationCacheEntry(
+      path, "paddle 3.0.0 abc1234\nother fusion", &loaded));
+  // the same fusion group saved by another build
+  EXPECT_FALSE(ReadCompilationCacheEntry(
+      path, "paddle 3.0.0 def5678\nfusion", &loaded));
+  EXPECT_TRUE(ReadCompilationCacheEntry(path, key, &loaded));
+  std::remove(path.c_str());
+
+  // the key of the cache tells the builds apart
+  const std::string& version = PersistentCompilationCache::Instance().version();
+  EXPECT_NE(version.find(paddle::framework::paddle_commit()),
+            std::string::npos);
+}
+
+}  // namespace cinn::hlir::framework
@@ -13,8 +13,11 @@
 // limitations under the License.
 
 #include <gtest/gtest.h>
+#include <atomic>
 #include "glog/logging.h"
 
+#include "paddle/common/flags.h"
+
 // NOTE(zhangbo9674): File pd_op.h is generated by op_gen.py, see details in
 // paddle/fluid/pir/dialect/CMakeLists.txt.
 #include "paddle/fluid/pir/dialect/operator/interface/op_yaml_info.h"
@@ -22,6 +25,8 @@
 #include "paddle/fluid/pir/dialect/operator/ir/op_type.h"
 #include "paddle/fluid/pir/dialect/operator/ir/pd_op.h"
 #include "paddle/fluid/pir/dialect/operator/utils/utils.h"
+#include "paddle/fluid/pir/transforms/general/map_op_to_another_pass.h"
+#include "paddle/fluid/pir/transforms/general/replace_fetch_with_shadow_output_pass.h"
 #include "paddle/fluid/platform/errors.h"
 #include "paddle/phi/core/enforce.h"
 #include "paddle/phi/kernels/elementwise_add_kernel.h"
@@ -34,7 +39,12 @@
 #include "paddle/pir/include/core/operation.h"
 #include "paddle/pir/include/pass/pass.h"
 #include "paddle/pir/include/pass/pass_manager.h"
+#include "paddle/pir/include/pass/pass_timing.h"
 #include "test/cpp/pir/tools/macros_utils.h"
+#include "test/cpp/pir/tools/test_dialect.h"
+#include "test/cpp/pir/tools/test_op.h"
+
+COMMON_DECLARE_int32(pir_pass_num_threads);
 
 #ifndef _WIN32
 class TestAnalysis1 {};
@@ -256,3 +266,167 @@ TEST(pass_manager, PassManager) {
 
   CHECK_EQ(pm.Run(&program), true);
 }
+
+class EraseUnusedFullPass : public pir::Pass {
+ public:
+  EraseUnusedFullPass() : pir::Pass("EraseUnusedFullPass", 1) {}
+
+  void Run(pir::Operation *op) override {
+    std::vector<pir::Operation *> unused_ops;
+    for (auto &inner_op : op->region(0).front()) {
+      if (inner_op.isa<paddle::dialect::FullOp>() &&
+          inner_op.result(0).use_empty()) {
+        unused_ops.push_back(&inner_op);
+      }
+    }
+    for (auto *unused_op : unused_ops) {
+      unused_op->Erase();
+    }
+    num_runs++;
+    AddStatistics(static_cast<int64_t>(unused_ops.size()));
+  }
+
+  bool CanApplyOn(pir::Operation *op) const override {
+    return op->isa<test::RegionOp>();
+  }
+
+  bool IsRegionLocal() const override { return true; }
+
+  std::atomic<int> num_runs{0};
+};
+
+TEST(pass_manager, MultiThreading) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<test::TestDialect>();
+  pir::Program program(ctx);
+  pir::Builder builder = pir::Builder(ctx, program.block());
+
+  auto shared_op = builder.Build<paddle::dialect::FullOp>(
+      std::vector<int64_t>{64}, 1.5, phi::DataType::FLOAT32, phi::CPUPlace());
+  std::vector<pir::Block *> blocks;
+  for (int i = 0; i < 8; ++i) {
+    builder.SetInsertionPointToBlockEnd(program.block());
+    auto region_op = builder.Build<test::RegionOp>();
+    blocks.push_back(&region_op->region(0).emplace_back());
+  }
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    builder.SetInsertionPointToBlockEnd(blocks[i]);
+    for (int j = 0; j < 3; ++j) {
+      builder.Build<paddle::dialect::FullOp>(std::vector<int64_t>{64},
+                                             1.5,
+                                             phi::DataType::FLOAT32,
+                                             phi::CPUPlace());
+    }
+    // The first two region ops use the same value from above, so they can
+    // not run concurrently.
+    if (i < 2) {
+      auto full_op = builder.Build<paddle::dialect::FullOp>(
+          std::vector<int64_t>{64},
+          1.5,
+          phi::DataType::FLOAT32,
+          phi::CPUPlace());
+      builder.Build<paddle::dialect::AddOp>(shared_op.out(), full_op.out());
+    }
+  }
+
+  pir::PassManager pm(ctx);
+  auto pass = std::make_unique<EraseUnusedFullPass>();
+  auto *pass_ptr = pass.get();
+  pm.AddPass(std::move(pass));
+  auto timer = std::make_unique<pir::PassTimer>(false, false);
+  auto *timer_ptr = timer.get();
+  pm.AddInstrumentation(std::move(timer));
+  pm.EnableMultiThreading(4);
+
+  CHECK_EQ(pm.Run(&program), true);
+  EXPECT_EQ(pass_ptr->num_runs, 8);
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    EXPECT_EQ(blocks[i]->size(), i < 2 ? 2u : 0u);
+  }
+  EXPECT_EQ(program.block()->size(), 9u);
+
+  auto pass_times = timer_ptr->GetPassTimes();
+  EXPECT_EQ(pass_times.size(), 1u);
+  EXPECT_EQ(pass_times[0].first, "EraseUnusedFullPass");
+}
+
+// Builds a program with a fetch and 8 region ops, each of which holds a
+// depthwise conv2d on its own inputs.
+void BuildDepthwiseConv2dProgram(pir::Program *program,
+                                 std::vector<pir::Block *> *blocks) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+  pir::Builder builder = pir::Builder(ctx, program->block());
+  auto full_op = builder.Build<paddle::dialect::FullOp>(
+      std::vector<int64_t>{64}, 1.5, phi::DataType::FLOAT32, phi::CPUPlace());
+  builder.Build<paddle::dialect::FetchOp>(full_op.out(), "out", 0);
+  for (int i = 0; i < 8; ++i) {
+    builder.SetInsertionPointToBlockEnd(program->block());
+    auto region_op = builder.Build<test::RegionOp>();
+    blocks->push_back(&region_op->region(0).emplace_back());
+  }
+  for (auto *block : *blocks) {
+    builder.SetInsertionPointToBlockEnd(block);
+    auto input = builder.Build<paddle::dialect::FullOp>(
+        std::vector<int64_t>{1, 4, 8, 8},
+        1.5,
+        phi::DataType::FLOAT32,
+        phi::CPUPlace());
+    auto filter = builder.Build<paddle::dialect::FullOp>(
+        std::vector<int64_t>{4, 1, 3, 3},
+        1.5,
+        phi::DataType::FLOAT32,
+        phi::CPUPlace());
+    builder.Build<paddle::dialect::DepthwiseConv2dOp>(input.out(),
+                                                      filter.out(),
+                                                      std::vector<int>{1, 1},
+                                                      std::vector<int>{1, 1},
+                                                      "EXPLICIT",
+                                                      4);
+  }
+}
+
+TEST(pass_manager, MultiThreadingRegionLocalPasses) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<test::TestDialect>();
+
+  auto run_pipeline = [&](pir::Program *program, int num_threads) {
+    int old_num_threads = FLAGS_pir_pass_num_threads;
+    FLAGS_pir_pass_num_threads = num_threads;
+    pir::PassManager pm(ctx, 2);
+    FLAGS_pir_pass_num_threads = old_num_threads;
+    pm.AddPass(pir::CreateReplaceFetchWithShadowOutputPass());
+    pm.AddPass(pir::CreateMapOpToAnotherPass());
+    return pm.Run(program);
+  };
+
+  pir::Program serial_program(ctx);
+  std::vector<pir::Block *> serial_blocks;
+  BuildDepthwiseConv2dProgram(&serial_program, &serial_blocks);
+  CHECK_EQ(run_pipeline(&serial_program, 1), true);
+
+  pir::Program parallel_program(ctx);
+  std::vector<pir::Block *> parallel_blocks;
+  BuildDepthwiseConv2dProgram(&parallel_program, &parallel_blocks);
+  CHECK_EQ(run_pipeline(&parallel_program, 4), true);
+
+  size_t num_fetch_ops = 0;
+  size_t num_shadow_output_ops = 0;
+  for (auto &op : *parallel_program.block()) {
+    num_fetch_ops += op.isa<paddle::dialect::FetchOp>();
+    num_shadow_output_ops += op.isa<pir::ShadowOutputOp>();
+  }
+  EXPECT_EQ(num_fetch_ops, 0u);
+  EXPECT_EQ(num_shadow_output_ops, 1u);
+  // The depthwise conv2d is only mapped to conv2d on GPU, the parallel run
+  // rewrites every region the same way as the serial one.
+  for (size_t i = 0; i < parallel_blocks.size(); ++i) {
+    ASSERT_EQ(parallel_blocks[i]->size(), 3u);
+    ASSERT_EQ(serial_blocks[i]->size(), 3u);
+    EXPECT_EQ(parallel_blocks[i]->back().name(),
+              serial_blocks[i]->back().name());
+    EXPECT_EQ(parallel_blocks[i]->back().name(),
+              serial_blocks[0]->back().name());
+  }
+}
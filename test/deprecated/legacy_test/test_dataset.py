@@ -20,6 +20,8 @@ import os
 import tempfile
 import unittest
 
+import numpy as np
+
 import paddle
 from paddle import base
 from paddle.base import core
@@ -291,6 +293,207 @@ class TestDataset(unittest.TestCase):
 
         temp_dir.cleanup()
 
+    def _parse_text_records(self, data):
+        """
+        Parse MultiSlot text lines into tuples of slot values.
+        """
+        records = []
+        for line in data.splitlines():
+            tokens = [int(token) for token in line.split()]
+            record = []
+            while tokens:
+                record.append(tuple(tokens[1 : tokens[0] + 1]))
+                tokens = tokens[tokens[0] + 1 :]
+            records.append(tuple(record))
+        return sorted(records)
+
+    def _read_dataset_records(self, dataset, slots):
+        """
+        Read the records of an in memory dataset as tuples of slot values.
+        """
+        records = []
+        # the loader reads through one channel, gather the records in it
+        dataset._dynamic_adjust_before_train(1)
+        data_loader = base.io.DataLoader.from_dataset(
+            dataset, base.cpu_places(1), False
+        )
+        for data in data_loader():
+            batch = []
+            for slot in slots:
+                tensor = data[0][slot]
+                values = np.array(tensor).reshape([-1]).tolist()
+                offsets = tensor.lod()[0]
+                batch.append(
+                    [
+                        tuple(values[offsets[i] : offsets[i + 1]])
+                        for i in range(len(offsets) - 1)
+                    ]
+                )
+            records.extend(zip(*batch))
+        return sorted(records)
+
+    def test_in_memory_dataset_columnar_records(self):
+        """
+        Testcase for InMemoryDataset loading dumped columnar records.
+        """
+        temp_dir = tempfile.TemporaryDirectory()
+        filename = os.path.join(
+            temp_dir.name, "test_in_memory_dataset_columnar_records.txt"
+        )
+        with open(filename, "w") as f:
+            data = "1 1 2 3 3 4 5 5 5 5 1 1\n"
+            data += "1 2 2 3 4 4 6 6 6 6 1 2\n"
+            data += "1 3 2 3 5 4 7 7 7 7 1 3\n"
+            data += "1 4 2 3 3 4 5 5 5 5 1 4\n"
+            data += "1 5 2 3 4 4 6 6 6 6 1 5\n"
+            f.write(data)
+
+        slots = ["slot1", "slot2", "slot3", "slot4"]
+        slots_vars = []
+        for slot in slots:
+            var = paddle.static.data(
+                name=slot, shape=[-1, 1], dtype="int64", lod_level=1
+            )
+            slots_vars.append(var)
+
+        expected = self._parse_text_records(data)
+
+        exe = base.Executor(base.CPUPlace())
+        exe.run(base.default_startup_program())
+        # the records are in the input channel after loading, and in the
+        # output channels after a shuffle
+        for shuffle in [False, True]:
+            dataset = paddle.distributed.InMemoryDataset()
+            dataset.init(
+                batch_size=32,
+                thread_num=2,
+                pipe_command="cat",
+                use_var=slots_vars,
+            )
+            dataset.set_filelist([filename])
+            dataset.load_into_memory()
+            if shuffle:
+                dataset.local_shuffle()
+            files = dataset._dump_columnar_records(
+                os.path.join(temp_dir.name, f"columnar_{shuffle}")
+            )
+            self.assertEqual(len(files), 2)
+            self.assertEqual(dataset.get_memory_data_size(), 5)
+
+            columnar_dataset = paddle.distributed.InMemoryDataset()
+            columnar_dataset.init(
+                batch_size=32,
+                thread_num=2,
+                data_feed_type="MultiSlotColumnarInMemoryDataFeed",
+                use_var=slots_vars,
+            )
+            columnar_dataset.set_filelist(files)
+            columnar_dataset.load_into_memory()
+            self.assertEqual(columnar_dataset.get_memory_data_size(), 5)
+            self.assertEqual(
+                self._read_dataset_records(columnar_dataset, slots), expected
+            )
+
+            for i in range(self.epoch_num):
+                exe.train_from_dataset(
+                    base.default_main_program(), columnar_dataset
+                )
+
+        temp_dir.cleanup()
+
+    def test_in_memory_dataset_lock_free_channel(self):
+        """
+        Testcase for InMemoryDataset with lock-free channels.
+        """
+        temp_dir = tempfile.TemporaryDirectory()
+        filename = os.path.join(
+            temp_dir.name, "test_in_memory_dataset_lock_free_channel.txt"
+        )
+        with open(filename, "w") as f:
+            data = "1 1 2 3 3 4 5 5 5 5 1 1\n"
+            data += "1 2 2 3 4 4 6 6 6 6 1 2\n"
+            data += "1 3 2 3 5 4 7 7 7 7 1 3\n"
+            data += "1 4 2 3 3 4 5 5 5 5 1 4\n"
+            data += "1 5 2 3 4 4 6 6 6 6 1 5\n"
+            f.write(data)
+
+        slots = ["slot1", "slot2", "slot3", "slot4"]
+        slots_vars = []
+        for slot in slots:
+            var = paddle.static.data(
+                name=slot, shape=[-1, 1], dtype="int64", lod_level=1
+            )
+            slots_vars.append(var)
+
+        dataset = paddle.distributed.InMemoryDataset()
+        dataset.init(
+            batch_size=32,
+            thread_num=3,
+            pipe_command="cat",
+            use_var=slots_vars,
+            lock_free_channel=True,
+        )
+        dataset.set_filelist([filename])
+        dataset.load_into_memory()
+        dataset.local_shuffle()
+        self.assertEqual(dataset.get_memory_data_size(), 5)
+
+        exe = base.Executor(base.CPUPlace())
+        exe.run(base.default_startup_program())
+        for i in range(self.epoch_num):
+            exe.train_from_dataset(base.default_main_program(), dataset)
+
+        # every record comes out of the channels once and unchanged
+        self.assertEqual(
+            self._read_dataset_records(dataset, slots),
+            self._parse_text_records(data),
+        )
+
+        temp_dir.cleanup()
+
+    def test_in_memory_dataset_prefetch_reader(self):
+        """
+        Testcase for InMemoryDataset reading files ahead.
+        """
+        temp_dir = tempfile.TemporaryDirectory()
+        filenames = []
+        for i in range(3):
+            filename = os.path.join(
+                temp_dir.name, f"test_in_memory_dataset_prefetch_{i}.txt"
+            )
+            with open(filename, "w") as f:
+                for j in range(100):
+                    f.write(f"1 {j} 2 3 3 4 5 5 5 5 1 {i}\n")
+            filenames.append(filename)
+
+        slots = ["slot1", "slot2", "slot3", "slot4"]
+        slots_vars = []
+        for slot in slots:
+            var = paddle.static.data(
+                name=slot, shape=[-1, 1], dtype="int64", lod_level=1
+            )
+            slots_vars.append(var)
+
+        for pipe_command in ["cat", "cat | cat"]:
+            dataset = paddle.distributed.InMemoryDataset()
+            dataset.init(
+                batch_size=32,
+                thread_num=2,
+                pipe_command=pipe_command,
+                use_var=slots_vars,
+                prefetch_read_ahead=2,
+            )
+            dataset.set_filelist(filenames)
+            dataset.load_into_memory()
+            self.assertEqual(dataset.get_memory_data_size(), 300)
+
+        exe = base.Executor(base.CPUPlace())
+        exe.run(base.default_startup_program())
+        for i in range(self.epoch_num):
+            exe.train_from_dataset(base.default_main_program(), dataset)
+
+        temp_dir.cleanup()
+
     def test_in_memory_dataset_gpugraph_mode(self):
         """
         Testcase for InMemoryDataset in gpugraph mode.
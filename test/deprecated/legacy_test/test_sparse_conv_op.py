@@ -314,6 +314,52 @@ class TestSparseConv(unittest.TestCase):
             rtol=1e-5,
         )
 
+    def test_Conv3D_cpu_blocks(self):
+        # the rulebook has several chunks and the weights several blocks
+        origin_device = paddle.get_device()
+        paddle.set_device('cpu')
+        paddle.seed(0)
+        shape = [2, 12, 24, 24, 4]
+        mask = (paddle.rand(shape[:-1] + [1]) < 0.4).astype('float32')
+        x = paddle.randn(shape) * mask
+        sp_x = x.to_sparse_coo(4)
+        for stride, subm in [(1, False), (2, False), (1, True)]:
+            conv3d = paddle.nn.Conv3D(
+                4,
+                8,
+                3,
+                stride=stride,
+                padding=1,
+                data_format='NDHWC',
+                bias_attr=False,
+            )
+            if subm:
+                sp_conv3d = paddle.sparse.nn.SubmConv3D(
+                    4, 8, 3, padding=1, data_format='NDHWC', bias_attr=False
+                )
+            else:
+                sp_conv3d = paddle.sparse.nn.Conv3D(
+                    4,
+                    8,
+                    3,
+                    stride=stride,
+                    padding=1,
+                    data_format='NDHWC',
+                    bias_attr=False,
+                )
+            sp_conv3d.weight.set_value(
+                paddle.to_tensor(conv3d.weight.numpy().transpose(2, 3, 4, 1, 0))
+            )
+            out = conv3d(x)
+            if subm:
+                # only the non zero elements of x are computed
+                out = out * mask
+            dense_out = sp_conv3d(sp_x).to_dense()
+            np.testing.assert_allclose(
+                out.numpy(), dense_out.numpy(), atol=1e-3, rtol=1e-3
+            )
+        paddle.set_device(origin_device)
+
 
 class TestStatic(unittest.TestCase):
     @compare_legacy_with_pt
@@ -0,0 +1,84 @@
+# Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Times paddle.sparse.matmul of a CSR and a COO matrix with a dense one on
+# CPU, which runs through SparseBlas<CPUContext>, against paddle.matmul of
+# the same matrices stored dense, for growing densities of the sparse side.
+#
+#   python benchmark_sparse_matmul.py --m 1024 --k 1024 --n 256 \
+#       --densities 0.001 0.01 0.05 0.1 0.2 0.5
+
+import argparse
+import time
+
+import numpy as np
+
+import paddle
+
+
+def timeit(fn, repeat):
+    fn()
+    begin = time.perf_counter()
+    for _ in range(repeat):
+        fn()
+    return (time.perf_counter() - begin) / repeat * 1000
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--m', type=int, default=1024)
+    parser.add_argument('--k', type=int, default=1024)
+    parser.add_argument('--n', type=int, default=256)
+    parser.add_argument(
+        '--densities',
+        type=float,
+        nargs='+',
+        default=[0.001, 0.01, 0.05, 0.1, 0.2, 0.5],
+    )
+    parser.add_argument('--dtype', default='float32')
+    parser.add_argument('--repeat', type=int, default=10)
+    args = parser.parse_args()
+
+    paddle.set_device('cpu')
+    rng = np.random.default_rng(2024)
+    y = paddle.to_tensor(rng.standard_normal((args.k, args.n)), args.dtype)
+    for density in args.densities:
+        mask = rng.random((args.m, args.k)) < density
+        dense = paddle.to_tensor(
+            rng.standard_normal((args.m, args.k)) * mask, args.dtype
+        )
+        csr = dense.to_sparse_csr()
+        coo = dense.to_sparse_coo(2)
+
+        expected = paddle.matmul(dense, y).numpy()
+        for sparse in (csr, coo):
+            np.testing.assert_allclose(
+                paddle.sparse.matmul(sparse, y).numpy(),
+                expected,
+                rtol=1e-4,
+                atol=1e-4,
+            )
+
+        dense_ms = timeit(lambda: paddle.matmul(dense, y), args.repeat)
+        csr_ms = timeit(lambda: paddle.sparse.matmul(csr, y), args.repeat)
+        coo_ms = timeit(lambda: paddle.sparse.matmul(coo, y), args.repeat)
+        print(
+            f'density {density:6.3f} (nnz {int(mask.sum()):8d}): '
+            f'csr {csr_ms:8.2f} ms, coo {coo_ms:8.2f} ms, '
+            f'dense {dense_ms:8.2f} ms'
+        )
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,98 @@
+# Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Times variable_length_memory_efficient_attention on CPU against the
+# attention composed of matmul and softmax, which materializes the scores of
+# the whole sequence, for growing sequence lengths.
+#
+#   python benchmark_variable_length_memory_efficient_attention.py \
+#       --seq_lens 128 512 2048 8192 16384 --dtype float32
+
+import argparse
+import time
+
+import paddle
+from paddle.incubate.nn.functional import (
+    variable_length_memory_efficient_attention,
+)
+
+
+def naive_attention(query, key, value, scale, causal):
+    score = paddle.matmul(query, key, transpose_y=True) * scale
+    if causal:
+        seq_len = query.shape[2]
+        mask = paddle.triu(
+            paddle.full([seq_len, seq_len], float('-inf'), 'float32'), 1
+        )
+        score = score + mask.astype(score.dtype)
+    return paddle.matmul(paddle.nn.functional.softmax(score, -1), value)
+
+
+def timeit(fn, repeat):
+    fn()
+    begin = time.perf_counter()
+    for _ in range(repeat):
+        fn()
+    return (time.perf_counter() - begin) / repeat * 1000
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument(
+        '--seq_lens', type=int, nargs='+', default=[128, 512, 2048, 8192, 16384]
+    )
+    parser.add_argument('--batch_size', type=int, default=1)
+    parser.add_argument('--num_head', type=int, default=8)
+    parser.add_argument('--dim_head', type=int, default=64)
+    parser.add_argument('--dtype', default='float32')
+    parser.add_argument('--causal', action='store_true')
+    parser.add_argument('--repeat', type=int, default=3)
+    # the naive attention needs seq_len * seq_len scores per head
+    parser.add_argument('--naive_max_seq_len', type=int, default=4096)
+    args = parser.parse_args()
+
+    paddle.set_device('cpu')
+    scale = args.dim_head**-0.5
+    for seq_len in args.seq_lens:
+        shape = [args.batch_size, args.num_head, seq_len, args.dim_head]
+        query = paddle.randn(shape).astype(args.dtype)
+        key = paddle.randn(shape).astype(args.dtype)
+        value = paddle.randn(shape).astype(args.dtype)
+        seq_lens = paddle.full([args.batch_size], seq_len, 'int32')
+
+        tiled = timeit(
+            lambda: variable_length_memory_efficient_attention(
+                query,
+                key,
+                value,
+                seq_lens,
+                seq_lens,
+                None,
+                scale,
+                args.causal,
+            ),
+            args.repeat,
+        )
+        line = f'seq_len {seq_len:6d}: tiled {tiled:10.2f} ms'
+        if seq_len <= args.naive_max_seq_len:
+            naive = timeit(
+                lambda: naive_attention(query, key, value, scale, args.causal),
+                args.repeat,
+            )
+            line += f', naive {naive:10.2f} ms'
+        print(line)
+
+
+if __name__ == '__main__':
+    main()
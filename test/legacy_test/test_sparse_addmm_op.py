@@ -71,7 +71,7 @@ class TestAddmm(unittest.TestCase):
         np.testing.assert_allclose(
             sp_out.numpy(), dense_out.numpy(), rtol=1e-05
         )
-        if get_cuda_version() >= 11030:
+        if paddle.get_device() == 'cpu' or get_cuda_version() >= 11030:
             dense_out.backward()
             sp_out.backward()
             np.testing.assert_allclose(
@@ -105,5 +105,22 @@ class TestAddmm(unittest.TestCase):
         self.check_result([8, 16, 10], [8, 16, 12], [8, 12, 10], 'csr')
 
 
+class TestAddmmCPU(TestAddmm):
+    def setUp(self):
+        self.origin_device = paddle.get_device()
+        paddle.set_device('cpu')
+
+    def tearDown(self):
+        paddle.set_device(self.origin_device)
+
+    def test_addmm_2d(self):
+        self.check_result([16, 10], [16, 12], [12, 10], 'coo')
+        self.check_result([16, 10], [16, 12], [12, 10], 'csr')
+
+    def test_addmm_3d(self):
+        self.check_result([8, 16, 10], [8, 16, 12], [8, 12, 10], 'coo')
+        self.check_result([8, 16, 10], [8, 16, 12], [8, 12, 10], 'csr')
+
+
 if __name__ == "__main__":
     unittest.main()
@@ -66,7 +66,7 @@ class TestMatmulSparseDense(unittest.TestCase):
         np.testing.assert_allclose(
             sp_out.numpy(), dense_out.numpy(), rtol=1e-05
         )
-        if get_cuda_version() >= 11030:
+        if paddle.get_device() == 'cpu' or get_cuda_version() >= 11030:
             dense_out.backward()
             sp_out.backward()
             np.testing.assert_allclose(
@@ -95,6 +95,25 @@ class TestMatmulSparseDense(unittest.TestCase):
         self.check_result([8, 16, 12], [8, 12, 10], 'csr')
 
 
+class TestMatmulSparseDenseCPU(TestMatmulSparseDense):
+    def setUp(self):
+        self.origin_device = paddle.get_device()
+        paddle.set_device('cpu')
+
+    def tearDown(self):
+        paddle.set_device(self.origin_device)
+
+    def test_matmul_2d(self):
+        self.check_result([16, 12], [12, 10], 'coo')
+        self.check_result([16, 12], [12, 10], 'csr')
+        # the columns of y are taken in several blocks
+        self.check_result([64, 1024], [1024, 96], 'csr')
+
+    def test_matmul_3d(self):
+        self.check_result([8, 16, 12], [8, 12, 10], 'coo')
+        self.check_result([8, 16, 12], [8, 12, 10], 'csr')
+
+
 class TestMatmulSparseSparseInt64Index(unittest.TestCase):
     # x: sparse, y: sparse, out: sparse
     def check_result(self, x_shape, y_shape, format):
@@ -307,5 +326,71 @@ class TestMaskedMatmul(unittest.TestCase):
         )
 
 
+class TestMaskedMatmulCPU(unittest.TestCase):
+    # x: dense, y: dense, out: sparse_csr
+    def setUp(self):
+        self.origin_device = paddle.get_device()
+        paddle.set_device('cpu')
+
+    def tearDown(self):
+        paddle.set_device(self.origin_device)
+
+    def test_masked_matmul_2d(self):
+        np_mask = np.random.rand(10, 6) < 0.2
+
+        np_x = np.random.rand(10, 12)
+        np_y = np.random.rand(12, 6)
+        np_out = sp.csr_matrix(np.matmul(np_x, np_y) * np_mask)
+
+        np_out_grad = sp.csr_matrix(np.ones([10, 6]) * np_mask)
+        np_x_grad = np_out_grad @ np_y.transpose(1, 0)
+        np_y_grad = (np_out_grad.transpose() @ np_x).transpose(1, 0)
+
+        x = paddle.to_tensor(np_x, stop_gradient=False)
+        y = paddle.to_tensor(np_y, stop_gradient=False)
+        mask = paddle.to_tensor(np.ones([10, 6]) * np_mask).to_sparse_csr()
+        out = paddle.sparse.masked_matmul(x, y, mask)
+
+        np.testing.assert_allclose(
+            np_out.indptr, out.crows().numpy(), rtol=1e-05
+        )
+        np.testing.assert_allclose(
+            np_out.indices, out.cols().numpy(), rtol=1e-05
+        )
+        np.testing.assert_allclose(
+            np_out.data, out.values().numpy(), rtol=1e-05
+        )
+
+        out.backward()
+        np.testing.assert_allclose(out.is_sparse_csr(), True, rtol=1e-05)
+        np.testing.assert_allclose(np_x_grad, x.grad.numpy(), rtol=1e-05)
+        np.testing.assert_allclose(np_y_grad, y.grad.numpy(), rtol=1e-05)
+
+    def test_masked_matmul_3d(self):
+        np_mask = np.random.rand(4, 10, 6) < 0.2
+        np_x = np.random.rand(4, 10, 12)
+        np_y = np.random.rand(4, 12, 6)
+        np_out = np.matmul(np_x, np_y) * np_mask
+
+        x = paddle.to_tensor(np_x, stop_gradient=False)
+        y = paddle.to_tensor(np_y, stop_gradient=False)
+        mask = paddle.to_tensor(np.ones([4, 10, 6]) * np_mask).to_sparse_csr()
+        out = paddle.sparse.masked_matmul(x, y, mask)
+        np.testing.assert_allclose(np_out, out.to_dense().numpy(), rtol=1e-05)
+
+        out.backward()
+        np_out_grad = np.ones([4, 10, 6]) * np_mask
+        np.testing.assert_allclose(
+            np.matmul(np_out_grad, np_y.transpose(0, 2, 1)),
+            x.grad.numpy(),
+            rtol=1e-05,
+        )
+        np.testing.assert_allclose(
+            np.matmul(np_x.transpose(0, 2, 1), np_out_grad),
+            y.grad.numpy(),
+            rtol=1e-05,
+        )
+
+
 if __name__ == "__main__":
     unittest.main()
@@ -115,5 +115,57 @@ class TestCooMv(unittest.TestCase):
         )
 
 
+class TestMvCPU(unittest.TestCase):
+    # x: csr/coo-matrix, y: dense-vec, out: dense-vec
+    def setUp(self):
+        self.origin_device = paddle.get_device()
+        paddle.set_device('cpu')
+
+    def tearDown(self):
+        paddle.set_device(self.origin_device)
+
+    def check_result(self, format):
+        paddle.set_default_dtype('float64')
+        origin_x = paddle.rand([64, 32])
+        mask = paddle.randint(0, 2, [64, 32])
+        origin_x = origin_x * mask.astype('float64')
+        origin_vec = paddle.rand([32])
+
+        dense_x = origin_x.detach()
+        dense_x.stop_gradient = False
+        dense_vec = origin_vec.detach()
+        dense_vec.stop_gradient = False
+        dense_out = paddle.mv(dense_x, dense_vec)
+        dense_out.backward()
+
+        if format == "coo":
+            sp_x = origin_x.detach().to_sparse_coo(sparse_dim=2)
+        else:
+            sp_x = origin_x.detach().to_sparse_csr()
+        sp_x.stop_gradient = False
+        sp_vec = origin_vec.detach()
+        sp_vec.stop_gradient = False
+        sp_out = paddle.sparse.mv(sp_x, sp_vec)
+        sp_out.backward()
+
+        np.testing.assert_allclose(
+            sp_out.numpy(), dense_out.numpy(), rtol=1e-05
+        )
+        np.testing.assert_allclose(
+            sp_x.grad.to_dense().numpy(),
+            (dense_x.grad * mask.astype('float64')).numpy(),
+            rtol=1e-05,
+        )
+        np.testing.assert_allclose(
+            sp_vec.grad.numpy(), dense_vec.grad.numpy(), rtol=1e-05
+        )
+
+    def test_csr_mv(self):
+        self.check_result('csr')
+
+    def test_coo_mv(self):
+        self.check_result('coo')
+
+
 if __name__ == "__main__":
     unittest.main()
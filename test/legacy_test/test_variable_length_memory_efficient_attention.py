@@ -343,5 +343,171 @@ class TestMemEffAPIVariableDtypeFP16Static(unittest.TestCase):
         np.testing.assert_allclose(res[0], self.ref_out, rtol=5e-03, atol=1e-03)
 
 
+def naive_attention_numpy(
+    query, key, value, seq_lens, kv_seq_lens, mask, scale, causal, pre_cache
+):
+    batch_size, num_head, seq_len, _ = query.shape
+    kv_num_head = key.shape[1]
+    out = np.zeros(query.shape[:3] + value.shape[3:], dtype='float64')
+    for i in range(batch_size):
+        q_len = seq_lens[i]
+        kv_len = kv_seq_lens[i] + pre_cache if q_len > 0 else 0
+        for j in range(num_head):
+            kv_j = j // (num_head // kv_num_head)
+            score = query[i, j, :q_len] @ key[i, kv_j, :kv_len].T * scale
+            if mask is not None:
+                score += mask[i, j % mask.shape[1], :q_len, :kv_len]
+            if causal:
+                # the i-th query sees the keys up to the i-th one, as the
+                # cutlass kernel does
+                row = np.arange(q_len)[:, None]
+                col = np.arange(kv_len)[None, :]
+                score[col > row] = -np.inf
+            score = np.exp(score - score.max(axis=-1, keepdims=True))
+            score /= score.sum(axis=-1, keepdims=True)
+            out[i, j, :q_len] = score @ value[i, kv_j, :kv_len]
+    return out
+
+
+class TestMemEffAttentionVariableCPU(unittest.TestCase):
+    def setUp(self):
+        self.batch_size = 3
+        self.num_head = 4
+        self.kv_num_head = 2
+        self.seq_len = 100
+        self.dim_head = 32
+        self.seq_lens = [100, 37, 0]
+        self.pre_cache = 0
+        self.kv_seq_len = self.seq_len
+        self.kv_seq_lens = self.seq_lens
+        self.causal = False
+        self.mask_heads = 1
+        self.dtype = 'float32'
+        self.rtol = 1e-5
+        self.atol = 1e-5
+        self.config()
+
+    def config(self):
+        pass
+
+    def test_all(self):
+        paddle.disable_static()
+        place = paddle.get_device()
+        paddle.set_device('cpu')
+        query = np.random.random(
+            (self.batch_size, self.num_head, self.seq_len, self.dim_head)
+        )
+        key = np.random.random(
+            (self.batch_size, self.kv_num_head, self.kv_seq_len, self.dim_head)
+        )
+        value = np.random.random(
+            (self.batch_size, self.kv_num_head, self.kv_seq_len, self.dim_head)
+        )
+        mask = None
+        if self.mask_heads > 0:
+            mask = np.random.uniform(
+                -5,
+                0,
+                (
+                    self.batch_size,
+                    self.mask_heads,
+                    self.seq_len,
+                    self.kv_seq_len,
+                ),
+            )
+        scale = 1.0 / np.sqrt(self.dim_head)
+
+        def to_tensor(x):
+            return paddle.to_tensor(x, dtype='float32').astype(self.dtype)
+
+        out = variable_length_memory_efficient_attention(
+            to_tensor(query),
+            to_tensor(key),
+            to_tensor(value),
+            paddle.to_tensor(self.seq_lens, 'int32'),
+            paddle.to_tensor(self.kv_seq_lens, 'int32'),
+            None if mask is None else to_tensor(mask),
+            scale,
+            self.causal,
+            self.pre_cache,
+        )
+        paddle.set_device(place)
+
+        def round_trip(x):
+            return to_tensor(x).astype('float32').numpy()
+
+        ref = naive_attention_numpy(
+            round_trip(query),
+            round_trip(key),
+            round_trip(value),
+            self.seq_lens,
+            self.kv_seq_lens,
+            None if mask is None else round_trip(mask),
+            scale,
+            self.causal,
+            self.pre_cache,
+        )
+        np.testing.assert_allclose(
+            out.astype('float32').numpy(),
+            ref,
+            rtol=self.rtol,
+            atol=self.atol,
+        )
+
+
+class TestMemEffAttentionVariableCPUCausal(TestMemEffAttentionVariableCPU):
+    def config(self):
+        self.seq_len = 300
+        self.kv_seq_len = 300
+        self.seq_lens = [300, 129, 1]
+        self.kv_seq_lens = self.seq_lens
+        self.causal = True
+        self.mask_heads = 0
+
+
+class TestMemEffAttentionVariableCPUHeadMask(TestMemEffAttentionVariableCPU):
+    def config(self):
+        self.kv_num_head = 4
+        self.causal = True
+        self.mask_heads = 4
+
+
+class TestMemEffAttentionVariableCPUCache(TestMemEffAttentionVariableCPU):
+    def config(self):
+        # 70 appended queries attend to the 300 cached keys and their own
+        # ones; a causal mask is aligned to the first key, so it would hide
+        # most of the cache
+        self.seq_len = 70
+        self.pre_cache = 300
+        self.kv_seq_len = 370
+        self.seq_lens = [70, 21, 70]
+        self.kv_seq_lens = self.seq_lens
+        self.causal = False
+
+
+class TestMemEffAttentionVariableCPUDecode(TestMemEffAttentionVariableCPU):
+    def config(self):
+        # one decoded query attends to the 600 cached keys and its own one
+        self.seq_len = 1
+        self.pre_cache = 600
+        self.kv_seq_len = 601
+        self.seq_lens = [1, 1, 1]
+        self.kv_seq_lens = self.seq_lens
+        self.causal = False
+        self.mask_heads = 0
+
+
+class TestMemEffAttentionVariableCPUBF16(TestMemEffAttentionVariableCPU):
+    def config(self):
+        self.seq_len = 300
+        self.kv_seq_len = 300
+        self.seq_lens = [300, 129, 1]
+        self.kv_seq_lens = self.seq_lens
+        self.causal = True
+        self.dtype = 'bfloat16'
+        self.rtol = 2e-2
+        self.atol = 2e-2
+
+
 if __name__ == '__main__':
     unittest.main()
@@ -701,6 +701,127 @@ class WeightOnlyLinearTestCaseStatic(WeightOnlyLinearTestCase):
         )
 
 
+class WeightOnlyLinearCPUTestCase(unittest.TestCase):
+    def config(self):
+        self.dtype = 'float32'
+        self.weight_dtype = "int8"
+        self.group_size = -1
+        self.arch = 80
+        self.batch = 2
+        self.token = 2
+        self.in_features = 256
+        self.out_features = 96
+        self.bias = True
+        self.atol = 1e-3
+
+    def setUp(self):
+        self.config()
+        self.origin_device = paddle.get_device()
+        paddle.set_device('cpu')
+        self.x = np.random.uniform(
+            -1, 1, (self.batch, self.token, self.in_features)
+        ).astype('float32')
+        self.weight = np.random.uniform(
+            -1, 1, (self.in_features, self.out_features)
+        ).astype('float32')
+        self.bias_np = (
+            np.random.uniform(-1, 1, (self.out_features,)).astype('float32')
+            if self.bias
+            else None
+        )
+
+    def tearDown(self):
+        paddle.set_device(self.origin_device)
+
+    def get_dequantized_weight(self):
+        # the weight quantized as weight_quantize does
+        bound = 127.0 if self.weight_dtype == "int8" else 7.0
+        group_size = (
+            self.in_features if self.group_size == -1 else self.group_size
+        )
+        weight = self.weight.reshape(
+            [-1, group_size, self.out_features]
+        ).astype('float32')
+        scale = np.abs(weight).max(axis=1, keepdims=True) / bound
+        quant_weight = np.clip(np.round(weight / scale), -bound, bound)
+        return (quant_weight * scale).reshape(self.weight.shape)
+
+    def test_weight_only_linear(self):
+        x = paddle.to_tensor(self.x, dtype=self.dtype)
+        weight = paddle.to_tensor(self.weight, dtype=self.dtype)
+        bias = (
+            paddle.to_tensor(self.bias_np, dtype=self.dtype)
+            if self.bias
+            else None
+        )
+        quant_weight, weight_scale = Q.weight_quantize(
+            weight,
+            algo="weight_only_" + self.weight_dtype,
+            arch=self.arch,
+            group_size=self.group_size,
+        )
+        out = Q.weight_only_linear(
+            x,
+            quant_weight,
+            bias=bias,
+            weight_scale=weight_scale,
+            weight_dtype=self.weight_dtype,
+            arch=self.arch,
+            group_size=self.group_size,
+        )
+        if self.dtype == "bfloat16":
+            out_real = convert_uint16_to_float(out.numpy())
+            out_expect = np.matmul(self.x, self.weight)
+        else:
+            out_real = out.numpy()
+            out_expect = np.matmul(self.x, self.get_dequantized_weight())
+        if self.bias:
+            out_expect = out_expect + self.bias_np
+        np.testing.assert_allclose(
+            out_real, out_expect, rtol=1e-3, atol=self.atol
+        )
+
+
+class WeightOnlyLinearCPUTestCase1(WeightOnlyLinearCPUTestCase):
+    def config(self):
+        super().config()
+        self.weight_dtype = "int4"
+        self.group_size = 64
+        self.bias = False
+
+
+class WeightOnlyLinearCPUTestCase2(WeightOnlyLinearCPUTestCase):
+    def config(self):
+        super().config()
+        self.group_size = 128
+        self.token = 33
+
+
+class WeightOnlyLinearCPUTestCase3(WeightOnlyLinearCPUTestCase):
+    def config(self):
+        super().config()
+        self.weight_dtype = "int4"
+        self.arch = 75
+        self.batch = 1
+        self.token = 1
+
+
+class WeightOnlyLinearCPUTestCase4(WeightOnlyLinearCPUTestCase):
+    def config(self):
+        super().config()
+        self.weight_dtype = "int4"
+        self.arch = 70
+        self.group_size = 128
+        self.token = 17
+
+
+class WeightOnlyLinearCPUTestCase5(WeightOnlyLinearCPUTestCase):
+    def config(self):
+        super().config()
+        self.dtype = 'bfloat16'
+        self.atol = 1.3e-1
+
+
 @unittest.skipIf(
     not core.is_compiled_with_cuda()
     or get_cuda_version() < 11020